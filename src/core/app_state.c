@@ -5,6 +5,7 @@
 #include <stdlib.h>
 #include <unistd.h>
 
+#include "core/channel_monitor.h"
 #include "core/dvr.h"
 #include "core/input_device.h"
 #include "core/msp_displayport.h"
@@ -12,6 +13,7 @@
 #include "driver/dm5680.h"
 #include "driver/dm6302.h"
 #include "driver/hardware.h"
+#include "driver/hwio.h"
 #include "driver/it66121.h"
 #include "driver/rtc6715.h"
 #include "driver/screen.h"
@@ -83,8 +85,10 @@ void app_exit_menu() {
 }
 
 void app_switch_to_analog(bool is_av_in) {
+    channel_monitor_join();
+
 #ifdef HDZGOGGLE2
-    system_exec("aww 0x0300b084 0x0001555");
+    hwio_write(0x0300b084, 0x0001555);
 #endif
 
     dvr_update_vi_conf(VR_720P50);
@@ -121,8 +125,10 @@ void app_switch_to_analog(bool is_av_in) {
 }
 
 void app_switch_to_hdmi_in() {
+    channel_monitor_join();
+
 #if defined HDZGOGGLE2
-    system_exec("aww 0x0300b084 0x0001555");
+    hwio_write(0x0300b084, 0x0001555);
 #endif
 
 #if defined HDZBOXPRO
@@ -166,8 +172,10 @@ void app_switch_to_hdmi_in() {
 void app_switch_to_hdzero(bool is_default) {
     int ch;
 
+    channel_monitor_join();
+
 #if defined HDZGOGGLE2
-    system_exec("aww 0x0300b084 0x0001555");
+    hwio_write(0x0300b084, 0x0001555);
 #endif
 
 #if defined HDZBOXPRO
@@ -0,0 +1,291 @@
+#include "channel_monitor.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <log/log.h>
+
+#include "core/channel_scan.h"
+#include "core/common.hh"
+#include "core/settings.h"
+#include "driver/dm6302.h"
+#include "driver/hardware.h"
+#include "driver/rtc6715.h"
+#include "util/time.h"
+
+// time in the main menu before the first sample
+#define MONITOR_IDLE_MS 3000
+// one channel each, the analog ones take far less time on the receiver
+#define MONITOR_HDZERO_MS 250
+#define MONITOR_ANALOG_MS 50
+#define MONITOR_ANALOG_SETTLE_MS 20
+// analog channels once every this many HDZero sweeps
+#define MONITOR_ANALOG_EVERY 4
+
+#define MONITOR_HDZERO_CH(band) ((band) == 0 ? BASE_CH_NUM : 8)
+
+typedef struct {
+    channel_sample_t samples[CHANNEL_MONITOR_HISTORY];
+    uint8_t head; // next one written
+    uint8_t count;
+} sample_ring_t;
+
+typedef enum {
+    MONITOR_HDZERO = 0,
+    MONITOR_ANALOG,
+} monitor_phase_t;
+
+// history, taken by the monitor and the scan
+static pthread_mutex_t g_ring_mutex = PTHREAD_MUTEX_INITIALIZER;
+static sample_ring_t g_hdzero_rings[2][BASE_CH_NUM];
+static sample_ring_t g_analog_rings[CHANNEL_MONITOR_ANALOG_CH];
+static uint8_t g_hdzero_bw = 0xff;
+
+// held by the monitor for each sample
+static pthread_mutex_t g_rf_mutex = PTHREAD_MUTEX_INITIALIZER;
+static atomic_bool g_monitor_run = false;
+static uint32_t g_idle_since = 0;
+
+// used under g_rf_mutex
+static monitor_phase_t g_phase = MONITOR_HDZERO;
+static int g_next_ch = 0;
+static int g_sweeps = 0;
+static bool g_hdzero_opened = false;
+static bool g_analog_opened = false;
+
+static void ring_add(sample_ring_t *ring, bool valid, uint16_t level) {
+    channel_sample_t *sample = &ring->samples[ring->head];
+
+    sample->ms = time_ms();
+    sample->valid = valid;
+    sample->level = level;
+
+    ring->head = (ring->head + 1) % CHANNEL_MONITOR_HISTORY;
+    if (ring->count < CHANNEL_MONITOR_HISTORY)
+        ring->count++;
+}
+
+static int ring_get(const sample_ring_t *ring, channel_sample_t *samples, int max) {
+    int n = ring->count < max ? ring->count : max;
+
+    for (int i = 0; i < n; i++) {
+        samples[i] = ring->samples[(ring->head + CHANNEL_MONITOR_HISTORY - 1 - i) % CHANNEL_MONITOR_HISTORY];
+    }
+    return n;
+}
+
+void channel_monitor_add_hdzero(uint8_t band, uint8_t bw, int ch, bool valid, uint8_t gain) {
+    if (band > 1 || ch < 0 || ch >= BASE_CH_NUM) {
+        return;
+    }
+
+    pthread_mutex_lock(&g_ring_mutex);
+    // what was seen on the other bandwidth says nothing about this one
+    if (bw != g_hdzero_bw) {
+        memset(g_hdzero_rings, 0, sizeof(g_hdzero_rings));
+        g_hdzero_bw = bw;
+    }
+    ring_add(&g_hdzero_rings[band][ch], valid, gain);
+    pthread_mutex_unlock(&g_ring_mutex);
+}
+
+static void monitor_add_analog(int ch, int rssi) {
+    pthread_mutex_lock(&g_ring_mutex);
+    ring_add(&g_analog_rings[ch], false, rssi);
+    pthread_mutex_unlock(&g_ring_mutex);
+}
+
+int channel_monitor_hdzero(uint8_t band, int ch, channel_sample_t *samples, int max) {
+    int n;
+
+    if (band > 1 || ch < 0 || ch >= BASE_CH_NUM) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&g_ring_mutex);
+    n = g_hdzero_bw == g_setting.source.hdzero_bw ? ring_get(&g_hdzero_rings[band][ch], samples, max) : 0;
+    pthread_mutex_unlock(&g_ring_mutex);
+    return n;
+}
+
+int channel_monitor_analog(int ch, channel_sample_t *samples, int max) {
+    int n;
+
+    if (ch < 0 || ch >= CHANNEL_MONITOR_ANALOG_CH) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&g_ring_mutex);
+    n = ring_get(&g_analog_rings[ch], samples, max);
+    pthread_mutex_unlock(&g_ring_mutex);
+    return n;
+}
+
+int channel_monitor_hdzero_best(uint8_t band, int count, uint32_t max_age_ms) {
+    uint32_t now_ms = time_ms();
+    channel_sample_t samples[CHANNEL_MONITOR_HISTORY];
+    int best = -1, best_score = -1;
+
+    for (int ch = 0; ch < count; ch++) {
+        int n = channel_monitor_hdzero(band, ch, samples, CHANNEL_MONITOR_HISTORY);
+        int sum = 0, fresh = 0;
+
+        // only a channel valid the last time it was seen
+        if (n == 0 || !samples[0].valid || now_ms - samples[0].ms > max_age_ms) {
+            continue;
+        }
+
+        // the mean gain of the recent samples, the ones with no video as 0
+        for (int i = 0; i < n && now_ms - samples[i].ms <= max_age_ms; i++, fresh++) {
+            if (samples[i].valid)
+                sum += samples[i].level;
+        }
+        if (sum * 16 / fresh > best_score) {
+            best_score = sum * 16 / fresh;
+            best = ch;
+        }
+    }
+    return best;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// sampling, under g_rf_mutex
+
+static bool monitor_has_analog() {
+#if defined(HDZBOXPRO) || defined(HDZGOGGLE2)
+    return g_setting.source.analog_module == SETTING_SOURCES_ANALOG_MODULE_INTERNAL;
+#else
+    return false;
+#endif
+}
+
+static void monitor_release() {
+    if (g_analog_opened) {
+        rtc6715.init(0, 0);
+        g_analog_opened = false;
+    }
+    if (g_hdzero_opened) {
+        HDZero_Close();
+        g_hdzero_opened = false;
+    }
+    if (g_phase == MONITOR_ANALOG) {
+        g_phase = MONITOR_HDZERO;
+        g_next_ch = 0;
+    }
+}
+
+static uint32_t monitor_hdzero() {
+    uint8_t band = g_setting.source.hdzero_band;
+    uint8_t bw = g_setting.source.hdzero_bw;
+    uint8_t gain = 0;
+    bool valid;
+
+    if (g_next_ch >= MONITOR_HDZERO_CH(band)) {
+        g_next_ch = 0;
+    }
+
+    if (!g_hw_stat.hdzero_open) {
+        g_hdzero_opened = true;
+    }
+    HDZero_open(bw);
+
+    // stopped while the receivers were powered up, no need for the sample
+    if (!atomic_load(&g_monitor_run)) {
+        return MONITOR_HDZERO_MS;
+    }
+
+    valid = channel_scan_probe(band, g_next_ch, &gain);
+    channel_monitor_add_hdzero(band, bw, g_next_ch, valid, gain);
+
+    if (++g_next_ch == MONITOR_HDZERO_CH(band)) {
+        g_next_ch = 0;
+        if (monitor_has_analog() && ++g_sweeps % MONITOR_ANALOG_EVERY == 0) {
+            g_phase = MONITOR_ANALOG;
+        }
+    }
+    return MONITOR_HDZERO_MS;
+}
+
+static uint32_t monitor_analog() {
+    if (!monitor_has_analog()) {
+        g_phase = MONITOR_HDZERO;
+        g_next_ch = 0;
+        return MONITOR_ANALOG_MS;
+    }
+
+    // the RF switch goes over to the analog module until it is turned off
+    if (!g_analog_opened) {
+        rtc6715.init(1, 0);
+        g_analog_opened = true;
+    }
+
+    rtc6715.set_ch(g_next_ch);
+    usleep(MONITOR_ANALOG_SETTLE_MS * 1000);
+    monitor_add_analog(g_next_ch, rtc6715.get_rssi());
+
+    if (++g_next_ch == CHANNEL_MONITOR_ANALOG_CH) {
+        rtc6715.init(0, 0);
+        g_analog_opened = false;
+        g_phase = MONITOR_HDZERO;
+        g_next_ch = 0;
+    }
+    return MONITOR_ANALOG_MS;
+}
+
+void *thread_channel_monitor(void *ptr) {
+    for (;;) {
+        uint32_t period_ms = 100;
+
+        pthread_mutex_lock(&g_rf_mutex);
+        if (atomic_load(&g_monitor_run)) {
+            period_ms = g_phase == MONITOR_HDZERO ? monitor_hdzero() : monitor_analog();
+        } else {
+            // stopped, unless channel_monitor_join() got here first
+            monitor_release();
+        }
+        pthread_mutex_unlock(&g_rf_mutex);
+
+        usleep(period_ms * 1000);
+    }
+    return NULL;
+}
+
+void channel_monitor_idle(bool idle) {
+    uint32_t now_ms = time_ms();
+
+    if (!idle) {
+        // left the menu some way that didn't stop it
+        if (atomic_load(&g_monitor_run)) {
+            channel_monitor_stop();
+        }
+        g_idle_since = 0;
+        return;
+    }
+
+    if (g_idle_since == 0) {
+        g_idle_since = now_ms ? now_ms : 1;
+    } else if (now_ms - g_idle_since >= MONITOR_IDLE_MS && !atomic_load(&g_monitor_run)) {
+        LOGI("channel monitor: start");
+        atomic_store(&g_monitor_run, true);
+    }
+}
+
+void channel_monitor_stop() {
+    g_idle_since = 0;
+
+    if (atomic_exchange(&g_monitor_run, false)) {
+        LOGI("channel monitor: stop");
+    }
+}
+
+void channel_monitor_join() {
+    if (atomic_exchange(&g_monitor_run, false)) {
+        LOGI("channel monitor: stop");
+    }
+
+    pthread_mutex_lock(&g_rf_mutex);
+    monitor_release();
+    pthread_mutex_unlock(&g_rf_mutex);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Background channel monitor.
+//
+// While the goggle sits in the main menu, one channel is sampled at a time:
+// every HDZero channel of the current band (valid flag and gain), then now
+// and then every channel of the internal analog module (RSSI). The last
+// samples of each channel are kept, with what channel_scan measures, so the
+// scan page can show them while it sweeps and pick the best channel.
+//
+#define CHANNEL_MONITOR_HISTORY   8
+#define CHANNEL_MONITOR_ANALOG_CH 48
+
+// samples this recent are shown before the sweep gets to their channel
+#define CHANNEL_MONITOR_FRESH_MS 10000
+
+typedef struct {
+    uint32_t ms;    // time_ms() it was taken
+    bool valid;     // HDZero: the DM5680s reported video
+    uint16_t level; // HDZero: gain 0-60, analog: RSSI in mV
+} channel_sample_t;
+
+void *thread_channel_monitor(void *ptr);
+
+// from the main loop, true while in the main menu
+void channel_monitor_idle(bool idle);
+
+// on leaving the main menu, doesn't wait: the monitor thread turns off what
+// it turned on after the sample in flight
+void channel_monitor_stop();
+
+// before anything else takes the receivers: stops the monitor, waits for the
+// sample in flight and turns off what it turned on. Blocks for as long as
+// the monitor holds them, up to a full HDZero_open(), so keep it off the UI
+// thread where the caller can.
+void channel_monitor_join();
+
+void channel_monitor_add_hdzero(uint8_t band, uint8_t bw, int ch, bool valid, uint8_t gain);
+
+// the samples of a channel, newest first; how many
+int channel_monitor_hdzero(uint8_t band, int ch, channel_sample_t *samples, int max);
+int channel_monitor_analog(int ch, channel_sample_t *samples, int max);
+
+// the valid channel with the best recent gain, -1 if none
+int channel_monitor_hdzero_best(uint8_t band, int count, uint32_t max_age_ms);
+
+#ifdef __cplusplus
+}
+#endif
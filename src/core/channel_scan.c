@@ -0,0 +1,198 @@
+#include "channel_scan.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#include <log/log.h>
+
+#include "core/channel_monitor.h"
+#include "core/event_loop.h"
+#include "driver/dm5680.h"
+#include "driver/dm6302.h"
+#include "driver/hardware.h"
+#include "util/time.h"
+
+// the DM5680s are first asked this long after tuning
+#define SCAN_SETTLE_MS 20
+#define SCAN_POLL_MS   10
+// last request for the valid flag, the fixed settle time of the old scan
+#define SCAN_DWELL_MS 100
+// a channel is taken early only on this many valid answers in a row, one
+// stale answer from the previous channel doesn't make it valid
+#define SCAN_VALID_HITS 2
+
+typedef struct {
+    atomic_bool ready;
+    channel_scan_result_t result;
+} scan_slot_t;
+
+static atomic_int g_scan_state = CHANNEL_SCAN_IDLE;
+static atomic_int g_scan_published = 0;
+static scan_slot_t g_scan_slots[BASE_CH_NUM];
+
+// set before the thread is started
+static uint8_t g_scan_band;
+static uint8_t g_scan_bw;
+static int g_scan_count;
+
+static void scan_sleep_until(uint64_t t_us) {
+    uint64_t now_us = time_us();
+
+    if (t_us > now_us) {
+        usleep(t_us - now_us);
+    }
+}
+
+static uint8_t scan_gain() {
+    uint8_t gain[4];
+    uint8_t max = 0;
+
+    DM6302_get_gain(gain);
+    for (int i = 0; i < 4; i++) {
+        if (gain[i] > max)
+            max = gain[i];
+    }
+    return max;
+}
+
+// polls the valid flag of the channel tuned at tuned_us, true once valid.
+// The gain is read with every request and the one kept is read with the
+// request that decided: the second valid answer, or the last request at
+// SCAN_DWELL_MS, where the old scan read it.
+static bool scan_wait_valid(uint64_t tuned_us, uint8_t *gain) {
+    uint64_t req_us = tuned_us + SCAN_SETTLE_MS * 1000;
+    uint64_t last_us = tuned_us + SCAN_DWELL_MS * 1000;
+    int hits = 0;
+
+    for (;;) {
+        bool last = req_us >= last_us;
+
+        scan_sleep_until(req_us);
+        DM5680_clear_vldflg();
+        DM5680_req_vldflg();
+        *gain = scan_gain();
+
+        req_us += SCAN_POLL_MS * 1000;
+        scan_sleep_until(req_us);
+
+        if (rx_status[0].rx_valid | rx_status[1].rx_valid) {
+            hits++;
+        } else {
+            hits = 0;
+        }
+
+        // the old scan took a single answer, so does the last request
+        if (hits >= SCAN_VALID_HITS || (last && hits > 0)) {
+            return true;
+        }
+        if (last) {
+            return false;
+        }
+    }
+}
+
+static void scan_publish(int ch, const channel_scan_result_t *result) {
+    scan_slot_t *slot = &g_scan_slots[ch];
+
+    slot->result = *result;
+    atomic_store_explicit(&slot->ready, true, memory_order_release);
+    atomic_fetch_add(&g_scan_published, 1);
+    event_loop_post(EVENT_LOOP_SCAN);
+
+    channel_monitor_add_hdzero(g_scan_band, g_scan_bw, ch, result->valid, result->gain);
+}
+
+static void *channel_scan_thread(void *arg) {
+    uint64_t start_us = time_us();
+    uint64_t tuned_us;
+
+    // the monitor was told to stop by channel_scan_start(), waited for here
+    channel_monitor_join();
+    HDZero_open(g_scan_bw);
+
+    DM6302_SetChannel(g_scan_band, 0);
+    tuned_us = time_us();
+
+    for (int ch = 0; ch < g_scan_count; ch++) {
+        channel_scan_result_t result;
+        uint64_t decided_us;
+
+        result.valid = scan_wait_valid(tuned_us, &result.gain);
+        decided_us = time_us();
+        result.dwell_ms = (decided_us - tuned_us) / 1000;
+
+        // the next channel settles while this one is published
+        if (ch + 1 < g_scan_count) {
+            DM6302_SetChannel(g_scan_band, ch + 1);
+            tuned_us = time_us();
+        }
+
+        scan_publish(ch, &result);
+        LOGI("Scan band:%d, channel%d: valid:%d, gain:%d, %u ms",
+             g_scan_band, ch, result.valid, result.gain, result.dwell_ms);
+    }
+
+    LOGI("Scan band:%d, %d channels in %u ms",
+         g_scan_band, g_scan_count, (uint32_t)((time_us() - start_us) / 1000));
+
+    atomic_store(&g_scan_state, CHANNEL_SCAN_DONE);
+    event_loop_post(EVENT_LOOP_SCAN);
+    return NULL;
+}
+
+int channel_scan_start(uint8_t band, uint8_t bw, int count) {
+    int idle = CHANNEL_SCAN_IDLE;
+    pthread_t tid;
+
+    if (!atomic_compare_exchange_strong(&g_scan_state, &idle, CHANNEL_SCAN_RUNNING)) {
+        return -1;
+    }
+    channel_monitor_stop();
+
+    for (int i = 0; i < BASE_CH_NUM; i++) {
+        atomic_store(&g_scan_slots[i].ready, false);
+    }
+    atomic_store(&g_scan_published, 0);
+
+    g_scan_band = band;
+    g_scan_bw = bw;
+    g_scan_count = count < BASE_CH_NUM ? count : BASE_CH_NUM;
+
+    if (pthread_create(&tid, NULL, channel_scan_thread, NULL)) {
+        LOGE("scan: can't start the thread");
+        atomic_store(&g_scan_state, CHANNEL_SCAN_IDLE);
+        return -1;
+    }
+    pthread_detach(tid);
+    return 0;
+}
+
+channel_scan_state_t channel_scan_state() {
+    return atomic_load(&g_scan_state);
+}
+
+void channel_scan_finish() {
+    int done = CHANNEL_SCAN_DONE;
+
+    atomic_compare_exchange_strong(&g_scan_state, &done, CHANNEL_SCAN_IDLE);
+}
+
+int channel_scan_progress() {
+    return atomic_load(&g_scan_published);
+}
+
+bool channel_scan_result(int ch, channel_scan_result_t *result) {
+    if (ch < 0 || ch >= BASE_CH_NUM ||
+        !atomic_load_explicit(&g_scan_slots[ch].ready, memory_order_acquire)) {
+        return false;
+    }
+
+    *result = g_scan_slots[ch].result;
+    return true;
+}
+
+bool channel_scan_probe(uint8_t band, uint8_t ch, uint8_t *gain) {
+    DM6302_SetChannel(band, ch);
+    return scan_wait_valid(time_us(), gain);
+}
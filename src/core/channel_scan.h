@@ -0,0 +1,46 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// HDZero channel scan, run on its own thread.
+//
+// Each channel is taken as soon as the DM5680s report it valid, instead of
+// after a fixed settle time; its gain is read while they are still locking
+// and the next channel is tuned before the result is published. Results go
+// to a table the UI reads without locks on its own tick.
+//
+typedef enum {
+    CHANNEL_SCAN_IDLE = 0,
+    CHANNEL_SCAN_RUNNING,
+    CHANNEL_SCAN_DONE, // all results published, until channel_scan_finish()
+} channel_scan_state_t;
+
+typedef struct {
+    bool valid;
+    uint8_t gain;      // 0-60, max of the four receivers
+    uint16_t dwell_ms; // from tuned to the valid flag or giving up
+} channel_scan_result_t;
+
+// -1 if a scan is already going or the thread can't be started
+int channel_scan_start(uint8_t band, uint8_t bw, int count);
+channel_scan_state_t channel_scan_state();
+void channel_scan_finish();
+
+// channels published so far
+int channel_scan_progress();
+
+// false while the channel isn't published yet
+bool channel_scan_result(int ch, channel_scan_result_t *result);
+
+// tunes one channel and waits for its valid flag the way the scan does
+bool channel_scan_probe(uint8_t band, uint8_t ch, uint8_t *gain);
+
+#ifdef __cplusplus
+}
+#endif
@@ -3,6 +3,7 @@
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/shm.h>
 #include <unistd.h>
 
 #include <log/log.h>
@@ -13,64 +14,210 @@
 #include "core/msp_displayport.h"
 #include "core/settings.h"
 #include "driver/hardware.h"
+#include "driver/hwio.h"
+#include "player/gogglemsg.h"
 #include "record/record_definitions.h"
+#include "record/record_status.h"
 #include "ui/page_common.h"
 #include "util/sdcard.h"
 #include "util/system.h"
 
+#define DVR_ACK_TIMEOUT_MS 5000 // starting includes opening the file and the snapshot
+#define DVR_REQ_QUEUE      4    // a restart is a stop and a start
+
 bool dvr_is_recording = false;
 
 static time_t dvr_recording_start = 0;
-static pthread_mutex_t dvr_mutex;
+static pthread_mutex_t dvr_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static RecordStatusShm_t *dvr_status = NULL;
+static uint32_t dvr_status_seen;
+static int dvr_status_last = -1;
+
+// the requests wait for their ack here rather than on the caller, which is
+// usually the UI holding lvgl_mutex
+static pthread_t dvr_req_pid;
+static pthread_cond_t dvr_req_cond = PTHREAD_COND_INITIALIZER;
+static GoggleMsgCommand_e dvr_req_queue[DVR_REQ_QUEUE];
+static int dvr_req_head = 0;
+static int dvr_req_count = 0;
+static bool dvr_req_busy = false; // a request is waiting for its ack
 
 ///////////////////////////////////////////////////////////////////
 //-1=error;
 // 0=idle,1=recording,2=stopped,3=No SD card,4=recorf file path error,
 // 5=SD card Full,6=Encoder error
-void dvr_update_status() {
+static int dvr_get_status() {
+    if (dvr_status == NULL) {
+        int id = shmget(RECSTAT_memKEY, sizeof(RecordStatusShm_t), 0);
+        if (id < 0)
+            return -1;
+
+        RecordStatusShm_t *shm = (RecordStatusShm_t *)shmat(id, NULL, SHM_RDONLY);
+        if (shm == (void *)-1)
+            return -1;
+
+        dvr_status = shm;
+        dvr_status_seen = recstat_changes(shm) - 1;
+    }
+
+    if (dvr_status->magic != RECSTAT_MAGIC)
+        return -1;
+
+    // the record app bumps the change counter whenever the status changes
+    uint32_t changes = recstat_changes(dvr_status);
+    if (changes != dvr_status_seen) {
+        RecordStatusData_t data;
+
+        // stale while the record app is gone mid-update, try again next time
+        if (recstat_read(dvr_status, &data)) {
+            dvr_status_last = data.status;
+            dvr_status_seen = changes;
+        }
+    }
+
+    return dvr_status_last;
+}
+
+// returns the record status once the command is done, -1 if it could not be sent, -2 if not acknowledged
+static int dvr_request(GoggleMsgCommand_e cmd) {
+    int status = -1;
+    int ret = gogglemsg_request(MTYPE_RECORD, cmd, 0, DVR_ACK_TIMEOUT_MS, &status);
+
+    return (ret == 0) ? status : ret;
+}
+
+static void *dvr_request_thread(void *arg) {
     pthread_mutex_lock(&dvr_mutex);
-    if (dvr_is_recording) {
-        int ret = -1;
-        FILE *fp = fopen("/tmp/record.dat", "r");
-        if (fp) {
-            fscanf(fp, "%d", &ret);
-            fclose(fp);
+    for (;;) {
+        while (dvr_req_count == 0)
+            pthread_cond_wait(&dvr_req_cond, &dvr_mutex);
+
+        GoggleMsgCommand_e cmd = dvr_req_queue[dvr_req_head];
+        dvr_req_head = (dvr_req_head + 1) % DVR_REQ_QUEUE;
+        dvr_req_count--;
+        dvr_req_busy = true;
+
+        pthread_mutex_unlock(&dvr_mutex);
+        int status = dvr_request(cmd);
+        pthread_mutex_lock(&dvr_mutex);
+        dvr_req_busy = false;
+
+        // not acknowledged in time, dvr_update_status() sorts it out. A
+        // command queued meanwhile decides the state instead
+        if (cmd == MSG_cmdSTART && status != 1 && status != -2) {
+            LOGE("recording not started: %d", status);
+            if (dvr_req_count == 0)
+                dvr_is_recording = false;
+        }
+    }
+
+    return NULL;
+}
+
+// with dvr_mutex held
+static void dvr_request_async(GoggleMsgCommand_e cmd) {
+    if (dvr_req_pid == 0) {
+        if (pthread_create(&dvr_req_pid, NULL, dvr_request_thread, NULL)) {
+            LOGE("dvr request thread failed");
+            dvr_req_pid = 0;
+            return;
         }
+        pthread_detach(dvr_req_pid);
+    }
+
+    if (dvr_req_count == DVR_REQ_QUEUE) {
+        LOGE("dvr request %d dropped, queue full", cmd);
+        return;
+    }
+    dvr_req_queue[(dvr_req_head + dvr_req_count) % DVR_REQ_QUEUE] = cmd;
+    dvr_req_count++;
+    pthread_cond_signal(&dvr_req_cond);
+}
+
+void dvr_update_status() {
+    pthread_mutex_lock(&dvr_mutex);
+    // the status only means something once the requests are through
+    if (dvr_is_recording && dvr_req_count == 0 && !dvr_req_busy) {
+        int ret = dvr_get_status();
         if (ret != 1) {
             dvr_is_recording = false;
-            system_script(REC_STOP);
-            sleep(2); // wait for record process
+            dvr_request_async(MSG_cmdSTOP);
         }
     }
     pthread_mutex_unlock(&dvr_mutex);
 }
 
+// line out and the record input, as audio_sel.sh sets them
+
+static const hwio_mixer_t line_out_on[] = {
+    {"Lineout Switch", 1},
+    {"LINEOUTL Mux", 1},
+    {"LINEOUTR Mux", 1},
+    {"lineout volume", 31},
+    {"LINEINL/R to L_R output mixer gain", 7},
+    {"Left Output Mixer LINEINL Switch", 1},
+    {"Right Output Mixer LINEINR Switch", 1},
+    {"Left Output Mixer DACL Switch", 0},
+    {"Right Output Mixer DACR Switch", 0},
+};
+
+static const hwio_mixer_t line_out_off[] = {
+    {"Lineout Switch", 0},
+    {"LINEOUTL Mux", 0},
+    {"LINEOUTR Mux", 0},
+};
+
+static const hwio_mixer_t audio_in_clear[] = {
+    {"AIF1 AD0L Mixer ADCL Switch", 0},
+    {"AIF1 AD0R Mixer ADCR Switch", 0},
+    {"LADC input Mixer MIC1 boost Switch", 0},
+    {"RADC input Mixer MIC1 boost Switch", 0},
+    {"LADC input Mixer MIC2 boost Switch", 0},
+    {"RADC input Mixer MIC2 boost Switch", 0},
+    {"LADC input Mixer LINEINL Switch", 0},
+    {"RADC input Mixer LINEINR Switch", 0},
+};
+
+static const hwio_mixer_t audio_in_sources[3][4] = {
+    {
+        // mic1
+        {"LADC input Mixer MIC1 boost Switch", 1},
+        {"RADC input Mixer MIC1 boost Switch", 1},
+        {"AIF1 AD0L Mixer ADCL Switch", 1},
+        {"AIF1 AD0R Mixer ADCR Switch", 1},
+    },
+    {
+        // mic2
+        {"LADC input Mixer MIC2 boost Switch", 1},
+        {"RADC input Mixer MIC2 boost Switch", 1},
+        {"AIF1 AD0L Mixer ADCL Switch", 1},
+        {"AIF1 AD0R Mixer ADCR Switch", 1},
+    },
+    {
+        // line in
+        {"LADC input Mixer LINEINL Switch", 1},
+        {"RADC input Mixer LINEINR Switch", 1},
+        {"AIF1 AD0L Mixer ADCL Switch", 1},
+        {"AIF1 AD0R Mixer ADCR Switch", 1},
+    },
+};
+
+#define MIXER_COUNT(m) (int)(sizeof(m) / sizeof(m[0]))
+
 void dvr_enable_line_out(bool enable) {
-    char buf[128];
     if (enable) {
-        snprintf(buf, sizeof(buf), "%s out_on", AUDIO_SEL_SH);
-        system_exec(buf);
-        snprintf(buf, sizeof(buf), "%s out_linein_on", AUDIO_SEL_SH);
-        system_exec(buf);
-        snprintf(buf, sizeof(buf), "%s out_dac_off", AUDIO_SEL_SH);
-        system_exec(buf);
+        hwio_mixer_apply(line_out_on, MIXER_COUNT(line_out_on));
     } else {
-        snprintf(buf, sizeof(buf), "%s out_off", AUDIO_SEL_SH);
-        system_exec(buf);
+        hwio_mixer_apply(line_out_off, MIXER_COUNT(line_out_off));
     }
 }
 
 void dvr_select_audio_source(uint8_t source) {
-    char buf[128];
-    char *audio_source[3] = {
-        "in_mic1",
-        "in_mic2",
-        "in_linein"};
-
     if (source > 2)
         source = 2;
-    snprintf(buf, sizeof(buf), "%s %s", AUDIO_SEL_SH, audio_source[source]);
-    system_exec(buf);
+    hwio_mixer_apply(audio_in_clear, MIXER_COUNT(audio_in_clear));
+    hwio_mixer_apply(audio_in_sources[source], MIXER_COUNT(audio_in_sources[source]));
 }
 
 // video input config
@@ -333,17 +480,14 @@ void dvr_cmd(osd_dvr_cmd_t cmd) {
     if (start_rec) {
         if (!dvr_is_recording && !sdcard_is_full()) {
             dvr_update_record_conf();
+            dvr_request_async(MSG_cmdSTART);
             dvr_is_recording = true;
-            usleep(100 * 1000);
-            system_script(REC_START);
             dvr_recording_start = time(NULL);
-            sleep(2); // wait for record process
         }
     } else {
         if (dvr_is_recording) {
             dvr_is_recording = false;
-            system_script(REC_STOP);
-            sleep(2); // wait for record process
+            dvr_request_async(MSG_cmdSTOP);
         }
     }
 
@@ -0,0 +1,61 @@
+#include "event_loop.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdatomic.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <log/log.h>
+
+static int event_fd = -1;
+static atomic_uint event_pending = 0;
+
+int event_loop_init(void) {
+    event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (event_fd < 0) {
+        LOGE("eventfd failed: %m");
+        return -1;
+    }
+    return 0;
+}
+
+static void event_loop_drain(void) {
+    uint64_t cnt;
+
+    if (read(event_fd, &cnt, sizeof(cnt)) < 0 && errno != EAGAIN) {
+        LOGE("event_loop_drain failed: %m");
+    }
+}
+
+// Can be called from any thread to wake up the main loop
+void event_loop_post(event_loop_source_t source) {
+    const uint64_t one = 1;
+
+    // only the first post after a wait needs to kick the eventfd
+    if (atomic_fetch_or(&event_pending, source) == 0 && event_fd >= 0) {
+        if (write(event_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+            LOGE("event_loop_post failed: %m");
+        }
+    }
+}
+
+// Sleeps until an event is posted or timeout_ms passed,
+// returns the mask of event_loop_source_t posted in the meantime.
+uint32_t event_loop_wait(uint32_t timeout_ms) {
+    struct pollfd pfd = {
+        .fd = event_fd,
+        .events = POLLIN,
+    };
+    if (atomic_load(&event_pending) == 0) {
+        if (event_fd < 0) {
+            usleep(timeout_ms * 1000);
+        } else if (poll(&pfd, 1, timeout_ms) > 0) {
+            event_loop_drain();
+        }
+    } else if (event_fd >= 0) {
+        event_loop_drain();
+    }
+
+    return atomic_exchange(&event_pending, 0);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+// Upper bound for how long the main loop sleeps when nothing happens,
+// state that is only polled (battery, temperatures, ...) refreshes at this rate.
+#define EVENT_LOOP_IDLE_MS 50
+
+typedef enum {
+    EVENT_LOOP_INPUT = 1 << 0,  // key, dial or button handled
+    EVENT_LOOP_OSD = 1 << 1,    // FC OSD redrawn
+    EVENT_LOOP_SENSOR = 1 << 2, // peripheral status refreshed
+    EVENT_LOOP_SCAN = 1 << 3,   // channel scan result published
+} event_loop_source_t;
+
+int event_loop_init(void);
+void event_loop_post(event_loop_source_t source);
+uint32_t event_loop_wait(uint32_t timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
@@ -27,6 +27,7 @@
 #include "core/app_state.h"
 #include "core/dvr.h"
 #include "core/elrs.h"
+#include "core/event_loop.h"
 #include "core/settings.h"
 #include "core/sleep_mode.h"
 #include "driver/dm6302.h"
@@ -561,6 +562,7 @@ static void *thread_input_device(void *ptr) {
                     get_event(events[i].data.fd);
                 }
             }
+            event_loop_post(EVENT_LOOP_INPUT);
         } else {
             roller_up_acc = 0;
             roller_down_acc = 0;
@@ -632,6 +634,7 @@ static void *thread_input_device(void *ptr) {
                 }
                 break;
             }
+            event_loop_post(EVENT_LOOP_INPUT);
             SDL_LockMutex(global_sdl_mutex);
         }
         SDL_UnlockMutex(global_sdl_mutex);
@@ -22,6 +22,7 @@ SDL_mutex *global_sdl_mutex;
 #include "core/app_state.h"
 #include "core/common.hh"
 #include "core/elrs.h"
+#include "core/event_loop.h"
 #include "core/ht.h"
 #include "core/input_device.h"
 #include "core/osd.h"
@@ -53,8 +54,7 @@ SDL_mutex *global_sdl_mutex;
 #include "ui/ui_porting.h"
 #include "ui/ui_statusbar.h"
 #include "util/sdcard.h"
-
-int gif_cnt = 0;
+#include "util/time.h"
 
 static void *thread_autoscan(void *ptr) {
     for (;;) {
@@ -148,6 +148,7 @@ void lvgl_init() {
 
 int main(int argc, char *argv[]) {
     pthread_mutex_init(&lvgl_mutex, NULL);
+    event_loop_init();
 
 #ifdef EMULATOR_BUILD
     global_sdl_mutex = SDL_CreateMutex();
@@ -208,10 +209,7 @@ int main(int argc, char *argv[]) {
     start_running();
     create_threads();
 
-    // 8. Synthetic counter for gif refresh
-    gif_cnt = 0;
-
-    // 8.1 set initial analog module power state
+    // 8. set initial analog module power state
 #if defined(HDZGOGGLE2) || defined(HDZBOXPRO)
     Analog_Module_Power(0);
 #endif
@@ -220,21 +218,31 @@ int main(int argc, char *argv[]) {
     head_alarm_init();
 
     // 10. Execute main loop
+    //     Sleep until input, OSD or sensor threads post an event, lvgl has a
+    //     timer due or EVENT_LOOP_IDLE_MS passed without anything happening.
     g_init_done = 1;
+    uint32_t events = 0;
+    uint32_t update_ms = time_ms();
     for (;;) {
+        uint32_t now_ms = time_ms();
+
         pthread_mutex_lock(&lvgl_mutex);
-        main_menu_update();
-        sleep_reminder();
-        statubar_update();
-        osd_hdzero_update();
-        ims_update();
-        ui_osd_element_pos_update();
-        ht_detect_motion();
-        lv_timer_handler();
-        source_status_timer();
+        // an OSD redraw only needs lvgl to render, not a state refresh
+        if ((events & ~EVENT_LOOP_OSD) || now_ms - update_ms >= EVENT_LOOP_IDLE_MS) {
+            update_ms = now_ms;
+            main_menu_update();
+            sleep_reminder();
+            statubar_update();
+            osd_hdzero_update();
+            ims_update();
+            ui_osd_element_pos_update();
+            ht_detect_motion();
+            source_status_timer();
+        }
+        uint32_t timer_ms = lv_timer_handler();
         pthread_mutex_unlock(&lvgl_mutex);
-        usleep(5000);
-        gif_cnt++;
+
+        events = event_loop_wait(LV_MIN(timer_ms, EVENT_LOOP_IDLE_MS));
     }
     return 0;
 }
@@ -21,6 +21,7 @@
 #include "core/common.hh"
 #include "core/dvr.h"
 #include "core/elrs.h"
+#include "core/event_loop.h"
 #include "core/msp_displayport.h"
 #include "core/settings.h"
 #include "driver/dm5680.h"
@@ -36,6 +37,7 @@
 #include "ui/page_scannow.h"
 #include "ui/ui_image_setting.h"
 #include "ui/ui_porting.h"
+#include "util/time.h"
 
 extern const lv_font_t conthrax_26;
 extern const lv_font_t robotomono_26;
@@ -63,7 +65,6 @@ static int clock_format_offsets[OSD_RESOURCE_TOTAL];
 
 extern lv_style_t style_osd;
 extern pthread_mutex_t lvgl_mutex;
-extern int gif_cnt;
 
 // Use SDCARD for Embedded Glyph if the glyph exists otherwise use goggle FS
 void osd_resource_path(char *buf, const char *fmt, osd_resource_t osd_resource_type, ...) {
@@ -141,13 +142,16 @@ void osd_hdmi_in_dvr_update() {
 ///////////////////////////////////////////////////////////////////////////////
 // these are local for OSD controlling
 static osd_hdzero_t g_osd_hdzero;
-static lv_obj_t *img_arr[2][HD_VMAX][HD_HMAX];
 static lv_obj_t *scr_main;
 static lv_obj_t *scr_osd[2];                                                    // 0=720p,1=1080p
+static lv_obj_t *osd_grid[2];                                                   // 0=720p,1=1080p
 static uint32_t osdFont_hd[OSD_VNUM][OSD_HNUM][OSD_HEIGHT_HD][OSD_WIDTH_HD];    // 0x00bbggrr
 static uint32_t osdFont_fhd[OSD_VNUM][OSD_HNUM][OSD_HEIGHT_FHD][OSD_WIDTH_FHD]; // 0x00bbggrr
-static osd_font_t osd_font_hd;
-static osd_font_t osd_font_fhd;
+// FC OSD cells as last drawn, read by the grid's draw event; only changed
+// under lvgl_mutex and shared by both grids as only one is visible at a time
+#define OSD_CELL_EMPTY 0xFFFF
+static uint16_t osd_cells[HD_VMAX][HD_HMAX];
+static atomic_bool osd_redraw_all = false;
 static lv_obj_t *analog_rssi_bar;
 
 void osd_llock_show(bool bShow) {
@@ -675,17 +679,28 @@ void osd_elements_set_dummy_sources() {
     lv_img_set_src(g_osd_hdzero.topfan_speed[is_fhd], buf);
 }
 
-#define FC_OSD_CHECK_PERIOD 200 // 25ms
+#define FC_OSD_CHECK_PERIOD 1000 // ms without FC OSD data before it is cleared
+#define OSD_GIF_REFRESH_MS  50
 void osd_hdzero_update(void) {
+    static uint32_t update_ms = 0;
+    static uint32_t gif_ms = 0;
     char buf[128], i;
 
-    if (g_osd_update_cnt < FC_OSD_CHECK_PERIOD)
-        g_osd_update_cnt++;
-    else if (g_osd_update_cnt == FC_OSD_CHECK_PERIOD) {
-        osd_clear();
-        g_osd_update_cnt++;
+    // called at a variable rate from the main loop, so count in ms
+    const uint32_t now_ms = time_ms();
+    const uint32_t elapsed_ms = now_ms - update_ms;
+    update_ms = now_ms;
+
+    if (g_osd_update_cnt <= FC_OSD_CHECK_PERIOD) {
+        g_osd_update_cnt += elapsed_ms;
+        if (g_osd_update_cnt > FC_OSD_CHECK_PERIOD)
+            osd_clear();
     }
 
+    const bool gif_refresh = (now_ms - gif_ms) >= OSD_GIF_REFRESH_MS;
+    if (gif_refresh)
+        gif_ms = now_ms;
+
     if (fhd_change())
         return;
 
@@ -723,7 +738,7 @@ void osd_hdzero_update(void) {
     osd_battery_voltage_show(g_setting.osd.is_visible);
     osd_clock_show(g_setting.osd.is_visible);
 
-    if (gif_cnt % 10 == 0) { // delay needed to allow gif to flash
+    if (gif_refresh) { // delay needed to allow gif to flash
         osd_resource_path(buf, "%s", is_fhd, VrxTemp7_gif);
         lv_gif_set_src(g_osd_hdzero.vrx_temp[is_fhd], buf);
         osd_vrxtemp_show();
@@ -757,7 +772,7 @@ void osd_hdzero_update(void) {
 
 #endif
 
-    if (gif_cnt % 10 == 0) { // delay needed to allow gif to flash
+    if (gif_refresh) { // delay needed to allow gif to flash
         osd_resource_path(buf, "%s", is_fhd, lowBattery_gif);
         lv_gif_set_src(g_osd_hdzero.battery_low[is_fhd], buf);
         osd_battery_low_show();
@@ -817,16 +832,64 @@ int osd_clear(void) {
     return 0;
 }
 
-static int draw_osd_on_screen(uint8_t row, uint8_t col) {
-    pthread_mutex_lock(&lvgl_mutex);
-    int index = osd_buf_shadow[row][col];
-    if (is_fhd)
-        lv_img_set_src(img_arr[is_fhd][row][col], &osd_font_fhd.data[index]);
-    else
-        lv_img_set_src(img_arr[is_fhd][row][col], &osd_font_hd.data[index]);
-    pthread_mutex_unlock(&lvgl_mutex);
+// must be called with lvgl_mutex held
+static void draw_osd_on_screen(uint8_t row, uint8_t col) {
+    osd_cells[row][col] = osd_buf_shadow[row][col] % (OSD_VNUM * OSD_HNUM);
+}
 
-    return 0;
+// must be called with lvgl_mutex held
+static void osd_invalidate_cells(uint8_t row, uint8_t col_start, uint8_t col_end) {
+    lv_obj_t *grid = osd_grid[is_fhd];
+    int osd_width = is_fhd ? OSD_WIDTH_FHD : OSD_WIDTH_HD;
+    int osd_height = is_fhd ? OSD_HEIGHT_FHD : OSD_HEIGHT_HD;
+    lv_area_t area;
+
+    area.x1 = grid->coords.x1 + col_start * osd_width;
+    area.y1 = grid->coords.y1 + row * osd_height;
+    area.x2 = grid->coords.x1 + (col_end + 1) * osd_width - 1;
+    area.y2 = area.y1 + osd_height - 1;
+    lv_obj_invalidate_area(grid, &area);
+}
+
+// draws the glyphs of the cells in the area being refreshed straight into
+// LVGL's draw buffer, there is no pixel buffer of the whole grid
+static void osd_grid_draw_cb(lv_event_t *e) {
+    lv_obj_t *grid = lv_event_get_target(e);
+    lv_draw_ctx_t *draw_ctx = lv_event_get_draw_ctx(e);
+    bool fhd = (grid == osd_grid[1]);
+    int osd_width = fhd ? OSD_WIDTH_FHD : OSD_WIDTH_HD;
+    int osd_height = fhd ? OSD_HEIGHT_FHD : OSD_HEIGHT_HD;
+    lv_draw_img_dsc_t img_dsc;
+    const uint32_t *glyph;
+    lv_area_t clip, cell;
+
+    if (!_lv_area_intersect(&clip, draw_ctx->clip_area, &grid->coords))
+        return;
+
+    lv_draw_img_dsc_init(&img_dsc);
+
+    int row_end = (clip.y2 - grid->coords.y1) / osd_height;
+    int col_end = (clip.x2 - grid->coords.x1) / osd_width;
+
+    for (int row = (clip.y1 - grid->coords.y1) / osd_height; row <= row_end && row < HD_VMAX; row++) {
+        for (int col = (clip.x1 - grid->coords.x1) / osd_width; col <= col_end && col < HD_HMAX; col++) {
+            uint16_t index = osd_cells[row][col];
+            if (index == OSD_CELL_EMPTY)
+                continue;
+
+            if (fhd)
+                glyph = &osdFont_fhd[index / OSD_HNUM][index % OSD_HNUM][0][0];
+            else
+                glyph = &osdFont_hd[index / OSD_HNUM][index % OSD_HNUM][0][0];
+
+            cell.x1 = grid->coords.x1 + col * osd_width;
+            cell.y1 = grid->coords.y1 + row * osd_height;
+            cell.x2 = cell.x1 + osd_width - 1;
+            cell.y2 = cell.y1 + osd_height - 1;
+            // the font tables are already in the display's pixel format
+            lv_draw_img_decoded(draw_ctx, &img_dsc, &cell, (const uint8_t *)glyph, LV_IMG_CF_TRUE_COLOR);
+        }
+    }
 }
 
 static void embedded_osd_init(uint8_t fhd) {
@@ -942,15 +1005,16 @@ static void fc_osd_init(uint8_t fhd, uint16_t OFFSET_X, uint16_t OFFSET_Y) {
 
     load_fc_osd_font(fhd);
 
-    for (int i = 0; i < HD_VMAX; i++) {
-        for (int j = 0; j < HD_HMAX; j++) {
-            pthread_mutex_lock(&lvgl_mutex);
-            img_arr[fhd][i][j] = lv_img_create(scr_osd[fhd]);
-            lv_obj_set_size(img_arr[fhd][i][j], osd_width, osd_height);
-            lv_obj_set_pos(img_arr[fhd][i][j], j * osd_width + OFFSET_X, i * osd_height + OFFSET_Y);
-            pthread_mutex_unlock(&lvgl_mutex);
-        }
-    }
+    pthread_mutex_lock(&lvgl_mutex);
+    if (!fhd)
+        memset(osd_cells, 0xFF, sizeof(osd_cells));
+    osd_grid[fhd] = lv_obj_create(scr_osd[fhd]);
+    lv_obj_remove_style_all(osd_grid[fhd]);
+    lv_obj_clear_flag(osd_grid[fhd], LV_OBJ_FLAG_SCROLLABLE | LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_set_size(osd_grid[fhd], HD_HMAX * osd_width, HD_VMAX * osd_height);
+    lv_obj_set_pos(osd_grid[fhd], OFFSET_X, OFFSET_Y);
+    lv_obj_add_event_cb(osd_grid[fhd], osd_grid_draw_cb, LV_EVENT_DRAW_MAIN, NULL);
+    pthread_mutex_unlock(&lvgl_mutex);
 
 #if defined(HDZBOXPRO) || defined(HDZGOGGLE2)
     if (!fhd) {
@@ -1075,33 +1139,6 @@ int load_fc_osd_font_bmp(const char *file, uint8_t fhd) {
         }
     }
 
-    if (fhd) {
-        for (v = 0; v < OSD_VNUM; v++) {
-            for (h = 0; h < OSD_HNUM; h++) {
-                int index = v * OSD_HNUM + h;
-                osd_font_fhd.data[index].header.cf = LV_IMG_CF_TRUE_COLOR;
-                osd_font_fhd.data[index].header.always_zero = 0;
-                osd_font_fhd.data[index].header.reserved = 0;
-                osd_font_fhd.data[index].header.w = osd_width;
-                osd_font_fhd.data[index].header.h = osd_height;
-                osd_font_fhd.data[index].data_size = osd_width * osd_height * LV_COLOR_SIZE / 8;
-                osd_font_fhd.data[index].data = (uint8_t *)&osdFont_fhd[v][h][0][0];
-            }
-        }
-    } else {
-        for (v = 0; v < OSD_VNUM; v++) {
-            for (h = 0; h < OSD_HNUM; h++) {
-                int index = v * OSD_HNUM + h;
-                osd_font_hd.data[index].header.cf = LV_IMG_CF_TRUE_COLOR;
-                osd_font_hd.data[index].header.always_zero = 0;
-                osd_font_hd.data[index].header.reserved = 0;
-                osd_font_hd.data[index].header.w = osd_width;
-                osd_font_hd.data[index].header.h = osd_height;
-                osd_font_hd.data[index].data_size = osd_width * osd_height * LV_COLOR_SIZE / 8;
-                osd_font_hd.data[index].data = (uint8_t *)&osdFont_hd[v][h][0][0];
-            }
-        }
-    }
     // free(buf); //FIX ME, ntant, it seems system becomes unstable if uncomment this ???
     return 0;
 }
@@ -1157,21 +1194,149 @@ void load_fc_osd_font(uint8_t fhd) {
     for (i = 0; i < 3; i++) {
         if (!load_fc_osd_font_bmp(fp[i], fhd)) {
             LOGI(" succecss!");
+            osd_redraw_all = true;
             return;
         } else
             LOGE(" failed!");
     }
 }
 
-void osd_shadow_clear(void) {
+///////////////////////////////////////////////////////////////////////////////
+// Batched FC OSD rendering
+//
+// Changed cells are collected into osd_dirty[] first and then drawn in a
+// single lvgl_mutex critical section, instead of locking once per cell.
+#define OSD_BLANK_CHAR 0x20
+#define OSD_BLANK_WORD ((OSD_BLANK_CHAR << 16) | OSD_BLANK_CHAR)
+
+_Static_assert((HD_HMAX % 2) == 0, "osd rows are compared two cells at a time");
+
+typedef struct {
+    uint8_t row;
+    uint8_t col;
+} osd_cell_t;
+
+// logged by the OSD thread once a period while the FC OSD is changing
+#define OSD_STATS_PERIOD_MS 60000
+
+typedef struct {
+    uint32_t since_ms;
+    uint32_t frames;      // frames with at least one changed cell
+    uint32_t cells;       // changed cells over those frames
+    uint32_t hold_us;     // lvgl_mutex hold time over those frames
+    uint32_t hold_max_us; // worst lvgl_mutex hold time of one frame
+} osd_render_stats_t;
+
+static osd_cell_t osd_dirty[HD_VMAX * HD_HMAX];
+static osd_render_stats_t osd_render_stats;
+
+static inline uint32_t osd_load_word(const uint16_t *p) {
+    uint32_t w;
+    memcpy(&w, p, sizeof(w));
+    return w;
+}
+
+// blank fc_osd cells let the elrs_osd cell underneath show through
+static inline uint32_t osd_merge_word(uint32_t fc, uint32_t elrs) {
+    if (fc == OSD_BLANK_WORD)
+        return elrs;
+
+    if ((fc & 0xFFFF) == OSD_BLANK_CHAR)
+        fc = (fc & 0xFFFF0000) | (elrs & 0xFFFF);
+    if ((fc >> 16) == OSD_BLANK_CHAR)
+        fc = (fc & 0xFFFF) | (elrs & 0xFFFF0000);
+    return fc;
+}
+
+// diff fc_osd/elrs_osd against osd_buf_shadow, update the shadow and
+// return the number of changed cells stored in osd_dirty[]
+static int osd_collect_dirty(void) {
+    int n = 0;
+
     for (int i = 0; i < HD_VMAX; i++) {
-        for (int j = 0; j < HD_HMAX; j++) {
-            if (osd_buf_shadow[i][j] != 0x20) {
-                osd_buf_shadow[i][j] = 0x20;
-                draw_osd_on_screen(i, j);
+        for (int j = 0; j < HD_HMAX; j += 2) {
+            uint32_t ch = osd_merge_word(osd_load_word(&fc_osd[i][j]), osd_load_word(&elrs_osd[i][j]));
+            uint32_t sh = osd_load_word(&osd_buf_shadow[i][j]);
+            if (ch == sh)
+                continue;
+
+            uint16_t prev[2];
+            memcpy(prev, &sh, sizeof(prev));
+            memcpy(&osd_buf_shadow[i][j], &ch, sizeof(ch));
+
+            for (int k = 0; k < 2; k++) {
+                if (osd_buf_shadow[i][j + k] != prev[k]) {
+                    osd_dirty[n].row = i;
+                    osd_dirty[n].col = j + k;
+                    n++;
+                }
             }
         }
     }
+    return n;
+}
+
+static void osd_draw_dirty(int n) {
+    uint64_t t0;
+    uint32_t hold;
+
+    if (n == 0)
+        return;
+
+    pthread_mutex_lock(&lvgl_mutex);
+    t0 = time_us();
+    for (int k = 0, start = 0; k < n; k++) {
+        draw_osd_on_screen(osd_dirty[k].row, osd_dirty[k].col);
+
+        // invalidate each horizontal run of changed cells as one rectangle
+        if (k + 1 == n ||
+            osd_dirty[k + 1].row != osd_dirty[k].row ||
+            osd_dirty[k + 1].col != osd_dirty[k].col + 1) {
+            osd_invalidate_cells(osd_dirty[k].row, osd_dirty[start].col, osd_dirty[k].col);
+            start = k + 1;
+        }
+    }
+    hold = time_us() - t0;
+    pthread_mutex_unlock(&lvgl_mutex);
+
+    event_loop_post(EVENT_LOOP_OSD);
+
+    osd_render_stats.frames++;
+    osd_render_stats.cells += n;
+    osd_render_stats.hold_us += hold;
+    if (hold > osd_render_stats.hold_max_us)
+        osd_render_stats.hold_max_us = hold;
+}
+
+static void osd_log_render_stats(void) {
+    osd_render_stats_t *stats = &osd_render_stats;
+    uint32_t now_ms = time_ms();
+
+    if (stats->since_ms == 0) {
+        stats->since_ms = now_ms;
+        return;
+    }
+    if (now_ms - stats->since_ms < OSD_STATS_PERIOD_MS)
+        return;
+
+    if (stats->frames) {
+        LOGI("osd: %u frames in %u s, %u cells/frame, lvgl_mutex held %u us/frame, max %u us",
+             stats->frames, (now_ms - stats->since_ms) / 1000, stats->cells / stats->frames,
+             stats->hold_us / stats->frames, stats->hold_max_us);
+    }
+    memset(stats, 0, sizeof(*stats));
+    stats->since_ms = now_ms;
+}
+
+// clear the grid and force every cell to be redrawn, needed whenever the
+// shared cells change layout or font
+static void osd_grid_reset(void) {
+    pthread_mutex_lock(&lvgl_mutex);
+    memset(osd_cells, 0xFF, sizeof(osd_cells));
+    lv_obj_invalidate(osd_grid[is_fhd]);
+    pthread_mutex_unlock(&lvgl_mutex);
+
+    memset(osd_buf_shadow, 0xFF, sizeof(osd_buf_shadow));
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -1187,24 +1352,16 @@ void *thread_osd(void *ptr) {
         // wait for signal to render
         sem_wait(&osd_semaphore);
 
-        // clear shadow buffer when mode changes
-        if (fhd_d != is_fhd) {
-            osd_shadow_clear();
+        // redraw everything when mode or font changes
+        if (fhd_d != is_fhd || osd_redraw_all) {
+            osd_redraw_all = false;
             fhd_d = is_fhd;
+            osd_grid_reset();
         }
 
         // display osd
-        for (int i = 0; i < HD_VMAX; i++) {
-            for (int j = 0; j < HD_HMAX; j++) {
-                uint16_t ch = fc_osd[i][j];
-                if (ch == 0x20)
-                    ch = elrs_osd[i][j];
-                if (ch != osd_buf_shadow[i][j]) {
-                    osd_buf_shadow[i][j] = ch;
-                    draw_osd_on_screen(i, j);
-                }
-            }
-        }
+        osd_draw_dirty(osd_collect_dirty());
+        osd_log_render_stats();
     }
     return NULL;
-}
\ No newline at end of file
+}
@@ -82,10 +82,6 @@ typedef struct
     bitMAPINFOHEADER info;
 } __attribute__((packed)) bmpFileHead;
 
-typedef struct {
-    lv_img_dsc_t data[512];
-} osd_font_t;
-
 extern uint8_t channel_osd_mode;
 
 int osd_init(void);
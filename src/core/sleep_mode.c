@@ -1,6 +1,7 @@
 #include "sleep_mode.h"
 
 #include "core/app_state.h"
+#include "core/channel_monitor.h"
 #include "core/common.hh"
 #include "core/dvr.h"
 #include "core/settings.h"
@@ -11,12 +12,13 @@
 #include "driver/rtc6715.h"
 #include "log/log.h"
 #include "ui/page_fans.h"
+#include "util/time.h"
 
 static app_state_t previousState;
 static int fans_auto_mode_save;
 static fan_speed_t fan_speed_save;
 
-static uint16_t beepCnt = 0;
+static uint32_t beepMs = 0;
 
 bool isSleeping = false;
 
@@ -36,6 +38,7 @@ void go_sleep() {
     hw_screen_on(0);
 
     // Turn off HDZero Receiver
+    channel_monitor_join();
     HDZero_Close();
 
     // Turn off Analog Receiver
@@ -57,7 +60,7 @@ void go_sleep() {
     fans_left_setspeed(MIN_FAN_SIDE);
     fans_right_setspeed(MIN_FAN_SIDE);
     isSleeping = true;
-    beepCnt = 0;
+    beepMs = time_ms();
 }
 
 void wake_up() {
@@ -90,9 +93,9 @@ void sleep_reminder() {
         return;
     }
 
-#define BEEP_INTERVAL 4000
-    if (++beepCnt == BEEP_INTERVAL) {
+#define BEEP_INTERVAL 20000 // ms
+    if (time_ms() - beepMs >= BEEP_INTERVAL) {
         beep_dur(BEEP_VERY_SHORT);
-        beepCnt = 0;
+        beepMs = time_ms();
     }
 }
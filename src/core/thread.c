@@ -12,9 +12,11 @@
 
 #include "core/app_state.h"
 #include "core/battery.h"
+#include "core/channel_monitor.h"
 #include "core/common.hh"
 #include "core/defines.h"
 #include "core/dvr.h"
+#include "core/event_loop.h"
 #include "core/input_device.h"
 #include "core/msp_displayport.h"
 #include "core/osd.h"
@@ -227,6 +229,8 @@ static void *thread_peripheral(void *ptr) {
             g_latency_locked = (bool)Get_VideoLatancy_status();
             check_source_signal(record_vtmg_change);
             record_vtmg_change = 0;
+
+            event_loop_post(EVENT_LOOP_SENSOR);
         }
         j++;
         usleep(2000);
@@ -243,6 +247,7 @@ static void threads_instance(threads_obj_t *obj) {
     obj->instance[1] = thread_version;
     obj->instance[2] = thread_osd;
     obj->instance[3] = thread_rtc6715_rssi;
+    obj->instance[4] = thread_channel_monitor;
 }
 
 int create_threads() {
@@ -11,6 +11,8 @@
 #include "../core/common.hh"
 #include "defines.h"
 #include "dm5680.h"
+#include "dm6302_regs.h"
+#include "hwio.h"
 #include "i2c.h"
 #include "uart.h"
 #include "util/system.h"
@@ -18,67 +20,62 @@
 #define WAIT(ms) usleep((ms) * 1000)
 
 void SPI_Read(uint8_t page, uint16_t addr, uint32_t *dat0, uint32_t *dat1) {
-    uint8_t val;
-    uint32_t rdat;
+    i2c_txn_t txn;
+    uint8_t rdat[8];
+
+    I2C_TxnBeginStop(&txn);
 
     // spi_addr
-    val = addr & 0xFF;
-    I2C_Write(ADDR_FPGA, 0x91, val);
-    val = (page << 4) | (addr >> 8);
-    I2C_Write(ADDR_FPGA, 0x92, val);
+    i2c_txn_write(&txn, ADDR_FPGA, 0x91, addr & 0xFF);
+    i2c_txn_write(&txn, ADDR_FPGA, 0x92, (page << 4) | (addr >> 8));
 
     // read cmd
-    I2C_Write(ADDR_FPGA, 0x90, 0x10);
-
-    // read dat
-    rdat = I2C_Read(ADDR_FPGA, 0x9b);
-    rdat <<= 8;
-    rdat |= I2C_Read(ADDR_FPGA, 0x9a);
-    rdat <<= 8;
-    rdat |= I2C_Read(ADDR_FPGA, 0x99);
-    rdat <<= 8;
-    rdat |= I2C_Read(ADDR_FPGA, 0x98);
-    *dat0 = rdat;
-
-    rdat = I2C_Read(ADDR_FPGA, 0x9f);
-    rdat <<= 8;
-    rdat |= I2C_Read(ADDR_FPGA, 0x9e);
-    rdat <<= 8;
-    rdat |= I2C_Read(ADDR_FPGA, 0x9d);
-    rdat <<= 8;
-    rdat |= I2C_Read(ADDR_FPGA, 0x9c);
-    *dat1 = rdat;
+    i2c_txn_write(&txn, ADDR_FPGA, 0x90, 0x10);
+    i2c_txn_submit(&txn);
+
+    // read dat, once the command went out
+    for (int i = 0; i < 8; i++) {
+        i2c_txn_read(&txn, ADDR_FPGA, 0x98 + i, &rdat[i], 1);
+    }
+    if (i2c_txn_submit(&txn) < 0) {
+        memset(rdat, 0, sizeof(rdat));
+    }
+
+    *dat0 = rdat[0] | (rdat[1] << 8) | (rdat[2] << 16) | ((uint32_t)rdat[3] << 24);
+    *dat1 = rdat[4] | (rdat[5] << 8) | (rdat[6] << 16) | ((uint32_t)rdat[7] << 24);
 
 #ifdef _DEBUG_DM6300
     LOGI("SPI READ: addr=%x  data=  %x  %x", addr, (*dat1), (*dat0));
 #endif
 }
 
-void SPI_Write(uint8_t sel, uint8_t page, uint16_t addr, uint32_t dat) {
-    uint8_t val;
-    uint32_t r1 = 0, r0 = 0;
-
+// queue one register write to the bridge
+static void SPI_Queue(i2c_txn_t *txn, uint8_t sel, uint8_t page, uint16_t addr, uint32_t dat) {
     // spi_addr
-    val = addr & 0xFF;
-    I2C_Write(ADDR_FPGA, 0x91, val);
-    val = (page << 4) | (addr >> 8);
-    I2C_Write(ADDR_FPGA, 0x92, val);
+    i2c_txn_write(txn, ADDR_FPGA, 0x91, addr & 0xFF);
+    i2c_txn_write(txn, ADDR_FPGA, 0x92, (page << 4) | (addr >> 8));
 
     // spi_wdat
-    val = dat & 0xFF;
-    I2C_Write(ADDR_FPGA, 0x93, val);
-    val = (dat >> 8) & 0xFF;
-    I2C_Write(ADDR_FPGA, 0x94, val);
-    val = (dat >> 16) & 0xFF;
-    I2C_Write(ADDR_FPGA, 0x95, val);
-    val = (dat >> 24) & 0xFF;
-    I2C_Write(ADDR_FPGA, 0x96, val);
+    i2c_txn_write(txn, ADDR_FPGA, 0x93, dat & 0xFF);
+    i2c_txn_write(txn, ADDR_FPGA, 0x94, (dat >> 8) & 0xFF);
+    i2c_txn_write(txn, ADDR_FPGA, 0x95, (dat >> 16) & 0xFF);
+    i2c_txn_write(txn, ADDR_FPGA, 0x96, (dat >> 24) & 0xFF);
 
     // wrte cmd
     if (sel == 0)
-        I2C_Write(ADDR_FPGA, 0x90, 0x03);
+        i2c_txn_write(txn, ADDR_FPGA, 0x90, 0x03);
     else
-        I2C_Write(ADDR_FPGA, 0x90, sel);
+        i2c_txn_write(txn, ADDR_FPGA, 0x90, sel);
+}
+
+void SPI_Write(uint8_t sel, uint8_t page, uint16_t addr, uint32_t dat) {
+    i2c_txn_t txn;
+    uint32_t r1 = 0, r0 = 0;
+
+    // the whole register under one hold of the port lock
+    I2C_TxnBeginStop(&txn);
+    SPI_Queue(&txn, sel, page, addr, dat);
+    i2c_txn_submit(&txn);
 
 #ifdef _DEBUG_DM6300
     SPI_Read(page, addr, &r0, &r1);
@@ -95,1080 +92,100 @@ void SPI_Write(uint8_t sel, uint8_t page, uint16_t addr, uint32_t dat) {
 #endif
 }
 
-uint32_t tab[3][20] = {
-    // 0x120
-    {
-        // race band
-        0x3741,
-        0x379D,
-        0x37FA,
-        0x3856,
-        0x38B3,
-        0x390F,
-        0x396C,
-        0x39C8,
-
-        // e band
-        0x38DF, // E1
-
-        //  fatshark band
-        0x3938, // F1
-        0x3840, // F2
-        0x38A4, // F4
-
-        // low band
-        0x3574,
-        0x35D2,
-        0x3631,
-        0x368F,
-        0x36ED,
-        0x374C,
-        0x37AA,
-        0x3809,
-    },
-    // 0x104
-    {
-        // race band
-        0x93,
-        0x94,
-        0x95,
-        0x96,
-        0x97,
-        0x98,
-        0x99,
-        0x9A,
-
-        // e band
-        0x94, // E1
-
-        // fatshark band
-        0x95, // F1
-        0x96, // F2
-        0x97, // F4
-
-        // low band
-        0x8B,
-        0x8C,
-        0x8D,
-        0x8E,
-        0x8F,
-        0x90,
-        0x91,
-        0x92,
-    },
-    // 0x108
-    {
-        // race band
-        0xB00000,
-        0x9D5555,
-        0x8AAAAB,
-        0x780000,
-        0x655555,
-        0x52AAAB,
-        0x400000,
-        0x2D5555,
-
-        // e band
-        0X122AAAB, // E1
-
-        // fatshark band
-        0XF55555, // F1
-        0x000000, // F2
-        0x155555, // F4
-
-        // low band
-        0x1455555,
-        0x132AAAB,
-        0x1200000,
-        0x10D5555,
-        0xFAAAAB,
-        0xE80000,
-        0xD55555,
-        0xC2AAAB,
-    },
-};
-
-void DM6302_SetChannel(uint8_t band, uint8_t ch) {
-    // band
-    // 1: lowband
-    // 0: race band
-    if (band == 1)
-        ch = ch + BASE_CH_NUM;
-    SPI_Write(0, 0x6, 0xFF0, 0x00000018);
-    SPI_Write(0, 0x3, 0x130, 0x00000013);
-    SPI_Write(0, 0x3, 0x134, 0x00000013);
-    SPI_Write(0, 0x3, 0x138, 0x00000370);
-    SPI_Write(0, 0x3, 0x13C, 0x00000410);
-    SPI_Write(0, 0x3, 0x140, 0x00000000);
-    if (band == 1 || ch == 8 || ch == 9) {
-        SPI_Write(0, 0x3, 0x144, 0x15240735);
-    } else {
-        SPI_Write(0, 0x3, 0x144, 0x0D640735);
-    }
-
-    SPI_Write(0, 0x3, 0x148, 0x01017F03);
-    if (band == 1 || ch == 8 || ch == 9) {
-        SPI_Write(0, 0x3, 0x14C, 0x021288A2);
-    } else {
-        SPI_Write(0, 0x3, 0x14C, 0x022288A2);
-    }
-    SPI_Write(0, 0x3, 0x150, 0x00FFCF33);
-    if (band == 1 || ch == 8 || ch == 9) {
-        SPI_Write(0, 0x3, 0x154, 0x1F2C3840);
-        SPI_Write(0, 0x3, 0x128, 0x00008031);
-    } else {
-        SPI_Write(0, 0x3, 0x154, 0x1F0C3440);
-        SPI_Write(0, 0x3, 0x128, 0x00008030);
-    }
-    SPI_Write(0, 0x3, 0x120, tab[0][ch]); // ch
-
-    SPI_Write(0, 0x3, 0x11C, 0x00000002);
-    SPI_Write(0, 0x3, 0x118, 0x00000001);
-    SPI_Write(0, 0x3, 0x118, 0x00000000);
-    if (band == 1 || ch == 8 || ch == 9) {
-        SPI_Write(0, 0x3, 0x128, 0x00008031);
-    } else {
-        SPI_Write(0, 0x3, 0x128, 0x00008030);
-    }
-    SPI_Write(0, 0x3, 0x120, tab[0][ch]); // ch
-    SPI_Write(0, 0x3, 0x11C, 0x00000003);
-    SPI_Write(0, 0x3, 0x118, 0x00000001);
-    SPI_Write(0, 0x3, 0x118, 0x00000000);
-    SPI_Write(0, 0x3, 0x150, 0x00FFCFB3);
-    SPI_Write(0, 0x3, 0x104, tab[1][ch]); // ch
-    SPI_Write(0, 0x3, 0x108, tab[2][ch]); // ch
-    SPI_Write(0, 0x3, 0x100, 0x00000000);
-    SPI_Write(0, 0x3, 0x100, 0x00000003);
-    SPI_Write(0, 0x3, 0x150, 0x000333B3);
-    if (band == 1 || ch == 8 || ch == 9) {
-        SPI_Write(0, 0x3, 0x140, 0x07070002);
-    } else {
-        SPI_Write(0, 0x3, 0x140, 0x07070000);
-    }
-    SPI_Write(0, 0x3, 0x130, 0x00000010);
-}
-
-void DM6302_M0() {
-    uint32_t i;
-    uint32_t dat[] = {
-        0x0000C118,
-        0x000000D5,
-        0x00000135,
-        0x0000010D,
-        0x000003A0,
-        0x00000000,
-        0x00000000,
-        0x00000000,
-        0x00000000,
-        0x00000000,
-        0x00000000,
-        0x000002B1,
-        0x00000000,
-        0x00000000,
-        0x00000137,
-        0x000002B5,
-        0x00000000,
-        0x00000000,
-        0x00000000,
-        0x00000000,
-        0x00000000,
-        0x00000000,
-        0x00000000,
-        0x00000000,
-        0x00000000,
-        0x00000000,
-        0x00000000,
-        0x00000000,
-        0x00000000,
-        0x00000000,
-        0x00000000,
-        0x00000000,
-        0x00000000,
-        0x00000000,
-        0x00000175,
-        0x00000000,
-        0x00000000,
-        0x00000139,
-        0x00000000,
-        0x00000000,
-        0x00000000,
-        0x00000000,
-        0x00000000,
-        0x00000000,
-        0x00000000,
-        0x00000000,
-        0x00000000,
-        0x00000000,
-        0x46854803,
-        0xF810F000,
-        0x47004800,
-        0x000002F5,
-        0x0000C118,
-        0x47004803,
-        0xE7FEE7FE,
-        0xE7FEE7FE,
-        0xE7FEE7FE,
-        0x000000C1,
-        0x25014C06,
-        0xE0054E06,
-        0xCC0768E3,
-        0x3C0C432B,
-        0x34104798,
-        0xD3F742B4,
-        0xFFE2F7FF,
-        0x00000368,
-        0x00000388,
-        0x4802B672,
-        0x60480641,
-        0xE7FDBF30,
-        0x01233210,
-        0x28014904,
-        0x2000D003,
-        0x628843C0,
-        0x20004770,
-        0x0000E7FB,
-        0x00201080,
-        0x47704770,
-        0x2000B510,
-        0xFFEEF7FF,
-        0x07412021,
-        0x21006008,
-        0x43C94808,
-        0x00496281,
-        0x48076281,
-        0x21016A42,
-        0x430A0549,
-        0x6A426242,
-        0x6242438A,
-        0xF7FF2001,
-        0xBD10FFD9,
-        0x00200700,
-        0x00201080,
-        0x2000B510,
-        0xFFD0F7FF,
-        0x21012018,
-        0x60080749,
-        0x48092100,
-        0x610143C9,
-        0x61010049,
-        0x6A424807,
-        0x04892101,
-        0x6242430A,
-        0x438A6A42,
-        0x20016242,
-        0xFFBAF7FF,
-        0x0000BD10,
-        0x00200740,
-        0x00201080,
-        0x2800B5F0,
-        0x4938D03C,
-        0x4C386809,
-        0x0082B24B,
-        0x250A58A1,
-        0x17CD4369,
-        0x18690F2D,
-        0x4934110D,
-        0x58892606,
-        0x43711A59,
-        0x50A11869,
-        0xD02A2800,
-        0x3C084C2D,
-        0x4D2C6827,
-        0x3D904C2E,
-        0x2F1C2698,
-        0x2800D024,
-        0x4928D03A,
-        0x68093908,
-        0x01BF270F,
-        0xD13A42B9,
-        0x58894928,
-        0xDD3D4299,
-        0x4B224925,
-        0x3B783118,
-        0xD02C2800,
-        0x6814461A,
-        0x28002500,
-        0x461AD029,
-        0x28006015,
-        0x4619D000,
-        0xBDF0600C,
-        0x3190491C,
-        0x4C1BE7C0,
-        0xE7D33488,
-        0xDA232900,
-        0x0F9217CA,
-        0x22671851,
-        0x43D21089,
-        0x233F1A51,
-        0x43DBB249,
-        0xDD014291,
-        0xDB004299,
-        0x28004619,
-        0x462CD000,
-        0xBDF06021,
-        0xBDF06026,
-        0x3188490D,
-        0x460AE7C3,
-        0x460AE7D1,
-        0x2800E7D4,
-        0x4906D008,
-        0x68093908,
-        0xD0F02900,
-        0xD0ED2800,
-        0xE7EB462C,
-        0x31884904,
-        0x0000E7F5,
-        0x00200BB0,
-        0x0000C000,
-        0x0000C008,
-        0x00200920,
-        0x0000C010,
-        0x00004770,
-        0x20FFB510,
-        0x02004C05,
-        0x20006120,
-        0xFF78F7FF,
-        0xF7FF2001,
-        0x2000FF75,
-        0xBD106120,
-        0x00201000,
-        0xC808E002,
-        0xC1081F12,
-        0xD1FA2A00,
-        0x47704770,
-        0xE0012000,
-        0x1F12C101,
-        0xD1FB2A00,
-        0x00004770,
-        0x69814816,
-        0x12094B16,
-        0x1E49B249,
-        0x69806019,
-        0xB2411400,
-        0x30084618,
-        0x49126001,
-        0x1212698A,
-        0x1E52B252,
-        0x6989605A,
-        0xB2491409,
-        0x480F6041,
-        0x6141490D,
-        0x2207490E,
-        0x021B69CB,
-        0x04440A1B,
-        0x61CB4323,
-        0x61812100,
-        0xB6626102,
-        0x302420FF,
-        0x07492101,
-        0xBF306048,
-        0x0000E7FD,
-        0x00200940,
-        0x0000C008,
-        0x00200B40,
-        0x000002FF,
-        0xE000E000,
-        0xE000ED04,
-        0x00000388,
-        0x0000C000,
-        0x00000018,
-        0x000002D4,
-        0x000003A0,
-        0x0000C018,
-        0x00000100,
-        0x000002E4,
-        0x00000000,
-        0x00000000,
-        0x00000000,
-        0x00000000,
-        0x00000000,
-        0x00000000,
-        0x31323032,
-        0x2D36302D,
-        0x31203332,
-        0x32323A30,
-        0x2036313A};
-
-    SPI_Write(0, 0x6, 0xFF0, 0x00000000);
-    for (i = 0; i < 237; i++) {
-        SPI_Write(0, 0x3, i << 2, dat[i]);
-    }
+// Registers written back to back, SPI_regsPerXFER of them under one hold of
+// the port lock. 6 take the 42 messages of a transaction, 1 sends them like
+// SPI_Write.
+#define SPI_regsPerXFER 6
 
-    /*SPI_Write(0, 0x6, 0xFF0, 0x00000001);
-    for(i=1024;i<1329;i++){
-        SPI_Write(0, 0x3, i<<2, dat[i]);
-    }*/
+typedef struct {
+    i2c_txn_t txn;
+    int nregs;
+} spi_stream_t;
 
-    SPI_Write(0, 0x6, 0x7FC, 0x00000000);
-    // SPI_Write(0, 0x6, 0x7FC, 0x00000001);
+static void SPI_StreamBegin(spi_stream_t *st) {
+    I2C_TxnBeginStop(&st->txn);
+    st->nregs = 0;
 }
 
-void DM6302_Init0(uint8_t sel) {
-    // 00_INIT
-    SPI_Write(sel, 0x6, 0x7FC, 0x00000000);
-    SPI_Write(sel, 0x6, 0xF1C, 0x00000001);
-    SPI_Write(sel, 0x6, 0xF20, 0x0000FCD0);
-    SPI_Write(sel, 0x6, 0xF04, 0x00004741); // 0x00004741
-    SPI_Write(sel, 0x6, 0xF08, 0x00000083);
-    SPI_Write(sel, 0x6, 0xF08, 0x000000C3);
-    SPI_Write(sel, 0x6, 0xF24, 0x00007000); // 0x00007000
-    SPI_Write(sel, 0x6, 0xF40, 0x00000003);
-    SPI_Write(sel, 0x6, 0xF40, 0x00000001);
-    SPI_Write(sel, 0x6, 0xFFC, 0x00000000);
-    SPI_Write(sel, 0x6, 0xFFC, 0x00000001);
-    SPI_Write(sel, 0x6, 0xFF0, 0x00000018);
+static void SPI_StreamEnd(spi_stream_t *st) {
+    i2c_txn_submit(&st->txn);
+    st->nregs = 0;
 }
 
-void DM6302_Init1(uint8_t sel, uint8_t bw) {
-    // 01_BB_PLL_3456
-    if (bw) {
-        SPI_Write(sel, 0x6, 0xFF0, 0x00000018);
-        SPI_Write(sel, 0x3, 0x2B0, 0x00077777);
-        SPI_Write(sel, 0x3, 0x230, 0x00000000);
-        SPI_Write(sel, 0x3, 0x234, 0x10000000);
-        SPI_Write(sel, 0x3, 0x238, 0x000000BF);
-        SPI_Write(sel, 0x3, 0x23C, 0x55530610);
-        SPI_Write(sel, 0x3, 0x240, 0x3FFC0047);
-        SPI_Write(sel, 0x3, 0x244, 0x00188A13);
-        SPI_Write(sel, 0x3, 0x248, 0x00000000);
-        SPI_Write(sel, 0x3, 0x24C, 0x0A121707);
-        SPI_Write(sel, 0x3, 0x250, 0x017F0001);
-        SPI_Write(sel, 0x3, 0x228, 0x0000807C);
-        SPI_Write(sel, 0x3, 0x220, 0x0000292C);
-        SPI_Write(sel, 0x3, 0x21C, 0x00000002);
-        SPI_Write(sel, 0x3, 0x218, 0x00000001);
-        SPI_Write(sel, 0x3, 0x218, 0x00000000);
-        SPI_Write(sel, 0x3, 0x228, 0x0000807C);
-        SPI_Write(sel, 0x3, 0x220, 0x0000292C);
-        SPI_Write(sel, 0x3, 0x21C, 0x00000003);
-        SPI_Write(sel, 0x3, 0x218, 0x00000001);
-        SPI_Write(sel, 0x3, 0x218, 0x00000000);
-        SPI_Write(sel, 0x3, 0x244, 0x00188A17);
-        SPI_Write(sel, 0x3, 0x204, 0x0000002A);
-        SPI_Write(sel, 0x3, 0x208, 0x00400000);
-        SPI_Write(sel, 0x3, 0x200, 0x00000000);
-        SPI_Write(sel, 0x3, 0x200, 0x00000003);
-        SPI_Write(sel, 0x3, 0x240, 0x00030041);
-        SPI_Write(sel, 0x3, 0x248, 0x00000404);
-    } else {
-        SPI_Write(sel, 0x6, 0xFF0, 0x00000018);
-        SPI_Write(sel, 0x3, 0x2ac, 0x00000300);
-        SPI_Write(sel, 0x3, 0x2B0, 0x00077777); // dcxo_pathbuf_sel
-        SPI_Write(sel, 0x3, 0x230, 0x00000000);
-        SPI_Write(sel, 0x3, 0x234, 0x10000000);
-        SPI_Write(sel, 0x3, 0x238, 0x000000BF);
-        SPI_Write(sel, 0x3, 0x23C, 0x73530610); // 55530610,
-        SPI_Write(sel, 0x3, 0x240, 0x3FFC0047);
-        SPI_Write(sel, 0x3, 0x244, 0x00188A13);
-        SPI_Write(sel, 0x3, 0x248, 0x00000000);
-        SPI_Write(sel, 0x3, 0x24C, 0x0A121707);
-        SPI_Write(sel, 0x3, 0x250, 0x017F0001);
-        SPI_Write(sel, 0x3, 0x228, 0x0000807A); // coarse tune freq calibra
-        SPI_Write(sel, 0x3, 0x220, 0x00002AE4);
-        SPI_Write(sel, 0x3, 0x21C, 0x00000002);
-        SPI_Write(sel, 0x3, 0x218, 0x00000001);
-        SPI_Write(sel, 0x3, 0x218, 0x00000000);
-        SPI_Write(sel, 0x3, 0x228, 0x0000807A); // fine tune freq calibra
-        SPI_Write(sel, 0x3, 0x220, 0x00002AE4);
-        SPI_Write(sel, 0x3, 0x21C, 0x00000003);
-        SPI_Write(sel, 0x3, 0x218, 0x00000001);
-        SPI_Write(sel, 0x3, 0x218, 0x00000000);
-        SPI_Write(sel, 0x3, 0x244, 0x00188A17);
-        SPI_Write(sel, 0x3, 0x204, 0x0000002D); // int div ratio
-        SPI_Write(sel, 0x3, 0x208, 0x00000000); // fracn div ratio
-        SPI_Write(sel, 0x3, 0x200, 0x00000000); // sdm en
-        SPI_Write(sel, 0x3, 0x200, 0x00000003);
-        SPI_Write(sel, 0x3, 0x240, 0x00030041); // pll close loop
-        SPI_Write(sel, 0x3, 0x248, 0x00000404);
+static void SPI_StreamWrite(spi_stream_t *st, uint8_t sel, uint8_t page, uint16_t addr, uint32_t dat) {
+#ifdef _DEBUG_DM6300
+    SPI_Write(sel, page, addr, dat); // read back each one
+#else
+    SPI_Queue(&st->txn, sel, page, addr, dat);
+    if (++st->nregs == SPI_regsPerXFER) {
+        SPI_StreamEnd(st);
     }
+#endif
 }
 
-void DM6302_Init2(uint8_t sel, uint8_t freq) {
-    // 02_RX1_PLL_11316(5658MHz)
-    SPI_Write(sel, 0x6, 0xFF0, 0x00000018);
-    SPI_Write(sel, 0x3, 0x130, 0x00000013); // 0x00000013 10
-    SPI_Write(sel, 0x3, 0x134, 0x00000013);
-    SPI_Write(sel, 0x3, 0x138, 0x00000370);
-    SPI_Write(sel, 0x3, 0x13C, 0x00000410);
-    SPI_Write(sel, 0x3, 0x140, 0x00000000);
-    SPI_Write(sel, 0x3, 0x144, 0x0D640735);
-    SPI_Write(sel, 0x3, 0x148, 0x01017F03);
-    SPI_Write(sel, 0x3, 0x14C, 0x022288A2); // 0x021288A2
-    SPI_Write(sel, 0x3, 0x150, 0x00FFCF33); // 0x00FFCF33
-    SPI_Write(sel, 0x3, 0x154, 0x1F0C3440); // 0x1F3C3C40 0x1F0C3440
-    SPI_Write(sel, 0x3, 0x128, 0x00008030);
-    SPI_Write(sel, 0x3, 0x120, tab[0][freq]); // ch
-    SPI_Write(sel, 0x3, 0x11C, 0x00000002);
-    SPI_Write(sel, 0x3, 0x118, 0x00000001);
-    SPI_Write(sel, 0x3, 0x118, 0x00000000);
-    SPI_Write(sel, 0x3, 0x128, 0x00008030);
-    SPI_Write(sel, 0x3, 0x120, tab[0][freq]); // ch
-    SPI_Write(sel, 0x3, 0x11C, 0x00000003);
-    SPI_Write(sel, 0x3, 0x118, 0x00000001);
-    SPI_Write(sel, 0x3, 0x118, 0x00000000);
-    SPI_Write(sel, 0x3, 0x150, 0x00FFCFB3);
-    SPI_Write(sel, 0x3, 0x104, tab[1][freq]); // ch
-    SPI_Write(sel, 0x3, 0x108, tab[2][freq]); // ch
-    SPI_Write(sel, 0x3, 0x100, 0x00000000);
-    SPI_Write(sel, 0x3, 0x100, 0x00000003);
-    SPI_Write(sel, 0x3, 0x150, 0x000333B3);
-    SPI_Write(sel, 0x3, 0x140, 0x07070000);
-    SPI_Write(sel, 0x3, 0x130, 0x00000010);
-}
+// write a register sequence, the tables of the other bandwidth are left out
+static void DM6302_exec(uint8_t sel, const dm6302_seq_t *seq, uint8_t bw, uint8_t ch) {
+    spi_stream_t st;
 
-void DM6302_Init3(uint8_t sel) {
-    // 03_RX1_RF
-    SPI_Write(sel, 0x6, 0xFF0, 0x00000018);
-    SPI_Write(sel, 0x3, 0x480, 0x60FFFFFF);
-    SPI_Write(sel, 0x3, 0x484, 0xFFFFF7FF);
-    SPI_Write(sel, 0x3, 0x488, 0x0FFF7FE0); // 0x0FFF7FE0
-    SPI_Write(sel, 0x3, 0x48C, 0x00000001);
-    SPI_Write(sel, 0x3, 0x490, 0x34460E01);
-    SPI_Write(sel, 0x3, 0x494, 0x066727CC); // 0x066427CC
-    SPI_Write(sel, 0x3, 0x498, 0x00000002); // 0x00001020
-    SPI_Write(sel, 0x3, 0x49C, 0x00001020);
-    SPI_Write(sel, 0x3, 0x4A0, 0x00001020);
-    SPI_Write(sel, 0x3, 0x4A4, 0x00001030);
-    SPI_Write(sel, 0x3, 0x4A8, 0x00001030);
-    SPI_Write(sel, 0x3, 0x4AC, 0x8102040D);
-    SPI_Write(sel, 0x3, 0x4B0, 0x00000964);
-    SPI_Write(sel, 0x3, 0x4B4, 0x00000000);
-    SPI_Write(sel, 0x3, 0x4B8, 0x00000000);
-}
+    bw = bw ? DM6302_bw17M : DM6302_bw27M;
 
-void DM6302_Init4(uint8_t sel, uint8_t bw) {
-    // 04_RX1_BBF
-    if (bw) {
-        SPI_Write(sel, 0x6, 0xFF0, 0x00000018);
-        SPI_Write(sel, 0x3, 0x500, 0x0F85FF49);
-        SPI_Write(sel, 0x3, 0x504, 0x1488809A);
-        SPI_Write(sel, 0x3, 0x508, 0x1488609A);
-        SPI_Write(sel, 0x3, 0x50C, 0x1F828216);
-        SPI_Write(sel, 0x3, 0x510, 0x00040C49);
-        SPI_Write(sel, 0x3, 0x514, 0x12088230);
-        SPI_Write(sel, 0x3, 0x518, 0x02509439);
-        SPI_Write(sel, 0x3, 0x51C, 0x0294A541);
-        SPI_Write(sel, 0x3, 0x520, 0x02E4B94B);
-        SPI_Write(sel, 0x3, 0x524, 0x06719CAA);
-        SPI_Write(sel, 0x3, 0x528, 0x83A4E962);
-        SPI_Write(sel, 0x3, 0x52C, 0x141506E0);
-        SPI_Write(sel, 0x3, 0x530, 0x60410411);
-        SPI_Write(sel, 0x3, 0x534, 0x40820823);
-        SPI_Write(sel, 0x3, 0x538, 0x01051057);
-        SPI_Write(sel, 0x3, 0x53C, 0x020B20BF);
-        SPI_Write(sel, 0x3, 0x540, 0x0300000B);
-        SPI_Write(sel, 0x3, 0x544, 0x05001300);
-        SPI_Write(sel, 0x3, 0x548, 0x0000000A);
-        SPI_Write(sel, 0x3, 0x54C, 0x00000000);
-        SPI_Write(sel, 0x3, 0x550, 0x0000002F);
-        SPI_Write(sel, 0x3, 0x554, 0x00000100);
-        SPI_Write(sel, 0x3, 0x558, 0x00000500);
-        SPI_Write(sel, 0x3, 0x55C, 0x00000000);
-        SPI_Write(sel, 0x3, 0x560, 0x00000000);
-        SPI_Write(sel, 0x3, 0x564, 0x00000007);
-        SPI_Write(sel, 0x3, 0x568, 0x00000000);
-        SPI_Write(sel, 0x3, 0x56C, 0x00000000);
-    } else {
-        SPI_Write(sel, 0x6, 0xFF0, 0x00000018);
-        SPI_Write(sel, 0x3, 0x500, 0x0F85FF49);
-        SPI_Write(sel, 0x3, 0x504, 0x1488809A);
-        SPI_Write(sel, 0x3, 0x508, 0x1488809A);
-        SPI_Write(sel, 0x3, 0x50C, 0x1F616110);
-        SPI_Write(sel, 0x3, 0x510, 0x00040C49);
-        SPI_Write(sel, 0x3, 0x514, 0x11846130);
-        SPI_Write(sel, 0x3, 0x518, 0x01B86E39);
-        SPI_Write(sel, 0x3, 0x51C, 0x01F07C41);
-        SPI_Write(sel, 0x3, 0x520, 0x02288A4B);
-        SPI_Write(sel, 0x3, 0x524, 0x026C9B55);
-        SPI_Write(sel, 0x3, 0x528, 0x82B8AE62);
-        SPI_Write(sel, 0x3, 0x52C, 0x1310C470);
-        SPI_Write(sel, 0x3, 0x530, 0x60300301);
-        SPI_Write(sel, 0x3, 0x534, 0x40610613);
-        SPI_Write(sel, 0x3, 0x538, 0x00C40C47);
-        SPI_Write(sel, 0x3, 0x53C, 0x0188188F);
-        SPI_Write(sel, 0x3, 0x540, 0x00010B00);
-        SPI_Write(sel, 0x3, 0x544, 0x00090900);
-        SPI_Write(sel, 0x3, 0x548, 0x0000000A);
-        SPI_Write(sel, 0x3, 0x54C, 0x00000000);
-        SPI_Write(sel, 0x3, 0x550, 0x0000002F);
-        SPI_Write(sel, 0x3, 0x554, 0x00000100);
-        SPI_Write(sel, 0x3, 0x55C, 0x00000000);
-        SPI_Write(sel, 0x3, 0x560, 0x00000000);
-        SPI_Write(sel, 0x3, 0x564, 0x00000007);
-        SPI_Write(sel, 0x3, 0x568, 0x00000000);
-    }
-}
+    SPI_StreamBegin(&st);
+    for (; seq->regs; seq++) {
+        if (seq->bw != DM6302_bwANY && seq->bw != bw)
+            continue;
 
-void DM6302_Init5(uint8_t sel, uint8_t bw) {
-    // 05_RX1_ADC
-    if (bw) {
-        SPI_Write(sel, 0x6, 0xFF0, 0x00000018);
-        SPI_Write(sel, 0x3, 0x728, 0xFFFFFFFE);
-        SPI_Write(sel, 0x3, 0x72C, 0x22C42273);
-        SPI_Write(sel, 0x3, 0x730, 0x14208208);
-        SPI_Write(sel, 0x3, 0x734, 0x0040B208);
-        SPI_Write(sel, 0x3, 0x738, 0x22C42273);
-        SPI_Write(sel, 0x3, 0x73C, 0x14208208);
-        SPI_Write(sel, 0x3, 0x740, 0x0040B208);
-        SPI_Write(sel, 0x3, 0x744, 0x00A20001);
-        SPI_Write(sel, 0x3, 0x748, 0x00004300);
-        SPI_Write(sel, 0x3, 0x74C, 0x00000000);
-    } else {
-        SPI_Write(sel, 0x6, 0xFF0, 0x00000018);
-        SPI_Write(sel, 0x3, 0x728, 0xFFFFFFFE);
-        SPI_Write(sel, 0x3, 0x72C, 0x22C42273);
-        SPI_Write(sel, 0x3, 0x730, 0x141E81E8);
-        SPI_Write(sel, 0x3, 0x734, 0x0040B1E8);
-        SPI_Write(sel, 0x3, 0x738, 0x22C42273);
-        SPI_Write(sel, 0x3, 0x73C, 0x141E81E8);
-        SPI_Write(sel, 0x3, 0x740, 0x0040B1E8);
-        SPI_Write(sel, 0x3, 0x744, 0x00A20001);
-        SPI_Write(sel, 0x3, 0x748, 0x00004400);
-        SPI_Write(sel, 0x3, 0x74C, 0x00000000);
-    }
-}
+        for (int i = 0; i < seq->len; i++) {
+            const dm6302_reg_t *reg = &seq->regs[i];
 
-void DM6302_Init6(uint8_t sel, uint8_t bw) {
-    // 06_RX1_DFE
-    SPI_Write(sel, 0x6, 0xFF0, 0x00000019);
-    SPI_Write(sel, 0x3, 0x0E4, 0x0000000C);
-    SPI_Write(sel, 0x3, 0x0E8, 0x00000003);
-
-    if (bw) {
-        SPI_Write(sel, 0x6, 0xFF0, 0x00000018);
-        SPI_Write(sel, 0x3, 0x254, 0x0055780F); // ADC1=ADC2=3264/8=408
-        SPI_Write(sel, 0x3, 0x258, 0x00010003); // RBDP=3264/8=408
-        SPI_Write(sel, 0x3, 0x908, 0x001FFF03);
-        SPI_Write(sel, 0x3, 0x90C, 0xDEA3C008); // ADC=408/2,FBCLK=ADC/4=51
-        SPI_Write(sel, 0x3, 0x880, 0x0000001C); // GAIN
-        SPI_Write(sel, 0x3, 0x938, 0x00000082); // AGC
-    } else {
-        SPI_Write(sel, 0x6, 0xFF0, 0x00000018);
-        SPI_Write(sel, 0x3, 0x254, 0x0055780F); // ADC1=ADC2=3456/8=432
-        SPI_Write(sel, 0x3, 0x258, 0x00010002); // RBDP=3456/8=432
-        SPI_Write(sel, 0x3, 0x908, 0x001FFF03); // 0x001FFF03
-        SPI_Write(sel, 0x3, 0x90C, 0xDE07E0F0); // ADC=432/2,FBCLK=ADC/4=54  0xDE07E0F0
-        SPI_Write(sel, 0x3, 0x880, 0x0000001C); // GAIN
-        SPI_Write(sel, 0x3, 0x938, 0x00000082); // AGC 0x00000082
-    }
-}
-
-void DM6302_Init7(uint8_t sel, uint8_t bw) {
-    // 07_RX1_FIR
-    if (bw) {
-        SPI_Write(sel, 0x6, 0xFF0, 0x00000018);
-        SPI_Write(sel, 0x3, 0x800, 0x00100006);
-        SPI_Write(sel, 0x3, 0x804, 0x002E001E);
-        SPI_Write(sel, 0x3, 0x808, 0x003F003C);
-        SPI_Write(sel, 0x3, 0x80C, 0x000D0031);
-        SPI_Write(sel, 0x3, 0x810, 0xFF97FFD6);
-        SPI_Write(sel, 0x3, 0x814, 0xFF4AFF61);
-        SPI_Write(sel, 0x3, 0x818, 0xFFC0FF67);
-        SPI_Write(sel, 0x3, 0x81C, 0x00EE004D);
-        SPI_Write(sel, 0x3, 0x820, 0x01B20177);
-        SPI_Write(sel, 0x3, 0x824, 0x00A50172);
-        SPI_Write(sel, 0x3, 0x828, 0xFDE7FF60);
-        SPI_Write(sel, 0x3, 0x82C, 0xFC06FCA0);
-        SPI_Write(sel, 0x3, 0x830, 0xFE68FC87);
-        SPI_Write(sel, 0x3, 0x834, 0x060801AC);
-        SPI_Write(sel, 0x3, 0x838, 0x0F900AE9);
-        SPI_Write(sel, 0x3, 0x83C, 0x15371336);
-        SPI_Write(sel, 0x3, 0x840, 0x13361537);
-        SPI_Write(sel, 0x3, 0x844, 0x0AE90F90);
-        SPI_Write(sel, 0x3, 0x848, 0x01AC0608);
-        SPI_Write(sel, 0x3, 0x84C, 0xFC87FE68);
-        SPI_Write(sel, 0x3, 0x850, 0xFCA0FC06);
-        SPI_Write(sel, 0x3, 0x854, 0xFF60FDE7);
-        SPI_Write(sel, 0x3, 0x858, 0x017200A5);
-        SPI_Write(sel, 0x3, 0x85C, 0x017701B2);
-        SPI_Write(sel, 0x3, 0x860, 0x004D00EE);
-        SPI_Write(sel, 0x3, 0x864, 0xFF67FFC0);
-        SPI_Write(sel, 0x3, 0x868, 0xFF61FF4A);
-        SPI_Write(sel, 0x3, 0x86C, 0xFFD6FF97);
-        SPI_Write(sel, 0x3, 0x870, 0x0031000D);
-        SPI_Write(sel, 0x3, 0x874, 0x003C003F);
-        SPI_Write(sel, 0x3, 0x878, 0x001E002E);
-        SPI_Write(sel, 0x3, 0x87C, 0x00060010);
-    } else {
-        SPI_Write(sel, 0x6, 0xFF0, 0x00000018);
-        SPI_Write(sel, 0x3, 0x800, 0x000E000A);
-        SPI_Write(sel, 0x3, 0x804, 0xFFEFFFF4);
-        SPI_Write(sel, 0x3, 0x808, 0x00140010);
-        SPI_Write(sel, 0x3, 0x80C, 0xFFE9FFEA);
-        SPI_Write(sel, 0x3, 0x810, 0x0018001D);
-        SPI_Write(sel, 0x3, 0x814, 0xFFE7FFDA);
-        SPI_Write(sel, 0x3, 0x818, 0x0018002F);
-        SPI_Write(sel, 0x3, 0x81C, 0xFFEAFFC5);
-        SPI_Write(sel, 0x3, 0x820, 0x00110047);
-        SPI_Write(sel, 0x3, 0x824, 0xFFF6FFAC);
-        SPI_Write(sel, 0x3, 0x828, 0x00000062);
-        SPI_Write(sel, 0x3, 0x82C, 0x000DFF8F);
-        SPI_Write(sel, 0x3, 0x830, 0xFFE3007F);
-        SPI_Write(sel, 0x3, 0x834, 0x0032FF73);
-        SPI_Write(sel, 0x3, 0x838, 0xFFB6009B);
-        SPI_Write(sel, 0x3, 0x83C, 0x0068FF59);
-        SPI_Write(sel, 0x3, 0x840, 0xFF7600B0);
-        SPI_Write(sel, 0x3, 0x844, 0x00B1FF49);
-        SPI_Write(sel, 0x3, 0x848, 0xFF2100BA);
-        SPI_Write(sel, 0x3, 0x84C, 0x0112FF48);
-        SPI_Write(sel, 0x3, 0x850, 0xFEB400B0);
-        SPI_Write(sel, 0x3, 0x854, 0x018EFF5F);
-        SPI_Write(sel, 0x3, 0x858, 0xFE280089);
-        SPI_Write(sel, 0x3, 0x85C, 0x022EFF9B);
-        SPI_Write(sel, 0x3, 0x860, 0xFD6E0032);
-        SPI_Write(sel, 0x3, 0x864, 0x030A0015);
-        SPI_Write(sel, 0x3, 0x868, 0xFC5EFF87);
-        SPI_Write(sel, 0x3, 0x86C, 0x046E0109);
-        SPI_Write(sel, 0x3, 0x870, 0xFA61FE1B);
-        SPI_Write(sel, 0x3, 0x874, 0x07BB035C);
-        SPI_Write(sel, 0x3, 0x878, 0xF304F990);
-        SPI_Write(sel, 0x3, 0x87C, 0x3B341183);
+            if (reg->page == DM6302_pageWAIT) {
+                SPI_StreamEnd(&st);
+                usleep(reg->dat);
+            } else if (reg->ch) {
+                SPI_StreamWrite(&st, sel, reg->page, reg->addr, dm6302_ch_tab[reg->ch - 1][ch]);
+            } else {
+                SPI_StreamWrite(&st, sel, reg->page, reg->addr, reg->dat);
+            }
+        }
     }
+    SPI_StreamEnd(&st);
 }
 
-void DM6302_Init8(uint8_t sel) {
-    // 08_RX1_AGC
-    SPI_Write(sel, 0x6, 0xFF0, 0x00000018);
-    SPI_Write(sel, 0x3, 0x880, 0x003C001C);
-    SPI_Write(sel, 0x3, 0x884, 0x007C005C);
-    SPI_Write(sel, 0x3, 0x888, 0x00BC009C);
-    SPI_Write(sel, 0x3, 0x88C, 0x013C011C);
-    SPI_Write(sel, 0x3, 0x890, 0x017C015C);
-    SPI_Write(sel, 0x3, 0x894, 0x01BC019C);
-    SPI_Write(sel, 0x3, 0x898, 0x023C01DC);
-    SPI_Write(sel, 0x3, 0x89C, 0x027C025C);
-    SPI_Write(sel, 0x3, 0x8A0, 0x02BC029C);
-    SPI_Write(sel, 0x3, 0x8A4, 0x033C02DC);
-    SPI_Write(sel, 0x3, 0x8A8, 0x037C035C);
-    SPI_Write(sel, 0x3, 0x8AC, 0x03BC039C);
-    SPI_Write(sel, 0x3, 0x8B0, 0x033403DC);
-    SPI_Write(sel, 0x3, 0x8B4, 0x03740354);
-    SPI_Write(sel, 0x3, 0x8B8, 0x03B40394);
-    SPI_Write(sel, 0x3, 0x8BC, 0x032C03D4);
-    SPI_Write(sel, 0x3, 0x8C0, 0x036C034C);
-    SPI_Write(sel, 0x3, 0x8C4, 0x03AC038C);
-    SPI_Write(sel, 0x3, 0x8C8, 0x032403CC);
-    SPI_Write(sel, 0x3, 0x8CC, 0x03640344);
-    SPI_Write(sel, 0x3, 0x8D0, 0x03A40384);
-    SPI_Write(sel, 0x3, 0x8D4, 0x038303C4);
-    SPI_Write(sel, 0x3, 0x8D8, 0x03C303A3);
-    SPI_Write(sel, 0x3, 0x8DC, 0x03A20382);
-    SPI_Write(sel, 0x3, 0x8E0, 0x032103C2);
-    SPI_Write(sel, 0x3, 0x8E4, 0x03610341);
-    SPI_Write(sel, 0x3, 0x8E8, 0x03A10381);
-    SPI_Write(sel, 0x3, 0x8EC, 0x032003C1);
-    SPI_Write(sel, 0x3, 0x8F0, 0x03600340);
-    SPI_Write(sel, 0x3, 0x8F4, 0x03A00380);
-    SPI_Write(sel, 0x3, 0x8F8, 0x03C103C0);
-    SPI_Write(sel, 0x3, 0x8FC, 0x03C303C2);
-    SPI_Write(sel, 0x3, 0x8FC, 0x03C503C4);
-    SPI_Write(sel, 0x3, 0x900, 0x03C703C6);
-    SPI_Write(sel, 0x3, 0x904, 0x03C903C8);
-    SPI_Write(sel, 0x3, 0x93C, 0x0001FF00); // 0x0002FF00
-    SPI_Write(sel, 0x3, 0x944, 0x00004300);
-    SPI_Write(sel, 0x3, 0x948, 0x00010000); // 0x00001000
-    SPI_Write(sel, 0x3, 0x958, 0x00FCFE00); // 0x00FCFE00
-    SPI_Write(sel, 0x3, 0x960, 0x0000B278); // 0x0000B260
-    SPI_Write(sel, 0x3, 0x938, 0x0000100A); // 0x0000101A
-    SPI_Write(sel, 0x3, 0x968, 0x00000020);
-    SPI_Write(sel, 0x3, 0x974, 0x0058001F);
-    SPI_Write(sel, 0x3, 0x978, 0x00000000);
-    SPI_Write(sel, 0x3, 0x52C, 0x1310C470);
-    SPI_Write(sel, 0x3, 0x530, 0x98300301);
-    SPI_Write(sel, 0x3, 0x534, 0x40610613);
-    SPI_Write(sel, 0x3, 0x4B0, 0x00000964);
-    SPI_Write(sel, 0x3, 0x970, 0x0000003F);
-    SPI_Write(sel, 0x3, 0x940, 0x00050A0A);
-    SPI_Write(sel, 0x3, 0x94C, 0x10001000);
-}
-
-void DM6302_Init9(uint8_t sel) {
-    // 09_RX2_RF
-    SPI_Write(sel, 0x6, 0xFF0, 0x00000018);
-    SPI_Write(sel, 0x3, 0x4C0, 0x6000F001);
-    SPI_Write(sel, 0x3, 0x4C4, 0x00000000);
-    SPI_Write(sel, 0x3, 0x4C8, 0x00006048);
-    SPI_Write(sel, 0x3, 0x4CC, 0x00000001);
-    SPI_Write(sel, 0x3, 0x4D0, 0x34460E01);
-    SPI_Write(sel, 0x3, 0x4D4, 0x066727CC); // 0x066427CC
-    SPI_Write(sel, 0x3, 0x4D8, 0x00000002); // 0x00001020
-    SPI_Write(sel, 0x3, 0x4DC, 0x00001020);
-    SPI_Write(sel, 0x3, 0x4E0, 0x00001020);
-    SPI_Write(sel, 0x3, 0x4E4, 0x00001030);
-    SPI_Write(sel, 0x3, 0x4E8, 0x00001030);
-    SPI_Write(sel, 0x3, 0x4EC, 0x8102040D);
-    SPI_Write(sel, 0x3, 0x4F0, 0x00000964);
-    SPI_Write(sel, 0x3, 0x4F4, 0x00000000);
-    SPI_Write(sel, 0x3, 0x4F8, 0x00000000);
-}
+void DM6302_SetChannel(uint8_t band, uint8_t ch) {
+    // band
+    // 1: lowband
+    // 0: race band
+    if (band == 1)
+        ch = ch + BASE_CH_NUM;
 
-void DM6302_Init10(uint8_t sel, uint8_t bw) {
-    // 10_RX2_BBF
-    if (bw) {
-        SPI_Write(sel, 0x6, 0xFF0, 0x00000018);
-        SPI_Write(sel, 0x3, 0x600, 0x0F85FF49);
-        SPI_Write(sel, 0x3, 0x604, 0x1488809A);
-        SPI_Write(sel, 0x3, 0x608, 0x1488609A);
-        SPI_Write(sel, 0x3, 0x60C, 0x1F828216);
-        SPI_Write(sel, 0x3, 0x610, 0x00040C49);
-        SPI_Write(sel, 0x3, 0x614, 0x12088230);
-        SPI_Write(sel, 0x3, 0x618, 0x02509439);
-        SPI_Write(sel, 0x3, 0x61C, 0x0294A541);
-        SPI_Write(sel, 0x3, 0x620, 0x02E4B94B);
-        SPI_Write(sel, 0x3, 0x624, 0x06719CAA);
-        SPI_Write(sel, 0x3, 0x628, 0x83A4E962);
-        SPI_Write(sel, 0x3, 0x62C, 0x141506E0);
-        SPI_Write(sel, 0x3, 0x630, 0x60410411);
-        SPI_Write(sel, 0x3, 0x634, 0x40820823);
-        SPI_Write(sel, 0x3, 0x638, 0x01051057);
-        SPI_Write(sel, 0x3, 0x63C, 0x020B20BF);
-        SPI_Write(sel, 0x3, 0x640, 0x0300000B);
-        SPI_Write(sel, 0x3, 0x644, 0x05001300);
-        SPI_Write(sel, 0x3, 0x648, 0x0000000A);
-        SPI_Write(sel, 0x3, 0x64C, 0x00000000);
-        SPI_Write(sel, 0x3, 0x650, 0x0000002F);
-        SPI_Write(sel, 0x3, 0x654, 0x00000100);
-        SPI_Write(sel, 0x3, 0x658, 0x00000500);
-        SPI_Write(sel, 0x3, 0x65C, 0x00000000);
-        SPI_Write(sel, 0x3, 0x660, 0x00000000);
-        SPI_Write(sel, 0x3, 0x664, 0x00000007);
-        SPI_Write(sel, 0x3, 0x668, 0x00000000);
-        SPI_Write(sel, 0x3, 0x66C, 0x00000000);
+    if (band == 1 || ch == 8 || ch == 9) {
+        DM6302_exec(0, dm6302_seq_rx_pll_low, 0, ch);
     } else {
-        SPI_Write(sel, 0x6, 0xFF0, 0x00000018);
-        SPI_Write(sel, 0x3, 0x600, 0x0F85FF49);
-        SPI_Write(sel, 0x3, 0x604, 0x1488809A);
-        SPI_Write(sel, 0x3, 0x608, 0x1488809A);
-        SPI_Write(sel, 0x3, 0x60C, 0x1F616110);
-        SPI_Write(sel, 0x3, 0x610, 0x00040C49);
-        SPI_Write(sel, 0x3, 0x614, 0x11846130);
-        SPI_Write(sel, 0x3, 0x618, 0x01B86E39);
-        SPI_Write(sel, 0x3, 0x61C, 0x01F07C41);
-        SPI_Write(sel, 0x3, 0x620, 0x02288A4B);
-        SPI_Write(sel, 0x3, 0x624, 0x026C9B55);
-        SPI_Write(sel, 0x3, 0x628, 0x82B8AE62);
-        SPI_Write(sel, 0x3, 0x62C, 0x1310C470);
-        SPI_Write(sel, 0x3, 0x630, 0x60300301);
-        SPI_Write(sel, 0x3, 0x634, 0x40610613);
-        SPI_Write(sel, 0x3, 0x638, 0x00C40C47);
-        SPI_Write(sel, 0x3, 0x63C, 0x0188188F);
-        SPI_Write(sel, 0x3, 0x640, 0x00010B00);
-        SPI_Write(sel, 0x3, 0x644, 0x00090900);
-        SPI_Write(sel, 0x3, 0x648, 0x0000000A);
-        SPI_Write(sel, 0x3, 0x64C, 0x00000000);
-        SPI_Write(sel, 0x3, 0x650, 0x0000002F);
-        SPI_Write(sel, 0x3, 0x654, 0x00000100);
-        SPI_Write(sel, 0x3, 0x65C, 0x00000000);
-        SPI_Write(sel, 0x3, 0x660, 0x00000000);
-        SPI_Write(sel, 0x3, 0x664, 0x00000007);
-        SPI_Write(sel, 0x3, 0x668, 0x00000000);
+        DM6302_exec(0, dm6302_seq_rx_pll, 0, ch);
     }
 }
 
-void DM6302_Init11(uint8_t sel, uint8_t bw) {
-    // 11_RX2_ADC
-    if (bw) {
-        SPI_Write(sel, 0x6, 0xFF0, 0x00000018);
-        SPI_Write(sel, 0x3, 0x750, 0xFFFFFFFE);
-        SPI_Write(sel, 0x3, 0x754, 0x22C42273);
-        SPI_Write(sel, 0x3, 0x758, 0x14208208);
-        SPI_Write(sel, 0x3, 0x75C, 0x0040B208);
-        SPI_Write(sel, 0x3, 0x760, 0x22C42273);
-        SPI_Write(sel, 0x3, 0x764, 0x14208208);
-        SPI_Write(sel, 0x3, 0x768, 0x0040B208);
-        SPI_Write(sel, 0x3, 0x76C, 0x00A20001);
-        SPI_Write(sel, 0x3, 0x770, 0x00004300);
-        SPI_Write(sel, 0x3, 0x774, 0x00000000);
-    } else {
-        SPI_Write(sel, 0x6, 0xFF0, 0x00000018);
-        SPI_Write(sel, 0x3, 0x750, 0xFFFFFFFE);
-        SPI_Write(sel, 0x3, 0x754, 0x22C42273);
-        SPI_Write(sel, 0x3, 0x758, 0x141E81E8);
-        SPI_Write(sel, 0x3, 0x75C, 0x0040B1E8);
-        SPI_Write(sel, 0x3, 0x760, 0x22C42273);
-        SPI_Write(sel, 0x3, 0x764, 0x141E81E8);
-        SPI_Write(sel, 0x3, 0x768, 0x0040B1E8);
-        SPI_Write(sel, 0x3, 0x76C, 0x00A20001);
-        SPI_Write(sel, 0x3, 0x770, 0x00004400);
-        SPI_Write(sel, 0x3, 0x774, 0x00000000);
-    }
-}
+void DM6302_M0() {
+    spi_stream_t st;
+    uint32_t i;
 
-void DM6302_Init12(uint8_t sel, uint8_t bw) {
-    // 12_RX2_FIR
-    if (bw) {
-        SPI_Write(sel, 0x6, 0xFF0, 0x00000018);
-        SPI_Write(sel, 0x3, 0xA00, 0x00100006);
-        SPI_Write(sel, 0x3, 0xA04, 0x002E001E);
-        SPI_Write(sel, 0x3, 0xA08, 0x003F003C);
-        SPI_Write(sel, 0x3, 0xA0C, 0x000D0031);
-        SPI_Write(sel, 0x3, 0xA10, 0xFF97FFD6);
-        SPI_Write(sel, 0x3, 0xA14, 0xFF4AFF61);
-        SPI_Write(sel, 0x3, 0xA18, 0xFFC0FF67);
-        SPI_Write(sel, 0x3, 0xA1C, 0x00EE004D);
-        SPI_Write(sel, 0x3, 0xA20, 0x01B20177);
-        SPI_Write(sel, 0x3, 0xA24, 0x00A50172);
-        SPI_Write(sel, 0x3, 0xA28, 0xFDE7FF60);
-        SPI_Write(sel, 0x3, 0xA2C, 0xFC06FCA0);
-        SPI_Write(sel, 0x3, 0xA30, 0xFE68FC87);
-        SPI_Write(sel, 0x3, 0xA34, 0x060801AC);
-        SPI_Write(sel, 0x3, 0xA38, 0x0F900AE9);
-        SPI_Write(sel, 0x3, 0xA3C, 0x15371336);
-        SPI_Write(sel, 0x3, 0xA40, 0x13361537);
-        SPI_Write(sel, 0x3, 0xA44, 0x0AE90F90);
-        SPI_Write(sel, 0x3, 0xA48, 0x01AC0608);
-        SPI_Write(sel, 0x3, 0xA4C, 0xFC87FE68);
-        SPI_Write(sel, 0x3, 0xA50, 0xFCA0FC06);
-        SPI_Write(sel, 0x3, 0xA54, 0xFF60FDE7);
-        SPI_Write(sel, 0x3, 0xA58, 0x017200A5);
-        SPI_Write(sel, 0x3, 0xA5C, 0x017701B2);
-        SPI_Write(sel, 0x3, 0xA60, 0x004D00EE);
-        SPI_Write(sel, 0x3, 0xA64, 0xFF67FFC0);
-        SPI_Write(sel, 0x3, 0xA68, 0xFF61FF4A);
-        SPI_Write(sel, 0x3, 0xA6C, 0xFFD6FF97);
-        SPI_Write(sel, 0x3, 0xA70, 0x0031000D);
-        SPI_Write(sel, 0x3, 0xA74, 0x003C003F);
-        SPI_Write(sel, 0x3, 0xA78, 0x001E002E);
-        SPI_Write(sel, 0x3, 0xA7C, 0x00060010);
-    } else {
-        SPI_Write(sel, 0x6, 0xFF0, 0x00000018);
-        SPI_Write(sel, 0x3, 0xA00, 0x000E000A);
-        SPI_Write(sel, 0x3, 0xA04, 0xFFEFFFF4);
-        SPI_Write(sel, 0x3, 0xA08, 0x00140010);
-        SPI_Write(sel, 0x3, 0xA0C, 0xFFE9FFEA);
-        SPI_Write(sel, 0x3, 0xA10, 0x0018001D);
-        SPI_Write(sel, 0x3, 0xA14, 0xFFE7FFDA);
-        SPI_Write(sel, 0x3, 0xA18, 0x0018002F);
-        SPI_Write(sel, 0x3, 0xA1C, 0xFFEAFFC5);
-        SPI_Write(sel, 0x3, 0xA20, 0x00110047);
-        SPI_Write(sel, 0x3, 0xA24, 0xFFF6FFAC);
-        SPI_Write(sel, 0x3, 0xA28, 0x00000062);
-        SPI_Write(sel, 0x3, 0xA2C, 0x000DFF8F);
-        SPI_Write(sel, 0x3, 0xA30, 0xFFE3007F);
-        SPI_Write(sel, 0x3, 0xA34, 0x0032FF73);
-        SPI_Write(sel, 0x3, 0xA38, 0xFFB6009B);
-        SPI_Write(sel, 0x3, 0xA3C, 0x0068FF59);
-        SPI_Write(sel, 0x3, 0xA40, 0xFF7600B0);
-        SPI_Write(sel, 0x3, 0xA44, 0x00B1FF49);
-        SPI_Write(sel, 0x3, 0xA48, 0xFF2100BA);
-        SPI_Write(sel, 0x3, 0xA4C, 0x0112FF48);
-        SPI_Write(sel, 0x3, 0xA50, 0xFEB400B0);
-        SPI_Write(sel, 0x3, 0xA54, 0x018EFF5F);
-        SPI_Write(sel, 0x3, 0xA58, 0xFE280089);
-        SPI_Write(sel, 0x3, 0xA5C, 0x022EFF9B);
-        SPI_Write(sel, 0x3, 0xA60, 0xFD6E0032);
-        SPI_Write(sel, 0x3, 0xA64, 0x030A0015);
-        SPI_Write(sel, 0x3, 0xA68, 0xFC5EFF87);
-        SPI_Write(sel, 0x3, 0xA6C, 0x046E0109);
-        SPI_Write(sel, 0x3, 0xA70, 0xFA61FE1B);
-        SPI_Write(sel, 0x3, 0xA74, 0x07BB035C);
-        SPI_Write(sel, 0x3, 0xA78, 0xF304F990);
-        SPI_Write(sel, 0x3, 0xA7C, 0x3B341183);
+    SPI_StreamBegin(&st);
+    SPI_StreamWrite(&st, 0, 0x6, 0xFF0, 0x00000000);
+    for (i = 0; i < DM6302_m0LEN; i++) {
+        SPI_StreamWrite(&st, 0, 0x3, i << 2, dm6302_m0[i]);
     }
-}
 
-void DM6302_Init13(uint8_t sel, uint8_t bw) {
-    // 13_RX2_DFE
-    if (bw) {
-        SPI_Write(sel, 0x6, 0xFF0, 0x00000019);
-        SPI_Write(sel, 0x3, 0x080, 0x1B318C0C); // RBDP=432/8,CLKOUT=432/4
-        SPI_Write(sel, 0x3, 0x084, 0x00000004);
-        SPI_Write(sel, 0x3, 0x088, 0x00000205); // TDD,2PORT,2T2R 0x00000005
-        SPI_Write(sel, 0x3, 0x018, 0xE4F15E3C);
-        SPI_Write(sel, 0x3, 0x01C, 0x0001C140);
-        SPI_Write(sel, 0x3, 0x020, 0x0000000D);
-
-        SPI_Write(sel, 0x6, 0xFF0, 0x00000018);
-        SPI_Write(sel, 0x3, 0xB08, 0x001FFF03); // 0x001FFF03
-        SPI_Write(sel, 0x3, 0xB0C, 0xDEA3C008); // 0xDE07E0F0
-        SPI_Write(sel, 0x3, 0xA80, 0x0000001C); // GAIN
-        SPI_Write(sel, 0x3, 0xB38, 0x00000082); // AGC 0x00000082
-    } else {
-        SPI_Write(sel, 0x6, 0xFF0, 0x00000019);
-        SPI_Write(sel, 0x3, 0x080, 0x1004210C); // RBDP=432/8,CLKOUT=432/4
-        SPI_Write(sel, 0x3, 0x084, 0x00000004);
-        SPI_Write(sel, 0x3, 0x088, 0x00000205); // TDD,2PORT,2T2R 0x00000005
-        SPI_Write(sel, 0x3, 0x018, 0xE4F15E3C);
-        SPI_Write(sel, 0x3, 0x01C, 0x0001C140);
-        SPI_Write(sel, 0x3, 0x020, 0x0000000D);
-
-        SPI_Write(sel, 0x6, 0xFF0, 0x00000018);
-        SPI_Write(sel, 0x3, 0xB08, 0x001FFF03); // 0x001FFF03
-        SPI_Write(sel, 0x3, 0xB0C, 0xDE07E0F0); // 0xDE07E0F0
-        SPI_Write(sel, 0x3, 0xA80, 0x0000001C); // GAIN
-        SPI_Write(sel, 0x3, 0xB38, 0x00000082); // AGC 0x00000082
-    }
-}
+    /*SPI_Write(0, 0x6, 0xFF0, 0x00000001);
+    for(i=1024;i<1329;i++){
+        SPI_Write(0, 0x3, i<<2, dat[i]);
+    }*/
 
-void DM6302_Init14(uint8_t sel, uint8_t bw) {
-    // 14_RX2_AGC
-    SPI_Write(sel, 0x6, 0xFF0, 0x00000018);
-    SPI_Write(sel, 0x3, 0xA80, 0x003C001C);
-    SPI_Write(sel, 0x3, 0xA84, 0x007C005C);
-    SPI_Write(sel, 0x3, 0xA88, 0x00BC009C);
-    SPI_Write(sel, 0x3, 0xA8C, 0x013C011C);
-    SPI_Write(sel, 0x3, 0xA90, 0x017C015C);
-    SPI_Write(sel, 0x3, 0xA94, 0x01BC019C);
-    SPI_Write(sel, 0x3, 0xA98, 0x023C01DC);
-    SPI_Write(sel, 0x3, 0xA9C, 0x027C025C);
-    SPI_Write(sel, 0x3, 0xAA0, 0x02BC029C);
-    SPI_Write(sel, 0x3, 0xAA4, 0x033C02DC);
-    SPI_Write(sel, 0x3, 0xAA8, 0x037C035C);
-    SPI_Write(sel, 0x3, 0xAAC, 0x03BC039C);
-    SPI_Write(sel, 0x3, 0xAB0, 0x033403DC);
-    SPI_Write(sel, 0x3, 0xAB4, 0x03740354);
-    SPI_Write(sel, 0x3, 0xAB8, 0x03B40394);
-    SPI_Write(sel, 0x3, 0xABC, 0x032C03D4);
-    SPI_Write(sel, 0x3, 0xAC0, 0x036C034C);
-    SPI_Write(sel, 0x3, 0xAC4, 0x03AC038C);
-    SPI_Write(sel, 0x3, 0xAC8, 0x032403CC);
-    SPI_Write(sel, 0x3, 0xACC, 0x03640344);
-    SPI_Write(sel, 0x3, 0xAD0, 0x03A40384);
-    SPI_Write(sel, 0x3, 0xAD4, 0x038303C4);
-    SPI_Write(sel, 0x3, 0xAD8, 0x03C303A3);
-    SPI_Write(sel, 0x3, 0xADC, 0x03A20382);
-    SPI_Write(sel, 0x3, 0xAE0, 0x032103C2);
-    SPI_Write(sel, 0x3, 0xAE4, 0x03610341);
-    SPI_Write(sel, 0x3, 0xAE8, 0x03A10381);
-    SPI_Write(sel, 0x3, 0xAEC, 0x032003C1);
-    SPI_Write(sel, 0x3, 0xAF0, 0x03600340);
-    SPI_Write(sel, 0x3, 0xAF4, 0x03A00380);
-    SPI_Write(sel, 0x3, 0xAF8, 0x03C103C0);
-    SPI_Write(sel, 0x3, 0xAFC, 0x03C303C2);
-    SPI_Write(sel, 0x3, 0xAFC, 0x03C503C4);
-    SPI_Write(sel, 0x3, 0xB00, 0x03C703C6);
-    SPI_Write(sel, 0x3, 0xB04, 0x03C903C8);
-    SPI_Write(sel, 0x3, 0xB3C, 0x0001FF00); // 0x0002FF00
-    SPI_Write(sel, 0x3, 0xB44, 0x00004300);
-    SPI_Write(sel, 0x3, 0xB48, 0x00010000); // 0x00001000
-    SPI_Write(sel, 0x3, 0xB58, 0x00FCFE00); // 0x00FCFE00
-    SPI_Write(sel, 0x3, 0xB60, 0x0000B278); // 0x0000B260
-    SPI_Write(sel, 0x3, 0xB38, 0x0000100A); // 0x0000101A
-    SPI_Write(sel, 0x3, 0xB68, 0x00000020);
-    SPI_Write(sel, 0x3, 0xB74, 0x0058001F);
-    SPI_Write(sel, 0x3, 0xB78, 0x00000000);
-    SPI_Write(sel, 0x3, 0x62C, 0x1310C470);
-    SPI_Write(sel, 0x3, 0x630, 0x98300301);
-    SPI_Write(sel, 0x3, 0x634, 0x40610613);
-    SPI_Write(sel, 0x3, 0x4F0, 0x00000964);
-    SPI_Write(sel, 0x3, 0xB70, 0x0000003F);
-    SPI_Write(sel, 0x3, 0xB40, 0x00050A0A);
-    SPI_Write(sel, 0x3, 0xB4C, 0x10001000);
-
-    if (bw) {
-        SPI_Write(sel, 0x3, 0x90C, 0x9EA2C008);
-        SPI_Write(sel, 0x3, 0xB0C, 0x9EA2C008);
-    } else {
-        SPI_Write(sel, 0x3, 0x90C, 0x9E22E0F0);
-        SPI_Write(sel, 0x3, 0xB0C, 0x9E22E0F0);
-    }
+    SPI_StreamWrite(&st, 0, 0x6, 0x7FC, 0x00000000);
+    // SPI_Write(0, 0x6, 0x7FC, 0x00000001);
+    SPI_StreamEnd(&st);
+}
 
-    SPI_Write(sel, 0x3, 0x920, 0x00000098);
-    SPI_Write(sel, 0x3, 0xB20, 0x00000098);
-    SPI_Write(sel, 0x3, 0x908, 0x00000000);
-    SPI_Write(sel, 0x3, 0xB08, 0x00000000);
-    SPI_Write(sel, 0x3, 0x908, 0x001FFF03);
-    SPI_Write(sel, 0x3, 0xB08, 0x001FFF03);
+void DM6302_Init0(uint8_t sel) {
+    DM6302_exec(sel, dm6302_seq_init0, 0, 0);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1272,6 +289,11 @@ void DM6302_EFUSE1(uint8_t SEL6302) {
 
     LOGI("EFUSE1 %d, s2", SEL6302);
 
+    if (efuse_sel->macro.m0.band_num > EFUSE_NUM - 2) {
+        LOGE("EFUSE1 %d, %d bands", SEL6302, efuse_sel->macro.m0.band_num);
+        efuse_sel->macro.m0.band_num = EFUSE_NUM - 2;
+    }
+
     for (j = 0; j < 12 /*EFUSE_SIZE*/; j++) // read macro 1
     {
         // EFUSE_CFG = (1<<11) | (j<<4) | 0x1;
@@ -1669,11 +691,11 @@ int DM6302_init(uint8_t freq, uint8_t bw) {
     int to_cnt = 0;
     uint32_t r0 = 1, r1 = 1;
 #if defined HDZGOGGLE
-    system_exec("aww 0x05002814 0x00000008"); // set i2c speed to 1MHz
+    hwio_write(0x05002814, 0x00000008); // set i2c speed to 1MHz
 #elif defined HDZBOXPRO
-    system_exec("aww 0x05002814 0x00000018"); // set i2c speed to 500KHz
+    hwio_write(0x05002814, 0x00000018); // set i2c speed to 500KHz
 #elif defined HDZGOGGLE2
-    system_exec("aww 0x05002814 0x00000008"); // set i2c speed to 1MHz
+    hwio_write(0x05002814, 0x00000008); // set i2c speed to 1MHz
 #endif
 
     while (r0) {
@@ -1704,47 +726,8 @@ int DM6302_init(uint8_t freq, uint8_t bw) {
     DM6302_EFUSE1(2);
     LOGI("EFUSE1 2 done");
 
-    DM6302_Init1(0, bw);
-    LOGI("Init1 done");
-
-    DM6302_Init2(0, freq);
-    LOGI("Init2 done");
-
-    DM6302_Init3(0);
-    LOGI("Init3 done");
-
-    DM6302_Init4(0, bw);
-    LOGI("Init4 done");
-
-    DM6302_Init5(0, bw);
-    LOGI("Init5 done");
-
-    DM6302_Init6(0, bw);
-    LOGI("Init6 done");
-
-    DM6302_Init7(0, bw);
-    LOGI("Init7 done");
-
-    DM6302_Init8(0);
-    LOGI("Init8 done");
-
-    DM6302_Init9(0);
-    LOGI("Init9 done");
-
-    DM6302_Init10(0, bw);
-    LOGI("Init10 done");
-
-    DM6302_Init11(0, bw);
-    LOGI("Init11 done");
-
-    DM6302_Init12(0, bw);
-    LOGI("Init12 done");
-
-    DM6302_Init13(0, bw);
-    LOGI("Init13 done");
-
-    DM6302_Init14(0, bw);
-    LOGI("Init14 done");
+    DM6302_exec(0, dm6302_seq_bringup, bw, freq);
+    LOGI("Init1~14 done");
 
     DM6302_EFUSE2(1);
     LOGI("EFUSE2 1 done");
@@ -1761,7 +744,7 @@ int DM6302_init(uint8_t freq, uint8_t bw) {
     DM6302_M0();
     LOGI("M0 done");
 
-    system_exec("aww 0x05002814 0x00000058"); // set i2c speed to 200KHz
+    hwio_write(0x05002814, 0x00000058); // set i2c speed to 200KHz
 
     return 0;
 }
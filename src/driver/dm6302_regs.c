@@ -0,0 +1,1131 @@
+#include "dm6302_regs.h"
+
+#include <stddef.h>
+
+// DM6302 register sequences, as the chips are brought up.
+// Each register goes to the selected chip(s) through the FPGA spi bridge, see
+// SPI_Write; the tables only hold what is written, DM6302_exec sends them.
+
+#define REG(page, addr, dat)    {(page), 0, (addr), (dat)}
+#define REG_CH(page, addr, row) {(page), (row) + 1, (addr), 0}
+
+// the pll calibrations used to get about a millisecond before the next write,
+// kept now that the writes go out faster
+#define REG_WAIT(us)            {DM6302_pageWAIT, 0, 0, (us)}
+
+#define SEQ(regs, bw) {(regs), sizeof(regs) / sizeof((regs)[0]), (bw)}
+
+// channel dependent values of REG_CH, one row each
+
+const uint32_t dm6302_ch_tab[3][20] = {
+    // 0x120
+    {
+        // race band
+        0x3741,
+        0x379D,
+        0x37FA,
+        0x3856,
+        0x38B3,
+        0x390F,
+        0x396C,
+        0x39C8,
+
+        // e band
+        0x38DF, // E1
+
+        //  fatshark band
+        0x3938, // F1
+        0x3840, // F2
+        0x38A4, // F4
+
+        // low band
+        0x3574,
+        0x35D2,
+        0x3631,
+        0x368F,
+        0x36ED,
+        0x374C,
+        0x37AA,
+        0x3809,
+    },
+    // 0x104
+    {
+        // race band
+        0x93,
+        0x94,
+        0x95,
+        0x96,
+        0x97,
+        0x98,
+        0x99,
+        0x9A,
+
+        // e band
+        0x94, // E1
+
+        // fatshark band
+        0x95, // F1
+        0x96, // F2
+        0x97, // F4
+
+        // low band
+        0x8B,
+        0x8C,
+        0x8D,
+        0x8E,
+        0x8F,
+        0x90,
+        0x91,
+        0x92,
+    },
+    // 0x108
+    {
+        // race band
+        0xB00000,
+        0x9D5555,
+        0x8AAAAB,
+        0x780000,
+        0x655555,
+        0x52AAAB,
+        0x400000,
+        0x2D5555,
+
+        // e band
+        0X122AAAB, // E1
+
+        // fatshark band
+        0XF55555, // F1
+        0x000000, // F2
+        0x155555, // F4
+
+        // low band
+        0x1455555,
+        0x132AAAB,
+        0x1200000,
+        0x10D5555,
+        0xFAAAAB,
+        0xE80000,
+        0xD55555,
+        0xC2AAAB,
+    },
+};
+
+
+static const dm6302_reg_t init0_init[] = {
+    // 00_INIT
+    REG(0x6, 0x7FC, 0x00000000),
+    REG(0x6, 0xF1C, 0x00000001),
+    REG(0x6, 0xF20, 0x0000FCD0),
+    REG(0x6, 0xF04, 0x00004741), // 0x00004741
+    REG(0x6, 0xF08, 0x00000083),
+    REG(0x6, 0xF08, 0x000000C3),
+    REG(0x6, 0xF24, 0x00007000), // 0x00007000
+    REG(0x6, 0xF40, 0x00000003),
+    REG(0x6, 0xF40, 0x00000001),
+    REG(0x6, 0xFFC, 0x00000000),
+    REG(0x6, 0xFFC, 0x00000001),
+    REG(0x6, 0xFF0, 0x00000018),
+};
+
+static const dm6302_reg_t init1_bb_pll_3456_17m[] = {
+    // 01_BB_PLL_3456, 17MHz
+    REG(0x6, 0xFF0, 0x00000018),
+    REG(0x3, 0x2B0, 0x00077777),
+    REG(0x3, 0x230, 0x00000000),
+    REG(0x3, 0x234, 0x10000000),
+    REG(0x3, 0x238, 0x000000BF),
+    REG(0x3, 0x23C, 0x55530610),
+    REG(0x3, 0x240, 0x3FFC0047),
+    REG(0x3, 0x244, 0x00188A13),
+    REG(0x3, 0x248, 0x00000000),
+    REG(0x3, 0x24C, 0x0A121707),
+    REG(0x3, 0x250, 0x017F0001),
+    REG(0x3, 0x228, 0x0000807C),
+    REG(0x3, 0x220, 0x0000292C),
+    REG(0x3, 0x21C, 0x00000002),
+    REG(0x3, 0x218, 0x00000001),
+    REG(0x3, 0x218, 0x00000000),
+    REG_WAIT(1000),
+    REG(0x3, 0x228, 0x0000807C),
+    REG(0x3, 0x220, 0x0000292C),
+    REG(0x3, 0x21C, 0x00000003),
+    REG(0x3, 0x218, 0x00000001),
+    REG(0x3, 0x218, 0x00000000),
+    REG_WAIT(1000),
+    REG(0x3, 0x244, 0x00188A17),
+    REG(0x3, 0x204, 0x0000002A),
+    REG(0x3, 0x208, 0x00400000),
+    REG(0x3, 0x200, 0x00000000),
+    REG(0x3, 0x200, 0x00000003),
+    REG_WAIT(1000),
+    REG(0x3, 0x240, 0x00030041),
+    REG(0x3, 0x248, 0x00000404),
+};
+
+static const dm6302_reg_t init1_bb_pll_3456_27m[] = {
+    // 01_BB_PLL_3456, 27MHz
+    REG(0x6, 0xFF0, 0x00000018),
+    REG(0x3, 0x2AC, 0x00000300),
+    REG(0x3, 0x2B0, 0x00077777), // dcxo_pathbuf_sel
+    REG(0x3, 0x230, 0x00000000),
+    REG(0x3, 0x234, 0x10000000),
+    REG(0x3, 0x238, 0x000000BF),
+    REG(0x3, 0x23C, 0x73530610), // 55530610,
+    REG(0x3, 0x240, 0x3FFC0047),
+    REG(0x3, 0x244, 0x00188A13),
+    REG(0x3, 0x248, 0x00000000),
+    REG(0x3, 0x24C, 0x0A121707),
+    REG(0x3, 0x250, 0x017F0001),
+    REG(0x3, 0x228, 0x0000807A), // coarse tune freq calibra
+    REG(0x3, 0x220, 0x00002AE4),
+    REG(0x3, 0x21C, 0x00000002),
+    REG(0x3, 0x218, 0x00000001),
+    REG(0x3, 0x218, 0x00000000),
+    REG_WAIT(1000),
+    REG(0x3, 0x228, 0x0000807A), // fine tune freq calibra
+    REG(0x3, 0x220, 0x00002AE4),
+    REG(0x3, 0x21C, 0x00000003),
+    REG(0x3, 0x218, 0x00000001),
+    REG(0x3, 0x218, 0x00000000),
+    REG_WAIT(1000),
+    REG(0x3, 0x244, 0x00188A17),
+    REG(0x3, 0x204, 0x0000002D), // int div ratio
+    REG(0x3, 0x208, 0x00000000), // fracn div ratio
+    REG(0x3, 0x200, 0x00000000), // sdm en
+    REG(0x3, 0x200, 0x00000003),
+    REG_WAIT(1000),
+    REG(0x3, 0x240, 0x00030041), // pll close loop
+    REG(0x3, 0x248, 0x00000404),
+};
+
+static const dm6302_reg_t init2_rx1_pll_11316[] = {
+    // 02_RX1_PLL_11316(5658MHz)
+    REG(0x6, 0xFF0, 0x00000018),
+    REG(0x3, 0x130, 0x00000013), // 0x00000013 10
+    REG(0x3, 0x134, 0x00000013),
+    REG(0x3, 0x138, 0x00000370),
+    REG(0x3, 0x13C, 0x00000410),
+    REG(0x3, 0x140, 0x00000000),
+    REG(0x3, 0x144, 0x0D640735),
+    REG(0x3, 0x148, 0x01017F03),
+    REG(0x3, 0x14C, 0x022288A2), // 0x021288A2
+    REG(0x3, 0x150, 0x00FFCF33), // 0x00FFCF33
+    REG(0x3, 0x154, 0x1F0C3440), // 0x1F3C3C40 0x1F0C3440
+    REG(0x3, 0x128, 0x00008030),
+    REG_CH(0x3, 0x120, 0), // ch
+    REG(0x3, 0x11C, 0x00000002),
+    REG(0x3, 0x118, 0x00000001),
+    REG(0x3, 0x118, 0x00000000),
+    REG_WAIT(1000),
+    REG(0x3, 0x128, 0x00008030),
+    REG_CH(0x3, 0x120, 0), // ch
+    REG(0x3, 0x11C, 0x00000003),
+    REG(0x3, 0x118, 0x00000001),
+    REG(0x3, 0x118, 0x00000000),
+    REG_WAIT(1000),
+    REG(0x3, 0x150, 0x00FFCFB3),
+    REG_CH(0x3, 0x104, 1), // ch
+    REG_CH(0x3, 0x108, 2), // ch
+    REG(0x3, 0x100, 0x00000000),
+    REG(0x3, 0x100, 0x00000003),
+    REG_WAIT(1000),
+    REG(0x3, 0x150, 0x000333B3),
+    REG(0x3, 0x140, 0x07070000),
+    REG(0x3, 0x130, 0x00000010),
+};
+
+static const dm6302_reg_t rx1_pll_low[] = {
+    // 02_RX1_PLL on a low band channel, E1 or F1
+    REG(0x6, 0xFF0, 0x00000018),
+    REG(0x3, 0x130, 0x00000013),
+    REG(0x3, 0x134, 0x00000013),
+    REG(0x3, 0x138, 0x00000370),
+    REG(0x3, 0x13C, 0x00000410),
+    REG(0x3, 0x140, 0x00000000),
+    REG(0x3, 0x144, 0x15240735),
+    REG(0x3, 0x148, 0x01017F03),
+    REG(0x3, 0x14C, 0x021288A2),
+    REG(0x3, 0x150, 0x00FFCF33),
+    REG(0x3, 0x154, 0x1F2C3840),
+    REG(0x3, 0x128, 0x00008031),
+    REG_CH(0x3, 0x120, 0), // ch
+    REG(0x3, 0x11C, 0x00000002),
+    REG(0x3, 0x118, 0x00000001),
+    REG(0x3, 0x118, 0x00000000),
+    REG_WAIT(1000),
+    REG(0x3, 0x128, 0x00008031),
+    REG_CH(0x3, 0x120, 0), // ch
+    REG(0x3, 0x11C, 0x00000003),
+    REG(0x3, 0x118, 0x00000001),
+    REG(0x3, 0x118, 0x00000000),
+    REG_WAIT(1000),
+    REG(0x3, 0x150, 0x00FFCFB3),
+    REG_CH(0x3, 0x104, 1), // ch
+    REG_CH(0x3, 0x108, 2), // ch
+    REG(0x3, 0x100, 0x00000000),
+    REG(0x3, 0x100, 0x00000003),
+    REG_WAIT(1000),
+    REG(0x3, 0x150, 0x000333B3),
+    REG(0x3, 0x140, 0x07070002),
+    REG(0x3, 0x130, 0x00000010),
+};
+
+static const dm6302_reg_t init3_rx1_rf[] = {
+    // 03_RX1_RF
+    REG(0x6, 0xFF0, 0x00000018),
+    REG(0x3, 0x480, 0x60FFFFFF),
+    REG(0x3, 0x484, 0xFFFFF7FF),
+    REG(0x3, 0x488, 0x0FFF7FE0), // 0x0FFF7FE0
+    REG(0x3, 0x48C, 0x00000001),
+    REG(0x3, 0x490, 0x34460E01),
+    REG(0x3, 0x494, 0x066727CC), // 0x066427CC
+    REG(0x3, 0x498, 0x00000002), // 0x00001020
+    REG(0x3, 0x49C, 0x00001020),
+    REG(0x3, 0x4A0, 0x00001020),
+    REG(0x3, 0x4A4, 0x00001030),
+    REG(0x3, 0x4A8, 0x00001030),
+    REG(0x3, 0x4AC, 0x8102040D),
+    REG(0x3, 0x4B0, 0x00000964),
+    REG(0x3, 0x4B4, 0x00000000),
+    REG(0x3, 0x4B8, 0x00000000),
+};
+
+static const dm6302_reg_t init4_rx1_bbf_17m[] = {
+    // 04_RX1_BBF, 17MHz
+    REG(0x6, 0xFF0, 0x00000018),
+    REG(0x3, 0x500, 0x0F85FF49),
+    REG(0x3, 0x504, 0x1488809A),
+    REG(0x3, 0x508, 0x1488609A),
+    REG(0x3, 0x50C, 0x1F828216),
+    REG(0x3, 0x510, 0x00040C49),
+    REG(0x3, 0x514, 0x12088230),
+    REG(0x3, 0x518, 0x02509439),
+    REG(0x3, 0x51C, 0x0294A541),
+    REG(0x3, 0x520, 0x02E4B94B),
+    REG(0x3, 0x524, 0x06719CAA),
+    REG(0x3, 0x528, 0x83A4E962),
+    REG(0x3, 0x52C, 0x141506E0),
+    REG(0x3, 0x530, 0x60410411),
+    REG(0x3, 0x534, 0x40820823),
+    REG(0x3, 0x538, 0x01051057),
+    REG(0x3, 0x53C, 0x020B20BF),
+    REG(0x3, 0x540, 0x0300000B),
+    REG(0x3, 0x544, 0x05001300),
+    REG(0x3, 0x548, 0x0000000A),
+    REG(0x3, 0x54C, 0x00000000),
+    REG(0x3, 0x550, 0x0000002F),
+    REG(0x3, 0x554, 0x00000100),
+    REG(0x3, 0x558, 0x00000500),
+    REG(0x3, 0x55C, 0x00000000),
+    REG(0x3, 0x560, 0x00000000),
+    REG(0x3, 0x564, 0x00000007),
+    REG(0x3, 0x568, 0x00000000),
+    REG(0x3, 0x56C, 0x00000000),
+};
+
+static const dm6302_reg_t init4_rx1_bbf_27m[] = {
+    // 04_RX1_BBF, 27MHz
+    REG(0x6, 0xFF0, 0x00000018),
+    REG(0x3, 0x500, 0x0F85FF49),
+    REG(0x3, 0x504, 0x1488809A),
+    REG(0x3, 0x508, 0x1488809A),
+    REG(0x3, 0x50C, 0x1F616110),
+    REG(0x3, 0x510, 0x00040C49),
+    REG(0x3, 0x514, 0x11846130),
+    REG(0x3, 0x518, 0x01B86E39),
+    REG(0x3, 0x51C, 0x01F07C41),
+    REG(0x3, 0x520, 0x02288A4B),
+    REG(0x3, 0x524, 0x026C9B55),
+    REG(0x3, 0x528, 0x82B8AE62),
+    REG(0x3, 0x52C, 0x1310C470),
+    REG(0x3, 0x530, 0x60300301),
+    REG(0x3, 0x534, 0x40610613),
+    REG(0x3, 0x538, 0x00C40C47),
+    REG(0x3, 0x53C, 0x0188188F),
+    REG(0x3, 0x540, 0x00010B00),
+    REG(0x3, 0x544, 0x00090900),
+    REG(0x3, 0x548, 0x0000000A),
+    REG(0x3, 0x54C, 0x00000000),
+    REG(0x3, 0x550, 0x0000002F),
+    REG(0x3, 0x554, 0x00000100),
+    REG(0x3, 0x55C, 0x00000000),
+    REG(0x3, 0x560, 0x00000000),
+    REG(0x3, 0x564, 0x00000007),
+    REG(0x3, 0x568, 0x00000000),
+};
+
+static const dm6302_reg_t init5_rx1_adc_17m[] = {
+    // 05_RX1_ADC, 17MHz
+    REG(0x6, 0xFF0, 0x00000018),
+    REG(0x3, 0x728, 0xFFFFFFFE),
+    REG(0x3, 0x72C, 0x22C42273),
+    REG(0x3, 0x730, 0x14208208),
+    REG(0x3, 0x734, 0x0040B208),
+    REG(0x3, 0x738, 0x22C42273),
+    REG(0x3, 0x73C, 0x14208208),
+    REG(0x3, 0x740, 0x0040B208),
+    REG(0x3, 0x744, 0x00A20001),
+    REG(0x3, 0x748, 0x00004300),
+    REG(0x3, 0x74C, 0x00000000),
+};
+
+static const dm6302_reg_t init5_rx1_adc_27m[] = {
+    // 05_RX1_ADC, 27MHz
+    REG(0x6, 0xFF0, 0x00000018),
+    REG(0x3, 0x728, 0xFFFFFFFE),
+    REG(0x3, 0x72C, 0x22C42273),
+    REG(0x3, 0x730, 0x141E81E8),
+    REG(0x3, 0x734, 0x0040B1E8),
+    REG(0x3, 0x738, 0x22C42273),
+    REG(0x3, 0x73C, 0x141E81E8),
+    REG(0x3, 0x740, 0x0040B1E8),
+    REG(0x3, 0x744, 0x00A20001),
+    REG(0x3, 0x748, 0x00004400),
+    REG(0x3, 0x74C, 0x00000000),
+};
+
+static const dm6302_reg_t init6_rx1_dfe[] = {
+    // 06_RX1_DFE
+    REG(0x6, 0xFF0, 0x00000019),
+    REG(0x3, 0x0E4, 0x0000000C),
+    REG(0x3, 0x0E8, 0x00000003),
+};
+
+static const dm6302_reg_t init6_rx1_dfe_17m[] = {
+    // 06_RX1_DFE, 17MHz
+    REG(0x6, 0xFF0, 0x00000018),
+    REG(0x3, 0x254, 0x0055780F), // ADC1=ADC2=3264/8=408
+    REG(0x3, 0x258, 0x00010003), // RBDP=3264/8=408
+    REG(0x3, 0x908, 0x001FFF03),
+    REG(0x3, 0x90C, 0xDEA3C008), // ADC=408/2,FBCLK=ADC/4=51
+    REG(0x3, 0x880, 0x0000001C), // GAIN
+    REG(0x3, 0x938, 0x00000082), // AGC
+};
+
+static const dm6302_reg_t init6_rx1_dfe_27m[] = {
+    // 06_RX1_DFE, 27MHz
+    REG(0x6, 0xFF0, 0x00000018),
+    REG(0x3, 0x254, 0x0055780F), // ADC1=ADC2=3456/8=432
+    REG(0x3, 0x258, 0x00010002), // RBDP=3456/8=432
+    REG(0x3, 0x908, 0x001FFF03), // 0x001FFF03
+    REG(0x3, 0x90C, 0xDE07E0F0), // ADC=432/2,FBCLK=ADC/4=54  0xDE07E0F0
+    REG(0x3, 0x880, 0x0000001C), // GAIN
+    REG(0x3, 0x938, 0x00000082), // AGC 0x00000082
+};
+
+static const dm6302_reg_t init7_rx1_fir_17m[] = {
+    // 07_RX1_FIR, 17MHz
+    REG(0x6, 0xFF0, 0x00000018),
+    REG(0x3, 0x800, 0x00100006),
+    REG(0x3, 0x804, 0x002E001E),
+    REG(0x3, 0x808, 0x003F003C),
+    REG(0x3, 0x80C, 0x000D0031),
+    REG(0x3, 0x810, 0xFF97FFD6),
+    REG(0x3, 0x814, 0xFF4AFF61),
+    REG(0x3, 0x818, 0xFFC0FF67),
+    REG(0x3, 0x81C, 0x00EE004D),
+    REG(0x3, 0x820, 0x01B20177),
+    REG(0x3, 0x824, 0x00A50172),
+    REG(0x3, 0x828, 0xFDE7FF60),
+    REG(0x3, 0x82C, 0xFC06FCA0),
+    REG(0x3, 0x830, 0xFE68FC87),
+    REG(0x3, 0x834, 0x060801AC),
+    REG(0x3, 0x838, 0x0F900AE9),
+    REG(0x3, 0x83C, 0x15371336),
+    REG(0x3, 0x840, 0x13361537),
+    REG(0x3, 0x844, 0x0AE90F90),
+    REG(0x3, 0x848, 0x01AC0608),
+    REG(0x3, 0x84C, 0xFC87FE68),
+    REG(0x3, 0x850, 0xFCA0FC06),
+    REG(0x3, 0x854, 0xFF60FDE7),
+    REG(0x3, 0x858, 0x017200A5),
+    REG(0x3, 0x85C, 0x017701B2),
+    REG(0x3, 0x860, 0x004D00EE),
+    REG(0x3, 0x864, 0xFF67FFC0),
+    REG(0x3, 0x868, 0xFF61FF4A),
+    REG(0x3, 0x86C, 0xFFD6FF97),
+    REG(0x3, 0x870, 0x0031000D),
+    REG(0x3, 0x874, 0x003C003F),
+    REG(0x3, 0x878, 0x001E002E),
+    REG(0x3, 0x87C, 0x00060010),
+};
+
+static const dm6302_reg_t init7_rx1_fir_27m[] = {
+    // 07_RX1_FIR, 27MHz
+    REG(0x6, 0xFF0, 0x00000018),
+    REG(0x3, 0x800, 0x000E000A),
+    REG(0x3, 0x804, 0xFFEFFFF4),
+    REG(0x3, 0x808, 0x00140010),
+    REG(0x3, 0x80C, 0xFFE9FFEA),
+    REG(0x3, 0x810, 0x0018001D),
+    REG(0x3, 0x814, 0xFFE7FFDA),
+    REG(0x3, 0x818, 0x0018002F),
+    REG(0x3, 0x81C, 0xFFEAFFC5),
+    REG(0x3, 0x820, 0x00110047),
+    REG(0x3, 0x824, 0xFFF6FFAC),
+    REG(0x3, 0x828, 0x00000062),
+    REG(0x3, 0x82C, 0x000DFF8F),
+    REG(0x3, 0x830, 0xFFE3007F),
+    REG(0x3, 0x834, 0x0032FF73),
+    REG(0x3, 0x838, 0xFFB6009B),
+    REG(0x3, 0x83C, 0x0068FF59),
+    REG(0x3, 0x840, 0xFF7600B0),
+    REG(0x3, 0x844, 0x00B1FF49),
+    REG(0x3, 0x848, 0xFF2100BA),
+    REG(0x3, 0x84C, 0x0112FF48),
+    REG(0x3, 0x850, 0xFEB400B0),
+    REG(0x3, 0x854, 0x018EFF5F),
+    REG(0x3, 0x858, 0xFE280089),
+    REG(0x3, 0x85C, 0x022EFF9B),
+    REG(0x3, 0x860, 0xFD6E0032),
+    REG(0x3, 0x864, 0x030A0015),
+    REG(0x3, 0x868, 0xFC5EFF87),
+    REG(0x3, 0x86C, 0x046E0109),
+    REG(0x3, 0x870, 0xFA61FE1B),
+    REG(0x3, 0x874, 0x07BB035C),
+    REG(0x3, 0x878, 0xF304F990),
+    REG(0x3, 0x87C, 0x3B341183),
+};
+
+static const dm6302_reg_t init8_rx1_agc[] = {
+    // 08_RX1_AGC
+    REG(0x6, 0xFF0, 0x00000018),
+    REG(0x3, 0x880, 0x003C001C),
+    REG(0x3, 0x884, 0x007C005C),
+    REG(0x3, 0x888, 0x00BC009C),
+    REG(0x3, 0x88C, 0x013C011C),
+    REG(0x3, 0x890, 0x017C015C),
+    REG(0x3, 0x894, 0x01BC019C),
+    REG(0x3, 0x898, 0x023C01DC),
+    REG(0x3, 0x89C, 0x027C025C),
+    REG(0x3, 0x8A0, 0x02BC029C),
+    REG(0x3, 0x8A4, 0x033C02DC),
+    REG(0x3, 0x8A8, 0x037C035C),
+    REG(0x3, 0x8AC, 0x03BC039C),
+    REG(0x3, 0x8B0, 0x033403DC),
+    REG(0x3, 0x8B4, 0x03740354),
+    REG(0x3, 0x8B8, 0x03B40394),
+    REG(0x3, 0x8BC, 0x032C03D4),
+    REG(0x3, 0x8C0, 0x036C034C),
+    REG(0x3, 0x8C4, 0x03AC038C),
+    REG(0x3, 0x8C8, 0x032403CC),
+    REG(0x3, 0x8CC, 0x03640344),
+    REG(0x3, 0x8D0, 0x03A40384),
+    REG(0x3, 0x8D4, 0x038303C4),
+    REG(0x3, 0x8D8, 0x03C303A3),
+    REG(0x3, 0x8DC, 0x03A20382),
+    REG(0x3, 0x8E0, 0x032103C2),
+    REG(0x3, 0x8E4, 0x03610341),
+    REG(0x3, 0x8E8, 0x03A10381),
+    REG(0x3, 0x8EC, 0x032003C1),
+    REG(0x3, 0x8F0, 0x03600340),
+    REG(0x3, 0x8F4, 0x03A00380),
+    REG(0x3, 0x8F8, 0x03C103C0),
+    REG(0x3, 0x8FC, 0x03C303C2),
+    REG(0x3, 0x8FC, 0x03C503C4),
+    REG(0x3, 0x900, 0x03C703C6),
+    REG(0x3, 0x904, 0x03C903C8),
+    REG(0x3, 0x93C, 0x0001FF00), // 0x0002FF00
+    REG(0x3, 0x944, 0x00004300),
+    REG(0x3, 0x948, 0x00010000), // 0x00001000
+    REG(0x3, 0x958, 0x00FCFE00), // 0x00FCFE00
+    REG(0x3, 0x960, 0x0000B278), // 0x0000B260
+    REG(0x3, 0x938, 0x0000100A), // 0x0000101A
+    REG(0x3, 0x968, 0x00000020),
+    REG(0x3, 0x974, 0x0058001F),
+    REG(0x3, 0x978, 0x00000000),
+    REG(0x3, 0x52C, 0x1310C470),
+    REG(0x3, 0x530, 0x98300301),
+    REG(0x3, 0x534, 0x40610613),
+    REG(0x3, 0x4B0, 0x00000964),
+    REG(0x3, 0x970, 0x0000003F),
+    REG(0x3, 0x940, 0x00050A0A),
+    REG(0x3, 0x94C, 0x10001000),
+};
+
+static const dm6302_reg_t init9_rx2_rf[] = {
+    // 09_RX2_RF
+    REG(0x6, 0xFF0, 0x00000018),
+    REG(0x3, 0x4C0, 0x6000F001),
+    REG(0x3, 0x4C4, 0x00000000),
+    REG(0x3, 0x4C8, 0x00006048),
+    REG(0x3, 0x4CC, 0x00000001),
+    REG(0x3, 0x4D0, 0x34460E01),
+    REG(0x3, 0x4D4, 0x066727CC), // 0x066427CC
+    REG(0x3, 0x4D8, 0x00000002), // 0x00001020
+    REG(0x3, 0x4DC, 0x00001020),
+    REG(0x3, 0x4E0, 0x00001020),
+    REG(0x3, 0x4E4, 0x00001030),
+    REG(0x3, 0x4E8, 0x00001030),
+    REG(0x3, 0x4EC, 0x8102040D),
+    REG(0x3, 0x4F0, 0x00000964),
+    REG(0x3, 0x4F4, 0x00000000),
+    REG(0x3, 0x4F8, 0x00000000),
+};
+
+static const dm6302_reg_t init10_rx2_bbf_17m[] = {
+    // 10_RX2_BBF, 17MHz
+    REG(0x6, 0xFF0, 0x00000018),
+    REG(0x3, 0x600, 0x0F85FF49),
+    REG(0x3, 0x604, 0x1488809A),
+    REG(0x3, 0x608, 0x1488609A),
+    REG(0x3, 0x60C, 0x1F828216),
+    REG(0x3, 0x610, 0x00040C49),
+    REG(0x3, 0x614, 0x12088230),
+    REG(0x3, 0x618, 0x02509439),
+    REG(0x3, 0x61C, 0x0294A541),
+    REG(0x3, 0x620, 0x02E4B94B),
+    REG(0x3, 0x624, 0x06719CAA),
+    REG(0x3, 0x628, 0x83A4E962),
+    REG(0x3, 0x62C, 0x141506E0),
+    REG(0x3, 0x630, 0x60410411),
+    REG(0x3, 0x634, 0x40820823),
+    REG(0x3, 0x638, 0x01051057),
+    REG(0x3, 0x63C, 0x020B20BF),
+    REG(0x3, 0x640, 0x0300000B),
+    REG(0x3, 0x644, 0x05001300),
+    REG(0x3, 0x648, 0x0000000A),
+    REG(0x3, 0x64C, 0x00000000),
+    REG(0x3, 0x650, 0x0000002F),
+    REG(0x3, 0x654, 0x00000100),
+    REG(0x3, 0x658, 0x00000500),
+    REG(0x3, 0x65C, 0x00000000),
+    REG(0x3, 0x660, 0x00000000),
+    REG(0x3, 0x664, 0x00000007),
+    REG(0x3, 0x668, 0x00000000),
+    REG(0x3, 0x66C, 0x00000000),
+};
+
+static const dm6302_reg_t init10_rx2_bbf_27m[] = {
+    // 10_RX2_BBF, 27MHz
+    REG(0x6, 0xFF0, 0x00000018),
+    REG(0x3, 0x600, 0x0F85FF49),
+    REG(0x3, 0x604, 0x1488809A),
+    REG(0x3, 0x608, 0x1488809A),
+    REG(0x3, 0x60C, 0x1F616110),
+    REG(0x3, 0x610, 0x00040C49),
+    REG(0x3, 0x614, 0x11846130),
+    REG(0x3, 0x618, 0x01B86E39),
+    REG(0x3, 0x61C, 0x01F07C41),
+    REG(0x3, 0x620, 0x02288A4B),
+    REG(0x3, 0x624, 0x026C9B55),
+    REG(0x3, 0x628, 0x82B8AE62),
+    REG(0x3, 0x62C, 0x1310C470),
+    REG(0x3, 0x630, 0x60300301),
+    REG(0x3, 0x634, 0x40610613),
+    REG(0x3, 0x638, 0x00C40C47),
+    REG(0x3, 0x63C, 0x0188188F),
+    REG(0x3, 0x640, 0x00010B00),
+    REG(0x3, 0x644, 0x00090900),
+    REG(0x3, 0x648, 0x0000000A),
+    REG(0x3, 0x64C, 0x00000000),
+    REG(0x3, 0x650, 0x0000002F),
+    REG(0x3, 0x654, 0x00000100),
+    REG(0x3, 0x65C, 0x00000000),
+    REG(0x3, 0x660, 0x00000000),
+    REG(0x3, 0x664, 0x00000007),
+    REG(0x3, 0x668, 0x00000000),
+};
+
+static const dm6302_reg_t init11_rx2_adc_17m[] = {
+    // 11_RX2_ADC, 17MHz
+    REG(0x6, 0xFF0, 0x00000018),
+    REG(0x3, 0x750, 0xFFFFFFFE),
+    REG(0x3, 0x754, 0x22C42273),
+    REG(0x3, 0x758, 0x14208208),
+    REG(0x3, 0x75C, 0x0040B208),
+    REG(0x3, 0x760, 0x22C42273),
+    REG(0x3, 0x764, 0x14208208),
+    REG(0x3, 0x768, 0x0040B208),
+    REG(0x3, 0x76C, 0x00A20001),
+    REG(0x3, 0x770, 0x00004300),
+    REG(0x3, 0x774, 0x00000000),
+};
+
+static const dm6302_reg_t init11_rx2_adc_27m[] = {
+    // 11_RX2_ADC, 27MHz
+    REG(0x6, 0xFF0, 0x00000018),
+    REG(0x3, 0x750, 0xFFFFFFFE),
+    REG(0x3, 0x754, 0x22C42273),
+    REG(0x3, 0x758, 0x141E81E8),
+    REG(0x3, 0x75C, 0x0040B1E8),
+    REG(0x3, 0x760, 0x22C42273),
+    REG(0x3, 0x764, 0x141E81E8),
+    REG(0x3, 0x768, 0x0040B1E8),
+    REG(0x3, 0x76C, 0x00A20001),
+    REG(0x3, 0x770, 0x00004400),
+    REG(0x3, 0x774, 0x00000000),
+};
+
+static const dm6302_reg_t init12_rx2_fir_17m[] = {
+    // 12_RX2_FIR, 17MHz
+    REG(0x6, 0xFF0, 0x00000018),
+    REG(0x3, 0xA00, 0x00100006),
+    REG(0x3, 0xA04, 0x002E001E),
+    REG(0x3, 0xA08, 0x003F003C),
+    REG(0x3, 0xA0C, 0x000D0031),
+    REG(0x3, 0xA10, 0xFF97FFD6),
+    REG(0x3, 0xA14, 0xFF4AFF61),
+    REG(0x3, 0xA18, 0xFFC0FF67),
+    REG(0x3, 0xA1C, 0x00EE004D),
+    REG(0x3, 0xA20, 0x01B20177),
+    REG(0x3, 0xA24, 0x00A50172),
+    REG(0x3, 0xA28, 0xFDE7FF60),
+    REG(0x3, 0xA2C, 0xFC06FCA0),
+    REG(0x3, 0xA30, 0xFE68FC87),
+    REG(0x3, 0xA34, 0x060801AC),
+    REG(0x3, 0xA38, 0x0F900AE9),
+    REG(0x3, 0xA3C, 0x15371336),
+    REG(0x3, 0xA40, 0x13361537),
+    REG(0x3, 0xA44, 0x0AE90F90),
+    REG(0x3, 0xA48, 0x01AC0608),
+    REG(0x3, 0xA4C, 0xFC87FE68),
+    REG(0x3, 0xA50, 0xFCA0FC06),
+    REG(0x3, 0xA54, 0xFF60FDE7),
+    REG(0x3, 0xA58, 0x017200A5),
+    REG(0x3, 0xA5C, 0x017701B2),
+    REG(0x3, 0xA60, 0x004D00EE),
+    REG(0x3, 0xA64, 0xFF67FFC0),
+    REG(0x3, 0xA68, 0xFF61FF4A),
+    REG(0x3, 0xA6C, 0xFFD6FF97),
+    REG(0x3, 0xA70, 0x0031000D),
+    REG(0x3, 0xA74, 0x003C003F),
+    REG(0x3, 0xA78, 0x001E002E),
+    REG(0x3, 0xA7C, 0x00060010),
+};
+
+static const dm6302_reg_t init12_rx2_fir_27m[] = {
+    // 12_RX2_FIR, 27MHz
+    REG(0x6, 0xFF0, 0x00000018),
+    REG(0x3, 0xA00, 0x000E000A),
+    REG(0x3, 0xA04, 0xFFEFFFF4),
+    REG(0x3, 0xA08, 0x00140010),
+    REG(0x3, 0xA0C, 0xFFE9FFEA),
+    REG(0x3, 0xA10, 0x0018001D),
+    REG(0x3, 0xA14, 0xFFE7FFDA),
+    REG(0x3, 0xA18, 0x0018002F),
+    REG(0x3, 0xA1C, 0xFFEAFFC5),
+    REG(0x3, 0xA20, 0x00110047),
+    REG(0x3, 0xA24, 0xFFF6FFAC),
+    REG(0x3, 0xA28, 0x00000062),
+    REG(0x3, 0xA2C, 0x000DFF8F),
+    REG(0x3, 0xA30, 0xFFE3007F),
+    REG(0x3, 0xA34, 0x0032FF73),
+    REG(0x3, 0xA38, 0xFFB6009B),
+    REG(0x3, 0xA3C, 0x0068FF59),
+    REG(0x3, 0xA40, 0xFF7600B0),
+    REG(0x3, 0xA44, 0x00B1FF49),
+    REG(0x3, 0xA48, 0xFF2100BA),
+    REG(0x3, 0xA4C, 0x0112FF48),
+    REG(0x3, 0xA50, 0xFEB400B0),
+    REG(0x3, 0xA54, 0x018EFF5F),
+    REG(0x3, 0xA58, 0xFE280089),
+    REG(0x3, 0xA5C, 0x022EFF9B),
+    REG(0x3, 0xA60, 0xFD6E0032),
+    REG(0x3, 0xA64, 0x030A0015),
+    REG(0x3, 0xA68, 0xFC5EFF87),
+    REG(0x3, 0xA6C, 0x046E0109),
+    REG(0x3, 0xA70, 0xFA61FE1B),
+    REG(0x3, 0xA74, 0x07BB035C),
+    REG(0x3, 0xA78, 0xF304F990),
+    REG(0x3, 0xA7C, 0x3B341183),
+};
+
+static const dm6302_reg_t init13_rx2_dfe_17m[] = {
+    // 13_RX2_DFE, 17MHz
+    REG(0x6, 0xFF0, 0x00000019),
+    REG(0x3, 0x080, 0x1B318C0C), // RBDP=432/8,CLKOUT=432/4
+    REG(0x3, 0x084, 0x00000004),
+    REG(0x3, 0x088, 0x00000205), // TDD,2PORT,2T2R 0x00000005
+    REG(0x3, 0x018, 0xE4F15E3C),
+    REG(0x3, 0x01C, 0x0001C140),
+    REG(0x3, 0x020, 0x0000000D),
+
+    REG(0x6, 0xFF0, 0x00000018),
+    REG(0x3, 0xB08, 0x001FFF03), // 0x001FFF03
+    REG(0x3, 0xB0C, 0xDEA3C008), // 0xDE07E0F0
+    REG(0x3, 0xA80, 0x0000001C), // GAIN
+    REG(0x3, 0xB38, 0x00000082), // AGC 0x00000082
+};
+
+static const dm6302_reg_t init13_rx2_dfe_27m[] = {
+    // 13_RX2_DFE, 27MHz
+    REG(0x6, 0xFF0, 0x00000019),
+    REG(0x3, 0x080, 0x1004210C), // RBDP=432/8,CLKOUT=432/4
+    REG(0x3, 0x084, 0x00000004),
+    REG(0x3, 0x088, 0x00000205), // TDD,2PORT,2T2R 0x00000005
+    REG(0x3, 0x018, 0xE4F15E3C),
+    REG(0x3, 0x01C, 0x0001C140),
+    REG(0x3, 0x020, 0x0000000D),
+
+    REG(0x6, 0xFF0, 0x00000018),
+    REG(0x3, 0xB08, 0x001FFF03), // 0x001FFF03
+    REG(0x3, 0xB0C, 0xDE07E0F0), // 0xDE07E0F0
+    REG(0x3, 0xA80, 0x0000001C), // GAIN
+    REG(0x3, 0xB38, 0x00000082), // AGC 0x00000082
+};
+
+static const dm6302_reg_t init14_rx2_agc[] = {
+    // 14_RX2_AGC
+    REG(0x6, 0xFF0, 0x00000018),
+    REG(0x3, 0xA80, 0x003C001C),
+    REG(0x3, 0xA84, 0x007C005C),
+    REG(0x3, 0xA88, 0x00BC009C),
+    REG(0x3, 0xA8C, 0x013C011C),
+    REG(0x3, 0xA90, 0x017C015C),
+    REG(0x3, 0xA94, 0x01BC019C),
+    REG(0x3, 0xA98, 0x023C01DC),
+    REG(0x3, 0xA9C, 0x027C025C),
+    REG(0x3, 0xAA0, 0x02BC029C),
+    REG(0x3, 0xAA4, 0x033C02DC),
+    REG(0x3, 0xAA8, 0x037C035C),
+    REG(0x3, 0xAAC, 0x03BC039C),
+    REG(0x3, 0xAB0, 0x033403DC),
+    REG(0x3, 0xAB4, 0x03740354),
+    REG(0x3, 0xAB8, 0x03B40394),
+    REG(0x3, 0xABC, 0x032C03D4),
+    REG(0x3, 0xAC0, 0x036C034C),
+    REG(0x3, 0xAC4, 0x03AC038C),
+    REG(0x3, 0xAC8, 0x032403CC),
+    REG(0x3, 0xACC, 0x03640344),
+    REG(0x3, 0xAD0, 0x03A40384),
+    REG(0x3, 0xAD4, 0x038303C4),
+    REG(0x3, 0xAD8, 0x03C303A3),
+    REG(0x3, 0xADC, 0x03A20382),
+    REG(0x3, 0xAE0, 0x032103C2),
+    REG(0x3, 0xAE4, 0x03610341),
+    REG(0x3, 0xAE8, 0x03A10381),
+    REG(0x3, 0xAEC, 0x032003C1),
+    REG(0x3, 0xAF0, 0x03600340),
+    REG(0x3, 0xAF4, 0x03A00380),
+    REG(0x3, 0xAF8, 0x03C103C0),
+    REG(0x3, 0xAFC, 0x03C303C2),
+    REG(0x3, 0xAFC, 0x03C503C4),
+    REG(0x3, 0xB00, 0x03C703C6),
+    REG(0x3, 0xB04, 0x03C903C8),
+    REG(0x3, 0xB3C, 0x0001FF00), // 0x0002FF00
+    REG(0x3, 0xB44, 0x00004300),
+    REG(0x3, 0xB48, 0x00010000), // 0x00001000
+    REG(0x3, 0xB58, 0x00FCFE00), // 0x00FCFE00
+    REG(0x3, 0xB60, 0x0000B278), // 0x0000B260
+    REG(0x3, 0xB38, 0x0000100A), // 0x0000101A
+    REG(0x3, 0xB68, 0x00000020),
+    REG(0x3, 0xB74, 0x0058001F),
+    REG(0x3, 0xB78, 0x00000000),
+    REG(0x3, 0x62C, 0x1310C470),
+    REG(0x3, 0x630, 0x98300301),
+    REG(0x3, 0x634, 0x40610613),
+    REG(0x3, 0x4F0, 0x00000964),
+    REG(0x3, 0xB70, 0x0000003F),
+    REG(0x3, 0xB40, 0x00050A0A),
+    REG(0x3, 0xB4C, 0x10001000),
+};
+
+static const dm6302_reg_t init14_rx2_agc_17m[] = {
+    // 14_RX2_AGC, 17MHz
+    REG(0x3, 0x90C, 0x9EA2C008),
+    REG(0x3, 0xB0C, 0x9EA2C008),
+};
+
+static const dm6302_reg_t init14_rx2_agc_27m[] = {
+    // 14_RX2_AGC, 27MHz
+    REG(0x3, 0x90C, 0x9E22E0F0),
+    REG(0x3, 0xB0C, 0x9E22E0F0),
+};
+
+static const dm6302_reg_t init14_rx2_agc_tail[] = {
+    // 14_RX2_AGC (cont.)
+    REG(0x3, 0x920, 0x00000098),
+    REG(0x3, 0xB20, 0x00000098),
+    REG(0x3, 0x908, 0x00000000),
+    REG(0x3, 0xB08, 0x00000000),
+    REG(0x3, 0x908, 0x001FFF03),
+    REG(0x3, 0xB08, 0x001FFF03),
+};
+
+const dm6302_seq_t dm6302_seq_init0[] = {
+    SEQ(init0_init, DM6302_bwANY),
+    {NULL},
+};
+
+// Init1 ~ Init14
+const dm6302_seq_t dm6302_seq_bringup[] = {
+    SEQ(init1_bb_pll_3456_17m, DM6302_bw17M),
+    SEQ(init1_bb_pll_3456_27m, DM6302_bw27M),
+    SEQ(init2_rx1_pll_11316, DM6302_bwANY),
+    SEQ(init3_rx1_rf, DM6302_bwANY),
+    SEQ(init4_rx1_bbf_17m, DM6302_bw17M),
+    SEQ(init4_rx1_bbf_27m, DM6302_bw27M),
+    SEQ(init5_rx1_adc_17m, DM6302_bw17M),
+    SEQ(init5_rx1_adc_27m, DM6302_bw27M),
+    SEQ(init6_rx1_dfe, DM6302_bwANY),
+    SEQ(init6_rx1_dfe_17m, DM6302_bw17M),
+    SEQ(init6_rx1_dfe_27m, DM6302_bw27M),
+    SEQ(init7_rx1_fir_17m, DM6302_bw17M),
+    SEQ(init7_rx1_fir_27m, DM6302_bw27M),
+    SEQ(init8_rx1_agc, DM6302_bwANY),
+    SEQ(init9_rx2_rf, DM6302_bwANY),
+    SEQ(init10_rx2_bbf_17m, DM6302_bw17M),
+    SEQ(init10_rx2_bbf_27m, DM6302_bw27M),
+    SEQ(init11_rx2_adc_17m, DM6302_bw17M),
+    SEQ(init11_rx2_adc_27m, DM6302_bw27M),
+    SEQ(init12_rx2_fir_17m, DM6302_bw17M),
+    SEQ(init12_rx2_fir_27m, DM6302_bw27M),
+    SEQ(init13_rx2_dfe_17m, DM6302_bw17M),
+    SEQ(init13_rx2_dfe_27m, DM6302_bw27M),
+    SEQ(init14_rx2_agc, DM6302_bwANY),
+    SEQ(init14_rx2_agc_17m, DM6302_bw17M),
+    SEQ(init14_rx2_agc_27m, DM6302_bw27M),
+    SEQ(init14_rx2_agc_tail, DM6302_bwANY),
+    {NULL},
+};
+
+const dm6302_seq_t dm6302_seq_rx_pll[] = {
+    SEQ(init2_rx1_pll_11316, DM6302_bwANY),
+    {NULL},
+};
+
+const dm6302_seq_t dm6302_seq_rx_pll_low[] = {
+    SEQ(rx1_pll_low, DM6302_bwANY),
+    {NULL},
+};
+
+// M0 program, from address 0 of page 3
+const uint32_t dm6302_m0[DM6302_m0LEN] = {
+    0x0000C118,
+    0x000000D5,
+    0x00000135,
+    0x0000010D,
+    0x000003A0,
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    0x000002B1,
+    0x00000000,
+    0x00000000,
+    0x00000137,
+    0x000002B5,
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    0x00000175,
+    0x00000000,
+    0x00000000,
+    0x00000139,
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    0x46854803,
+    0xF810F000,
+    0x47004800,
+    0x000002F5,
+    0x0000C118,
+    0x47004803,
+    0xE7FEE7FE,
+    0xE7FEE7FE,
+    0xE7FEE7FE,
+    0x000000C1,
+    0x25014C06,
+    0xE0054E06,
+    0xCC0768E3,
+    0x3C0C432B,
+    0x34104798,
+    0xD3F742B4,
+    0xFFE2F7FF,
+    0x00000368,
+    0x00000388,
+    0x4802B672,
+    0x60480641,
+    0xE7FDBF30,
+    0x01233210,
+    0x28014904,
+    0x2000D003,
+    0x628843C0,
+    0x20004770,
+    0x0000E7FB,
+    0x00201080,
+    0x47704770,
+    0x2000B510,
+    0xFFEEF7FF,
+    0x07412021,
+    0x21006008,
+    0x43C94808,
+    0x00496281,
+    0x48076281,
+    0x21016A42,
+    0x430A0549,
+    0x6A426242,
+    0x6242438A,
+    0xF7FF2001,
+    0xBD10FFD9,
+    0x00200700,
+    0x00201080,
+    0x2000B510,
+    0xFFD0F7FF,
+    0x21012018,
+    0x60080749,
+    0x48092100,
+    0x610143C9,
+    0x61010049,
+    0x6A424807,
+    0x04892101,
+    0x6242430A,
+    0x438A6A42,
+    0x20016242,
+    0xFFBAF7FF,
+    0x0000BD10,
+    0x00200740,
+    0x00201080,
+    0x2800B5F0,
+    0x4938D03C,
+    0x4C386809,
+    0x0082B24B,
+    0x250A58A1,
+    0x17CD4369,
+    0x18690F2D,
+    0x4934110D,
+    0x58892606,
+    0x43711A59,
+    0x50A11869,
+    0xD02A2800,
+    0x3C084C2D,
+    0x4D2C6827,
+    0x3D904C2E,
+    0x2F1C2698,
+    0x2800D024,
+    0x4928D03A,
+    0x68093908,
+    0x01BF270F,
+    0xD13A42B9,
+    0x58894928,
+    0xDD3D4299,
+    0x4B224925,
+    0x3B783118,
+    0xD02C2800,
+    0x6814461A,
+    0x28002500,
+    0x461AD029,
+    0x28006015,
+    0x4619D000,
+    0xBDF0600C,
+    0x3190491C,
+    0x4C1BE7C0,
+    0xE7D33488,
+    0xDA232900,
+    0x0F9217CA,
+    0x22671851,
+    0x43D21089,
+    0x233F1A51,
+    0x43DBB249,
+    0xDD014291,
+    0xDB004299,
+    0x28004619,
+    0x462CD000,
+    0xBDF06021,
+    0xBDF06026,
+    0x3188490D,
+    0x460AE7C3,
+    0x460AE7D1,
+    0x2800E7D4,
+    0x4906D008,
+    0x68093908,
+    0xD0F02900,
+    0xD0ED2800,
+    0xE7EB462C,
+    0x31884904,
+    0x0000E7F5,
+    0x00200BB0,
+    0x0000C000,
+    0x0000C008,
+    0x00200920,
+    0x0000C010,
+    0x00004770,
+    0x20FFB510,
+    0x02004C05,
+    0x20006120,
+    0xFF78F7FF,
+    0xF7FF2001,
+    0x2000FF75,
+    0xBD106120,
+    0x00201000,
+    0xC808E002,
+    0xC1081F12,
+    0xD1FA2A00,
+    0x47704770,
+    0xE0012000,
+    0x1F12C101,
+    0xD1FB2A00,
+    0x00004770,
+    0x69814816,
+    0x12094B16,
+    0x1E49B249,
+    0x69806019,
+    0xB2411400,
+    0x30084618,
+    0x49126001,
+    0x1212698A,
+    0x1E52B252,
+    0x6989605A,
+    0xB2491409,
+    0x480F6041,
+    0x6141490D,
+    0x2207490E,
+    0x021B69CB,
+    0x04440A1B,
+    0x61CB4323,
+    0x61812100,
+    0xB6626102,
+    0x302420FF,
+    0x07492101,
+    0xBF306048,
+    0x0000E7FD,
+    0x00200940,
+    0x0000C008,
+    0x00200B40,
+    0x000002FF,
+    0xE000E000,
+    0xE000ED04,
+    0x00000388,
+    0x0000C000,
+    0x00000018,
+    0x000002D4,
+    0x000003A0,
+    0x0000C018,
+    0x00000100,
+    0x000002E4,
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    0x00000000,
+    0x31323032,
+    0x2D36302D,
+    0x31203332,
+    0x32323A30,
+    0x2036313A};
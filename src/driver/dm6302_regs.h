@@ -0,0 +1,44 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define DM6302_bwANY -1
+#define DM6302_bw27M 0
+#define DM6302_bw17M 1
+
+#define DM6302_m0LEN 237
+
+#define DM6302_pageWAIT 0xFF // not a register, dat is a delay in us
+
+// one register write
+typedef struct {
+    uint8_t page;
+    uint8_t ch; // 0, or 1 + the row of dm6302_ch_tab holding the value for the channel
+    uint16_t addr;
+    uint32_t dat;
+} dm6302_reg_t;
+
+// a table of registers, written in order; a sequence is a list of them
+// ending with a NULL regs
+typedef struct {
+    const dm6302_reg_t *regs;
+    uint16_t len;
+    int8_t bw; // DM6302_bwANY or the only bandwidth the table is for
+} dm6302_seq_t;
+
+extern const uint32_t dm6302_ch_tab[3][20];
+
+extern const dm6302_seq_t dm6302_seq_init0[];       // reset, 0xFF0 reads back 0x18 once it worked
+extern const dm6302_seq_t dm6302_seq_bringup[];     // Init1 ~ Init14
+extern const dm6302_seq_t dm6302_seq_rx_pll[];      // channel
+extern const dm6302_seq_t dm6302_seq_rx_pll_low[];  // channel, low band, E1 and F1
+
+extern const uint32_t dm6302_m0[DM6302_m0LEN];
+
+#ifdef __cplusplus
+}
+#endif
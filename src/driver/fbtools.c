@@ -37,7 +37,8 @@ int fb_open(PFBDEV pFbdev) {
 
     // map physics address to virtual address
     pFbdev->fb_mem_offset = (pFbdev->fb_fix.smem_start - (pFbdev->fb_fix.smem_start & ~(getpagesize() - 1)));
-    pFbdev->fb_mem = mmap(NULL, pFbdev->fb_fix.smem_len + pFbdev->fb_mem_offset, PROT_READ | PROT_WRITE, MAP_SHARED, pFbdev->fb, 0);
+    pFbdev->fb_mem_len = pFbdev->fb_fix.smem_len + pFbdev->fb_mem_offset;
+    pFbdev->fb_mem = mmap(NULL, pFbdev->fb_mem_len, PROT_READ | PROT_WRITE, MAP_SHARED, pFbdev->fb, 0);
 
     if (MAP_FAILED == pFbdev->fb_mem) {
         LOGE("mmap error! mem:%p offset:%ld", pFbdev->fb_mem, pFbdev->fb_mem_offset);
@@ -48,7 +49,7 @@ int fb_open(PFBDEV pFbdev) {
 
 // close frame buffer
 int fb_close(PFBDEV pFbdev) {
-    munmap(pFbdev->fb_mem, pFbdev->fb_fix.smem_len + pFbdev->fb_mem_offset);
+    munmap(pFbdev->fb_mem, pFbdev->fb_mem_len);
     pFbdev->fb_mem = NULL;
     close(pFbdev->fb);
     pFbdev->fb = -1;
@@ -71,13 +72,14 @@ void fb_memset(void *addr, int c, size_t len) {
 }
 
 void fb_sync(PFBDEV pFbdev) {
+    unsigned int bytes_per_pixel = pFbdev->fb_var.bits_per_pixel >> 3;
+
+    fb_sync_area(pFbdev, bytes_per_pixel * pFbdev->fb_var.xres, 0, 0, pFbdev->fb_var.xres, pFbdev->fb_var.yres);
+}
+
+static void fb_cache_sync(PFBDEV pFbdev, unsigned int pitch, int x, int y, int w, int h) {
     void *mem_start = pFbdev->fb_mem + pFbdev->fb_mem_offset;
     unsigned int bytes_per_pixel = pFbdev->fb_var.bits_per_pixel >> 3;
-    unsigned int pitch = bytes_per_pixel * pFbdev->fb_var.xres;
-    int x = 0;
-    int y = 0;
-    int w = pFbdev->fb_var.xres;
-    int h = pFbdev->fb_var.yres;
 
     void *args[2];
     void *dirty_rect_vir_addr_begin = (mem_start + pitch * y + bytes_per_pixel * x);
@@ -85,7 +87,13 @@ void fb_sync(PFBDEV pFbdev) {
     args[0] = dirty_rect_vir_addr_begin;
     args[1] = dirty_rect_vir_addr_end;
     ioctl(pFbdev->fb, FBIO_CACHE_SYNC, args);
+}
+
+// cache sync and pan only the dirty rectangle (x, y, w, h) of a frame laid out with the given pitch
+void fb_sync_area(PFBDEV pFbdev, unsigned int pitch, int x, int y, int w, int h) {
+    fb_cache_sync(pFbdev, pitch, x, y, w, h);
 
+    pFbdev->fb_var.xoffset = 0;
     pFbdev->fb_var.yoffset = 0;
     pFbdev->fb_var.reserved[0] = x;
     pFbdev->fb_var.reserved[1] = y;
@@ -94,6 +102,70 @@ void fb_sync(PFBDEV pFbdev) {
     ioctl(pFbdev->fb, FBIOPAN_DISPLAY, &pFbdev->fb_var);
 }
 
+// lay out the virtual screen as `pages` stacked pages of xres_virtual x yres pixels,
+// the previous layout is restored if the driver or the mapped memory can't hold them
+int fb_set_pages(PFBDEV pFbdev, int xres_virtual, int yres, int pages) {
+    struct fb_var_screeninfo var_prev = pFbdev->fb_var;
+    struct fb_var_screeninfo var = pFbdev->fb_var;
+    unsigned int bytes_per_pixel = var.bits_per_pixel >> 3;
+
+    var.xres_virtual = xres_virtual;
+    var.yres_virtual = yres * pages;
+    var.xoffset = 0;
+    var.yoffset = 0;
+
+    if (-1 == ioctl(pFbdev->fb, FBIOPUT_VSCREENINFO, &var)) {
+        LOGE("ioctl FBIOPUT_VSCREENINFO %dx%d", var.xres_virtual, var.yres_virtual);
+        return -1;
+    }
+
+    ioctl(pFbdev->fb, FBIOGET_VSCREENINFO, &(pFbdev->fb_var));
+    ioctl(pFbdev->fb, FBIOGET_FSCREENINFO, &(pFbdev->fb_fix));
+
+    if (pFbdev->fb_fix.line_length != xres_virtual * bytes_per_pixel ||
+        pFbdev->fb_var.yres_virtual < var.yres_virtual ||
+        pFbdev->fb_mem_len - pFbdev->fb_mem_offset < pFbdev->fb_fix.line_length * var.yres_virtual) {
+        LOGE("fb can't hold %d pages of %dx%d", pages, xres_virtual, yres);
+        ioctl(pFbdev->fb, FBIOPUT_VSCREENINFO, &var_prev);
+        ioctl(pFbdev->fb, FBIOGET_VSCREENINFO, &(pFbdev->fb_var));
+        ioctl(pFbdev->fb, FBIOGET_FSCREENINFO, &(pFbdev->fb_fix));
+        return -1;
+    }
+    return 0;
+}
+
+// blocks until the next vertical blank, once the driver turns out not to
+// support it this is a no-op
+static void fb_wait_vsync(PFBDEV pFbdev) {
+    static bool unsupported = false;
+    __u32 crtc = 0;
+
+    if (!unsupported && -1 == ioctl(pFbdev->fb, FBIO_WAITFORVSYNC, &crtc)) {
+        LOGW("ioctl FBIO_WAITFORVSYNC: %m, flips are not vsync'ed");
+        unsupported = true;
+    }
+}
+
+// cache sync the rectangle (x, y, w, h) of the virtual screen and
+// show the window starting at (xoffset, yoffset), returns once it is shown
+void fb_flip(PFBDEV pFbdev, int xoffset, int yoffset, int x, int y, int w, int h) {
+    if (w > 0 && h > 0) {
+        fb_cache_sync(pFbdev, pFbdev->fb_fix.line_length, x, y, w, h);
+    }
+
+    pFbdev->fb_var.xoffset = xoffset;
+    pFbdev->fb_var.yoffset = yoffset;
+    pFbdev->fb_var.reserved[0] = 0;
+    pFbdev->fb_var.reserved[1] = 0;
+    pFbdev->fb_var.reserved[2] = pFbdev->fb_var.xres;
+    pFbdev->fb_var.reserved[3] = pFbdev->fb_var.yres;
+    ioctl(pFbdev->fb, FBIOPAN_DISPLAY, &pFbdev->fb_var);
+
+    // the pan takes effect on the next vblank, the page it left is only free
+    // to be drawn into after that
+    fb_wait_vsync(pFbdev);
+}
+
 int fb_clean() {
     FBDEV fbdev;
     memset(&fbdev, 0x0, sizeof(FBDEV));
@@ -16,6 +16,7 @@ extern "C" {
 typedef struct fbdev {
     int fb;
     unsigned long fb_mem_offset;
+    unsigned long fb_mem_len; // bytes mapped at fb_mem
     void *fb_mem;
     struct fb_fix_screeninfo fb_fix;
     struct fb_var_screeninfo fb_var;
@@ -28,6 +29,9 @@ int fb_close(PFBDEV pFbdev);
 int get_display_depth(PFBDEV pFbdev);
 void fb_memset(void *addr, int c, size_t len);
 void fb_sync(PFBDEV pFbdev);
+void fb_sync_area(PFBDEV pFbdev, unsigned int pitch, int x, int y, int w, int h);
+int fb_set_pages(PFBDEV pFbdev, int xres_virtual, int yres, int pages);
+void fb_flip(PFBDEV pFbdev, int xoffset, int yoffset, int x, int y, int w, int h);
 
 #ifdef __cplusplus
 }
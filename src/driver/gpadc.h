@@ -7,7 +7,6 @@ extern "C" {
 #include <stdint.h>
 
 #define GPADC_INIT "/mnt/app/script/set_gpadc.sh"
-#define ADC0_FILE  "/tmp/adc0"
 
 void gpadc_init();
 void gpadc_on(uint8_t is_on);
@@ -22,6 +22,7 @@
 #include "driver/screen.h"
 #include "dvr.h"
 #include "hardware.h"
+#include "hwio.h"
 #include "i2c.h"
 #include "it66021.h"
 #include "it66121.h"
@@ -213,14 +214,12 @@ DCLK_DLY_NUM[5:0]
 void vdpo_sync_ctrl_set(bool dclk_invert, bool dclk_dly_en, uint8_t dvlk_dly_num) {
     const uint32_t addr = 0x06542008;
     uint32_t dat = 0x00000003;
-    char buf[32];
 
     dat |= (dclk_invert << 3);
     dat |= (dvlk_dly_num << 4);
     dat |= (dclk_dly_en << 10);
 
-    snprintf(buf, sizeof(buf), "aww 0x%08x 0x%08x", addr, dat);
-    system_exec(buf);
+    hwio_write(addr, dat);
 }
 
 /*
@@ -232,19 +231,15 @@ default value : 9
 void csic_pclk_dly_set(uint8_t pclk_dly_num) {
     const uint32_t addr = 0x06601500;
     uint32_t dat = pclk_dly_num;
-    char buf[32];
 
-    snprintf(buf, sizeof(buf), "aww 0x%08x 0x%08x", addr, dat);
-    system_exec(buf);
+    hwio_write(addr, dat);
 }
 
 void csic_pclk_invert_set(uint8_t is_invert) {
     const uint32_t addr = 0x06601004;
     uint32_t dat = is_invert ? 0x010000A0 : 0x010100A0;
-    char buf[32];
 
-    snprintf(buf, sizeof(buf), "aww 0x%08x 0x%08x", addr, dat);
-    system_exec(buf);
+    hwio_write(addr, dat);
 }
 
 void pclk_phase_set(video_source_t source) {
@@ -482,49 +477,49 @@ void Display_HDZ_t(int mode, int is_43) {
 
     switch (mode) {
     case VR_720P50:
-        system_exec("dispw -s vdpo 720p50");
+        hwio_vdpo_mode("720p50");
         g_hw_stat.vdpo_tmg = VDPO_TMG_720P50;
         I2C_Write(ADDR_FPGA, 0x80, 0x00);
         pclk_phase_set(VIDEO_SOURCE_HDZERO_IN_720P60_50);
         break;
     case VR_720P60:
-        system_exec("dispw -s vdpo 720p60");
+        hwio_vdpo_mode("720p60");
         g_hw_stat.vdpo_tmg = VDPO_TMG_720P60;
         I2C_Write(ADDR_FPGA, 0x80, 0x00);
         pclk_phase_set(VIDEO_SOURCE_HDZERO_IN_720P60_50);
         break;
     case VR_960x720P60:
-        system_exec("dispw -s vdpo 720p60");
+        hwio_vdpo_mode("720p60");
         g_hw_stat.vdpo_tmg = VDPO_TMG_720P60;
         I2C_Write(ADDR_FPGA, 0x80, 0x00);
         pclk_phase_set(VIDEO_SOURCE_HDZERO_IN_720P60_50);
         break;
     case VR_540P60:
-        system_exec("dispw -s vdpo 720p60");
+        hwio_vdpo_mode("720p60");
         g_hw_stat.vdpo_tmg = VDPO_TMG_720P60;
         I2C_Write(ADDR_FPGA, 0x80, 0x01);
         pclk_phase_set(VIDEO_SOURCE_HDZERO_IN_720P60_50);
         break;
     case VR_540P90:
-        system_exec("dispw -s vdpo 720p90");
+        hwio_vdpo_mode("720p90");
         g_hw_stat.vdpo_tmg = VDPO_TMG_720P90;
         I2C_Write(ADDR_FPGA, 0x80, 0x03);
         pclk_phase_set(VIDEO_SOURCE_HDZERO_IN_720P90);
         break;
     case VR_540P90_CROP:
-        system_exec("dispw -s vdpo 720p90");
+        hwio_vdpo_mode("720p90");
         g_hw_stat.vdpo_tmg = VDPO_TMG_720P90;
         I2C_Write(ADDR_FPGA, 0x80, 0x03);
         pclk_phase_set(VIDEO_SOURCE_HDZERO_IN_720P90);
         break;
     case VR_1080P30:
-        system_exec("dispw -s vdpo 720p60");
+        hwio_vdpo_mode("720p60");
         g_hw_stat.vdpo_tmg = VDPO_TMG_720P60;
         I2C_Write(ADDR_FPGA, 0x80, 0x04);
         pclk_phase_set(VIDEO_SOURCE_HDZERO_IN_720P60_50);
         break;
     case VR_1080P24:
-        system_exec("dispw -s vdpo 720p50");
+        hwio_vdpo_mode("720p50");
         g_hw_stat.vdpo_tmg = VDPO_TMG_720P60;
         I2C_Write(ADDR_FPGA, 0x80, 0x84);
         pclk_phase_set(VIDEO_SOURCE_HDZERO_IN_720P60_50);
@@ -538,7 +533,7 @@ void Display_HDZ_t(int mode, int is_43) {
     Display_VO_SWITCH(1);
     screen.display(1);
     I2C_Write(ADDR_FPGA, 0x8C, 0x01);
-    system_exec("aww 0x06542018 0x00000044"); // disable horizontal chroma FIR filter.
+    hwio_write(0x06542018, 0x00000044); // disable horizontal chroma FIR filter.
 }
 
 void Display_HDZ(int mode, int is_43) {
@@ -590,14 +585,14 @@ void Display_UI_init() {
     I2C_Write(ADDR_FPGA, 0x80, 0x00);
     I2C_Write(ADDR_FPGA, 0x84, 0x11);
 
-    system_exec("dispw -s vdpo 720p60");
+    hwio_vdpo_mode("720p60");
     g_hw_stat.vdpo_tmg = VDPO_TMG_720P60;
     Display_VO_SWITCH(0);
 
     pclk_phase_set(VIDEO_SOURCE_MENU_UI);
 
     screen.display(1);
-    system_exec("aww 0x06542018 0x00000044"); // disable horizontal chroma FIR filter.
+    hwio_write(0x06542018, 0x00000044); // disable horizontal chroma FIR filter.
 }
 
 void Display_UI() {
@@ -666,16 +661,16 @@ int HDZERO_detect() // return = 1: vtmg to V536 changed
 
 void AV_Mode_Switch_fpga(int is_pal) {
     if (is_pal) {
-        system_exec("dispw -s vdpo 720p50");
+        hwio_vdpo_mode("720p50");
         g_hw_stat.vdpo_tmg = VDPO_TMG_720P50;
         I2C_Write(ADDR_FPGA, 0x80, 0x10);
     } else {
-        system_exec("dispw -s vdpo 720p60");
+        hwio_vdpo_mode("720p60");
         g_hw_stat.vdpo_tmg = VDPO_TMG_720P60;
         I2C_Write(ADDR_FPGA, 0x80, 0x00);
     }
     I2C_Write(ADDR_FPGA, 0x06, 0x0F);
-    system_exec("aww 0x06542018 0x00000044"); // disable horizontal chroma FIR filter.
+    hwio_write(0x06542018, 0x00000044); // disable horizontal chroma FIR filter.
     pclk_phase_set(VIDEO_SOURCE_AV_IN);
 }
 
@@ -876,7 +871,7 @@ int HDMI_in_detect() {
                         break;
 
                     case HDMIIN_VTMG_1080P60:
-                        system_exec("dispw -s vdpo 720p60");
+                        hwio_vdpo_mode("720p60");
                         dvr_update_vi_conf(VR_1080P60);
                         g_hw_stat.vdpo_tmg = VDPO_TMG_720P60;
                         I2C_Write(ADDR_FPGA, 0x8D, 0x04);
@@ -888,7 +883,7 @@ int HDMI_in_detect() {
                         break;
 
                     case HDMIIN_VTMG_1080P50:
-                        system_exec("dispw -s vdpo 720p50");
+                        hwio_vdpo_mode("720p50");
                         dvr_update_vi_conf(VR_1080P50);
                         g_hw_stat.vdpo_tmg = VDPO_TMG_720P50;
                         I2C_Write(ADDR_FPGA, 0x8D, 0x04);
@@ -900,7 +895,7 @@ int HDMI_in_detect() {
                         break;
 
                     case HDMIIN_VTMG_1080Pother:
-                        system_exec("dispw -s vdpo 720p60");
+                        hwio_vdpo_mode("720p60");
                         dvr_update_vi_conf(VR_1080P50);
                         g_hw_stat.vdpo_tmg = VDPO_TMG_720P60;
                         I2C_Write(ADDR_FPGA, 0x8D, 0x14);
@@ -912,7 +907,7 @@ int HDMI_in_detect() {
                         break;
 
                     case HDMIIN_VTMG_720P50:
-                        system_exec("dispw -s vdpo 720p50");
+                        hwio_vdpo_mode("720p50");
                         dvr_update_vi_conf(VR_720P50);
                         g_hw_stat.vdpo_tmg = VDPO_TMG_720P50;
                         I2C_Write(ADDR_FPGA, 0x8D, 0x14);
@@ -925,7 +920,7 @@ int HDMI_in_detect() {
                         break;
 
                     case HDMIIN_VTMG_720P60:
-                        system_exec("dispw -s vdpo 720p60");
+                        hwio_vdpo_mode("720p60");
                         dvr_update_vi_conf(VR_720P60);
                         g_hw_stat.vdpo_tmg = VDPO_TMG_720P60;
                         I2C_Write(ADDR_FPGA, 0x8D, 0x14);
@@ -937,7 +932,7 @@ int HDMI_in_detect() {
                         break;
 
                     case HDMIIN_VTMG_720P100:
-                        system_exec("dispw -s vdpo 720p30"); // 100fps actually
+                        hwio_vdpo_mode("720p30"); // 100fps actually
                         dvr_update_vi_conf(VR_540P90);
                         g_hw_stat.vdpo_tmg = VDPO_TMG_720P100;
                         I2C_Write(ADDR_FPGA, 0x8D, 0x04);
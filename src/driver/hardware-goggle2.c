@@ -21,6 +21,7 @@
 #include "dm6302.h"
 #include "dvr.h"
 #include "hardware.h"
+#include "hwio.h"
 #include "i2c.h"
 #include "it66021.h"
 #include "it66121.h"
@@ -480,14 +481,12 @@ DCLK_DLY_NUM[5:0]
 void vdpo_sync_ctrl_set(bool dclk_invert, bool dclk_dly_en, uint8_t dvlk_dly_num) {
     const uint32_t addr = 0x06542008;
     uint32_t dat = 0x00000003;
-    char buf[32];
 
     dat |= (dclk_invert << 3);
     dat |= (dvlk_dly_num << 4);
     dat |= (dclk_dly_en << 10);
 
-    snprintf(buf, sizeof(buf), "aww 0x%08x 0x%08x", addr, dat);
-    system_exec(buf);
+    hwio_write(addr, dat);
 }
 
 /*
@@ -499,19 +498,15 @@ default value : 9
 void csic_pclk_dly_set(uint8_t pclk_dly_num) {
     const uint32_t addr = 0x06601500;
     uint32_t dat = pclk_dly_num;
-    char buf[32];
 
-    snprintf(buf, sizeof(buf), "aww 0x%08x 0x%08x", addr, dat);
-    system_exec(buf);
+    hwio_write(addr, dat);
 }
 
 void csic_pclk_invert_set(uint8_t is_invert) {
     const uint32_t addr = 0x06601004;
     uint32_t dat = is_invert ? 0x010000A0 : 0x010100A0;
-    char buf[32];
 
-    snprintf(buf, sizeof(buf), "aww 0x%08x 0x%08x", addr, dat);
-    system_exec(buf);
+    hwio_write(addr, dat);
 }
 
 void pclk_phase_set(video_source_t source) {
@@ -578,9 +573,9 @@ void Display_UI_init() {
     g_hw_stat.source_mode = SOURCE_MODE_UI;
     I2C_Write(ADDR_FPGA, 0x8C, 0x00);
 
-    system_exec("dispw -s vdpo 1080p50");
+    hwio_vdpo_mode("1080p50");
     g_hw_stat.vdpo_tmg = VDPO_TMG_1080P50;
-    system_exec("aww 0x0300b340 0x00000008");
+    hwio_write(0x0300b340, 0x00000008);
     Display_VO_SWITCH(0);
 
     vclk_phase_set(VIDEO_SOURCE_MENU_UI, 0);
@@ -589,9 +584,9 @@ void Display_UI_init() {
     I2C_Write(ADDR_FPGA, 0x84, 0x11);
 
     screen.vtmg(0);
-    system_exec("aww 0x0300b084 0x00002aaa"); // Set vdpo clock driver strength to level 2. Refer datasheet 12.7.5.11
+    hwio_write(0x0300b084, 0x00002aaa); // Set vdpo clock driver strength to level 2. Refer datasheet 12.7.5.11
     I2C_Write(ADDR_FPGA, 0xa7, 0x00);
-    system_exec("aww 0x06542018 0x00000044"); // disable horizontal chroma FIR filter.
+    hwio_write(0x06542018, 0x00000044); // disable horizontal chroma FIR filter.
 }
 
 void Display_UI() {
@@ -608,7 +603,7 @@ void Display_720P60_50_t(int mode, uint8_t is_43) // fps: 0=50, 1=60
     screen.display(0);
     I2C_Write(ADDR_FPGA, 0x8C, 0x00);
 
-    system_exec("dispw -s vdpo 720p60");
+    hwio_vdpo_mode("720p60");
     g_hw_stat.vdpo_tmg = VDPO_TMG_720P60;
     vclk_phase_set(VIDEO_SOURCE_HDZERO_IN_720P60_50, 0);
     pclk_phase_set(VIDEO_SOURCE_HDZERO_IN_720P60_50);
@@ -630,14 +625,14 @@ void Display_720P60_50_t(int mode, uint8_t is_43) // fps: 0=50, 1=60
     g_hw_stat.source_mode = SOURCE_MODE_HDZERO;
     Display_VO_SWITCH(1);
     screen.display(1);
-    system_exec("aww 0x06542018 0x00000044"); // disable horizontal chroma FIR filter.
+    hwio_write(0x06542018, 0x00000044); // disable horizontal chroma FIR filter.
 }
 
 void Display_720P90_t(int mode) {
     screen.display(0);
     I2C_Write(ADDR_FPGA, 0x8C, 0x00);
 
-    system_exec("dispw -s vdpo 720p90");
+    hwio_vdpo_mode("720p90");
     g_hw_stat.vdpo_tmg = VDPO_TMG_720P90;
     vclk_phase_set(VIDEO_SOURCE_HDZERO_IN_720P90, 0);
     pclk_phase_set(VIDEO_SOURCE_HDZERO_IN_720P90);
@@ -653,14 +648,14 @@ void Display_720P90_t(int mode) {
     g_hw_stat.source_mode = SOURCE_MODE_HDZERO;
     Display_VO_SWITCH(1);
     screen.display(1);
-    system_exec("aww 0x06542018 0x00000044"); // disable horizontal chroma FIR filter.
+    hwio_write(0x06542018, 0x00000044); // disable horizontal chroma FIR filter.
 }
 
 void Display_1080P30_t(int mode) {
     screen.display(0);
     I2C_Write(ADDR_FPGA, 0x8C, 0x00);
 
-    system_exec("dispw -s vdpo 1080p60");
+    hwio_vdpo_mode("1080p60");
     g_hw_stat.vdpo_tmg = VDPO_TMG_1080P60;
     vclk_phase_set(VIDEO_SOURCE_HDZERO_IN_1080P30, 0);
     pclk_phase_set(VIDEO_SOURCE_HDZERO_IN_1080P30);
@@ -677,14 +672,14 @@ void Display_1080P30_t(int mode) {
     g_hw_stat.source_mode = SOURCE_MODE_HDZERO;
     Display_VO_SWITCH(1);
     screen.display(1);
-    system_exec("aww 0x06542018 0x00000044"); // disable horizontal chroma FIR filter.
+    hwio_write(0x06542018, 0x00000044); // disable horizontal chroma FIR filter.
 }
 
 void Display_1080P24_t(int mode) {
     screen.display(0);
     I2C_Write(ADDR_FPGA, 0x8C, 0x00);
 
-    system_exec("dispw -s vdpo 1080p60");
+    hwio_vdpo_mode("1080p60");
     g_hw_stat.vdpo_tmg = VDPO_TMG_1080P60;
     vclk_phase_set(VIDEO_SOURCE_HDZERO_IN_1080P30, 0);
     pclk_phase_set(VIDEO_SOURCE_HDZERO_IN_1080P30);
@@ -701,7 +696,7 @@ void Display_1080P24_t(int mode) {
     g_hw_stat.source_mode = SOURCE_MODE_HDZERO;
     Display_VO_SWITCH(1);
     screen.display(1);
-    system_exec("aww 0x06542018 0x00000044"); // disable horizontal chroma FIR filter.
+    hwio_write(0x06542018, 0x00000044); // disable horizontal chroma FIR filter.
 }
 
 void Display_720P60_50(int mode, uint8_t is_43) {
@@ -815,16 +810,16 @@ int HDZERO_detect() // return = 1: vtmg to V536 changed
 
 void AV_Mode_Switch_fpga(int is_pal) {
     if (is_pal) {
-        system_exec("dispw -s vdpo 720p50");
+        hwio_vdpo_mode("720p50");
         g_hw_stat.vdpo_tmg = VDPO_TMG_720P50;
         I2C_Write(ADDR_FPGA, 0x80, 0x10);
     } else {
-        system_exec("dispw -s vdpo 720p60");
+        hwio_vdpo_mode("720p60");
         g_hw_stat.vdpo_tmg = VDPO_TMG_720P60;
         I2C_Write(ADDR_FPGA, 0x80, 0x00);
     }
     I2C_Write(ADDR_FPGA, 0x06, 0x0F);
-    system_exec("aww 0x06542018 0x00000044"); // disable horizontal chroma FIR filter.
+    hwio_write(0x06542018, 0x00000044); // disable horizontal chroma FIR filter.
 }
 
 void AV_Mode_Switch(int is_pal) {
@@ -1028,7 +1023,7 @@ int HDMI_in_detect() {
                         break;
 
                     case HDMIIN_VTMG_1080P60:
-                        system_exec("dispw -s vdpo 1080p60");
+                        hwio_vdpo_mode("1080p60");
                         dvr_update_vi_conf(VR_1080P60);
                         g_hw_stat.vdpo_tmg = VDPO_TMG_1080P60;
                         vclk_phase_set(VIDEO_SOURCE_HDMI_IN_1080P60, (freq_ref < 63));
@@ -1044,7 +1039,7 @@ int HDMI_in_detect() {
                         break;
 
                     case HDMIIN_VTMG_1080P50:
-                        system_exec("dispw -s vdpo 1080p50");
+                        hwio_vdpo_mode("1080p50");
                         dvr_update_vi_conf(VR_1080P50);
                         g_hw_stat.vdpo_tmg = VDPO_TMG_1080P50;
                         vclk_phase_set(VIDEO_SOURCE_HDMI_IN_1080P50, (freq_ref < 63));
@@ -1061,7 +1056,7 @@ int HDMI_in_detect() {
                         break;
 
                     case HDMIIN_VTMG_1080Pother:
-                        system_exec("dispw -s vdpo 1080p60");
+                        hwio_vdpo_mode("1080p60");
                         dvr_update_vi_conf(VR_1080P60);
                         g_hw_stat.vdpo_tmg = VDPO_TMG_1080P60;
                         vclk_phase_set(VIDEO_SOURCE_HDMI_IN_1080P60, (freq_ref < 63));
@@ -1078,7 +1073,7 @@ int HDMI_in_detect() {
                         break;
 
                     case HDMIIN_VTMG_720P50:
-                        system_exec("dispw -s vdpo 720p50");
+                        hwio_vdpo_mode("720p50");
                         dvr_update_vi_conf(VR_720P50);
                         g_hw_stat.vdpo_tmg = VDPO_TMG_720P50;
                         vclk_phase_set(VIDEO_SOURCE_HDMI_IN_720P50, (freq_ref < 63));
@@ -1095,7 +1090,7 @@ int HDMI_in_detect() {
                         break;
 
                     case HDMIIN_VTMG_720P60:
-                        system_exec("dispw -s vdpo 720p60");
+                        hwio_vdpo_mode("720p60");
                         dvr_update_vi_conf(VR_720P60);
                         g_hw_stat.vdpo_tmg = VDPO_TMG_720P60;
                         vclk_phase_set(VIDEO_SOURCE_HDMI_IN_720P60, (freq_ref < 63));
@@ -1111,7 +1106,7 @@ int HDMI_in_detect() {
                         break;
 
                     case HDMIIN_VTMG_720P100:
-                        system_exec("dispw -s vdpo 720p30"); // 100fps actually
+                        hwio_vdpo_mode("720p30"); // 100fps actually
                         dvr_update_vi_conf(VR_540P90);
                         g_hw_stat.vdpo_tmg = VDPO_TMG_720P100;
                         vclk_phase_set(VIDEO_SOURCE_HDMI_IN_720P100, (freq_ref < 63));
@@ -1228,7 +1223,7 @@ int Get_HAN_status() // ret: 0=error; 1=ok
 {
     uint8_t rdat;
 
-    system_exec("aww 0x0300b340 0x00000008");
+    hwio_write(0x0300b340, 0x00000008);
 
     I2C_Write(ADDR_FPGA, 0x81, 0x01);
 
@@ -0,0 +1,324 @@
+#include "hwio.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <sound/asound.h>
+
+// the display header takes the kernel types
+typedef unsigned char u8;
+typedef unsigned short u16;
+typedef unsigned int u32;
+typedef unsigned long long u64;
+typedef signed int s32;
+typedef signed long long s64;
+#include <video/sunxi_display2.h>
+
+#include <log/log.h>
+
+#include "hwio_fake.h"
+#include "util/system.h"
+
+#define HWIO_MEM_DEV   "/dev/mem"
+#define HWIO_SND_CTL   "/dev/snd/controlC0"
+#define HWIO_DISP_DEV  "/dev/disp"
+#define HWIO_AWR_FILE  "/tmp/hwio_awr"
+
+#define HWIO_pageSIZE 4096
+#define HWIO_MAPS     16
+
+typedef struct {
+    uint32_t base;
+    volatile uint32_t *ptr;
+} hwio_map_t;
+
+static pthread_mutex_t g_hwio_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t g_hwio_once = PTHREAD_ONCE_INIT;
+static const hwio_ops_t *g_hwio_ops = &hwio_dev_ops;
+
+static int g_mem_fd = -1;
+static bool g_mem_failed = false;
+static hwio_map_t g_maps[HWIO_MAPS];
+static int g_nmaps = 0;
+
+static int g_snd_fd = -1;
+static int g_disp_fd = -1;
+
+///////////////////////////////////////////////////////////////////////////////
+// device backend
+
+// the register mapped in, NULL if /dev/mem can't be used
+static volatile uint32_t *dev_reg(uint32_t addr) {
+    uint32_t base = addr & ~(HWIO_pageSIZE - 1);
+    volatile uint32_t *reg = NULL;
+    void *ptr;
+
+    pthread_mutex_lock(&g_hwio_mutex);
+
+    for (int i = 0; i < g_nmaps; i++) {
+        if (g_maps[i].base == base) {
+            reg = g_maps[i].ptr + (addr - base) / 4;
+            goto out;
+        }
+    }
+
+    if (g_mem_failed || g_nmaps == HWIO_MAPS) {
+        goto out;
+    }
+    if (g_mem_fd < 0) {
+        g_mem_fd = open(HWIO_MEM_DEV, O_RDWR | O_SYNC | O_CLOEXEC);
+        if (g_mem_fd < 0) {
+            LOGE("hwio: %s: %s, using aww", HWIO_MEM_DEV, strerror(errno));
+            g_mem_failed = true;
+            goto out;
+        }
+    }
+
+    ptr = mmap(NULL, HWIO_pageSIZE, PROT_READ | PROT_WRITE, MAP_SHARED, g_mem_fd, base);
+    if (ptr == MAP_FAILED) {
+        LOGE("hwio: map 0x%08x: %s", base, strerror(errno));
+        goto out;
+    }
+
+    g_maps[g_nmaps].base = base;
+    g_maps[g_nmaps].ptr = ptr;
+    g_nmaps++;
+    reg = (volatile uint32_t *)ptr + (addr - base) / 4;
+
+out:
+    pthread_mutex_unlock(&g_hwio_mutex);
+    return reg;
+}
+
+static uint32_t dev_read(uint32_t addr) {
+    volatile uint32_t *reg = dev_reg(addr);
+    char buf[64];
+    uint32_t raddr, val;
+    FILE *file;
+
+    if (reg) {
+        return *reg;
+    }
+
+    snprintf(buf, sizeof(buf), "awr 0x%08x > %s", addr, HWIO_AWR_FILE);
+    system(buf);
+
+    file = fopen(HWIO_AWR_FILE, "r");
+    if (file == NULL) {
+        return 0;
+    }
+    if (fscanf(file, "read 0x%x:0x%x", &raddr, &val) != 2 || raddr != addr) {
+        val = 0;
+    }
+    fclose(file);
+    return val;
+}
+
+static void dev_write(uint32_t addr, uint32_t val) {
+    volatile uint32_t *reg = dev_reg(addr);
+    char buf[64];
+
+    if (reg) {
+        *reg = val;
+        return;
+    }
+
+    snprintf(buf, sizeof(buf), "aww 0x%08x 0x%08x", addr, val);
+    system_exec(buf);
+}
+
+static int dev_mixer_ioctl(const char *name, int value) {
+    struct snd_ctl_elem_info info;
+    struct snd_ctl_elem_value elem;
+
+    if (g_snd_fd < 0) {
+        g_snd_fd = open(HWIO_SND_CTL, O_RDWR | O_CLOEXEC);
+        if (g_snd_fd < 0) {
+            return -1;
+        }
+    }
+
+    memset(&info, 0, sizeof(info));
+    info.id.iface = SNDRV_CTL_ELEM_IFACE_MIXER;
+    strncpy((char *)info.id.name, name, sizeof(info.id.name) - 1);
+    if (ioctl(g_snd_fd, SNDRV_CTL_IOCTL_ELEM_INFO, &info) < 0) {
+        return -1;
+    }
+
+    memset(&elem, 0, sizeof(elem));
+    elem.id = info.id;
+    for (unsigned i = 0; i < info.count; i++) {
+        switch (info.type) {
+        case SNDRV_CTL_ELEM_TYPE_BOOLEAN:
+        case SNDRV_CTL_ELEM_TYPE_INTEGER:
+            if (i >= sizeof(elem.value.integer.value) / sizeof(elem.value.integer.value[0]))
+                return -1;
+            elem.value.integer.value[i] = value;
+            break;
+        case SNDRV_CTL_ELEM_TYPE_ENUMERATED:
+            if (i >= sizeof(elem.value.enumerated.item) / sizeof(elem.value.enumerated.item[0]))
+                return -1;
+            elem.value.enumerated.item[i] = value;
+            break;
+        default:
+            return -1;
+        }
+    }
+
+    return ioctl(g_snd_fd, SNDRV_CTL_IOCTL_ELEM_WRITE, &elem) < 0 ? -1 : 0;
+}
+
+static int dev_mixer_set(const char *name, int value) {
+    char buf[128];
+    int ret;
+
+    pthread_mutex_lock(&g_hwio_mutex);
+    ret = dev_mixer_ioctl(name, value);
+    pthread_mutex_unlock(&g_hwio_mutex);
+
+    if (ret < 0) {
+        snprintf(buf, sizeof(buf), "amixer cset name='%s' %d", name, value);
+        ret = system_exec(buf);
+    }
+    return ret;
+}
+
+static const struct {
+    const char *name;
+    enum disp_tv_mode mode;
+} vdpo_modes[] = {
+    {"720p50", DISP_TV_MOD_720P_50HZ},
+    {"720p60", DISP_TV_MOD_720P_60HZ},
+    {"1080p50", DISP_TV_MOD_1080P_50HZ},
+    {"1080p60", DISP_TV_MOD_1080P_60HZ},
+};
+
+// the screen driving vdpo, -1 if none yet
+static int dev_vdpo_screen(struct disp_output *output) {
+    unsigned long args[4] = {0};
+
+    for (int screen = 0; screen < 2; screen++) {
+        args[0] = screen;
+        args[1] = (unsigned long)output;
+        if (ioctl(g_disp_fd, DISP_GET_OUTPUT, args) == 0 && output->type == DISP_OUTPUT_TYPE_VDPO) {
+            return screen;
+        }
+    }
+    return -1;
+}
+
+// switches an output already on vdpo to a standard mode; dispw knows the
+// board's own ones (720p90 ...) and does the first switch
+static int dev_vdpo_ioctl(const char *mode) {
+    unsigned long args[4] = {0};
+    struct disp_output output;
+    int screen, i;
+
+    for (i = 0; i < sizeof(vdpo_modes) / sizeof(vdpo_modes[0]); i++) {
+        if (strcmp(vdpo_modes[i].name, mode) == 0)
+            break;
+    }
+    if (i == sizeof(vdpo_modes) / sizeof(vdpo_modes[0])) {
+        return -1;
+    }
+
+    if (g_disp_fd < 0) {
+        g_disp_fd = open(HWIO_DISP_DEV, O_RDWR | O_CLOEXEC);
+        if (g_disp_fd < 0) {
+            return -1;
+        }
+    }
+
+    screen = dev_vdpo_screen(&output);
+    if (screen < 0) {
+        return -1;
+    }
+
+    args[0] = screen;
+    args[1] = DISP_OUTPUT_TYPE_VDPO;
+    args[2] = vdpo_modes[i].mode;
+    if (ioctl(g_disp_fd, DISP_DEVICE_SWITCH, args) < 0) {
+        return -1;
+    }
+
+    // taken as it is only if the driver reports the mode
+    if (dev_vdpo_screen(&output) != screen || output.mode != vdpo_modes[i].mode) {
+        return -1;
+    }
+    return 0;
+}
+
+static int dev_vdpo_mode(const char *mode) {
+    char buf[64];
+    int ret;
+
+    pthread_mutex_lock(&g_hwio_mutex);
+    ret = dev_vdpo_ioctl(mode);
+    pthread_mutex_unlock(&g_hwio_mutex);
+
+    if (ret < 0) {
+        snprintf(buf, sizeof(buf), "dispw -s vdpo %s", mode);
+        ret = system_exec(buf);
+    }
+    return ret;
+}
+
+const hwio_ops_t hwio_dev_ops = {
+    .read = dev_read,
+    .write = dev_write,
+    .mixer_set = dev_mixer_set,
+    .vdpo_mode = dev_vdpo_mode,
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+static void hwio_select() {
+    if (hwio_fake_init()) {
+        LOGI("hwio: fake backend");
+        g_hwio_ops = &hwio_fake_ops;
+    }
+}
+
+static const hwio_ops_t *hwio_ops() {
+    pthread_once(&g_hwio_once, hwio_select);
+    return g_hwio_ops;
+}
+
+void hwio_set_ops(const hwio_ops_t *ops) {
+    pthread_once(&g_hwio_once, hwio_select);
+    g_hwio_ops = ops ? ops : (hwio_fake_init() ? &hwio_fake_ops : &hwio_dev_ops);
+}
+
+uint32_t hwio_read(uint32_t addr) {
+    return hwio_ops()->read(addr);
+}
+
+void hwio_write(uint32_t addr, uint32_t val) {
+    hwio_ops()->write(addr, val);
+}
+
+int hwio_mixer_set(const char *name, int value) {
+    return hwio_ops()->mixer_set(name, value);
+}
+
+int hwio_mixer_apply(const hwio_mixer_t *mixer, int count) {
+    int ret = 0;
+
+    for (int i = 0; i < count; i++) {
+        if (hwio_mixer_set(mixer[i].name, mixer[i].value) != 0) {
+            ret = -1;
+        }
+    }
+    return ret;
+}
+
+int hwio_vdpo_mode(const char *mode) {
+    return hwio_ops()->vdpo_mode(mode);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Register, mixer and display output access from the app itself, in place of
+// running aww/awr, audio_sel.sh (amixer) and dispw for each of them.
+//
+// The device backend maps the registers from /dev/mem and talks to the sound
+// and display drivers with their ioctls; whatever it can't do that way still
+// goes to the tools. The fake backend (hwio_fake.c) is taken in the emulator
+// or when HDZ_HWIO_FAKE is set, so a source switch can be timed on a host.
+//
+typedef struct {
+    const char *name;
+    int value;
+} hwio_mixer_t;
+
+typedef struct {
+    uint32_t (*read)(uint32_t addr);
+    void (*write)(uint32_t addr, uint32_t val);
+    int (*mixer_set)(const char *name, int value);
+    int (*vdpo_mode)(const char *mode);
+} hwio_ops_t;
+
+extern const hwio_ops_t hwio_dev_ops;
+extern const hwio_ops_t hwio_fake_ops;
+
+// another backend, for a benchmark; NULL goes back to the default one
+void hwio_set_ops(const hwio_ops_t *ops);
+
+uint32_t hwio_read(uint32_t addr);            // awr addr
+void hwio_write(uint32_t addr, uint32_t val); // aww addr val
+
+// amixer cset name='<name>' <value>, on every channel of the control
+int hwio_mixer_set(const char *name, int value);
+int hwio_mixer_apply(const hwio_mixer_t *mixer, int count);
+
+// dispw -s vdpo <mode>, mode as dispw takes it: 720p50, 1080p60 ...
+int hwio_vdpo_mode(const char *mode);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,193 @@
+#include "hwio_fake.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <log/log.h>
+
+#include "hwio.h"
+
+#define FAKE_REGS 1024 // power of 2
+
+typedef struct {
+    uint32_t addr;
+    uint32_t val;
+    bool used;
+} fake_reg_t;
+
+static pthread_mutex_t g_fake_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t g_fake_once = PTHREAD_ONCE_INIT;
+static bool g_fake_on = false;
+
+static fake_reg_t *g_fake_regs = NULL;
+static char g_fake_vdpo[16] = "";
+static FILE *g_fake_trace = NULL;
+static uint32_t g_fake_mmio_us = 1;
+static uint32_t g_fake_mixer_us = 300;
+static uint32_t g_fake_vdpo_us = 20000;
+static bool g_fake_sleep = false;
+static hwio_fake_stats_t g_fake_stats;
+
+static uint32_t fake_env(const char *name, uint32_t def) {
+    const char *val = getenv(name);
+
+    if (val == NULL || *val == 0) {
+        return def;
+    }
+    return strtoul(val, NULL, 0);
+}
+
+static void fake_report() {
+    LOGI("hwio fake: %u reads, %u writes, %u mixer controls, %u vdpo switches, %llu us",
+         g_fake_stats.reads, g_fake_stats.writes, g_fake_stats.mixers, g_fake_stats.vdpos,
+         (unsigned long long)g_fake_stats.us);
+
+    if (g_fake_trace) {
+        fclose(g_fake_trace);
+        g_fake_trace = NULL;
+    }
+}
+
+static void fake_setup() {
+    const char *path;
+
+#ifndef EMULATOR_BUILD
+    if (getenv("HDZ_HWIO_FAKE") == NULL) {
+        return;
+    }
+#endif
+
+    g_fake_regs = calloc(FAKE_REGS, sizeof(fake_reg_t));
+    if (g_fake_regs == NULL) {
+        return;
+    }
+
+    g_fake_mmio_us = fake_env("HDZ_HWIO_FAKE_MMIO_US", g_fake_mmio_us);
+    g_fake_mixer_us = fake_env("HDZ_HWIO_FAKE_MIXER_US", g_fake_mixer_us);
+    g_fake_vdpo_us = fake_env("HDZ_HWIO_FAKE_VDPO_US", g_fake_vdpo_us);
+    g_fake_sleep = fake_env("HDZ_HWIO_FAKE_SLEEP", 0) != 0;
+
+    path = getenv("HDZ_HWIO_TRACE");
+    if (path && *path) {
+        g_fake_trace = fopen(path, "w");
+        if (g_fake_trace == NULL) {
+            LOGE("hwio fake: can't open trace %s", path);
+        }
+    }
+
+    atexit(fake_report);
+    g_fake_on = true;
+}
+
+bool hwio_fake_init() {
+    pthread_once(&g_fake_once, fake_setup);
+    return g_fake_on;
+}
+
+// called with the lock held
+static void fake_cost(uint32_t us) {
+    g_fake_stats.us += us;
+    if (g_fake_sleep && us) {
+        pthread_mutex_unlock(&g_fake_mutex);
+        usleep(us);
+        pthread_mutex_lock(&g_fake_mutex);
+    }
+}
+
+// the slot of a register, a free one if it was never written
+static fake_reg_t *fake_reg(uint32_t addr) {
+    uint32_t i = (addr >> 2) * 2654435761u;
+
+    for (int n = 0; n < FAKE_REGS; n++, i++) {
+        fake_reg_t *reg = &g_fake_regs[i & (FAKE_REGS - 1)];
+        if (!reg->used || reg->addr == addr) {
+            return reg;
+        }
+    }
+    return NULL;
+}
+
+static uint32_t fake_read(uint32_t addr) {
+    fake_reg_t *reg;
+    uint32_t val = 0;
+
+    pthread_mutex_lock(&g_fake_mutex);
+    reg = fake_reg(addr);
+    if (reg && reg->used) {
+        val = reg->val;
+    }
+    if (g_fake_trace) {
+        fprintf(g_fake_trace, "awr 0x%08x -> 0x%08x\n", addr, val);
+    }
+    g_fake_stats.reads++;
+    fake_cost(g_fake_mmio_us);
+    pthread_mutex_unlock(&g_fake_mutex);
+
+    return val;
+}
+
+static void fake_write(uint32_t addr, uint32_t val) {
+    fake_reg_t *reg;
+
+    pthread_mutex_lock(&g_fake_mutex);
+    reg = fake_reg(addr);
+    if (reg) {
+        reg->addr = addr;
+        reg->val = val;
+        reg->used = true;
+    }
+    if (g_fake_trace) {
+        fprintf(g_fake_trace, "aww 0x%08x 0x%08x\n", addr, val);
+    }
+    g_fake_stats.writes++;
+    fake_cost(g_fake_mmio_us);
+    pthread_mutex_unlock(&g_fake_mutex);
+}
+
+static int fake_mixer_set(const char *name, int value) {
+    pthread_mutex_lock(&g_fake_mutex);
+    if (g_fake_trace) {
+        fprintf(g_fake_trace, "amixer cset name='%s' %d\n", name, value);
+    }
+    g_fake_stats.mixers++;
+    fake_cost(g_fake_mixer_us);
+    pthread_mutex_unlock(&g_fake_mutex);
+
+    return 0;
+}
+
+static int fake_vdpo_mode(const char *mode) {
+    pthread_mutex_lock(&g_fake_mutex);
+    if (g_fake_trace) {
+        fprintf(g_fake_trace, "dispw -s vdpo %s%s\n", mode,
+                strcmp(g_fake_vdpo, mode) == 0 ? " (unchanged)" : "");
+    }
+    snprintf(g_fake_vdpo, sizeof(g_fake_vdpo), "%s", mode);
+    g_fake_stats.vdpos++;
+    fake_cost(g_fake_vdpo_us);
+    pthread_mutex_unlock(&g_fake_mutex);
+
+    return 0;
+}
+
+const hwio_ops_t hwio_fake_ops = {
+    .read = fake_read,
+    .write = fake_write,
+    .mixer_set = fake_mixer_set,
+    .vdpo_mode = fake_vdpo_mode,
+};
+
+void hwio_fake_stats(hwio_fake_stats_t *stats) {
+    pthread_mutex_lock(&g_fake_mutex);
+    *stats = g_fake_stats;
+    pthread_mutex_unlock(&g_fake_mutex);
+}
+
+void hwio_fake_reset_stats() {
+    pthread_mutex_lock(&g_fake_mutex);
+    memset(&g_fake_stats, 0, sizeof(g_fake_stats));
+    pthread_mutex_unlock(&g_fake_mutex);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Fake hwio backend. Registers read back what was written, mixer controls and
+// the vdpo mode are only kept. Every access adds a modelled cost:
+//
+//  HDZ_HWIO_TRACE=<file>          every access, one line each
+//  HDZ_HWIO_FAKE_MMIO_US=<us>     register read or write, 1
+//  HDZ_HWIO_FAKE_MIXER_US=<us>    mixer control, 300
+//  HDZ_HWIO_FAKE_VDPO_US=<us>     vdpo mode switch, 20000
+//  HDZ_HWIO_FAKE_SLEEP=1          sleep the modelled time
+//
+typedef struct {
+    uint32_t reads;
+    uint32_t writes;
+    uint32_t mixers;
+    uint32_t vdpos;
+    uint64_t us; // modelled time of all of them
+} hwio_fake_stats_t;
+
+// true when the fake is to be used
+bool hwio_fake_init();
+
+void hwio_fake_stats(hwio_fake_stats_t *stats);
+void hwio_fake_reset_stats();
+
+#ifdef __cplusplus
+}
+#endif
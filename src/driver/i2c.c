@@ -1,5 +1,6 @@
 #include "i2c.h"
 
+#include <errno.h>
 #include <fcntl.h>
 #include <linux/i2c-dev.h>
 #include <linux/i2c.h>
@@ -8,16 +9,14 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/ioctl.h>
 #include <unistd.h> // for close
 
 #include <log/log.h>
 
 #include "../core/common.hh"
-
-pthread_mutex_t i2c_mutex;
-
-#define IIC_PORTS 4
+#include "i2c_mock.h"
 
 static char *IIC_DEVS[IIC_PORTS] = {
     "/dev/i2c-0",
@@ -26,13 +25,27 @@ static char *IIC_DEVS[IIC_PORTS] = {
     "/dev/i2c-3",
 };
 
-static int g_iic_fds[IIC_PORTS];
+static int g_iic_fds[IIC_PORTS] = {-1, -1, -1, -1};
 static bool g_iic_report_once[IIC_PORTS] = {false};
+static bool g_iic_mock = false;
+
+// one lock per bus, the devices on different buses don't wait for each other
+static pthread_mutex_t g_iic_locks[IIC_PORTS] = {
+    PTHREAD_MUTEX_INITIALIZER,
+    PTHREAD_MUTEX_INITIALIZER,
+    PTHREAD_MUTEX_INITIALIZER,
+    PTHREAD_MUTEX_INITIALIZER,
+};
+
+// i2c_write_n buffer of each bus, used under its lock
+static uint8_t g_iic_wbufs[IIC_PORTS][I2C_xferMAX + 1];
 
 bool iic_is_port_ready(int port) {
     if (port < 0 || port >= IIC_PORTS) {
         LOGE("Port %d contains an invalid range [0=N/A,1=Right,2=Main,3=Left]", port);
         return false;
+    } else if (g_iic_mock) {
+        return true;
     } else if (g_iic_fds[port] < 0) {
         if (!g_iic_report_once[port]) {
             g_iic_report_once[port] = true;
@@ -44,7 +57,11 @@ bool iic_is_port_ready(int port) {
 }
 
 void iic_init() {
-    pthread_mutex_init(&i2c_mutex, NULL);
+    g_iic_mock = i2c_mock_init();
+    if (g_iic_mock) {
+        LOGI("i2c: mock backend");
+        return;
+    }
 
     // Offset starts with 1 as it is not referenced thus far.
     for (int i = 1; i < IIC_PORTS; ++i) {
@@ -53,76 +70,74 @@ void iic_init() {
     }
 }
 
-static uint8_t iic_read(int i2c_fd, uint8_t slave_address, uint16_t reg_address) {
+// all traffic goes through here, called with the port lock held
+static int iic_transfer(int port, struct i2c_msg *msgs, int nmsgs) {
     struct i2c_rdwr_ioctl_data work_queue;
-    struct i2c_msg msgs[2];
 
-    uint8_t val = 0;
-    int ret;
+    if (g_iic_mock) {
+        return i2c_mock_transfer(port, msgs, nmsgs);
+    }
 
-    work_queue.nmsgs = 2;
+    work_queue.nmsgs = nmsgs;
     work_queue.msgs = msgs;
+    return ioctl(g_iic_fds[port], I2C_RDWR, (unsigned long)&work_queue);
+}
 
-    val = (unsigned char)reg_address;
-    (work_queue.msgs[0]).len = 1;
-    (work_queue.msgs[0]).flags = 0;
-    (work_queue.msgs[0]).addr = slave_address;
-    (work_queue.msgs[0]).buf = &val;
+static uint8_t iic_read(int port, uint8_t slave_address, uint16_t reg_address) {
+    struct i2c_msg msgs[2];
+    uint8_t reg = (uint8_t)reg_address;
+    uint8_t val = 0;
 
-    (work_queue.msgs[1]).len = 1;
-    (work_queue.msgs[1]).flags = 1;
-    (work_queue.msgs[1]).addr = slave_address;
-    (work_queue.msgs[1]).buf = &val;
+    msgs[0].len = 1;
+    msgs[0].flags = 0;
+    msgs[0].addr = slave_address;
+    msgs[0].buf = &reg;
 
-    ret = ioctl(i2c_fd, I2C_RDWR, (unsigned long)&work_queue);
-    if (ret < 0) {
+    msgs[1].len = 1;
+    msgs[1].flags = I2C_M_RD;
+    msgs[1].addr = slave_address;
+    msgs[1].buf = &val;
+
+    if (iic_transfer(port, msgs, 2) < 0) {
         // LOGI("iic_read[%x.%x] failed.",slave_address, reg_address);
         val = 0;
     }
     return val;
 }
 
-static void iic_read_n(int i2c_fd, uint8_t slave_address, uint16_t reg_address, uint8_t *reg_data, uint16_t len) {
-    struct i2c_rdwr_ioctl_data work_queue;
+static void iic_read_n(int port, uint8_t slave_address, uint16_t reg_address, uint8_t *reg_data, uint16_t len) {
     struct i2c_msg msgs[2];
-    uint8_t val = 0;
-
-    work_queue.nmsgs = 2;
-    work_queue.msgs = msgs;
+    uint8_t reg = (uint8_t)reg_address;
 
-    val = (unsigned char)reg_address;
-    (work_queue.msgs[0]).len = 1;
-    (work_queue.msgs[0]).flags = 0;
-    (work_queue.msgs[0]).addr = slave_address;
-    (work_queue.msgs[0]).buf = &val;
+    msgs[0].len = 1;
+    msgs[0].flags = 0;
+    msgs[0].addr = slave_address;
+    msgs[0].buf = &reg;
 
-    (work_queue.msgs[1]).len = len;
-    (work_queue.msgs[1]).flags = 1;
-    (work_queue.msgs[1]).addr = slave_address;
-    (work_queue.msgs[1]).buf = reg_data;
+    msgs[1].len = len;
+    msgs[1].flags = I2C_M_RD;
+    msgs[1].addr = slave_address;
+    msgs[1].buf = reg_data;
 
-    ioctl(i2c_fd, I2C_RDWR, (unsigned long)&work_queue);
+    iic_transfer(port, msgs, 2);
     // if(ret < 0)
     //     LOGI("iic_read_n[%x.%x] failed.",slave_address, reg_address);
 }
 
-static int iic_write(int i2c_fd, uint8_t slave_address, uint16_t reg_address, uint16_t reg_val) {
-    struct i2c_rdwr_ioctl_data work_queue;
+static int iic_write(int port, uint8_t slave_address, uint16_t reg_address, uint16_t reg_val) {
     struct i2c_msg msgs;
     uint8_t obuf[2];
     int ret;
 
-    work_queue.nmsgs = 1;
-    work_queue.msgs = &msgs;
-    msgs.buf = obuf;
+    obuf[0] = reg_address;
+    obuf[1] = reg_val;
 
-    (work_queue.msgs[0]).len = 2;
-    (work_queue.msgs[0]).flags = 0;
-    (work_queue.msgs[0]).addr = slave_address;
-    (work_queue.msgs[0]).buf[0] = reg_address;
-    (work_queue.msgs[0]).buf[1] = reg_val;
+    msgs.len = 2;
+    msgs.flags = 0;
+    msgs.addr = slave_address;
+    msgs.buf = obuf;
 
-    ret = ioctl(i2c_fd, I2C_RDWR, (unsigned long)&work_queue);
+    ret = iic_transfer(port, &msgs, 1);
     if (ret < 0) {
         // LOGI("iic_write[%x.%x]<-%x failed.",slave_address, reg_address, reg_val);
         ret = 0;
@@ -130,33 +145,29 @@ static int iic_write(int i2c_fd, uint8_t slave_address, uint16_t reg_address, ui
     return ret;
 }
 
-static int iic_write_n(int i2c_fd, uint8_t slave_address, uint8_t reg_address, uint8_t *reg_val, uint16_t len) {
-    struct i2c_rdwr_ioctl_data work_queue;
+static int iic_write_n(int port, uint8_t slave_address, uint8_t reg_address, uint8_t *reg_val, uint16_t len) {
     struct i2c_msg msgs;
+    uint8_t *obuf = g_iic_wbufs[port];
     int ret;
 
-    work_queue.nmsgs = 1;
-    work_queue.msgs = &msgs;
-
-    if ((work_queue.msgs[0].buf = (unsigned char *)malloc((len + 1) * sizeof(unsigned char))) == NULL) {
-        // LOGI("buf memery alloc error...");
+    if (len > I2C_xferMAX) {
+        LOGE("iic_write_n[%x.%x] %d bytes, at most %d", slave_address, reg_address, len, I2C_xferMAX);
         return -1;
     }
 
-    (work_queue.msgs[0]).len = len + 1;
-    (work_queue.msgs[0]).flags = 0;
-    (work_queue.msgs[0]).addr = slave_address;
-    (work_queue.msgs[0]).buf[0] = reg_address;
+    obuf[0] = reg_address;
+    memcpy(obuf + 1, reg_val, len);
 
-    for (uint16_t i = 1; i <= len; i++)
-        (work_queue.msgs[0]).buf[i] = reg_val[i - 1];
+    msgs.len = len + 1;
+    msgs.flags = 0;
+    msgs.addr = slave_address;
+    msgs.buf = obuf;
 
-    ret = ioctl(i2c_fd, I2C_RDWR, (unsigned long)&work_queue);
+    ret = iic_transfer(port, &msgs, 1);
     if (ret < 0) {
         // LOGI("iic_write_n[%x.%x] failed.",slave_address, reg_address);
         ret = 0;
     }
-    free(work_queue.msgs[0].buf);
     return ret;
 }
 
@@ -167,9 +178,9 @@ uint8_t i2c_read(int port, uint8_t slave_address, uint8_t addr) {
         return 0;
     }
 
-    pthread_mutex_lock(&i2c_mutex);
-    val = iic_read(g_iic_fds[port], slave_address, addr);
-    pthread_mutex_unlock(&i2c_mutex);
+    pthread_mutex_lock(&g_iic_locks[port]);
+    val = iic_read(port, slave_address, addr);
+    pthread_mutex_unlock(&g_iic_locks[port]);
 
     return val;
 }
@@ -179,9 +190,9 @@ int8_t i2c_read_n(int port, uint8_t slave_address, uint8_t addr, uint8_t *data,
         return -1;
     }
 
-    pthread_mutex_lock(&i2c_mutex);
-    iic_read_n(g_iic_fds[port], slave_address, addr, data, len);
-    pthread_mutex_unlock(&i2c_mutex);
+    pthread_mutex_lock(&g_iic_locks[port]);
+    iic_read_n(port, slave_address, addr, data, len);
+    pthread_mutex_unlock(&g_iic_locks[port]);
 
     return 0;
 }
@@ -193,9 +204,9 @@ int i2c_write(int port, uint8_t slave_address, uint8_t addr, uint8_t val) {
         return ret;
     }
 
-    pthread_mutex_lock(&i2c_mutex);
-    ret = iic_write(g_iic_fds[port], slave_address, addr, val);
-    pthread_mutex_unlock(&i2c_mutex);
+    pthread_mutex_lock(&g_iic_locks[port]);
+    ret = iic_write(port, slave_address, addr, val);
+    pthread_mutex_unlock(&g_iic_locks[port]);
 
     return ret;
 }
@@ -207,9 +218,145 @@ int8_t i2c_write_n(int port, uint8_t slave_address, uint8_t addr, uint8_t *val,
         return ret;
     }
 
-    pthread_mutex_lock(&i2c_mutex);
-    iic_write_n(g_iic_fds[port], slave_address, addr, val, len);
-    pthread_mutex_unlock(&i2c_mutex);
+    pthread_mutex_lock(&g_iic_locks[port]);
+    ret = iic_write_n(port, slave_address, addr, val, len);
+    pthread_mutex_unlock(&g_iic_locks[port]);
 
-    return 0;
+    return ret < 0 ? -1 : 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Transactions
+
+void i2c_txn_begin(i2c_txn_t *txn, int port) {
+    txn->port = port;
+    txn->nmsgs = 0;
+    txn->nbytes = 0;
+    txn->ret = 0;
+    txn->stop = false;
+}
+
+void i2c_txn_begin_stop(i2c_txn_t *txn, int port) {
+    i2c_txn_begin(txn, port);
+    txn->stop = true;
+}
+
+// the messages one I2C_RDWR each, a read with the write before it as in
+// iic_read; called with the port lock held
+static int iic_transfer_stops(int port, struct i2c_msg *msgs, int nmsgs) {
+    int n;
+
+    for (int i = 0; i < nmsgs; i += n) {
+        n = (i + 1 < nmsgs && (msgs[i + 1].flags & I2C_M_RD)) ? 2 : 1;
+        if (iic_transfer(port, msgs + i, n) < 0) {
+            return -1;
+        }
+    }
+    return nmsgs;
+}
+
+static void i2c_txn_flush(i2c_txn_t *txn) {
+    int ret;
+
+    if (txn->nmsgs == 0) {
+        return;
+    }
+
+    if (!iic_is_port_ready(txn->port)) {
+        ret = -ENODEV;
+    } else {
+        pthread_mutex_lock(&g_iic_locks[txn->port]);
+        if (txn->stop) {
+            ret = iic_transfer_stops(txn->port, txn->msgs, txn->nmsgs);
+        } else {
+            ret = iic_transfer(txn->port, txn->msgs, txn->nmsgs);
+        }
+        if (ret < 0) {
+            ret = -errno;
+        }
+        pthread_mutex_unlock(&g_iic_locks[txn->port]);
+        if (ret < 0) {
+            LOGE("i2c-%d: %d messages failed (%d)", txn->port, txn->nmsgs, ret);
+        }
+    }
+
+    if (ret < 0 && txn->ret == 0) {
+        txn->ret = ret;
+    }
+    txn->nmsgs = 0;
+    txn->nbytes = 0;
+}
+
+// room for nmsgs more messages carrying nbytes in the transaction buffer
+static void i2c_txn_reserve(i2c_txn_t *txn, int nmsgs, int nbytes) {
+    if (txn->nmsgs + nmsgs > I2C_txnMSGS || txn->nbytes + nbytes > I2C_txnBYTES) {
+        i2c_txn_flush(txn);
+    }
+}
+
+static void i2c_txn_msg(i2c_txn_t *txn, uint8_t slave_address, uint16_t flags, uint8_t *buf, uint16_t len) {
+    struct i2c_msg *msg = &txn->msgs[txn->nmsgs++];
+
+    msg->addr = slave_address;
+    msg->flags = flags;
+    msg->len = len;
+    msg->buf = buf;
+}
+
+void i2c_txn_write(i2c_txn_t *txn, uint8_t slave_address, uint8_t addr, uint8_t val) {
+    uint8_t *obuf;
+
+    i2c_txn_reserve(txn, 1, 2);
+
+    obuf = txn->buf + txn->nbytes;
+    obuf[0] = addr;
+    obuf[1] = val;
+    txn->nbytes += 2;
+
+    i2c_txn_msg(txn, slave_address, 0, obuf, 2);
+}
+
+void i2c_txn_write_n(i2c_txn_t *txn, uint8_t slave_address, uint8_t addr, const uint8_t *val, uint16_t len) {
+    uint8_t *obuf;
+
+    if (len + 1 > I2C_txnBYTES) {
+        // does not fit, sent on its own in order with the rest
+        i2c_txn_flush(txn);
+        if (i2c_write_n(txn->port, slave_address, addr, (uint8_t *)val, len) < 0 && txn->ret == 0) {
+            txn->ret = -EINVAL;
+        }
+        return;
+    }
+
+    i2c_txn_reserve(txn, 1, len + 1);
+
+    obuf = txn->buf + txn->nbytes;
+    obuf[0] = addr;
+    memcpy(obuf + 1, val, len);
+    txn->nbytes += len + 1;
+
+    i2c_txn_msg(txn, slave_address, 0, obuf, len + 1);
+}
+
+void i2c_txn_read(i2c_txn_t *txn, uint8_t slave_address, uint8_t addr, uint8_t *data, uint16_t len) {
+    uint8_t *obuf;
+
+    i2c_txn_reserve(txn, 2, 1);
+
+    obuf = txn->buf + txn->nbytes;
+    obuf[0] = addr;
+    txn->nbytes += 1;
+
+    i2c_txn_msg(txn, slave_address, 0, obuf, 1);
+    i2c_txn_msg(txn, slave_address, I2C_M_RD, data, len);
+}
+
+int i2c_txn_submit(i2c_txn_t *txn) {
+    int ret;
+
+    i2c_txn_flush(txn);
+
+    ret = txn->ret;
+    txn->ret = 0;
+    return ret;
 }
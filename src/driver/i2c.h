@@ -4,8 +4,17 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
 #include <stdint.h>
 
+#include <linux/i2c.h>
+
+#define IIC_PORTS 4
+
+#define I2C_xferMAX  1024 // longest i2c_write_n
+#define I2C_txnMSGS  42   // I2C_RDWR_IOCTL_MAX_MSGS of the kernel
+#define I2C_txnBYTES 128
+
 void iic_init();
 uint8_t i2c_read(int port, uint8_t slave_address, uint8_t addr);
 int i2c_write(int port, uint8_t slave_address, uint8_t addr, uint8_t val);
@@ -13,6 +22,46 @@ int i2c_write(int port, uint8_t slave_address, uint8_t addr, uint8_t val);
 int8_t i2c_read_n(int port, uint8_t slave_address, uint8_t addr, uint8_t *data, uint16_t len);
 int8_t i2c_write_n(int port, uint8_t slave_address, uint8_t addr, uint8_t *val, uint16_t len);
 
+///////////////////////////////////////////////////////////////////////////////
+// Transactions
+//
+// Register writes and reads queued on one port and sent as a single I2C_RDWR,
+// one message each (repeated start between them), under the port lock so no
+// other thread gets in between. A transaction lives on the caller's stack;
+// when it is full the queued messages are sent and queuing goes on.
+// Read data lands in the caller's buffer once the messages are sent.
+//
+//    i2c_txn_t txn;
+//    i2c_txn_begin(&txn, 2);
+//    i2c_txn_write(&txn, ADDR_FPGA, 0x91, lo);
+//    i2c_txn_write(&txn, ADDR_FPGA, 0x92, hi);
+//    i2c_txn_read(&txn, ADDR_FPGA, 0x98, &val, 1);
+//    ret = i2c_txn_submit(&txn);
+//
+// i2c_txn_begin_stop queues the same way, but every write is sent as its own
+// I2C_RDWR and so ends with a STOP, a read together with its register
+// pointer write; i2c_write/i2c_read traffic, only without another thread
+// getting in between. The FPGA's SPI bridge registers (0x90-0x9f, 0xa0-0xb4)
+// are written like that, nothing shows it latches them on a repeated start.
+//
+typedef struct {
+    int port;
+    int nmsgs;
+    int nbytes;
+    int ret;   // first error since i2c_txn_begin
+    bool stop; // one I2C_RDWR per write
+    struct i2c_msg msgs[I2C_txnMSGS];
+    uint8_t buf[I2C_txnBYTES];
+} i2c_txn_t;
+
+void i2c_txn_begin(i2c_txn_t *txn, int port);
+void i2c_txn_begin_stop(i2c_txn_t *txn, int port);
+void i2c_txn_write(i2c_txn_t *txn, uint8_t slave_address, uint8_t addr, uint8_t val);
+void i2c_txn_write_n(i2c_txn_t *txn, uint8_t slave_address, uint8_t addr, const uint8_t *val, uint16_t len);
+void i2c_txn_read(i2c_txn_t *txn, uint8_t slave_address, uint8_t addr, uint8_t *data, uint16_t len);
+// 0 or the first error of the transaction, it can be reused afterwards
+int i2c_txn_submit(i2c_txn_t *txn);
+
 #define BMI_I2C_WRITE(addr, val, len) i2c_write_n(1, 0x68, addr, val, len)
 #define BMI_I2C_READ(addr, val, len)  i2c_read_n(1, 0x68, addr, val, len)
 
@@ -52,8 +101,10 @@ int8_t i2c_write_n(int port, uint8_t slave_address, uint8_t addr, uint8_t *val,
 
 #define ADDR_IT66021 0x49
 
-#define I2C_Write(s, a, d) i2c_write(2, s, a, d)
-#define I2C_Read(s, a)     i2c_read(2, s, a)
+#define I2C_Write(s, a, d)  i2c_write(2, s, a, d)
+#define I2C_Read(s, a)      i2c_read(2, s, a)
+#define I2C_TxnBegin(t)     i2c_txn_begin(t, 2)
+#define I2C_TxnBeginStop(t) i2c_txn_begin_stop(t, 2)
 
 #define I2C_R_Write(s, a, d) i2c_write(1, s, a, d)
 #define I2C_R_Read(s, a)     i2c_read(1, s, a)
@@ -0,0 +1,233 @@
+#include "i2c_mock.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <log/log.h>
+
+#include "i2c.h"
+
+#define MOCK_SLAVES 128
+
+typedef struct {
+    uint8_t regs[256];
+    uint8_t ptr;
+} mock_slave_t;
+
+static pthread_mutex_t g_mock_mutex = PTHREAD_MUTEX_INITIALIZER;
+static mock_slave_t *g_mock_slaves[IIC_PORTS];
+static FILE *g_mock_trace = NULL;
+static uint32_t g_mock_hz = 100000;
+static uint32_t g_mock_xfer_us = 60;
+static bool g_mock_sleep = false;
+static i2c_mock_stats_t g_mock_stats;
+
+static uint32_t mock_env(const char *name, uint32_t def) {
+    const char *val = getenv(name);
+
+    if (val == NULL || *val == 0) {
+        return def;
+    }
+    return strtoul(val, NULL, 0);
+}
+
+static void mock_report() {
+    LOGI("i2c mock: %u transfers, %u messages, %u bytes, %llu us on the bus",
+         g_mock_stats.xfers, g_mock_stats.msgs, g_mock_stats.bytes,
+         (unsigned long long)g_mock_stats.bus_us);
+
+    if (g_mock_trace) {
+        fclose(g_mock_trace);
+        g_mock_trace = NULL;
+    }
+}
+
+bool i2c_mock_init() {
+    const char *path;
+
+#ifndef EMULATOR_BUILD
+    if (getenv("HDZ_I2C_MOCK") == NULL) {
+        return false;
+    }
+#endif
+
+    for (int i = 0; i < IIC_PORTS; i++) {
+        g_mock_slaves[i] = calloc(MOCK_SLAVES, sizeof(mock_slave_t));
+    }
+
+    g_mock_hz = mock_env("HDZ_I2C_MOCK_HZ", g_mock_hz);
+    if (g_mock_hz == 0) {
+        g_mock_hz = 100000;
+    }
+    g_mock_xfer_us = mock_env("HDZ_I2C_MOCK_XFER_US", g_mock_xfer_us);
+    g_mock_sleep = mock_env("HDZ_I2C_MOCK_SLEEP", 0) != 0;
+
+    path = getenv("HDZ_I2C_TRACE");
+    if (path && *path) {
+        g_mock_trace = fopen(path, "w");
+        if (g_mock_trace == NULL) {
+            LOGE("i2c mock: can't open trace %s", path);
+        }
+    }
+
+    atexit(mock_report);
+    return true;
+}
+
+int i2c_mock_transfer(int port, struct i2c_msg *msgs, int nmsgs) {
+    uint64_t bits = 0;
+    uint32_t us;
+
+    if (port < 0 || port >= IIC_PORTS || g_mock_slaves[port] == NULL ||
+        nmsgs <= 0 || nmsgs > I2C_txnMSGS) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_mock_mutex);
+
+    for (int i = 0; i < nmsgs; i++) {
+        struct i2c_msg *msg = &msgs[i];
+        mock_slave_t *slave;
+
+        if (msg->addr >= MOCK_SLAVES) {
+            pthread_mutex_unlock(&g_mock_mutex);
+            errno = ENXIO;
+            return -1;
+        }
+        slave = &g_mock_slaves[port][msg->addr];
+
+        if (msg->flags & I2C_M_RD) {
+            for (int j = 0; j < msg->len; j++) {
+                msg->buf[j] = slave->regs[slave->ptr++];
+            }
+            if (g_mock_trace) {
+                fprintf(g_mock_trace, "%d %02x R %x\n", port, msg->addr, msg->len);
+            }
+        } else {
+            if (msg->len > 0) {
+                slave->ptr = msg->buf[0];
+            }
+            for (int j = 1; j < msg->len; j++) {
+                slave->regs[slave->ptr++] = msg->buf[j];
+            }
+            if (g_mock_trace) {
+                fprintf(g_mock_trace, "%d %02x W", port, msg->addr);
+                for (int j = 0; j < msg->len; j++) {
+                    fprintf(g_mock_trace, " %02x", msg->buf[j]);
+                }
+                fprintf(g_mock_trace, "\n");
+            }
+        }
+
+        // (re)start, address and data bytes with their ack, stop at the end
+        bits += 1 + 9 * (1 + msg->len);
+        g_mock_stats.bytes += msg->len;
+    }
+    bits += 1;
+
+    us = g_mock_xfer_us + (uint32_t)(bits * 1000000 / g_mock_hz);
+    g_mock_stats.xfers++;
+    g_mock_stats.msgs += nmsgs;
+    g_mock_stats.bus_us += us;
+
+    pthread_mutex_unlock(&g_mock_mutex);
+
+    if (g_mock_sleep) {
+        usleep(us);
+    }
+    return nmsgs;
+}
+
+void i2c_mock_stats(i2c_mock_stats_t *stats) {
+    pthread_mutex_lock(&g_mock_mutex);
+    *stats = g_mock_stats;
+    pthread_mutex_unlock(&g_mock_mutex);
+}
+
+void i2c_mock_reset_stats() {
+    pthread_mutex_lock(&g_mock_mutex);
+    memset(&g_mock_stats, 0, sizeof(g_mock_stats));
+    pthread_mutex_unlock(&g_mock_mutex);
+}
+
+int i2c_trace_replay(const char *path) {
+    FILE *fp;
+    char line[1024];
+    i2c_txn_t txn;
+    uint8_t rbuf[I2C_txnMSGS][I2C_txnBYTES];
+    int nreads = 0;
+    int count = 0;
+    int ret = 0;
+
+    // a register write with no data, held back as it may start a read
+    int ptr_port = -1;
+    uint8_t ptr_slave = 0, ptr_reg = 0;
+
+    fp = fopen(path, "r");
+    if (fp == NULL) {
+        LOGE("i2c replay: can't open %s", path);
+        return -1;
+    }
+
+    i2c_txn_begin(&txn, -1);
+
+    while (fgets(line, sizeof(line), fp)) {
+        uint8_t data[I2C_xferMAX + 1];
+        unsigned port, slave, val;
+        char dir;
+        int len = 0, pos = 0, n;
+
+        if (sscanf(line, "%u %x %c%n", &port, &slave, &dir, &pos) != 3 || port >= IIC_PORTS) {
+            continue;
+        }
+        while (len <= I2C_xferMAX && sscanf(line + pos, "%x%n", &val, &n) == 1) {
+            data[len++] = val;
+            pos += n;
+        }
+
+        if (ptr_port >= 0 && (dir != 'R' || ptr_port != port || ptr_slave != slave)) {
+            i2c_txn_write_n(&txn, ptr_slave, ptr_reg, &ptr_reg, 0);
+            ptr_port = -1;
+        }
+
+        if ((int)port != txn.port || nreads == I2C_txnMSGS) {
+            // reads land in rbuf, which is only reused once they are sent
+            if (txn.port >= 0 && i2c_txn_submit(&txn) < 0) {
+                ret = -1;
+            }
+            i2c_txn_begin(&txn, port);
+            nreads = 0;
+        }
+
+        if (dir == 'W' && len == 1) {
+            ptr_port = port;
+            ptr_slave = slave;
+            ptr_reg = data[0];
+        } else if (dir == 'W' && len > 1) {
+            i2c_txn_write_n(&txn, slave, data[0], data + 1, len - 1);
+        } else if (dir == 'R' && len == 1 && ptr_port >= 0) {
+            val = data[0] < I2C_txnBYTES ? data[0] : I2C_txnBYTES;
+            i2c_txn_read(&txn, slave, ptr_reg, rbuf[nreads++], val);
+            ptr_port = -1;
+        } else {
+            // a read that doesn't follow its register write is left out
+            continue;
+        }
+        count++;
+    }
+
+    if (ptr_port >= 0) {
+        i2c_txn_write_n(&txn, ptr_slave, ptr_reg, &ptr_reg, 0);
+    }
+    if (txn.port >= 0 && i2c_txn_submit(&txn) < 0) {
+        ret = -1;
+    }
+
+    fclose(fp);
+    return ret < 0 ? -1 : count;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <linux/i2c.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Mock of /dev/i2c-N, taken instead of the devices in the emulator or when
+// HDZ_I2C_MOCK is set, so the register sequences run on a Linux host.
+//
+// Every slave is a 256 byte register file with an auto incremented pointer:
+// writes are kept, reads return what was written.
+//
+//  HDZ_I2C_TRACE=<file>      every message, one line each (see below)
+//  HDZ_I2C_MOCK_HZ=<hz>      bus clock of the timing model, 100000
+//  HDZ_I2C_MOCK_XFER_US=<us> cost of one I2C_RDWR besides the bus, 60
+//  HDZ_I2C_MOCK_SLEEP=1      sleep the modelled time, so it shows in wall time
+//
+// Trace lines, hex bytes:
+//  <port> <slave> W <b0> <b1> ...    b0 is the register
+//  <port> <slave> R <len>
+//
+typedef struct {
+    uint32_t xfers; // I2C_RDWR calls
+    uint32_t msgs;
+    uint32_t bytes;
+    uint64_t bus_us; // modelled time of all of them
+} i2c_mock_stats_t;
+
+// true when the mock is to be used
+bool i2c_mock_init();
+int i2c_mock_transfer(int port, struct i2c_msg *msgs, int nmsgs);
+
+void i2c_mock_stats(i2c_mock_stats_t *stats);
+void i2c_mock_reset_stats();
+
+// sends a trace again through i2c transactions, to the devices or the mock;
+// the number of messages or -1
+int i2c_trace_replay(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
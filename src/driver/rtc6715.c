@@ -20,34 +20,31 @@
 #if defined(HDZBOXPRO) || defined(HDZGOGGLE2)
 
 static void MM_Write(uint8_t addr, uint32_t dat) {
-    uint8_t val;
+    i2c_txn_t txn;
+
+    I2C_TxnBeginStop(&txn);
 #if defined(HDZBOXPRO)
     // spi_addr
-    I2C_Write(ADDR_FPGA, 0xa1, addr);
+    i2c_txn_write(&txn, ADDR_FPGA, 0xa1, addr);
     // spi_wdat
-    val = dat & 0xFF;
-    I2C_Write(ADDR_FPGA, 0xa2, val);
-    val = (dat >> 8) & 0xFF;
-    I2C_Write(ADDR_FPGA, 0xa3, val);
-    val = (dat >> 16) & 0xFF;
-    I2C_Write(ADDR_FPGA, 0xa4, val);
+    i2c_txn_write(&txn, ADDR_FPGA, 0xa2, dat & 0xFF);
+    i2c_txn_write(&txn, ADDR_FPGA, 0xa3, (dat >> 8) & 0xFF);
+    i2c_txn_write(&txn, ADDR_FPGA, 0xa4, (dat >> 16) & 0xFF);
     // wrte cmd
-    I2C_Write(ADDR_FPGA, 0xa0, 0x01);
+    i2c_txn_write(&txn, ADDR_FPGA, 0xa0, 0x01);
 #elif defined(HDZGOGGLE2)
     // spi_addr
-    I2C_Write(ADDR_FPGA, 0xb1, addr);
+    i2c_txn_write(&txn, ADDR_FPGA, 0xb1, addr);
 
     // spi_wdat
-    val = dat & 0xFF;
-    I2C_Write(ADDR_FPGA, 0xb2, val);
-    val = (dat >> 8) & 0xFF;
-    I2C_Write(ADDR_FPGA, 0xb3, val);
-    val = (dat >> 16) & 0xFF;
-    I2C_Write(ADDR_FPGA, 0xb4, val);
+    i2c_txn_write(&txn, ADDR_FPGA, 0xb2, dat & 0xFF);
+    i2c_txn_write(&txn, ADDR_FPGA, 0xb3, (dat >> 8) & 0xFF);
+    i2c_txn_write(&txn, ADDR_FPGA, 0xb4, (dat >> 16) & 0xFF);
 
     // wrte cmd
-    I2C_Write(ADDR_FPGA, 0xb0, 0x01);
+    i2c_txn_write(&txn, ADDR_FPGA, 0xb0, 0x01);
 #endif
+    i2c_txn_submit(&txn);
     usleep(10000);
 }
 
@@ -94,7 +91,7 @@ static void rtc6715_set_ch(int ch) {
     LOGI("Set_RTC6715: %d", (uint16_t)ch);
 }
 
-int rtc6715_get_rssi() {
+static int rtc6715_get_rssi() {
     static int rssi_adc = 0;
     int value = gpdac0_get();
 
@@ -110,6 +107,9 @@ static void rtc6715_init(bool power_on, bool audio_on) {
 }
 static void rtc6715_set_ch(int ch) {
 }
+static int rtc6715_get_rssi() {
+    return 0;
+}
 #endif
 
 void *thread_rtc6715_rssi(void *ptr) {
@@ -126,5 +126,6 @@ void *thread_rtc6715_rssi(void *ptr) {
 rtc6715_t rtc6715 = {
     .init = rtc6715_init,
     .set_ch = rtc6715_set_ch,
+    .get_rssi = rtc6715_get_rssi,
     .rssi = 0,
 };
@@ -7,6 +7,7 @@ extern "C" {
 typedef struct {
     void (*init)(bool power_on, bool audio_on);
     void (*set_ch)(int ch);
+    int (*get_rssi)(); // mV
     int rssi;
 } rtc6715_t;
 
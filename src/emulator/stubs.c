@@ -2,6 +2,7 @@
 
 #include "adec2ao.h"
 #include "awdmx.h"
+#include "gogglemsg.h"
 #include "vdec2vo.h"
 
 typedef struct
@@ -24,6 +25,7 @@ void *thread_media(void *params) { return NULL; }
 void media_control(media_t *media, player_cmd_t *cmd) {}
 media_t *media_instantiate(char *filename, notify_cb_t notify) { return NULL; }
 void media_exit(media_t *media) {}
+int gogglemsg_request(GoggleMsgType_e mtype, GoggleMsgCommand_e cmd, int arg, int timeoutMs, int *result) { return -1; }
 
 #if HDZGOGGLE
 void Display_HDZ(int mode, int is_43) {}
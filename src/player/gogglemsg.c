@@ -14,6 +14,8 @@ extern "C" {
 #include <string.h>
 #include <unistd.h>
 #include <errno.h>
+#include <pthread.h>
+#include <time.h>
 #include <sys/types.h>
 #include <sys/ipc.h>
 #include <sys/msg.h>
@@ -24,6 +26,8 @@ extern "C" {
 
 #define CommandMSG_SIZE()	(sizeof(CommandMsg_t)-sizeof(long))
 #define DataMSG_SIZE(n)	    ((n)-sizeof(long))
+#define RequestMSG_SIZE()	(sizeof(RequestMsg_t)-sizeof(long))
+#define AckMSG_SIZE()	    (sizeof(AckMsg_t)-sizeof(long))
 
 #if(THIS_MTYPE == MTYPE_NONE)
 #define LOGE printf
@@ -42,6 +46,25 @@ extern "C" {
 
 int gGoggleMsg = -1;
 
+/* acks come back on the target app's queue, a thread blocks in msgrcv for
+ * them so the requester only waits on the condvar, with a timeout */
+typedef struct
+{
+	pthread_t       threadId;
+	pthread_mutex_t mutex;
+	pthread_cond_t  cond;
+	int             qid;        //queue the listener reads
+	long            mtype;      //our ack mtype
+	bool            bRunning;   //false once the queue is gone
+	uint32_t        reqId;      //request waited for, 0: none
+	bool            bAcked;
+	int32_t         result;
+} GoggleAckListen_t;
+
+static GoggleAckListen_t gGoggleAck = { .mutex = PTHREAD_MUTEX_INITIALIZER };
+static pthread_mutex_t gGoggleReqMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t gGoggleAckOnce = PTHREAD_ONCE_INIT;
+
 /**
 * @ingroup functions implementation
 * @defgroup functions implementation
@@ -161,7 +184,7 @@ int gogglemsg_flush( GoggleMsgType_e mtype )
 {
 	CommandMsg_t msg = {0, 0};
 
-	while( msgrcv(gGoggleMsg, &msg, CommandMSG_SIZE(), mtype, IPC_NOWAIT) == 0 )
+	while( msgrcv(gGoggleMsg, &msg, CommandMSG_SIZE(), mtype, IPC_NOWAIT|MSG_NOERROR) >= 0 )
 	{
 		msg.cmd = 0;
 		msg.mtype = 0;
@@ -170,6 +193,181 @@ int gogglemsg_flush( GoggleMsgType_e mtype )
 	return 0;
 }
 
+static void gogglemsg_ackInit( void )
+{
+	pthread_condattr_t attr;
+
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&gGoggleAck.cond, &attr);
+	pthread_condattr_destroy(&attr);
+}
+
+static void* gogglemsg_ackProc( void* param )
+{
+	GoggleAckListen_t* al = (GoggleAckListen_t*)param;
+	AckMsg_t ack;
+
+	for(;;)
+	{
+		if( msgrcv(al->qid, &ack, AckMSG_SIZE(), al->mtype, MSG_NOERROR) < 0 )
+		{
+			if( errno == EINTR ) {
+				continue;
+			}
+			//the app removed its queue when it exited
+			break;
+		}
+
+		pthread_mutex_lock(&al->mutex);
+		if( (al->reqId != 0) && (ack.reqId == al->reqId) )
+		{
+			al->result = ack.result;
+			al->bAcked = true;
+			pthread_cond_signal(&al->cond);
+		}
+		else
+		{
+			//late ack of a request that timed out before
+			LOGD("stale ack %u of %ld dropped", ack.reqId, ack.cmd);
+		}
+		pthread_mutex_unlock(&al->mutex);
+	}
+
+	pthread_mutex_lock(&al->mutex);
+	al->bRunning = false;
+	pthread_cond_signal(&al->cond);
+	pthread_mutex_unlock(&al->mutex);
+
+	return (void*)0;
+}
+
+/* with al->mutex held, (re)starts the listener on qid once the last one has
+ * seen its queue go */
+static int gogglemsg_ackListen( GoggleAckListen_t* al, int qid, long mtype )
+{
+	//a new id means the old queue is gone, its listener is about to notice
+	while( al->bRunning && (al->qid != qid) ) {
+		pthread_cond_wait(&al->cond, &al->mutex);
+	}
+	if( al->bRunning ) {
+		return 0;
+	}
+	if( al->threadId != 0 )
+	{
+		pthread_join(al->threadId, NULL);
+		al->threadId = 0;
+	}
+
+	al->qid = qid;
+	al->mtype = mtype;
+	al->bRunning = true;
+	if( pthread_create(&al->threadId, NULL, gogglemsg_ackProc, al) != 0 )
+	{
+		LOGE("create ack thread failed");
+		al->threadId = 0;
+		al->bRunning = false;
+		return -1;
+	}
+
+	return 0;
+}
+
+/* sends cmd to the app owning mtype's queue, waits up to timeoutMs for its ack when timeoutMs > 0.
+ * One request at a time, the waiting is done on the ack listener's condvar */
+int gogglemsg_request( GoggleMsgType_e mtype, GoggleMsgCommand_e cmd, int arg, int timeoutMs, int* result )
+{
+	static uint32_t reqIdLast = 0;
+	GoggleAckListen_t* al = &gGoggleAck;
+	RequestMsg_t req;
+	struct timespec ts;
+	int ret = -2;
+
+	//looked up every time, the app removes its queue when it exits
+	int qid = msgget(GoggleMSG_KEY + mtype - MTYPE_RECORD, 0);
+	if( qid < 0 )
+	{
+		LOGE("no queue for %d", mtype);
+		return -1;
+	}
+
+	req.mtype = mtype;
+	req.cmd = cmd;
+	req.reqId = 0;
+	req.replyType = GoggleMSG_ackTYPE(getpid());
+	req.arg = arg;
+
+	if( timeoutMs <= 0 )
+	{
+		if( msgsnd(qid, &req, RequestMSG_SIZE(), IPC_NOWAIT) < 0 )
+		{
+			LOGE("request %d failed: %s", cmd, strerror(errno));
+			return -1;
+		}
+		return 0;
+	}
+
+	pthread_once(&gGoggleAckOnce, gogglemsg_ackInit);
+	pthread_mutex_lock(&gGoggleReqMutex);
+	pthread_mutex_lock(&al->mutex);
+
+	if( gogglemsg_ackListen(al, qid, req.replyType) < 0 )
+	{
+		pthread_mutex_unlock(&al->mutex);
+		pthread_mutex_unlock(&gGoggleReqMutex);
+		return -1;
+	}
+
+	do {
+		req.reqId = ++reqIdLast;
+	} while( req.reqId == 0 );
+	al->reqId = req.reqId;
+	al->bAcked = false;
+
+	if( msgsnd(qid, &req, RequestMSG_SIZE(), IPC_NOWAIT) < 0 )
+	{
+		LOGE("request %d failed: %s", cmd, strerror(errno));
+		ret = -1;
+	}
+	else
+	{
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		ts.tv_sec += timeoutMs / 1000;
+		ts.tv_nsec += (timeoutMs % 1000) * 1000000;
+		if( ts.tv_nsec >= 1000000000 )
+		{
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000000000;
+		}
+
+		while( !al->bAcked && al->bRunning )
+		{
+			if( pthread_cond_timedwait(&al->cond, &al->mutex, &ts) == ETIMEDOUT ) {
+				break;
+			}
+		}
+
+		if( al->bAcked )
+		{
+			if( result != NULL ) {
+				*result = al->result;
+			}
+			ret = 0;
+		}
+		else
+		{
+			LOGE("request %d not acknowledged", cmd);
+		}
+	}
+
+	//whatever comes for this one from now on is dropped by the listener
+	al->reqId = 0;
+	pthread_mutex_unlock(&al->mutex);
+	pthread_mutex_unlock(&gGoggleReqMutex);
+
+	return ret;
+}
+
 #if defined (__cplusplus)
 }
 #endif
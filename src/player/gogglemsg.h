@@ -26,6 +26,26 @@ typedef struct
 	uint8_t data[1];
 } DataMsg_t;
 
+/* typed request, gogglecmd still sends plain CommandMsg_t, those come with reqId 0 */
+typedef struct
+{
+	long     mtype;
+	long     cmd;
+	uint32_t reqId;     //0: no ack wanted
+	int32_t  replyType; //mtype of the ack
+	int32_t  arg;
+} RequestMsg_t;
+
+typedef struct
+{
+	long     mtype;
+	long     cmd;       //command acknowledged
+	uint32_t reqId;
+	int32_t  result;
+} AckMsg_t;
+
+#define GoggleMSG_ackTYPE(pid)  (0x40000000 | (pid))
+
 /** @} */
 
 /**
@@ -42,6 +62,7 @@ int gogglemsg_recv( GoggleMsgType_e mtype );
 int gogglemsg_sendData( GoggleMsgType_e mtype, GoggleMsgCommand_e cmd, void* data, int len );
 int gogglemsg_recvData( GoggleMsgType_e mtype, void* data, int len );
 int gogglemsg_flush( GoggleMsgType_e mtype );
+int gogglemsg_request( GoggleMsgType_e mtype, GoggleMsgCommand_e cmd, int arg, int timeoutMs, int* result );
 /** @} */
 
 #if defined (__cplusplus)
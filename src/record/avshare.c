@@ -23,28 +23,15 @@
 #include <unistd.h>
 
 #include "avshare.h"
+#include "avshare_shm.h"
 
-#define MEM_KEY          0x568066
-#define largeStreamSize  10 * 1024 // 0x100000
-#define littleStreamSize 5 * 1024  // 0x80000
-#define audioStreamSize  1 * 1024  // 0x40000
-#define SHAREBUF_COUNT   56        // 8*7
 #define FRAME_LenMAX     (3 * 1024 * 1024)
 #define AUDIO_LenMAX     (32 * 1024)
 
-#define RESET_IsConnect(p, num)              \
-    {                                        \
-        gAvshare.ptrConnect = p;             \
-        memset(gAvshare.ptrConnect, 0, num); \
-    }
-#define CHECK_IsConnect(no) (gAvshare.ptrConnect[MEDIA_type2index(no)])
-#define SET_IsConnect(no, x) \
-    { gAvshare.ptrConnect[MEDIA_type2index(no)] = x; }
 #define MEDIA_type2index(t) ((t)-MEDIA_VIDEO)
 
 #define FIFO_NAME "rtspStream.fifo" //"/tmp/H264_fifo"
 
-#define MEDIA_NUM 2
 #define FIFO_EN   1
 
 #define PRINT_INFO 1
@@ -71,36 +58,12 @@
 #define SAVE_FILE_TEST 0
 #define SAVE_FILE_PATH "/mnt/extsd/test_share_tx.264"
 
-#pragma pack(push)
-#pragma pack(1)
-
-typedef struct {
-    char wflag;     //\CAǷ\F1\BF\C9д\A3\AC\B5\B1Ϊ0ʱ\BFɶ\C1\B2\BB\BF\C9д\A3\AC\B6\C1ȡ\BD\F8\B3̶\C1\CD\EA֮\BA\F3\D6\C31\A3\BB\B5\B1Ϊ1ʱ\BF\C9д\B2\BB\BFɶ\C1\A3\ACд\C8\EB\BD\F8\B3\CCд\CD\EA\BA\F3\D6\C30\A1\A3
-    char frameType; //\CA\D3Ƶ֡\C0\E0\D0ͣ\BA I֡:1 P֡:0
-    char mediaType; // ֡\C0\E0\D0ͣ\BAvedio:0 audio:1
-    char buff_type;
-    uint64_t timestamp;
-    int length;
-} ShareStream_t;
-
-#pragma pack(pop)
-
-enum _BUFF_TYPE {
-    BUF_BEGIN,
-    BUF_MIDDLE,
-    BUF_END,
-    BUF_BEG_END,
-};
-
 typedef struct
 {
     int id;
-    uint8_t *bufShare;
-    uint8_t *ptrConnect;
+    AvshareShm_t *shm;
+    bool bKeyPending;       // SPS published, the IDR that follows is part of the same key
 
-    ShareStream_t *bufStreamHead[MEDIA_NUM];
-    uint8_t *streamBuf[MEDIA_NUM][SHAREBUF_COUNT];
-    int idxNext[MEDIA_NUM];
 #if (!FIFO_EN)
     int fdPipe;
 #endif
@@ -122,55 +85,38 @@ typedef struct
 AvshareInfo_t gAvshare;
 
 int avshare_init(void) {
-    int j = 0;
     int i = 0;
-    // system_exec("killall rtspServer");//kill rtspServer，通过app_deamon使rtspServer重启，保证rtspServer读取的顺序是正确的
-    // sleep(1);
-
-    int SHARE_CAPACITY = (largeStreamSize + audioStreamSize + sizeof(ShareStream_t) * MEDIA_NUM) * SHAREBUF_COUNT + MEDIA_NUM;
 
     memset(&gAvshare, 0, sizeof(gAvshare));
-    memset(gAvshare.streamBuf, 0, sizeof(gAvshare.streamBuf));
 
-    if ((gAvshare.id = shmget(MEM_KEY, SHARE_CAPACITY, IPC_CREAT | 0644)) == -1) {
+    if ((gAvshare.id = shmget(AVSHARE_memKEY, AVSHARE_shmSIZE, IPC_CREAT | 0644)) == -1) {
         dpf("failed to create share memory\n");
         return -1;
     }
 
-    if ((gAvshare.bufShare = shmat(gAvshare.id, NULL, 0)) == (void *)-1) {
+    if ((gAvshare.shm = shmat(gAvshare.id, NULL, 0)) == (void *)-1) {
         dpf("get share mem address failed\n");
-        gAvshare.bufShare = NULL;
+        gAvshare.shm = NULL;
         return -2;
     }
 
-    RESET_IsConnect(gAvshare.bufShare, MEDIA_NUM);
-    // sleep(1);
-    /*        ____________________________________________________________________________________________________
-     format:|connect |        (video + audio) header           |          (video + audio) stream                  |
-     bytes: |-2(v,a)-|-(sizeof(ShareStream_t)*2*SHAREBUF_COUNT-|-(largeStreamSize+audioStreamSize)*SHAREBUF_COUNT-|
+    /*        _________________________________________________________________________
+     format:|magic/version| ring[video] | ring[audio] | slot[readers] | video data | audio data |
+     bytes: |--------------------AVSHARE_dataOFFSET------------------|-videoSIZE-|-audioSIZE-|
+     head keeps counting from where a previous run stopped, readers attached before we
+     started keep their slots and wait for the first key frame
     */
-
-    for (i = 0; i < MEDIA_NUM; i++) {
-        gAvshare.bufStreamHead[i] = (ShareStream_t *)(gAvshare.bufShare + MEDIA_NUM + i * sizeof(ShareStream_t) * SHAREBUF_COUNT);
-        for (j = 0; j < SHAREBUF_COUNT; j++) {
-            gAvshare.bufStreamHead[i][j].wflag = 1;
-        }
+    for (i = 0; i < AVSHARE_mediaNUM; i++) {
+        AvshareRing_t *ring = &gAvshare.shm->ring[i];
+        uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+        ring->dropped = 0;
+        atomic_store_explicit(&ring->reserve, head, memory_order_relaxed);
+        atomic_store_explicit(&ring->keyPos, head, memory_order_release);
     }
+    gAvshare.shm->version = AVSHARE_VERSION;
+    gAvshare.shm->magic = AVSHARE_MAGIC;
 
-    for (j = 0; j < SHAREBUF_COUNT; j++) // video
-    {
-        gAvshare.streamBuf[0][j] = gAvshare.bufShare + MEDIA_NUM + sizeof(ShareStream_t) * SHAREBUF_COUNT * MEDIA_NUM + j * largeStreamSize;
-    }
-
-    for (j = 0; j < SHAREBUF_COUNT; j++) // audio
-    {
-        gAvshare.streamBuf[1][j] = gAvshare.streamBuf[0][SHAREBUF_COUNT - 1] + largeStreamSize + j * audioStreamSize;
-    }
-
-    for (i = 0; i < MEDIA_NUM; i++)
-        gAvshare.idxNext[i] = 0;
-
-        // dpf("bufShare=%x, countOfBuffer=%d\n", gAvshare.bufShare, SHAREBUF_COUNT);
+        // dpf("shm=%p, size=%d\n", gAvshare.shm, AVSHARE_shmSIZE);
 #if (!FIFO_EN)
     if (access(FIFO_NAME, F_OK) == -1) {
         mkfifo(FIFO_NAME, 0777);
@@ -192,84 +138,103 @@ int avshare_init(void) {
 }
 
 /*
-pstStream:流数据
-len:流数据长度
-frame_type: 1:I帧; 0:P帧，音频帧不生效，可默认赋值为0
-millis: 时间戳
-streamType: 0:大码流; 1:小码流; 2:音频流
+ segs/nbSegs: stream data, written as one record
+ frameType: FRAME_I/FRAME_P/FRAME_SPS, not used by audio
+ timestamp: ms for video, 90KHz for audio
+ captureUs: CLOCK_MONOTONIC at capture for the reader's latency counter, 0 if unknown
+ return: 0 written, 1 ring full (frame dropped), -2 not initialized, -3 no reader connected
 */
+int avshare_addv(const struct iovec *segs, int nbSegs, FrameType_e frameType, uint64_t timestamp, uint64_t captureUs, MediaType_e streamType) {
+    int index = MEDIA_type2index(streamType);
+    AvshareRing_t *ring;
+    AvshareRecord_t *rec;
+    uint8_t *data;
+    uint32_t size, head, start, pos, room, need, len = 0;
+    int i;
 
-int avshare_add(uint8_t *pstStream, int len, FrameType_e frame_type, uint32_t millis, MediaType_e streamType) {
-    int buff_size[MEDIA_NUM];
-    ShareStream_t *pStreamHead = NULL;
-    int data_send = 0;
-    int data_len = len;
-    int connect_flag = 0;
+    if (gAvshare.shm == NULL)
+        return -2;
 
-    buff_size[0] = largeStreamSize;
-    buff_size[1] = audioStreamSize;
+    ring = &gAvshare.shm->ring[index];
+    if (atomic_load_explicit(&ring->readers, memory_order_acquire) == 0) {
+        return -3;
+    }
 
-    if (gAvshare.bufShare == NULL)
-        return -2;
+    for (i = 0; i < nbSegs; i++) {
+        len += segs[i].iov_len;
+    }
 
-    while (data_len > 0) {
-        connect_flag = MEDIA_type2index(streamType);
-        pStreamHead = (ShareStream_t *)&gAvshare.bufStreamHead[connect_flag][gAvshare.idxNext[connect_flag]];
+    size = avshare_ringSize(index);
+    data = avshare_ringData(gAvshare.shm, index);
+    need = sizeof(AvshareRecord_t) + AVSHARE_align(len);
 
-        if (!CHECK_IsConnect(streamType)) {
-            gAvshare.idxNext[connect_flag] = 0;
-            return -3;
-        }
+    // readers never hold the writer back, only a frame larger than half the ring is dropped
+    if (need > size / 2) {
+        ring->seq++;
+        ring->dropped++;
+        return 1;
+    }
 
-        int buffer_len = data_len;
-        if (buffer_len > buff_size[connect_flag]) {
-            buffer_len = buff_size[connect_flag];
-        }
+    head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    pos = head & (size - 1);
+    room = size - pos;
+    start = (room < need) ? head + room : head;
 
-        // printf("debug --share_stream_header[%d][%d]---AddToShareStream-1--%d,%d,%d,%d\n",streamType,indexOfBuf[streamType],pShareStreamHeader->wflag,streamType,pShareStreamHeader->frameType,frame_type);
-        // printf("debug -----AddToShareStream-1--%d,%d,%d,%d\n",pShareStreamHeader->wflag,streamType,pShareStreamHeader->frameType,frame_type);
-        if (pStreamHead->wflag == 1) {
-            pStreamHead->frameType = frame_type;
-            pStreamHead->timestamp = millis;
-            pStreamHead->mediaType = streamType;
-
-            memcpy((uint8_t *)gAvshare.streamBuf[connect_flag][gAvshare.idxNext[connect_flag]], pstStream + data_send, buffer_len);
-
-            pStreamHead->length = buffer_len;
-            if (data_send == 0) // begin
-            {
-                if (data_len > buff_size[connect_flag]) {
-                    pStreamHead->buff_type = BUF_BEGIN;
-                    // printf("frame begin %d\n", gAvshare.idxNext);
-                } else {
-                    pStreamHead->buff_type = BUF_BEG_END;
-                    // printf("frame begin end %d\n", gAvshare.idxNext);
-                }
-            } else {
-                if (data_len > buff_size[connect_flag]) {
-                    pStreamHead->buff_type = BUF_MIDDLE;
-                } else {
-                    pStreamHead->buff_type = BUF_END;
-                    // printf("frame end %d\n", gAvshare.idxNext);
-                }
-            }
-
-            pStreamHead->wflag = 0;
-            gAvshare.idxNext[connect_flag] = (gAvshare.idxNext[connect_flag] + 1) % SHAREBUF_COUNT;
-
-            data_len -= buffer_len;
-            data_send += buffer_len;
-        } else // 对有连接却没读取数据的情况做处理
-        {
-            return 1;
+    // announce the bytes about to be overwritten before touching them
+    atomic_store_explicit(&ring->reserve, start + need, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    // records never wrap, the tail of the ring is skipped when it is too short
+    if (room < need) {
+        *(uint32_t *)(data + pos) = AVSHARE_lenWRAP;
+        pos = 0;
+    }
+
+    rec = (AvshareRecord_t *)(data + pos);
+    rec->len = len;
+    rec->seq = ring->seq++;
+    rec->frameType = frameType;
+    rec->mediaType = streamType;
+    rec->timestamp = timestamp;
+    rec->captureUs = captureUs;
+
+    pos += sizeof(AvshareRecord_t);
+    for (i = 0; i < nbSegs; i++) {
+        memcpy(data + pos, segs[i].iov_base, segs[i].iov_len);
+        pos += segs[i].iov_len;
+    }
+
+    atomic_store_explicit(&ring->head, start + need, memory_order_release);
+
+    // a lapped reader restarts at the newest SPS, or the IDR when it came alone
+    if (streamType == MEDIA_VIDEO) {
+        if ((frameType == FRAME_SPS) || ((frameType == FRAME_I) && !gAvshare.bKeyPending)) {
+            atomic_store_explicit(&ring->keyPos, start, memory_order_release);
         }
+        gAvshare.bKeyPending = (frameType == FRAME_SPS);
+    }
+
+    // pairs with a reader counting itself in sleepers before it checks the futex word
+    atomic_fetch_add(&ring->futex, 1);
+    if (atomic_load(&ring->sleepers)) {
+        avshare_futexWake(&ring->futex);
     }
 
     return 0;
 }
 
+int avshare_add(uint8_t *pstStream, int len, FrameType_e frame_type, uint32_t millis, MediaType_e streamType) {
+    struct iovec seg = {pstStream, len};
+
+    return avshare_addv(&seg, 1, frame_type, millis, 0, streamType);
+}
+
 int avshare_uninit(void) {
-    if (shmdt(gAvshare.bufShare) == -1) {
+    if (gAvshare.shm == NULL) {
+        return 0;
+    }
+
+    if (shmdt(gAvshare.shm) == -1) {
         dperr("remove share mem failed\n");
     }
 
@@ -277,6 +242,7 @@ int avshare_uninit(void) {
     {
         dperr("remove share mem ID failed");
     }
+    gAvshare.shm = NULL;
 #if (!FIFO_EN)
     if (gAvshare.fdPipe >= 0) {
         close(gAvshare.fdPipe);
@@ -297,23 +263,21 @@ int avshare_uninit(void) {
 }
 
 //-----------------------------------------------------------------------------------------------------------
-void avshare_addaud(unsigned char *buf, int len, uint32_t millis) {
-#if (0)
-    // printf("debug --------------1\n");
-    int ret = avshare_add(buf, len, 1, millis, 2); //  add to share memory, Audio stream
-    if (ret == 1) {
-        // buffer fuul, dropped
-        static int iDropped = 0;
+// ADTS framed AAC, timestamped with its capture time only, on the same clock as video
+void avshare_addaud(uint8_t *buf, int len, uint64_t captureUs) {
+    static int iDropped = 0;
+    struct iovec seg = {buf, len};
 
-        iDropped++;
-        if (iDropped >= 100) {
+    int ret = avshare_addv(&seg, 1, FRAME_I, captureUs, captureUs, MEDIA_AUDIO); //  add to share memory, Audio stream
+    if (ret == 1) {
+        // buffer full, dropped
+        if ((iDropped++ % 100) == 0) {
             dpf("share buffer overflowed, dropped %d audio packets\n", iDropped);
         }
     }
-#endif
 }
 
-void avshare_addvid(uint8_t *pstStream, int len, FrameType_e frameType, uint32_t millis) {
+void avshare_addvidv(const struct iovec *segs, int nbSegs, FrameType_e frameType, uint32_t millis, uint64_t captureUs) {
     static int iDropped = 0;
     int ret = 0;
 
@@ -322,12 +286,15 @@ void avshare_addvid(uint8_t *pstStream, int len, FrameType_e frameType, uint32_t
         gAvshare.fileTest = fopen(SAVE_FILE_PATH, "wb");
     }
     if (gAvshare.fileTest != NULL) {
-        fwrite(pstStream, len, 1, gAvshare.fileTest);
+        for (int i = 0; i < nbSegs; i++) {
+            fwrite(segs[i].iov_base, segs[i].iov_len, 1, gAvshare.fileTest);
+        }
     }
 #endif
 
+    // after a drop the reader can only resume at the next key frame, it comes with its SPS
     if (iDropped > 0) {
-        if (frameType != FRAME_I) {
+        if ((frameType != FRAME_I) && (frameType != FRAME_SPS)) {
             iDropped++;
             return;
         } else {
@@ -336,7 +303,7 @@ void avshare_addvid(uint8_t *pstStream, int len, FrameType_e frameType, uint32_t
         }
     }
 
-    ret = avshare_add(pstStream, len, frameType, millis, MEDIA_VIDEO); // add to share memory
+    ret = avshare_addv(segs, nbSegs, frameType, millis, captureUs, MEDIA_VIDEO); // add to share memory
     if (ret == 1) {
         // buffer full, dropped a frame
         iDropped++;
@@ -345,16 +312,20 @@ void avshare_addvid(uint8_t *pstStream, int len, FrameType_e frameType, uint32_t
     }
 }
 
+void avshare_addvid(uint8_t *pstStream, int len, FrameType_e frameType, uint32_t millis) {
+    struct iovec seg = {pstStream, len};
+
+    avshare_addvidv(&seg, 1, frameType, millis, 0);
+}
+
 void avshare_flush(void) {
-    int j;
     int i;
 
-    if (gAvshare.bufShare != NULL) {
-        for (i = 0; i < MEDIA_NUM; i++) {
-            for (j = 0; j < SHAREBUF_COUNT; j++) {
-                gAvshare.bufStreamHead[i][j].wflag = 1;
-            }
-            gAvshare.idxNext[i] = 0;
+    if (gAvshare.shm != NULL) {
+        for (i = 0; i < AVSHARE_mediaNUM; i++) {
+            // readers resyncing from now on wait for the next key frame
+            AvshareRing_t *ring = &gAvshare.shm->ring[i];
+            atomic_store_explicit(&ring->keyPos, atomic_load_explicit(&ring->head, memory_order_relaxed), memory_order_release);
         }
     }
 }
@@ -422,49 +393,19 @@ int avshare_write(uint8_t *pstStream, int len) {
 #endif
 
 //----------------------------------------------------------------------------------------------
-// avshare client
+// avshare client, the reader side lives in rtspLive
 //----------------------------------------------------------------------------------------------
-int avshare_connect(MediaType_e media_type) {
-    if (!CHECK_IsConnect(media_type)) {
-        SET_IsConnect(media_type, 1);
-        gAvshare.idxNext[media_type] = 0;
-    }
-
-    dpf("connect stream %d successfully - %d\n", media_type, CHECK_IsConnect(media_type));
-
-    return 0;
-}
-
-int avshare_disconnect(MediaType_e media_type) {
-    int i = 0;
-
-    SET_IsConnect(media_type, 0);
-
-    usleep(500 * 1000); // ä¿è¯writeä¸åç»§ç»­ï¼åå° wflagé½ç½®ä¸º1ï¼writeçindexOfBufå°è¢«ç½®ä¸º0;
-
-    for (i = 0; i < SHAREBUF_COUNT; i++) {
-        gAvshare.bufStreamHead[media_type][i].wflag = 1;
-    }
-
-    dpf("disconnect stream %d successfully\n", media_type);
-
-    return 0;
-}
-
 bool avshare_connected(MediaType_e streamType) {
-    if (!CHECK_IsConnect(streamType)) {
-        int streamIndex = MEDIA_type2index(streamType);
-        gAvshare.idxNext[streamIndex] = 0;
+    if (gAvshare.shm == NULL) {
         return false;
     }
 
-    return true;
+    return atomic_load_explicit(&gAvshare.shm->ring[MEDIA_type2index(streamType)].readers, memory_order_acquire) != 0;
 }
 
 void avshare_reset(void) {
     dpf("avshare reset\n");
 
-    // RESET_IsConnect(gAvshare.bufShare, MEDIA_NUM);
     // avshare_flush();
 
 #if (SAVE_FILE_TEST)
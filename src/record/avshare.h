@@ -22,6 +22,7 @@ extern "C" {
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <sys/uio.h>
 
 typedef enum
 {
@@ -43,8 +44,10 @@ typedef enum
 } FrameType_e;
 
 int  avshare_add(uint8_t * pstStream, int len, FrameType_e frameType, uint32_t millis, MediaType_e streamType);
-void avshare_addaud(uint8_t * buf, int len, uint32_t millis );
+void avshare_addaud(uint8_t * buf, int len, uint64_t captureUs);
+int  avshare_addv(const struct iovec * segs, int nbSegs, FrameType_e frameType, uint64_t timestamp, uint64_t captureUs, MediaType_e streamType);
 void avshare_addvid(uint8_t * pstStream, int len, FrameType_e frameType, uint32_t millis);
+void avshare_addvidv(const struct iovec * segs, int nbSegs, FrameType_e frameType, uint32_t millis, uint64_t captureUs);
 void avshare_flush(void);
 
 int avshare_init(void);
@@ -54,8 +57,6 @@ int avshare_write(uint8_t * pstStream, int len);
 int avshare_addPacket(uint8_t* data, int len, uint64_t timestamp, int isNewFrame, int pesLen);
 int avshare_addAudio(uint8_t* data, int len, uint64_t timestamp, int isNewFrame, int pesLen);
 
-int  avshare_connect(MediaType_e streamType);
-int  avshare_disconnect(MediaType_e streamType);
 bool avshare_connected(MediaType_e streamType);
 void avshare_reset(void);
 
@@ -0,0 +1,45 @@
+#include "bitstream.h"
+
+int bitstream_unescape(const uint8_t* src, int len, uint8_t* dst, int dstSize)
+{
+    int i, n = 0, zeros = 0;
+
+    if (len > dstSize) {
+        return -1;
+    }
+
+    for (i = 0; i < len; i++) {
+        if ((zeros >= 2) && (src[i] == 0x03)) {
+            zeros = 0;
+            continue;
+        }
+
+        zeros = (src[i] == 0x00) ? (zeros + 1) : 0;
+        dst[n++] = src[i];
+    }
+
+    return n;
+}
+
+int bitstream_escape(const uint8_t* src, int len, uint8_t* dst, int dstSize)
+{
+    int i, n = 0, zeros = 0;
+
+    for (i = 0; i < len; i++) {
+        if ((zeros >= 2) && (src[i] <= 0x03)) {
+            if (n >= dstSize) {
+                return -1;
+            }
+            dst[n++] = 0x03;
+            zeros = 0;
+        }
+
+        if (n >= dstSize) {
+            return -1;
+        }
+        zeros = (src[i] == 0x00) ? (zeros + 1) : 0;
+        dst[n++] = src[i];
+    }
+
+    return n;
+}
@@ -0,0 +1,244 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/* msb first bit reader/writer for NAL payloads (RBSP, emulation prevention
+ * bytes already removed). Both sides keep up to 64 bits cached in a register
+ * and touch memory a word at a time, a field costs a shift and a mask
+ * instead of a loop over its bits. */
+
+typedef struct
+{
+    const uint8_t* ptr;         // next byte to load into the cache
+    const uint8_t* end;
+    uint64_t cache;             // cached bits, left aligned
+    int      bits;              // valid bits in cache
+    int      pos;               // bits consumed
+    int      len;               // bits in the buffer
+} BitReader_t;
+
+typedef struct
+{
+    uint8_t* buf;
+    uint8_t* ptr;               // next byte to store
+    uint8_t* end;
+    uint64_t cache;             // pending bits, left aligned, always < 32
+    int      bits;
+    bool     bOverflow;
+} BitWriter_t;
+
+static inline uint64_t bitstream_load64(const uint8_t* p)
+{
+    uint64_t w;
+
+    memcpy(&w, p, sizeof(w));
+#if (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    w = __builtin_bswap64(w);
+#endif
+    return w;
+}
+
+static inline void bitstream_store32(uint8_t* p, uint32_t w)
+{
+#if (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    w = __builtin_bswap32(w);
+#endif
+    memcpy(p, &w, sizeof(w));
+}
+
+static inline void bitreader_init(BitReader_t* br, const uint8_t* buf, int len)
+{
+    br->ptr = buf;
+    br->end = buf + len;
+    br->cache = 0;
+    br->bits = 0;
+    br->pos = 0;
+    br->len = len << 3;
+}
+
+/* tops the cache up to at least 57 bits while data is left */
+static inline void bitreader_refill(BitReader_t* br)
+{
+    if (br->end - br->ptr >= 8) {
+        int n = (64 - br->bits) >> 3;
+        uint64_t w = bitstream_load64(br->ptr) & (~0ULL << (64 - (n << 3)));
+
+        br->cache |= w >> br->bits;
+        br->ptr += n;
+        br->bits += n << 3;
+    } else {
+        while ((br->bits <= 56) && (br->ptr < br->end)) {
+            br->cache |= (uint64_t)*br->ptr++ << (56 - br->bits);
+            br->bits += 8;
+        }
+    }
+}
+
+static inline bool bitreader_eof(BitReader_t* br)
+{
+    return (br->pos >= br->len);
+}
+
+static inline int bitreader_left(BitReader_t* br)
+{
+    return (br->pos < br->len) ? (br->len - br->pos) : 0;
+}
+
+/* n: 0..32, reads past the end return 0 */
+static inline uint32_t bitreader_readU(BitReader_t* br, int n)
+{
+    uint32_t val;
+
+    if (n <= 0) {
+        return 0;
+    }
+    if (br->bits < n) {
+        bitreader_refill(br);
+    }
+
+    val = (uint32_t)(br->cache >> (64 - n));
+    br->cache <<= n;
+    br->bits = (br->bits > n) ? (br->bits - n) : 0;
+    br->pos += n;
+
+    return val;
+}
+
+static inline void bitreader_skip(BitReader_t* br, int n)
+{
+    while (n > 32) {
+        bitreader_readU(br, 32);
+        n -= 32;
+    }
+    bitreader_readU(br, n);
+}
+
+/* unsigned Exp-Golomb, leading zeros counted on the whole cache at once */
+static inline uint32_t bitreader_readUE(BitReader_t* br)
+{
+    int zeros;
+
+    if (br->bits < 32) {
+        bitreader_refill(br);
+    }
+    if (br->cache == 0) {
+        // more than 31 leading zeros is not a valid code, or the data ran out
+        bitreader_skip(br, (br->bits < 32) ? 32 : br->bits);
+        return 0;
+    }
+
+    zeros = __builtin_clzll(br->cache);
+    if (zeros > 31) {
+        bitreader_skip(br, 32);
+        return 0;
+    }
+
+    br->cache <<= zeros;
+    br->bits -= zeros;
+    br->pos += zeros;
+
+    return bitreader_readU(br, zeros + 1) - 1;
+}
+
+static inline int32_t bitreader_readSE(BitReader_t* br)
+{
+    uint32_t ue = bitreader_readUE(br);
+
+    return (ue & 1) ? (int32_t)((ue + 1) >> 1) : -(int32_t)(ue >> 1);
+}
+
+static inline void bitwriter_init(BitWriter_t* bw, uint8_t* buf, int size)
+{
+    bw->buf = buf;
+    bw->ptr = buf;
+    bw->end = buf + size;
+    bw->cache = 0;
+    bw->bits = 0;
+    bw->bOverflow = false;
+}
+
+/* n: 0..32 */
+static inline void bitwriter_putU(BitWriter_t* bw, uint32_t val, int n)
+{
+    if (n <= 0) {
+        return;
+    }
+
+    bw->cache |= ((uint64_t)val << (64 - n)) >> bw->bits;
+    bw->bits += n;
+
+    if (bw->bits >= 32) {
+        if (bw->end - bw->ptr >= 4) {
+            bitstream_store32(bw->ptr, (uint32_t)(bw->cache >> 32));
+            bw->ptr += 4;
+        } else {
+            bw->bOverflow = true;
+        }
+        bw->cache <<= 32;
+        bw->bits -= 32;
+    }
+}
+
+static inline void bitwriter_putUE(BitWriter_t* bw, uint32_t val)
+{
+    uint64_t code = (uint64_t)val + 1;
+    int n = 64 - __builtin_clzll(code);
+
+    if (n > 32) {
+        bitwriter_putU(bw, 0, 32);
+        bitwriter_putU(bw, (uint32_t)(code >> 32), 1);
+        bitwriter_putU(bw, (uint32_t)code, 32);
+        return;
+    }
+
+    bitwriter_putU(bw, 0, n - 1);
+    bitwriter_putU(bw, (uint32_t)code, n);
+}
+
+/* bits written so far */
+static inline int bitwriter_pos(BitWriter_t* bw)
+{
+    return (int)((bw->ptr - bw->buf) << 3) + bw->bits;
+}
+
+/* pads the last byte with zeros, returns the bytes written or -1 if the
+ * buffer was too small */
+static inline int bitwriter_flush(BitWriter_t* bw)
+{
+    while (bw->bits > 0) {
+        if (bw->ptr < bw->end) {
+            *bw->ptr++ = (uint8_t)(bw->cache >> 56);
+        } else {
+            bw->bOverflow = true;
+        }
+        bw->cache <<= 8;
+        bw->bits = (bw->bits > 8) ? (bw->bits - 8) : 0;
+    }
+
+    return bw->bOverflow ? -1 : (int)(bw->ptr - bw->buf);
+}
+
+/* moves n bits over unchanged */
+static inline void bitstream_copy(BitReader_t* br, BitWriter_t* bw, int n)
+{
+    while (n >= 32) {
+        bitwriter_putU(bw, bitreader_readU(br, 32), 32);
+        n -= 32;
+    }
+    bitwriter_putU(bw, bitreader_readU(br, n), n);
+}
+
+/* NAL payload <-> RBSP, a single pass each way. Return the output length or
+ * -1 if dst is too small. */
+int bitstream_unescape(const uint8_t* src, int len, uint8_t* dst, int dstSize);
+int bitstream_escape(const uint8_t* src, int len, uint8_t* dst, int dstSize);
+
+#ifdef __cplusplus
+}
+#endif
@@ -28,6 +28,10 @@
 #define KEY_FULL        "full"
 #define KEY_AUDIO       "audio"
 #define KEY_NAMING      "naming"
+#define KEY_FRAGMENT    "fragment"
+#define KEY_SYNC        "sync"
+#define KEY_PREALLOC    "prealloc"
+#define KEY_FANOUT      "fanout"
 
 #define KEY_WIDTH       "width"
 #define KEY_HEIGHT      "height"
@@ -444,6 +448,18 @@ void conf_loadRecordParams(char* confFile, RecordParams_t* para)
 
     lValue = ini_getbool(SEC_RECORD, KEY_AUDIO, TRUE, confFile);
     para->enableAudio = (lValue>0);
+
+    lValue = ini_getl(SEC_RECORD, KEY_FRAGMENT, REC_fragDURATION, confFile);
+    para->fragDuration = check_set(lValue, 0, REC_maxFragDURATION);
+
+    lValue = ini_getl(SEC_RECORD, KEY_SYNC, REC_syncINTERVAL, confFile);
+    para->syncInterval = check_set(lValue, 0, REC_maxSyncINTERVAL);
+
+    lValue = ini_getbool(SEC_RECORD, KEY_PREALLOC, TRUE, confFile);
+    para->preallocate = (lValue>0);
+
+    lValue = ini_getbool(SEC_RECORD, KEY_FANOUT, TRUE, confFile);
+    para->enableFanout = (lValue>0);
 }
 
 void conf_saveRecordParams(char* confFile, RecordParams_t* para)
@@ -454,6 +470,10 @@ void conf_saveRecordParams(char* confFile, RecordParams_t* para)
     ini_putl(SEC_RECORD, KEY_SIZE, para->packSize/(1024*1024), confFile);
     ini_putl(SEC_RECORD, KEY_FULL, para->minDiskSize, confFile);
     ini_putl(SEC_RECORD, KEY_AUDIO, para->enableAudio, confFile);
+    ini_putl(SEC_RECORD, KEY_FRAGMENT, para->fragDuration, confFile);
+    ini_putl(SEC_RECORD, KEY_SYNC, para->syncInterval, confFile);
+    ini_putl(SEC_RECORD, KEY_PREALLOC, para->preallocate, confFile);
+    ini_putl(SEC_RECORD, KEY_FANOUT, para->enableFanout, confFile);
 }
 
 void conf_loadAiParams(char* confFile, AiParams_t* para)
@@ -230,6 +230,37 @@ void disk_dump(char* sPath)
             availableDisk / GB);
 }
 
+/* number of a movie named <prefix><index>...<ext>, -1 for anything else */
+int disk_movieIndex(const char* sName, char* sPrefix, char* sExts[], int nExts, int nIndexLen)
+{
+    char sTemp[FILE_NAME_LEN];
+    int  size = strlen(sName);
+    int  nPrefix = strlen(sPrefix);
+    int  nExtLen = 0;
+    int  i;
+
+    if( strstr(sName, sPrefix) != sName ) {
+        return -1;
+    }
+
+    for(i=0; i<nExts; i++) {
+        nExtLen = strlen(sExts[i]);
+        if( size < (nIndexLen + nPrefix + nExtLen) ) {
+            continue;
+        }
+        if( strcmp((sName + (size - nExtLen)), sExts[i]) == 0 ) {
+            break;
+        }
+    }
+    if( i >= nExts ) {
+        return -1;
+    }
+
+    memset(sTemp, 0, sizeof(sTemp));
+    memcpy(sTemp, sName+nPrefix, nIndexLen);
+    return atoi(sTemp);
+}
+
 int disk_countMovies(char* sPath, char* sPrefix, char* sExts[], int nExts, int nIndexLen)
 {
     DIR* dp = opendir(sPath);
@@ -240,12 +271,8 @@ int disk_countMovies(char* sPath, char* sPrefix, char* sExts[], int nExts, int n
 
     struct dirent *dirp;
     char sTemp[FILE_NAME_LEN];
-    int  nExtLen = 0;
-    int  nPrefix = strlen(sPrefix);
-    int  nCount = 0;
     int  nIndex = 0;
     int  nIndexMax = -1;
-    int  i;
 
     while( (dirp = readdir(dp)) != NULL ) {
         if(strcmp(dirp->d_name, ".") == 0 || strcmp(dirp->d_name, "..") == 0){//exclude "." and ".."
@@ -254,52 +281,31 @@ int disk_countMovies(char* sPath, char* sPrefix, char* sExts[], int nExts, int n
 
         //LOGD("%s", dirp->d_name);
 
-        int size = strlen(dirp->d_name);
-
-        if( strstr(dirp->d_name, sPrefix) != dirp->d_name ) {
+        nIndex = disk_movieIndex(dirp->d_name, sPrefix, sExts, nExts, nIndexLen);
+        if( nIndex < 0 ) {
             continue;
         }
 
-        for(i=0; i<nExts; i++) {
-            nExtLen = strlen(sExts[i]);
-            if( size < (nIndexLen + nPrefix + nExtLen) ) {
+        // d_type saves the stat where the filesystem reports it
+        if( dirp->d_type != DT_UNKNOWN ) {
+            if( dirp->d_type != DT_REG ) {
                 continue;
             }
-            if( strcmp((dirp->d_name + (size - nExtLen)), sExts[i]) == 0 ) {
-                break;
-            }
-        }
-        if( i >= nExts ) {
-            continue;
-        }
+        } else {
+            struct stat myStat;
 
-        strcpy(sTemp, sPath);
-        strcat(sTemp, dirp->d_name);
-
-        //LOGD("%s", sTemp);
-
-        struct stat myStat;
-        if( stat(sTemp, &myStat) < 0 ) {
-            continue;
-        }
-        if( S_ISREG(myStat.st_mode) ) {
-            memset(sTemp, 0, sizeof(sTemp));
-            memcpy(sTemp, dirp->d_name+nPrefix, nIndexLen);
-            nIndex = atoi(sTemp);
-            nCount++;
-            if( nIndex > nIndexMax ) {
-                nIndexMax = nIndex;
+            snprintf(sTemp, sizeof(sTemp), "%s%s", sPath, dirp->d_name);
+            if( stat(sTemp, &myStat) < 0 || !S_ISREG(myStat.st_mode) ) {
+                continue;
             }
         }
-#if(0)
-        if( S_ISDIR(myStat.st_mode) ) {
-            continue;
-        }
-        else{//link file and others
+
+        if( nIndex > nIndexMax ) {
+            nIndexMax = nIndex;
         }
-#endif
     }
 
+    closedir(dp);
     return nIndexMax;
 }
 
@@ -421,6 +427,7 @@ bool disk_sdstat(uint32_t mbFull, SdcardStatus_t* sds)
     bool updated = sdContext.updated;
     sds->inserted = sdContext.inserted;
     sds->mounted = sdContext.mounted;
+    sds->availMB = sdContext.avail;
     if( sds->full != (sdContext.avail < mbFull)) {
         sds->full = (sdContext.avail < mbFull);
         updated = true;
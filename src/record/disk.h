@@ -15,12 +15,14 @@ uint32_t disk_availableSize(char* sPath);
 bool     disk_checkPath(char* sPath);
 bool     disk_checkFile(char* sPath);
 int      disk_countMovies(char* sPath, char* sPrefix, char* sExts[], int nExts, int nIndexLen);
+int      disk_movieIndex(const char* sName, char* sPrefix, char* sExts[], int nExts, int nIndexLen);
 
 typedef struct
 {
     bool inserted;
     bool mounted;
     bool full;
+    uint32_t availMB;
 } SdcardStatus_t;
 
 void     disk_sdstat_create(char* sPath, bool bThread);
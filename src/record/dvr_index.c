@@ -0,0 +1,431 @@
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "dvr_index.h"
+
+#define DVRIDX_MAGIC        0x58444944          //"DIDX"
+#define DVRIDX_VERSION      1
+#define DVRIDX_pathLEN      256
+
+typedef enum {
+    DVRIDX_opADD = 1,
+    DVRIDX_opREMOVE,
+    DVRIDX_opRENAME,
+} DvrIndexOp_e;
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t reserved;
+} DvrIndexHead_t;
+
+typedef struct
+{
+    uint32_t op;
+    uint32_t reserved;
+    DvrIndexEntry_t entry;
+    char     sNewName[DVRIDX_nameLEN];  //rename only
+    uint32_t sum;
+} DvrIndexRecord_t;
+
+static uint32_t dvridx_sum(const void* data, size_t len)
+{
+    const uint8_t* p = (const uint8_t*)data;
+    uint32_t h = 2166136261u;
+
+    while (len--) {
+        h = (h ^ *p++) * 16777619u;
+    }
+    return h;
+}
+
+static void dvridx_path(char* sPath, const char* sDir, const char* sFile)
+{
+    size_t len = strlen(sDir);
+
+    snprintf(sPath, DVRIDX_pathLEN, "%s%s%s", sDir, (len > 0 && sDir[len - 1] == '/') ? "" : "/", sFile);
+}
+
+static bool dvridx_headOk(const DvrIndexHead_t* head)
+{
+    return (head->magic == DVRIDX_MAGIC) && (head->version == DVRIDX_VERSION) &&
+           (head->recordSize == sizeof(DvrIndexRecord_t));
+}
+
+static void dvridx_headInit(DvrIndexHead_t* head)
+{
+    memset(head, 0, sizeof(DvrIndexHead_t));
+    head->magic = DVRIDX_MAGIC;
+    head->version = DVRIDX_VERSION;
+    head->recordSize = sizeof(DvrIndexRecord_t);
+}
+
+static void dvridx_seal(DvrIndexRecord_t* rec)
+{
+    rec->sum = dvridx_sum(rec, offsetof(DvrIndexRecord_t, sum));
+}
+
+/* one record, one write. An index left with a torn record is not touched,
+ * the next reader finds it invalid and rebuilds it. */
+static int dvridx_append(const char* sDir, DvrIndexRecord_t* rec)
+{
+    char sPath[DVRIDX_pathLEN];
+    struct stat st;
+    int ret = -1;
+
+    dvridx_path(sPath, sDir, DVRIDX_fileNAME);
+    dvridx_seal(rec);
+
+    int fd = open(sPath, O_WRONLY | O_APPEND | O_CREAT, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+
+    if (fstat(fd, &st) < 0) {
+        goto done;
+    }
+
+    if (st.st_size == 0) {
+        DvrIndexHead_t head;
+
+        dvridx_headInit(&head);
+        if (write(fd, &head, sizeof(head)) != sizeof(head)) {
+            goto done;
+        }
+    } else if ((st.st_size < sizeof(DvrIndexHead_t)) ||
+               ((st.st_size - sizeof(DvrIndexHead_t)) % sizeof(DvrIndexRecord_t)) != 0) {
+        goto done;
+    }
+
+    if (write(fd, rec, sizeof(DvrIndexRecord_t)) == sizeof(DvrIndexRecord_t)) {
+        fdatasync(fd);
+        ret = 0;
+    }
+
+done:
+    close(fd);
+    return ret;
+}
+
+int dvridx_add(const char* sDir, const DvrIndexEntry_t* entry)
+{
+    DvrIndexRecord_t rec;
+
+    memset(&rec, 0, sizeof(rec));
+    rec.op = DVRIDX_opADD;
+    rec.entry = *entry;
+    rec.entry.sName[DVRIDX_nameLEN - 1] = 0;
+
+    return dvridx_append(sDir, &rec);
+}
+
+int dvridx_remove(const char* sDir, const char* sName)
+{
+    DvrIndexRecord_t rec;
+
+    memset(&rec, 0, sizeof(rec));
+    rec.op = DVRIDX_opREMOVE;
+    snprintf(rec.entry.sName, DVRIDX_nameLEN, "%s", sName);
+
+    return dvridx_append(sDir, &rec);
+}
+
+int dvridx_rename(const char* sDir, const char* sName, const char* sNewName)
+{
+    DvrIndexRecord_t rec;
+
+    memset(&rec, 0, sizeof(rec));
+    rec.op = DVRIDX_opRENAME;
+    snprintf(rec.entry.sName, DVRIDX_nameLEN, "%s", sName);
+    snprintf(rec.sNewName, DVRIDX_nameLEN, "%s", sNewName);
+
+    return dvridx_append(sDir, &rec);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// replay
+//
+// clips are looked up by name through an open addressing table of entry
+// numbers, so a log of thousands of records replays in one pass. Removed
+// clips leave a tombstone in the table and a blank entry, both are swept
+// out together when the table fills up and once more at the end.
+
+#define DVRIDX_slotGONE     (-1)
+
+typedef struct
+{
+    DvrIndex_t* idx;
+    int  nbAlloc;
+    int* slots;             //entry + 1, 0 free, DVRIDX_slotGONE removed
+    int  nbSlots;           //power of 2
+    int  nbUsed;            //slots not free, tombstones included
+    int  nbLive;            //entries not removed
+} DvrIndexReplay_t;
+
+/* the slot of sName or, if it isn't there, the one it goes to: the first
+ * tombstone on its probe chain, else the free slot ending it */
+static int dvridx_slot(DvrIndexReplay_t* rp, const char* sName)
+{
+    uint32_t i = dvridx_sum(sName, strlen(sName)) & (rp->nbSlots - 1);
+    int gone = -1;
+
+    while (rp->slots[i] != 0) {
+        if (rp->slots[i] == DVRIDX_slotGONE) {
+            if (gone < 0) {
+                gone = i;
+            }
+        } else if (strcmp(rp->idx->entries[rp->slots[i] - 1].sName, sName) == 0) {
+            return i;
+        }
+        i = (i + 1) & (rp->nbSlots - 1);
+    }
+    return (gone >= 0) ? gone : (int)i;
+}
+
+/* squeezes the removed entries out, keeping the recording order, and builds
+ * the table again without tombstones */
+static int dvridx_rehash(DvrIndexReplay_t* rp, int nbSlots)
+{
+    DvrIndex_t* idx = rp->idx;
+    int* slots = (int*)calloc(nbSlots, sizeof(int));
+    int i, n = 0;
+
+    if (slots == NULL) {
+        return -1;
+    }
+
+    free(rp->slots);
+    rp->slots = slots;
+    rp->nbSlots = nbSlots;
+
+    for (i = 0; i < idx->nbEntries; i++) {
+        if (idx->entries[i].sName[0] != 0) {
+            idx->entries[n] = idx->entries[i];
+            rp->slots[dvridx_slot(rp, idx->entries[n].sName)] = n + 1;
+            n++;
+        }
+    }
+    idx->nbEntries = n;
+    rp->nbUsed = n;
+    rp->nbLive = n;
+    return 0;
+}
+
+/* adds the clip or updates the one of that name */
+static int dvridx_put(DvrIndexReplay_t* rp, const DvrIndexEntry_t* entry)
+{
+    DvrIndex_t* idx = rp->idx;
+    int slot;
+
+    if (rp->nbSlots > 0) {
+        slot = dvridx_slot(rp, entry->sName);
+        if (rp->slots[slot] > 0) {
+            idx->entries[rp->slots[slot] - 1] = *entry;
+            return 0;
+        }
+    }
+
+    // kept at most half used, tombstones too, so probe chains stay short
+    if ((rp->nbUsed + 1) * 2 > rp->nbSlots) {
+        int nbSlots = rp->nbSlots ? rp->nbSlots : 1024;
+
+        while ((rp->nbLive + 1) * 4 > nbSlots) {
+            nbSlots *= 2;
+        }
+        if (dvridx_rehash(rp, nbSlots) < 0) {
+            return -1;
+        }
+    }
+
+    if (idx->nbEntries >= rp->nbAlloc) {
+        int nbAlloc = rp->nbAlloc ? rp->nbAlloc * 2 : 256;
+        DvrIndexEntry_t* entries = (DvrIndexEntry_t*)realloc(idx->entries, nbAlloc * sizeof(DvrIndexEntry_t));
+        if (entries == NULL) {
+            return -1;
+        }
+        idx->entries = entries;
+        rp->nbAlloc = nbAlloc;
+    }
+
+    slot = dvridx_slot(rp, entry->sName);
+    if (rp->slots[slot] == 0) {
+        rp->nbUsed++;
+    }
+    idx->entries[idx->nbEntries] = *entry;
+    rp->slots[slot] = ++idx->nbEntries;
+    rp->nbLive++;
+    return 0;
+}
+
+/* the entry is blanked and its slot left as a tombstone, the probe chains
+ * through it stay intact until the next rehash */
+static void dvridx_drop(DvrIndexReplay_t* rp, int slot)
+{
+    rp->idx->entries[rp->slots[slot] - 1].sName[0] = 0;
+    rp->slots[slot] = DVRIDX_slotGONE;
+    rp->nbLive--;
+}
+
+static int dvridx_replay(DvrIndexReplay_t* rp, const DvrIndexRecord_t* rec)
+{
+    DvrIndex_t* idx = rp->idx;
+    int slot;
+
+    if (rec->entry.sName[0] == 0) {
+        return 0;
+    }
+
+    switch (rec->op) {
+    case DVRIDX_opADD:
+        return dvridx_put(rp, &rec->entry);
+
+    case DVRIDX_opREMOVE:
+        if (rp->nbSlots > 0) {
+            slot = dvridx_slot(rp, rec->entry.sName);
+            if (rp->slots[slot] > 0) {
+                dvridx_drop(rp, slot);
+            }
+        }
+        return 0;
+
+    case DVRIDX_opRENAME:
+        if (rp->nbSlots > 0) {
+            slot = dvridx_slot(rp, rec->entry.sName);
+            if (rp->slots[slot] > 0) {
+                DvrIndexEntry_t entry = idx->entries[rp->slots[slot] - 1];
+
+                dvridx_drop(rp, slot);
+                memcpy(entry.sName, rec->sNewName, DVRIDX_nameLEN);
+                entry.sName[DVRIDX_nameLEN - 1] = 0;
+                return dvridx_put(rp, &entry);
+            }
+        }
+        return 0;
+
+    default:
+        return -1;
+    }
+}
+
+int dvridx_load(const char* sDir, DvrIndex_t* idx)
+{
+    char sPath[DVRIDX_pathLEN];
+    struct stat stDir, stIdx;
+    DvrIndexHead_t head;
+    DvrIndexRecord_t rec;
+    DvrIndexReplay_t rp;
+    int i, n = 0, ret = -1;
+
+    memset(idx, 0, sizeof(DvrIndex_t));
+    dvridx_path(sPath, sDir, DVRIDX_fileNAME);
+
+    if (stat(sDir, &stDir) < 0 || stat(sPath, &stIdx) < 0) {
+        return -1;
+    }
+    if (stDir.st_mtime > stIdx.st_mtime) {
+        // changed behind the index's back
+        return -1;
+    }
+    if ((stIdx.st_size < sizeof(DvrIndexHead_t)) ||
+        ((stIdx.st_size - sizeof(DvrIndexHead_t)) % sizeof(DvrIndexRecord_t)) != 0) {
+        return -1;
+    }
+
+    FILE* fp = fopen(sPath, "rb");
+    if (fp == NULL) {
+        return -1;
+    }
+
+    memset(&rp, 0, sizeof(rp));
+    rp.idx = idx;
+
+    if (fread(&head, sizeof(head), 1, fp) != 1 || !dvridx_headOk(&head)) {
+        goto done;
+    }
+
+    while (fread(&rec, sizeof(rec), 1, fp) == 1) {
+        if (rec.sum != dvridx_sum(&rec, offsetof(DvrIndexRecord_t, sum))) {
+            goto done;
+        }
+        rec.entry.sName[DVRIDX_nameLEN - 1] = 0;
+        if (dvridx_replay(&rp, &rec) < 0) {
+            goto done;
+        }
+        idx->nbRecords++;
+    }
+    if (ferror(fp)) {
+        goto done;
+    }
+
+    // squeeze out what was removed, keeping the recording order
+    for (i = 0; i < idx->nbEntries; i++) {
+        if (idx->entries[i].sName[0] != 0) {
+            idx->entries[n++] = idx->entries[i];
+        }
+    }
+    idx->nbEntries = n;
+    ret = 0;
+
+done:
+    fclose(fp);
+    free(rp.slots);
+    if (ret != 0) {
+        dvridx_free(idx);
+    }
+    return ret;
+}
+
+void dvridx_free(DvrIndex_t* idx)
+{
+    free(idx->entries);
+    memset(idx, 0, sizeof(DvrIndex_t));
+}
+
+int dvridx_rebuild(const char* sDir, const DvrIndexEntry_t* entries, int nbEntries)
+{
+    char sPath[DVRIDX_pathLEN];
+    char sTemp[DVRIDX_pathLEN];
+    DvrIndexHead_t head;
+    DvrIndexRecord_t rec;
+    int i;
+
+    dvridx_path(sPath, sDir, DVRIDX_fileNAME);
+    dvridx_path(sTemp, sDir, DVRIDX_fileNAME ".tmp");
+
+    FILE* fp = fopen(sTemp, "wb");
+    if (fp == NULL) {
+        return -1;
+    }
+
+    dvridx_headInit(&head);
+    bool ok = (fwrite(&head, sizeof(head), 1, fp) == 1);
+
+    for (i = 0; ok && i < nbEntries; i++) {
+        memset(&rec, 0, sizeof(rec));
+        rec.op = DVRIDX_opADD;
+        rec.entry = entries[i];
+        rec.entry.sName[DVRIDX_nameLEN - 1] = 0;
+        dvridx_seal(&rec);
+        ok = (fwrite(&rec, sizeof(rec), 1, fp) == 1);
+    }
+
+    ok = ok && (fflush(fp) == 0) && (fdatasync(fileno(fp)) == 0);
+    fclose(fp);
+
+    if (!ok || rename(sTemp, sPath) < 0) {
+        remove(sTemp);
+        return -1;
+    }
+
+    // the rename made the directory newer than the file, the index is
+    // current as of now
+    utimensat(AT_FDCWD, sPath, NULL, 0);
+    return 0;
+}
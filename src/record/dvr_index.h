@@ -0,0 +1,71 @@
+/******************************************************************************
+  File Name     : dvr_index.h
+  Description   : index of the recordings kept on the card next to them, so
+                  neither the record app nor the playback page has to scan
+                  and stat the whole movies directory.
+
+  The index is a log of fixed size records, each one a single append with a
+  checksum followed by fdatasync, so a power cut loses at most the record
+  being written. The record app adds a segment marked partial when it opens
+  it and again with its size and duration once it is closed, the playback
+  page logs what it deletes or renames. Reading replays the log.
+
+  Anything else touching the directory (a PC, a card cleared from the menu)
+  leaves it newer than the index; the index then counts as invalid, the
+  reader scans as before and writes a fresh index from the result. The
+  mtimes are coarse (2 s on vfat) and the directory's is written back
+  lazily, so a valid index may still miss the newest file; the record app
+  looks past the indexed clips before it picks a name.
+******************************************************************************/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define DVRIDX_fileNAME     ".dvr_index"
+#define DVRIDX_nameLEN      64
+
+#define DVRIDX_flagSTAR     0x01
+#define DVRIDX_flagPARTIAL  0x02        //still being recorded, or cut off by a power loss
+
+typedef struct
+{
+    char     sName[DVRIDX_nameLEN];     //file name in the movies directory
+    uint64_t size;                      //bytes
+    uint32_t durationMs;                //0 if not known
+    uint32_t thumbSize;                 //bytes of <label>.jpg, 0 if none
+    uint32_t flags;
+} DvrIndexEntry_t;
+
+typedef struct
+{
+    DvrIndexEntry_t* entries;
+    int nbEntries;
+    int nbRecords;                      //in the file, > nbEntries once clips were deleted or renamed
+} DvrIndex_t;
+
+/* 0 and the clips in the order they were recorded, -1 if there is no valid
+ * index for sDir */
+int  dvridx_load(const char* sDir, DvrIndex_t* idx);
+void dvridx_free(DvrIndex_t* idx);
+
+int  dvridx_add(const char* sDir, const DvrIndexEntry_t* entry);
+int  dvridx_remove(const char* sDir, const char* sName);
+int  dvridx_rename(const char* sDir, const char* sName, const char* sNewName);
+
+/* replaces the index with these clips, after a scan or to compact the log */
+int  dvridx_rebuild(const char* sDir, const DvrIndexEntry_t* entries, int nbEntries);
+
+/* worth a dvridx_rebuild */
+static inline bool dvridx_sparse(const DvrIndex_t* idx)
+{
+    return idx->nbRecords > 2 * idx->nbEntries + 64;
+}
+
+#ifdef __cplusplus
+}
+#endif
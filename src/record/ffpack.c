@@ -1,15 +1,30 @@
 //#define LOG_NDEBUG 0
 #define LOG_TAG "ffpack"
 #include <log/log.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <time.h>
 #include "ffpack.h"
 
 #define FFPack_bufSIZE  65535
+#define FFPack_fileBufSIZE  (512*1024)  //AVIO buffer for file output, the usual write size
 #define FFPack(p)       ((FFPack_t*)(p))
 
+static uint32_t ffpack_tick(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
 void ff_printerr(char* sPrefix, int err)
 {
 	char strError[256] = {0};
@@ -33,6 +48,48 @@ int write_packet(void *opaque, uint8_t *buf, int buf_size)
 	return 0;
 }
 
+/* file output goes through a larger AVIO buffer than libavformat's default
+ * 32 KB so the card mostly sees big writes; offsets aren't aligned, a flush
+ * or seek writes out whatever is buffered */
+static int ffpack_writeFile(void *opaque, uint8_t *buf, int buf_size)
+{
+    FFPack_t* ff = FFPack(opaque);
+    int nWritten = 0;
+
+    while(nWritten < buf_size)
+    {
+        ssize_t n = write(ff->fd, buf + nWritten, buf_size - nWritten);
+        if(n < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            return AVERROR(errno);
+        }
+        nWritten += n;
+    }
+
+    return nWritten;
+}
+
+static int64_t ffpack_seekFile(void *opaque, int64_t offset, int whence)
+{
+    FFPack_t* ff = FFPack(opaque);
+
+    if(whence == AVSEEK_SIZE)
+    {
+        struct stat st;
+        if(fstat(ff->fd, &st) < 0)
+            return AVERROR(errno);
+        return st.st_size;
+    }
+
+    off_t pos = lseek(ff->fd, offset, whence & ~AVSEEK_FORCE);
+    if(pos < 0)
+        return AVERROR(errno);
+
+    return pos;
+}
+
 FFPack_t* ffpack_open(CB_onData cbOnData, void* context)
 {
     FFPack_t* ff = (FFPack_t*)malloc(sizeof(FFPack_t));
@@ -42,6 +99,7 @@ FFPack_t* ffpack_open(CB_onData cbOnData, void* context)
     }
 
     memset(ff, 0, sizeof(FFPack_t));
+    ff->fd = -1;
 
     int nRet = avformat_alloc_output_context2(&ff->ofmtContext, NULL, "mpegts", NULL);
     //int nRet = avformat_alloc_output_context2(&ff->ofmtContext, NULL, "mp4", NULL);
@@ -77,6 +135,7 @@ FFPack_t* ffpack_openFile(char* sName, void* context)
     }
 
     memset(ff, 0, sizeof(FFPack_t));
+    ff->fd = -1;
 
     int nRet = avformat_alloc_output_context2(&ff->ofmtContext, NULL, NULL, sName);
     //int nRet = avformat_alloc_output_context2(&ff->ofmtContext, NULL, "mp4", NULL);
@@ -90,7 +149,29 @@ FFPack_t* ffpack_openFile(char* sName, void* context)
 
     if(!(ff->ofmtContext->flags & AVFMT_NOFILE))
     {
-        nRet = avio_open(&ff->ofmtContext->pb, sName, AVIO_FLAG_WRITE);
+        uint8_t* buf = NULL;
+
+        // never over an existing clip, the caller picks the next name
+        ff->fd = open(sName, O_WRONLY | O_CREAT | O_EXCL, 0644);
+        nRet = (ff->fd < 0) ? AVERROR(errno) : 0;
+        if(nRet == 0)
+        {
+            buf = (uint8_t*)av_malloc(FFPack_fileBufSIZE);
+            if(buf != NULL)
+            {
+                ff->ofmtContext->pb = avio_alloc_context(buf, FFPack_fileBufSIZE, 1, ff, NULL, ffpack_writeFile, ffpack_seekFile);
+            }
+            if(ff->ofmtContext->pb == NULL)
+            {
+                av_free(buf);
+                close(ff->fd);
+                nRet = AVERROR(ENOMEM);
+            }
+            else
+            {
+                ff->ofmtContext->flags |= AVFMT_FLAG_CUSTOM_IO;
+            }
+        }
         if(nRet < 0)
         {
             ff_printerr( "pb failed: ", nRet);
@@ -128,7 +209,14 @@ void ffpack_close(FFPack_t* ff)
 
     if( ff->ofmtContext != NULL )
     {
-        if(!(ff->ofmtContext->flags & AVFMT_NOFILE))
+        if(ff->fd >= 0)
+        {
+            avio_flush(ff->ofmtContext->pb);
+            av_freep(&ff->ofmtContext->pb->buffer);
+            avio_context_free(&ff->ofmtContext->pb);
+            close(ff->fd);
+        }
+        else if(!(ff->ofmtContext->flags & AVFMT_NOFILE))
         {
             //LOGD("close pb=%p\n", ff->ofmtContext->pb);
             avio_close(ff->ofmtContext->pb);
@@ -154,6 +242,8 @@ void ffpack_close(FFPack_t* ff)
         avformat_free_context(ff->ofmtContext);
     }
 
+    av_dict_free(&ff->options);
+
     free(ff);
 
     LOGD("done\n");
@@ -334,7 +424,8 @@ int ffpack_start(FFPack_t* ff)
 
     //ffpack_dumpTimebase(ff);
 
-    ret = avformat_write_header(ff->ofmtContext, NULL);
+    ret = avformat_write_header(ff->ofmtContext, &ff->options);
+    av_dict_free(&ff->options);
     if (ret < 0)
     {
         ff_printerr("failed: ", ret);
@@ -395,6 +486,56 @@ void ffpack_setParams(FFPack_t* ff, int streamIndex, void* param)
 #endif
 }
 
+/* a key frame starts a new fragment, so the previous one is complete once the
+ * key frame gets to the muxer: drain the interleaving queue so it does, push
+ * the AVIO buffer out and get it on the card. av_write_frame(NULL) isn't used,
+ * on mp4 it would cut a fragment right after the key frame.
+ * fdatasync blocks the writer for as long as the card takes, so it is done
+ * once per syncIntervalMs at most, the key frames in between are left to
+ * the page cache */
+static int ffpack_syncKey(FFPack_t* ff, int streamIndex)
+{
+	AVIOContext* pb = ff->ofmtContext->pb;
+	uint32_t tick;
+	int nRet;
+
+	// every audio frame is a key frame, fragments are cut on video ones
+	if(ff->ofmtContext->streams[streamIndex]->codecpar->codec_type != AVMEDIA_TYPE_VIDEO)
+	{
+		return 0;
+	}
+
+	tick = ffpack_tick();
+	if((uint32_t)(tick - ff->tickSync) < ff->syncIntervalMs)
+	{
+		return 0;
+	}
+	ff->tickSync = tick;
+
+	nRet = av_interleaved_write_frame(ff->ofmtContext, NULL);
+	if(nRet < 0)
+	{
+		ff_printerr("ffpack_syncKey: interleave flush ", nRet);
+		return nRet;
+	}
+
+	avio_flush(pb);
+	if(pb->error < 0)
+	{
+		ff_printerr("ffpack_syncKey: avio flush ", pb->error);
+		return pb->error;
+	}
+
+	if(fdatasync(ff->fd) < 0)
+	{
+		nRet = AVERROR(errno);
+		ff_printerr("ffpack_syncKey: fdatasync ", nRet);
+		return nRet;
+	}
+
+	return 0;
+}
+
 int ffpack_input(FFPack_t* ff, int streamIndex, uint8_t* frameData, int frameLen, bool keyFrame, uint64_t pts)
 {
 	int nRet = 0;
@@ -434,10 +575,111 @@ int ffpack_input(FFPack_t* ff, int streamIndex, uint8_t* frameData, int frameLen
     {
         ff_printerr("ffpack_Input: ", nRet);
     }
+	else if(keyFrame && ff->bSyncOnKey)
+	{
+		nRet = ffpack_syncKey(ff, streamIndex);
+	}
 
 	return nRet;
 }
 
+/* scatter/gather input: a contiguous frame goes through ffpack_input as is,
+ * a wrapped one is gathered straight into a refcounted packet the muxer takes over */
+int ffpack_inputv(FFPack_t* ff, int streamIndex, const struct iovec* frameSegs, int nbSegs, bool keyFrame, uint64_t pts)
+{
+	int nRet = 0;
+	int frameLen = 0;
+	int i;
+
+	if(nbSegs == 1)
+	{
+		return ffpack_input(ff, streamIndex, frameSegs[0].iov_base, frameSegs[0].iov_len, keyFrame, pts);
+	}
+
+	for(i = 0; i < nbSegs; i++)
+	{
+		frameLen += frameSegs[i].iov_len;
+	}
+
+	AVPacket pkt;
+
+	av_init_packet(&pkt);
+	nRet = av_new_packet(&pkt, frameLen);
+	if(nRet != 0)
+	{
+		ff_printerr("ffpack_inputv: ", nRet);
+		return nRet;
+	}
+
+	uint8_t* p = pkt.data;
+	for(i = 0; i < nbSegs; i++)
+	{
+		memcpy(p, frameSegs[i].iov_base, frameSegs[i].iov_len);
+		p += frameSegs[i].iov_len;
+	}
+
+	pkt.stream_index = streamIndex;
+	pkt.pts = pkt.dts = pts;
+	pkt.flags |= keyFrame ? AV_PKT_FLAG_KEY : 0;
+
+	AVStream* st = ff->ofmtContext->streams[streamIndex];
+	AVRational time_base = (AVRational){1, 100000};
+	av_packet_rescale_ts(&pkt, time_base, st->time_base);
+
+	// takes ownership of the packet reference, success or not
+	nRet = av_interleaved_write_frame(ff->ofmtContext, &pkt);
+
+	ff->nbTotalSize += frameLen;
+
+	if(nRet != 0)
+	{
+		ff_printerr("ffpack_inputv: ", nRet);
+	}
+	else if(keyFrame && ff->bSyncOnKey)
+	{
+		nRet = ffpack_syncKey(ff, streamIndex);
+	}
+
+	return nRet;
+}
+
+/* mp4 only: write self-contained fragments instead of one moov at the end,
+ * so a power cut loses what came after the last sync rather than the whole
+ * file. The sync waits for a key frame syncIntervalMs after the previous one */
+int ffpack_setFragmented(FFPack_t* ff, uint32_t fragDurationMs, uint32_t syncIntervalMs)
+{
+    if(strcmp(ff->ofmtContext->oformat->name, "mp4") != 0 && strcmp(ff->ofmtContext->oformat->name, "mov") != 0)
+    {
+        return -1;
+    }
+
+    av_dict_set(&ff->options, "movflags", "frag_keyframe+empty_moov+default_base_moof", 0);
+    av_dict_set_int(&ff->options, "frag_duration", (int64_t)fragDurationMs * 1000, 0);
+    ff->bSyncOnKey = (ff->fd >= 0);
+    ff->syncIntervalMs = syncIntervalMs;
+    ff->tickSync = ffpack_tick();
+
+    return 0;
+}
+
+/* reserve the clusters up front so the card writes sequentially, the file size
+ * is left alone and the unused tail is released on close */
+int ffpack_preallocate(FFPack_t* ff, uint64_t size)
+{
+    if(ff->fd < 0)
+    {
+        return -1;
+    }
+
+    if(fallocate(ff->fd, FALLOC_FL_KEEP_SIZE, 0, size) < 0)
+    {
+        LOGD("fallocate %llu: %s", size, strerror(errno));
+        return -errno;
+    }
+
+    return 0;
+}
+
 int ffpack_inputStream(FFPack_t* ff, int streamIndex, void* pstream, void* ppkt)
 {
     static int nbFrames = 0;
@@ -5,6 +5,7 @@ extern "C" {
 #endif
 
 #include <stdbool.h>
+#include <sys/uio.h>
 #include "ffmpeg.h"
 
 typedef enum AVMediaType FFMediaType_e;
@@ -52,6 +53,11 @@ typedef struct tagFFPack
     CB_onData   cbOnData;
     void*       cbContext;
     uint64_t    nbTotalSize;
+    int         fd;         //file output only, -1 otherwise
+    AVDictionary* options;  //muxer options, consumed by ffpack_start
+    bool        bSyncOnKey; //flush to the card on key frames
+    uint32_t    syncIntervalMs; //no closer together than this
+    uint32_t    tickSync;   //CLOCK_MONOTONIC ms of the last sync
 } FFPack_t;
 
 FFPack_t* ffpack_openFile(char* sName, void* context);
@@ -62,10 +68,13 @@ int  ffpack_newAudioStream(FFPack_t* ff, uint16_t programId, FFStreamParameters_
 int  ffpack_newDataStream (FFPack_t* ff, uint16_t programId, FFStreamParameters_t* param);
 int  ffpack_start(FFPack_t* ff);
 int  ffpack_input(FFPack_t* ff, int streamIndex, uint8_t* frameData, int frameLen, bool keyFrame, uint64_t pts);
+int  ffpack_inputv(FFPack_t* ff, int streamIndex, const struct iovec* frameSegs, int nbSegs, bool keyFrame, uint64_t pts);
 void ffpack_close(FFPack_t* ff);
 int  ffpack_inputStream(FFPack_t* ff, int streamIndex, void* stream, void* pkt);
 
 void ffpack_setParams(FFPack_t* ff, int streamIndex, void* param);
+int  ffpack_setFragmented(FFPack_t* ff, uint32_t fragDurationMs, uint32_t syncIntervalMs);
+int  ffpack_preallocate(FFPack_t* ff, uint64_t size);
 int  ffpack_setExtradata(FFPack_t* ff, int streamIndex, void* extradata, int extradataSize);
 
 #ifdef __cplusplus
@@ -14,6 +14,8 @@ extern "C" {
 #include <sys/types.h>
 #include <sys/ipc.h>
 #include <sys/msg.h>
+#include <pthread.h>
+#include <time.h>
 
 #include "gogglemsg.h"
 
@@ -23,6 +25,10 @@ extern "C" {
 
 #define CommandMSG_SIZE()	(sizeof(CommandMsg_t)-sizeof(long))
 #define DataMSG_SIZE(n)	    ((n)-sizeof(long))
+#define RequestMSG_SIZE()	(sizeof(RequestMsg_t)-sizeof(long))
+#define AckMSG_SIZE()	    (sizeof(AckMsg_t)-sizeof(long))
+
+#define ListenQUEUE_NUM	    16
 
 
 /* Codec gogglemsg */
@@ -37,6 +43,19 @@ extern "C" {
 
 int gGoggleMsg = -1;
 
+typedef struct
+{
+	pthread_t       threadId;
+	pthread_mutex_t mutex;
+	pthread_cond_t  cond;
+	long            mtype;
+	RequestMsg_t    queue[ListenQUEUE_NUM];
+	int             head;
+	int             count;
+} GoggleListen_t;
+
+GoggleListen_t gGoggleListen = { 0 };
+
 /**
 * @ingroup functions implementation
 * @defgroup functions implementation
@@ -66,8 +85,17 @@ int gogglemsg_init( int r, int id )
 
 int gogglemsg_uninit( void )
 {
+	//a removed queue wakes the listener up with EIDRM
 	msgctl( gGoggleMsg, IPC_RMID, NULL);
 
+	if( gGoggleListen.threadId != 0 )
+	{
+		pthread_join(gGoggleListen.threadId, NULL);
+		gGoggleListen.threadId = 0;
+		pthread_cond_destroy(&gGoggleListen.cond);
+		pthread_mutex_destroy(&gGoggleListen.mutex);
+	}
+
 	LOGE("msgid %d free!\n", gGoggleMsg);
 
 	return 0;
@@ -98,7 +126,8 @@ int gogglemsg_recv( GoggleMsgType_e mtype )
 {
 	CommandMsg_t msg = {0, 0};
 
-	if( msgrcv(gGoggleMsg, &msg, CommandMSG_SIZE(), mtype, IPC_NOWAIT) < 0 )
+	//typed requests are longer, only cmd is wanted here
+	if( msgrcv(gGoggleMsg, &msg, CommandMSG_SIZE(), mtype, IPC_NOWAIT|MSG_NOERROR) < 0 )
 	{
 		return MSG_none;
 	}
@@ -157,7 +186,7 @@ int gogglemsg_flush( GoggleMsgType_e mtype )
 {
 	CommandMsg_t msg = {0, 0};
 
-	while( msgrcv(gGoggleMsg, &msg, CommandMSG_SIZE(), mtype, IPC_NOWAIT) == 0 )
+	while( msgrcv(gGoggleMsg, &msg, CommandMSG_SIZE(), mtype, IPC_NOWAIT|MSG_NOERROR) >= 0 )
 	{
 		msg.cmd = 0;
 		msg.mtype = 0;
@@ -166,6 +195,123 @@ int gogglemsg_flush( GoggleMsgType_e mtype )
 	return 0;
 }
 
+static void* gogglemsg_listenProc( void* param )
+{
+	GoggleListen_t* gl = (GoggleListen_t*)param;
+	RequestMsg_t msg;
+	ssize_t len;
+
+	for(;;)
+	{
+		memset(&msg, 0, sizeof(msg));
+		len = msgrcv(gGoggleMsg, &msg, RequestMSG_SIZE(), gl->mtype, MSG_NOERROR);
+		if( len < 0 )
+		{
+			if( errno == EINTR ) {
+				continue;
+			}
+			break;
+		}
+
+		//plain commands from gogglecmd
+		if( len < (ssize_t)RequestMSG_SIZE() ) {
+			msg.reqId = 0;
+		}
+
+		pthread_mutex_lock(&gl->mutex);
+		if( gl->count == ListenQUEUE_NUM )
+		{
+			LOGE("command %ld dropped, queue full\n", gl->queue[gl->head].cmd);
+			gl->head = (gl->head + 1) % ListenQUEUE_NUM;
+			gl->count--;
+		}
+		gl->queue[(gl->head + gl->count) % ListenQUEUE_NUM] = msg;
+		gl->count++;
+		pthread_cond_signal(&gl->cond);
+		pthread_mutex_unlock(&gl->mutex);
+	}
+
+	return (void*)0;
+}
+
+int gogglemsg_listen( GoggleMsgType_e mtype )
+{
+	GoggleListen_t* gl = &gGoggleListen;
+	pthread_condattr_t attr;
+
+	if( gl->threadId != 0 ) {
+		return 0;
+	}
+
+	pthread_mutex_init(&gl->mutex, NULL);
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&gl->cond, &attr);
+	pthread_condattr_destroy(&attr);
+	gl->mtype = mtype;
+	gl->head = 0;
+	gl->count = 0;
+
+	if( pthread_create(&gl->threadId, NULL, gogglemsg_listenProc, gl) != 0 )
+	{
+		LOGE("create listen thread failed\n");
+		gl->threadId = 0;
+		return -1;
+	}
+
+	return 0;
+}
+
+/* returns as soon as anything is queued, with all of it, or after timeoutMs with none */
+int gogglemsg_wait( RequestMsg_t* msgs, int nbMsgs, int timeoutMs )
+{
+	GoggleListen_t* gl = &gGoggleListen;
+	struct timespec ts;
+	int n = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	ts.tv_sec += timeoutMs / 1000;
+	ts.tv_nsec += (timeoutMs % 1000) * 1000000;
+	if( ts.tv_nsec >= 1000000000 )
+	{
+		ts.tv_sec++;
+		ts.tv_nsec -= 1000000000;
+	}
+
+	pthread_mutex_lock(&gl->mutex);
+	while( gl->count == 0 )
+	{
+		if( pthread_cond_timedwait(&gl->cond, &gl->mutex, &ts) == ETIMEDOUT ) {
+			break;
+		}
+	}
+	while( (gl->count > 0) && (n < nbMsgs) )
+	{
+		msgs[n++] = gl->queue[gl->head];
+		gl->head = (gl->head + 1) % ListenQUEUE_NUM;
+		gl->count--;
+	}
+	pthread_mutex_unlock(&gl->mutex);
+
+	return n;
+}
+
+int gogglemsg_ack( const RequestMsg_t* msg, int result )
+{
+	AckMsg_t ack;
+
+	if( msg->reqId == 0 ) {
+		return 0;
+	}
+
+	ack.mtype = msg->replyType;
+	ack.cmd = msg->cmd;
+	ack.reqId = msg->reqId;
+	ack.result = result;
+
+	return msgsnd( gGoggleMsg, &ack, AckMSG_SIZE(), IPC_NOWAIT );
+}
+
 #if defined (__cplusplus)
 }
 #endif
@@ -236,6 +236,7 @@ ERRORTYPE jpegenc_destroy(JpegEnc_t* jenc)
 ERRORTYPE jpegenc_encode(JpegEnc_t* jenc, VIDEO_FRAME_INFO_S *frameInfo, VENC_EXIFINFO_S *exifInfo, int32_t s32MillSec)
 {
     jenc->mCurFrameId = frameInfo->mId;
+    jenc->mSemFrameBack = false;
 
     if( exifInfo != NULL ) {
         AW_MPI_VENC_SetJpegExifInfo(jenc->mChn, exifInfo);
@@ -473,6 +474,49 @@ JPEG_INIT_ERR:
     return 0;
 }
 
+static int jpegenc_writeFile(JpegEnc_t* jenc, PictureBuffer_t* buf, const char* sFile, bool bThumb)
+{
+    int fd = -1;
+    int ret = FAILURE;
+
+    LOGD("write file: %s", sFile);
+
+    fd = open(sFile, O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if(fd < 0) {
+        LOGE("open %s failed(%s)", sFile, strerror(errno));
+        return FAILURE;
+    }
+
+    if( bThumb ) {
+        if( buf->mThumbLen > 0 ) {
+            ret = write(fd, jenc->mJpegThumbBuf.ThumbAddrVir, buf->mThumbLen);
+        }
+    }
+    else {
+        if(buf->mLen0 > 0) {
+            ret = write(fd, buf->mpData0, buf->mLen0);
+            if (ret < 0) {
+                LOGE("write data failed(%s)", strerror(errno));
+            }
+        }
+        if(buf->mLen1 > 0) {
+            ret = write(fd, buf->mpData1, buf->mLen1);
+            if (ret < 0) {
+                LOGE("write data failed(%s)", strerror(errno));
+            }
+        }
+        if(buf->mLen2 > 0) {
+            ret = write(fd, buf->mpData2, buf->mLen2);
+            if (ret < 0) {
+                LOGE("write data failed(%s)", strerror(errno));
+            }
+        }
+    }
+    close(fd);
+
+    return (ret > 0) ? SUCCESS : FAILURE;
+}
+
 static ERRORTYPE jpegenc_createViChn(VI_DEV ViDev, void *pAttr)
 {
     ERRORTYPE ret;
@@ -630,51 +674,16 @@ static void* jpegenc_frameProc(void *arg)
     buf.mThumbLen = thumbLen;
     buf.mDataSize = buf.mLen0+buf.mLen1+buf.mLen2;
 
-    jpegenc_returnFrame(jenc, &jenc->mOutStream);
-
     if( jenc->io.cbOnFrame != NULL ) {
         jenc->io.cbOnFrame( &buf, jenc->io.ctxOnFrame );
     }
 
     if( jenc->io.sFile != NULL ) {
-        int fd = -1;
-
-        LOGD("write file: %s", jenc->io.sFile);
-
-        fd = open(jenc->io.sFile, O_RDWR | O_CREAT, 0666);
-        if(fd >= 0) {
-            if( jenc->io.bThumb ) {
-                if( buf.mThumbLen > 0 ) {
-                    ret = write(fd, jenc->mJpegThumbBuf.ThumbAddrVir, buf.mThumbLen);
-                }
-            }
-            else {
-                if(buf.mLen0 > 0) {
-                    ret = write(fd, buf.mpData0, buf.mLen0);
-                    if (ret < 0) {
-                        LOGE("write data failed(%s)", strerror(errno));
-                    }
-                }
-                if(buf.mLen1 > 0) {
-                    ret = write(fd, buf.mpData1, buf.mLen1);
-                    if (ret < 0) {
-                        LOGE("write data failed(%s)", strerror(errno));
-                    }
-                }
-                if(buf.mLen2 > 0) {
-                    ret = write(fd, buf.mpData2, buf.mLen2);
-                    if (ret < 0) {
-                        LOGE("write data failed(%s)", strerror(errno));
-                    }
-                }
-                if( ret > 0 ) {
-                    ret = SUCCESS;
-                }
-            }
-            close(fd);
-        }
+        ret = jpegenc_writeFile(jenc, &buf, jenc->io.sFile, jenc->io.bThumb);
     }
 
+    jpegenc_returnFrame(jenc, &jenc->mOutStream);
+
 failed:
     AW_MPI_VI_ReleaseFrame(vipp_dev, virvi_chn, &srcFrame);
     jpegenc_stopVirvi(vipp_dev, virvi_chn);
@@ -707,3 +716,225 @@ int jpegenc_takePicture(JpegEncIO_t* io, JpegEncConfig_t* config, int32_t s32Mil
 
     return pthread_create(&jenc->threadId, NULL, jpegenc_frameProc, jenc);
 }
+
+//----------------------------------------------------------------------------------------------
+// snapshot service: the VI tap and the JPEG channel stay open while recording, requests are
+// served by a thread from the next frame, so neither setup nor the file write hit the caller.
+// The thread hands every other frame straight back, the tap never holds on to VIPP buffers
+// the record encoder is waiting for.
+//----------------------------------------------------------------------------------------------
+#define JpegSNAP_queueNUM   4
+#define JpegSNAP_idleMS     100     //frame wait while idle, also how soon close is noticed
+
+typedef struct
+{
+    char sFile[JpegSNAP_fileLEN];
+    bool bThumb;
+} JpegSnapRequest_t;
+
+struct JpegSnap
+{
+    JpegEnc_t       jenc;
+    JpegEncConfig_t config;
+    VI_DEV          viDev;
+    VI_CHN          viChn;
+    int32_t         s32Timeout;
+
+    pthread_t       threadId;
+    pthread_mutex_t mutex;
+    bool            bExit;
+    JpegSnapRequest_t queue[JpegSNAP_queueNUM];
+    int             head;
+    int             count;
+};
+
+/* encodes srcFrame, taken after the request was queued, and releases it */
+static int jpegsnap_shoot(JpegSnap_t* snap, JpegSnapRequest_t* req, VIDEO_FRAME_INFO_S* srcFrame)
+{
+    JpegEnc_t* jenc = &snap->jenc;
+    off_t  thumbOffset = 0;
+    size_t thumbLen = 0;
+    int ret;
+
+    // created on the first frame, its format is only known then
+    if( jenc->mChn == MM_INVALID_CHN ) {
+        ret = jpegenc_initialize(jenc, srcFrame, &snap->config);
+        if( ret != SUCCESS ) {
+            LOGE("start venc failed: %x", ret);
+            jpegenc_destroy(jenc);
+            goto release;
+        }
+    }
+
+    VENC_EXIFINFO_S exifInfo;
+    VENC_EXIFINFO_S *pExifInfo = NULL;
+    memset(&exifInfo, 0, sizeof(exifInfo));
+    if( req->bThumb ) {
+        exifInfo.thumb_quality = snap->config.thunbnailQuality;
+        exifInfo.ThumbWidth = snap->config.thumbnailWidth;
+        exifInfo.ThumbHeight = snap->config.thumbnailHeight;
+        pExifInfo = &exifInfo;
+    }
+
+    ret = jpegenc_encode(jenc, srcFrame, pExifInfo, snap->s32Timeout);
+    if( ret != SUCCESS ) {
+        LOGE("encode failed: %x", ret);
+        goto release;
+    }
+
+    ret = jpegenc_getFrame(jenc, snap->s32Timeout);
+    if( ret != SUCCESS ) {
+        LOGE("get encoded frame failed: %x", ret);
+        goto release;
+    }
+
+    jpegenc_getThumbOffset(jenc, &thumbOffset, &thumbLen);
+
+    PictureBuffer_t buf;
+    buf.mpData0 = jenc->mOutStream.mpPack[0].mpAddr0;
+    buf.mpData1 = jenc->mOutStream.mpPack[0].mpAddr1;
+    buf.mpData2 = jenc->mOutStream.mpPack[0].mpAddr2;
+    buf.mLen0 = jenc->mOutStream.mpPack[0].mLen0;
+    buf.mLen1 = jenc->mOutStream.mpPack[0].mLen1;
+    buf.mLen2 = jenc->mOutStream.mpPack[0].mLen2;
+    buf.mThumbOffset = thumbOffset;
+    buf.mThumbLen = thumbLen;
+    buf.mDataSize = buf.mLen0+buf.mLen1+buf.mLen2;
+
+    ret = jpegenc_writeFile(jenc, &buf, req->sFile, req->bThumb);
+
+    jpegenc_returnFrame(jenc, &jenc->mOutStream);
+
+release:
+    AW_MPI_VI_ReleaseFrame(snap->viDev, snap->viChn, srcFrame);
+    return ret;
+}
+
+static void* jpegsnap_proc(void* arg)
+{
+    JpegSnap_t* snap = (JpegSnap_t*)arg;
+    VIDEO_FRAME_INFO_S srcFrame;
+    JpegSnapRequest_t req;
+    int32_t waitedMs = 0;
+
+    for(;;)
+    {
+        // looked at before the wait, so the frame a request gets is a newer one
+        pthread_mutex_lock(&snap->mutex);
+        bool bWant = (snap->count > 0);
+        bool bExit = snap->bExit && !bWant;
+        pthread_mutex_unlock(&snap->mutex);
+        if( bExit ) {
+            break;
+        }
+
+        memset(&srcFrame, 0, sizeof(srcFrame));
+        bool bGot = (AW_MPI_VI_GetFrame(snap->viDev, snap->viChn, &srcFrame, JpegSNAP_idleMS) == SUCCESS);
+        if( !bWant ) {
+            if( bGot ) {
+                AW_MPI_VI_ReleaseFrame(snap->viDev, snap->viChn, &srcFrame);
+            }
+            continue;
+        }
+        if( !bGot && (waitedMs += JpegSNAP_idleMS) < snap->s32Timeout ) {
+            continue;
+        }
+        waitedMs = 0;
+
+        pthread_mutex_lock(&snap->mutex);
+        req = snap->queue[snap->head];
+        snap->head = (snap->head + 1) % JpegSNAP_queueNUM;
+        snap->count--;
+        pthread_mutex_unlock(&snap->mutex);
+
+        if( !bGot ) {
+            LOGE("snapshot %s: no frame from dev[%d] chn[%d]", req.sFile, snap->viDev, snap->viChn);
+            continue;
+        }
+        int ret = jpegsnap_shoot(snap, &req, &srcFrame);
+        LOGD("snapshot %s: %x", req.sFile, ret);
+    }
+
+    return NULL;
+}
+
+JpegSnap_t* jpegsnap_open(VI_DEV viDev, JpegEncConfig_t* config, int32_t s32Millisec)
+{
+    JpegSnap_t* snap = (JpegSnap_t*)malloc(sizeof(JpegSnap_t));
+    if( snap == NULL ) {
+        LOGE("out of memory");
+        return NULL;
+    }
+    memset(snap, 0, sizeof(JpegSnap_t));
+    jpegenc_init(&snap->jenc);
+
+    snap->config = *config;
+    snap->viDev = viDev;
+    snap->s32Timeout = s32Millisec;
+
+    snap->viChn = jpegenc_createViChn(viDev, NULL);
+    if( snap->viChn < 0 ) {
+        goto failed;
+    }
+    if( jpegenc_startVirvi(viDev, snap->viChn, NULL) != SUCCESS ) {
+        LOGE("start vi dev[%d] chn[%d] failed", viDev, snap->viChn);
+        AW_MPI_VI_DestoryVirChn(viDev, snap->viChn);
+        goto failed;
+    }
+
+    pthread_mutex_init(&snap->mutex, NULL);
+    if( pthread_create(&snap->threadId, NULL, jpegsnap_proc, snap) != 0 ) {
+        LOGE("create snapshot thread failed");
+        pthread_mutex_destroy(&snap->mutex);
+        jpegenc_stopVirvi(viDev, snap->viChn);
+        goto failed;
+    }
+
+    LOGD("snapshot service on dev[%d] chn[%d]", viDev, snap->viChn);
+    return snap;
+
+failed:
+    jpegenc_deinit(&snap->jenc);
+    free(snap);
+    return NULL;
+}
+
+/* pending requests are still served, the thread leaves once they are done */
+void jpegsnap_close(JpegSnap_t* snap)
+{
+    if( snap == NULL ) {
+        return;
+    }
+
+    pthread_mutex_lock(&snap->mutex);
+    snap->bExit = true;
+    pthread_mutex_unlock(&snap->mutex);
+    pthread_join(snap->threadId, NULL);
+
+    jpegenc_destroy(&snap->jenc);
+    jpegenc_stopVirvi(snap->viDev, snap->viChn);
+    pthread_mutex_destroy(&snap->mutex);
+    jpegenc_deinit(&snap->jenc);
+    free(snap);
+}
+
+int jpegsnap_request(JpegSnap_t* snap, const char* sFile, bool bThumb)
+{
+    int ret = 0;
+
+    pthread_mutex_lock(&snap->mutex);
+    if( snap->count == JpegSNAP_queueNUM ) {
+        LOGE("snapshot %s dropped, busy", sFile);
+        ret = -1;
+    }
+    else {
+        JpegSnapRequest_t* req = &snap->queue[(snap->head + snap->count) % JpegSNAP_queueNUM];
+
+        snprintf(req->sFile, sizeof(req->sFile), "%s", sFile);
+        req->bThumb = bThumb;
+        snap->count++;
+    }
+    pthread_mutex_unlock(&snap->mutex);
+
+    return ret;
+}
@@ -7,6 +7,7 @@ extern "C" {
 #include <mpi_venc.h>
 
 #define PictureThumbQuality_DEFAULT 60
+#define JpegSNAP_fileLEN            256
 
 typedef struct JpegEncConfig
 {
@@ -47,6 +48,13 @@ typedef struct JpegEncIO
 int jpegenc_encodeFrame(VIDEO_FRAME_INFO_S* frame, JpegEncConfig_t* config, CB_onJpegFrame cbOnFrame, void* context);
 int jpegenc_takePicture(JpegEncIO_t* io, JpegEncConfig_t* config, int32_t s32Millisec);
 
+/* long lived snapshot service, see jpegenc.c */
+typedef struct JpegSnap JpegSnap_t;
+
+JpegSnap_t* jpegsnap_open(VI_DEV viDev, JpegEncConfig_t* config, int32_t s32Millisec);
+void jpegsnap_close(JpegSnap_t* snap);
+int  jpegsnap_request(JpegSnap_t* snap, const char* sFile, bool bThumb);
+
 #ifdef __cplusplus
 }
 #endif
@@ -7,10 +7,14 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/shm.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "avshare.h"
 #include "confparser.h"
 #include "disk.h"
+#include "dvr_index.h"
 #include "ffpack.h"
 #include "gogglemsg.h"
 #include "jpegenc.h"
@@ -34,6 +38,14 @@ uint32_t get_tickCount(void) {
     return (ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
 }
 
+uint64_t get_tickUs(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
+
 /******************************************************************************
  * funciton : signal handler
  ******************************************************************************/
@@ -160,22 +172,107 @@ void record_dumpAiParams(AiParams_t *params) {
     LOGD("sample bits : %d", params->bitsPerSample);
 }
 
+static void record_getStats(RecordContext_t *recCtx, RecordStats_t *stats) {
+    RecordWriter_t *wr = &recCtx->writer;
+
+    pthread_mutex_lock(&recCtx->mutex);
+    *stats = recCtx->stats;
+    pthread_mutex_unlock(&recCtx->mutex);
+
+    // the video backlog is what the writer holds of the encoder's stream buffer
+    if (recCtx->vv != NULL) {
+        stats->ringHighWater = atomic_load(&recCtx->vv->heldHighWater) / 1024;
+    }
+    stats->nbDropsVideo = atomic_load(&wr->ringVideo.nbDrops);
+    stats->nbDropsAudio = atomic_load(&wr->ringAudio.nbDrops);
+}
+
+static int record_statusOpen(RecordContext_t *recCtx) {
+    int id = shmget(RECSTAT_memKEY, sizeof(RecordStatusShm_t), IPC_CREAT | 0644);
+    if (id < 0) {
+        LOGE("status shmget failed: %s", strerror(errno));
+        return -1;
+    }
+
+    RecordStatusShm_t *shm = (RecordStatusShm_t *)shmat(id, NULL, 0);
+    if (shm == (void *)-1) {
+        LOGE("status shmat failed: %s", strerror(errno));
+        return -1;
+    }
+
+    // seq and changes carry on from the last instance, the UI may be holding
+    // on to them; an odd seq left by a crash is only made even by writeEnd,
+    // once the block is set up
+    recstat_writeBegin(shm);
+    memset(&shm->data, 0, sizeof(shm->data));
+    shm->data.status = REC_statusIdle;
+    shm->magic = RECSTAT_MAGIC;
+    shm->version = RECSTAT_VERSION;
+    recstat_writeEnd(shm, true);
+
+    recCtx->statusShm = shm;
+
+    return 0;
+}
+
+static void record_statusClose(RecordContext_t *recCtx) {
+    if (recCtx->statusShm != NULL) {
+        shmdt(recCtx->statusShm);
+        recCtx->statusShm = NULL;
+    }
+}
+
+// the UI reads the status block lock free, record.dat only mirrors status changes for scripts
 void record_saveStatus(RecordContext_t *recCtx, RecordStatus_e recStatus) {
+    RecordWriter_t *wr = &recCtx->writer;
+    RecordStatusShm_t *shm = recCtx->statusShm;
+    RecordStats_t stats;
+    bool bChanged = false;
     int fd;
     char buf[16];
 
-    if (recStatus == REC_statusSave) {
-        if (recCtx->status == recCtx->statusSaved) {
-            return;
+    if (recStatus != REC_statusSave) {
+        recCtx->status = recStatus;
+    }
+
+    if (shm != NULL) {
+        RecordStatusData_t *data = &shm->data;
+
+        record_getStats(recCtx, &stats);
+
+        recstat_writeBegin(shm);
+        if (data->status != recCtx->status) {
+            data->status = recCtx->status;
+            bChanged = true;
+        }
+        if (strncmp(data->sFile, recCtx->sFileNow, sizeof(data->sFile)) != 0) {
+            snprintf(data->sFile, sizeof(data->sFile), "%s", recCtx->sFileNow);
+            bChanged = true;
+        }
+        data->fps = recCtx->fpsStatus.fps;
+        data->bytesWritten = atomic_load(&wr->nbBytes);
+        data->nbDropsVideo = stats.nbDropsVideo;
+        data->nbDropsAudio = stats.nbDropsAudio;
+        if (recCtx->vv != NULL) {
+            data->ringDepth = atomic_load(&recCtx->vv->heldBytes) / 1024;
+            data->ringSize = recCtx->vv->heldBytesMax / 1024;
         }
-    } else if (recStatus == recCtx->status) {
+        data->ringHighWater = stats.ringHighWater;
+        data->nbRollovers = stats.nbRollovers;
+        data->closeUs = stats.closeUs;
+        data->closeMaxUs = stats.closeMaxUs;
+        data->diskFreeMB = recCtx->sdstat.availMB;
+        recstat_writeEnd(shm, bChanged);
+    }
+
+    if (recCtx->status == recCtx->statusSaved) {
         return;
     }
-    recCtx->status = recStatus;
 
     fd = open(REC_dataFILE, O_RDWR | O_CREAT, LOCKMODE);
     if (fd < 0) {
         LOGE("can't open %s: %s", REC_dataFILE, strerror(errno));
+        return;
     }
     if (lockfile(fd) < 0) {
         if (errno == EACCES || errno == EAGAIN) {
@@ -193,15 +290,47 @@ void record_saveStatus(RecordContext_t *recCtx, RecordStatus_e recStatus) {
     recCtx->statusSaved = recCtx->status;
 }
 
+static void record_snapConfig(JpegEncConfig_t *jencCfg) {
+    memset(jencCfg, 0, sizeof(JpegEncConfig_t));
+    jencCfg->width = VI_WIDTH;
+    jencCfg->height = VI_HEIGHT;
+    jencCfg->quality = 60;
+    jencCfg->thumbnailWidth = VE_thumbWIDTH;
+    jencCfg->thumbnailHeight = VE_thumbHEIGHT;
+    jencCfg->thunbnailQuality = VE_thumbQUALITY;
+}
+
+// keeps a VI tap and the JPEG channel open for the thumbnails of all segments
+static void record_snapOpen(RecordContext_t *recCtx) {
+    JpegEncConfig_t jencCfg;
+
+    record_snapConfig(&jencCfg);
+    recCtx->snap = jpegsnap_open(recCtx->vv->viDev, &jencCfg, 500);
+    if (recCtx->snap == NULL) {
+        LOGE("snapshot service failed, one shot pictures");
+    }
+}
+
+static void record_snapClose(RecordContext_t *recCtx) {
+    jpegsnap_close(recCtx->snap);
+    recCtx->snap = NULL;
+}
+
 int record_takePicture(RecordContext_t *recCtx, char *sFile) {
     int ret = SUCCESS;
 
     LOGD("start");
 
+    if (recCtx->snap != NULL) {
+        ret = jpegsnap_request(recCtx->snap, sFile, true);
+        LOGD("queued: %x", ret);
+        return ret;
+    }
+
     JpegEncConfig_t jencCfg;
     JpegEncIO_t jencIO;
 
-    memset(&jencCfg, 0, sizeof(jencCfg));
+    record_snapConfig(&jencCfg);
     memset(&jencIO, 0, sizeof(jencIO));
 
     jencIO.cbOnFrame = NULL;
@@ -211,16 +340,10 @@ int record_takePicture(RecordContext_t *recCtx, char *sFile) {
     jencIO.sFile = sFile;
     jencIO.bThumb = true;
 
-    jencCfg.width = VI_WIDTH;
-    jencCfg.height = VI_HEIGHT;
-    jencCfg.quality = 60;
-    jencCfg.thumbnailWidth = VE_thumbWIDTH;
-    jencCfg.thumbnailHeight = VE_thumbHEIGHT;
-    jencCfg.thunbnailQuality = VE_thumbQUALITY;
-
     ret = jpegenc_takePicture(&jencIO, &jencCfg, 500);
 
     LOGD("done: %x", ret);
+
     return ret;
 }
 
@@ -242,30 +365,546 @@ inline static bool record_isGoing(Vi2Venc_t *vv) {
     return (vv->threadId > 0);
 }
 
+inline static bool aenc_isGoing(Ai2Aenc_t *aa) {
+    return (aa->threadId > 0);
+}
+
 inline static bool record_isArecording(RecordContext_t *recCtx) {
     return record_isGoing(recCtx->vv) && recCtx->params.enableAudio;
 }
 
-void record_stop(RecordContext_t *recCtx) {
+/* a clip of that number in any container */
+static bool record_packExists(RecordContext_t *recCtx, int nbFileIndex) {
+    char *sTypes[] = REC_packTYPES;
+    char sFile[MAX_pathLEN];
+
+    for (int i = 0; i < REC_packTypesNUM; i++) {
+        REC_filePathGet(sFile, sizeof(sFile), recCtx->params.packPath, REC_packPREFIX, nbFileIndex, sTypes[i]);
+        if (access(sFile, F_OK) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* names the next segment and takes its number, numbers already on the card
+ * are skipped */
+static void record_makeFile(RecordContext_t *recCtx, RecordFile_t *file) {
+    switch (recCtx->params.fileNaming) {
+    case NAMING_CONTIGUOUS:
+        while (record_packExists(recCtx, recCtx->nbFileIndex)) {
+            LOGW("%s%04d exists, skipped", REC_packPREFIX, recCtx->nbFileIndex);
+            recCtx->nbFileIndex++;
+        }
+        REC_filePathGet(file->sFile, sizeof(file->sFile), recCtx->params.packPath, REC_packPREFIX, recCtx->nbFileIndex, recCtx->params.packType);
+        REC_filePathGet(file->sSnap, sizeof(file->sSnap), recCtx->params.packPath, REC_packPREFIX, recCtx->nbFileIndex, REC_packSnapTYPE);
+        recCtx->nbFileIndex++;
+        break;
+    case NAMING_DATE: {
+        char dateString[16];
+        const time_t t = time(0);
+        const struct tm *date = localtime(&t);
+        snprintf(dateString, sizeof(dateString), "%04d%02d%02d-%02d%02d%02d", date->tm_year + 1900, date->tm_mon + 1, date->tm_mday, date->tm_hour, date->tm_min, date->tm_sec);
+        snprintf(file->sFile, sizeof(file->sFile), "%s%s.%s", recCtx->params.packPath, dateString, recCtx->params.packType);
+        snprintf(file->sSnap, sizeof(file->sSnap), "%s%s.%s", recCtx->params.packPath, dateString, REC_packSnapTYPE);
+        break;
+    }
+    }
+}
+
+/* create the file with the streams of the running encoders, header written */
+static FFPack_t *record_openPack(RecordContext_t *recCtx, char *sFile, int *videoIndex, int *audioIndex) {
+    VencSpspps_t veHeader = {NULL, 0};
+    VencParams_t *veParams = &recCtx->vv->veParams;
+    FFStreamParameters_t streamParam;
+    int streamIndex;
+
+    FFPack_t *ff = ffpack_openFile(sFile, NULL);
+    if (ff == NULL) {
+        return NULL;
+    }
+
+    if (recCtx->params.preallocate) {
+        // whichever limit hits first, plus some headroom for bitrate overshoot
+        uint64_t size = (uint64_t)veParams->bps / 8 * (recCtx->params.packDuration / 1000);
+        size += size / 8;
+        if (size == 0 || size > recCtx->params.packSize) {
+            size = recCtx->params.packSize;
+        }
+        ffpack_preallocate(ff, size);
+    }
+
+    if ((recCtx->params.fragDuration > 0) && (strcmp(recCtx->params.packType, REC_packMP4) == 0)) {
+        ffpack_setFragmented(ff, recCtx->params.fragDuration, recCtx->params.syncInterval);
+    }
+
+    if (vi2venc_getSpsPpsInfo(recCtx->vv, &veHeader, true) == SUCCESS) {
+        // LOGD("dump spspps");
+        // dump_bytes(veHeader.pBuffer, veHeader.nLength);
+    } else {
+        LOGE("get sps failed");
+    }
+
+    ZeroMemory(&streamParam, sizeof(streamParam));
+    streamParam.mediaType = AVMEDIA_TYPE_VIDEO;
+    streamParam.codecId = (PT_H265 == veParams->codecType) ? AV_CODEC_ID_HEVC : AV_CODEC_ID_H264;
+    streamParam.video.width = veParams->width;   // VE_WIDTH;
+    streamParam.video.height = veParams->height; // VE_HEIGHT;
+    streamParam.video.fps = veParams->fps;       // VE_FPS;
+    streamParam.spsData = veHeader.pBuffer;
+    streamParam.spsLen = veHeader.nLength;
+    streamIndex = ffpack_newVideoStream(ff, -1, &streamParam);
+    if (streamIndex < 0) {
+        LOGE("create video stream failed");
+        goto failed;
+    }
+    *videoIndex = streamIndex;
+
     if (recCtx->params.enableAudio) {
+        AencAttr_t *aeParams = &recCtx->aa->aeAttr;
+
+        ZeroMemory(&streamParam, sizeof(streamParam));
+        streamParam.mediaType = AVMEDIA_TYPE_AUDIO;
+        streamParam.codecId = (PT_AAC == aeParams->Type) ? AV_CODEC_ID_AAC : AV_CODEC_ID_MP3;
+        streamParam.audio.sample_rate = aeParams->sampleRate;
+        streamParam.audio.channels = aeParams->channels;
+        streamParam.audio.bits_per_sample = aeParams->bitsPerSample;
+        streamIndex = ffpack_newAudioStream(ff, -1, &streamParam);
+        if (streamIndex < 0) {
+            LOGE("create audio stream failed");
+            goto failed;
+        }
+        *audioIndex = streamIndex;
+    }
+
+    // Add metadata to the program context
+    // Note: ts container does not support date so this will only be visible when
+    //       recording to mp4 container format
+    {
+        const time_t t = time(0);
+        const struct tm *date = localtime(&t);
+        char localDateString[20];
+        char fileName[64];
+
+        snprintf(fileName, sizeof(fileName), "%s", strrchr(sFile, '/') + 1);
+        av_dict_set(&ff->ofmtContext->metadata, "title", fileName, 0);
+
+        snprintf(localDateString, sizeof(localDateString), "%04d-%02d-%02d %02d:%02d:%02d", date->tm_year + 1900, date->tm_mon + 1, date->tm_mday, date->tm_hour, date->tm_min, date->tm_sec);
+        av_dict_set(&ff->ofmtContext->metadata, "date", localDateString, 0);
+    }
+
+    if (ffpack_start(ff) != SUCCESS) {
+        goto failed;
+    }
+
+    return ff;
+
+failed:
+    ffpack_close(ff);
+    remove(sFile);
+    return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// writer
+//
+// vv_onFrame/aa_onFrame only queue the frame and return, so a slow card never
+// stalls the encoders. Video stays in the encoder's stream buffer, the ring
+// only carries where it is and the writer gives the stream back once muxed;
+// audio frames are small and copied. When the writer can't keep up frames are
+// dropped (up to the next IDR for video) and counted.
+//
+// Rollover is split in three steps: record_pack queues the next file ahead of
+// time, the writer opens it, then swaps it in on the next IDR and finalizes the
+// old one once the rings are drained.
+
+/* adds a segment to the index on the card, DVRIDX_flagPARTIAL as soon as it
+ * is opened and again once closed; its thumbnail and star marks share its
+ * name */
+static void record_indexClip(RecordContext_t *recCtx, const char *sFile, uint32_t durationMs, uint32_t flags) {
+    DvrIndexEntry_t entry;
+    char sTemp[MAX_pathLEN * 2 + 16];
+    const char *sName = strrchr(sFile, '/');
+    const char *sDot = strrchr(sFile, '.');
+    struct stat st;
+
+    ZeroMemory(&entry, sizeof(entry));
+    snprintf(entry.sName, sizeof(entry.sName), "%s", (sName != NULL) ? sName + 1 : sFile);
+    entry.durationMs = durationMs;
+    entry.flags = flags;
+    if (stat(sFile, &st) == 0) {
+        entry.size = st.st_size;
+    }
+
+    if (sDot != NULL) {
+        snprintf(sTemp, sizeof(sTemp), "%.*s." REC_packSnapTYPE, (int)(sDot - sFile), sFile);
+        if (stat(sTemp, &st) == 0) {
+            entry.thumbSize = st.st_size;
+        }
+    }
+
+    snprintf(sTemp, sizeof(sTemp), "%s" REC_starSUFFIX, sFile);
+    if (access(sTemp, F_OK) == 0) {
+        entry.flags |= DVRIDX_flagSTAR;
+    }
+
+    if (dvridx_add(recCtx->params.packPath, &entry) != 0) {
+        LOGE("index %s failed", entry.sName);
+    }
+}
+
+/* a segment opened ahead and removed unused */
+static void record_unindexClip(RecordContext_t *recCtx, const char *sFile) {
+    const char *sName = strrchr(sFile, '/');
+
+    dvridx_remove(recCtx->params.packPath, (sName != NULL) ? sName + 1 : sFile);
+}
+
+/* called on an IDR with recCtx->mutex held */
+static void record_swapPack(RecordContext_t *recCtx) {
+    RecordWriter_t *wr = &recCtx->writer;
+
+    pthread_mutex_lock(&wr->mutex);
+    wr->ffRetired = recCtx->ff;
+    snprintf(wr->fileRetired.sFile, sizeof(wr->fileRetired.sFile), "%s", recCtx->sFileNow);
+    wr->durationRetired = get_tickCount() - recCtx->tickBegin;
+    pthread_mutex_unlock(&wr->mutex);
+
+    recCtx->ff = recCtx->ffNext;
+    recCtx->ffNext = NULL;
+    recCtx->bPackDue = false;
+    snprintf(recCtx->sFileNow, sizeof(recCtx->sFileNow), "%s", wr->fileNext.sFile);
+    recCtx->bSnapPending = true;
+    recCtx->nbVideoStreamIndex = recCtx->nbVideoStreamIndexNext;
+    recCtx->nbAudioStreamIndex = recCtx->nbAudioStreamIndexNext;
+    recCtx->nbFramesTotal = 0;
+    recCtx->nbAudioFrames = 0;
+    recCtx->ptsBase = 0;
+    recCtx->ptsBaseAudio = 0;
+    recCtx->ptsBaseDeltaA = 0;
+    recCtx->ptsBaseDeltaV = 0;
+    recCtx->tickBegin = get_tickCount();
+    recCtx->stats.nbRollovers++;
+}
+
+static void record_writeVideo(RecordContext_t *recCtx, PktHead_t *pkt) {
+    int ret = 0;
+    uint64_t pts = pkt->pts;
+    uint64_t pts2 = 0; // nbFrames * 90000;
+    bool bKey = (pkt->flags & PKT_flagKEY);
+
+    if (bKey) {
+        pthread_mutex_lock(&recCtx->mutex);
+        if (recCtx->bPackDue && (recCtx->ffNext != NULL)) {
+            record_swapPack(recCtx);
+            LOGD("rollover %u", recCtx->stats.nbRollovers);
+        }
+        pthread_mutex_unlock(&recCtx->mutex);
+    }
+
+    FFPack_t *ff = (FFPack_t *)recCtx->ff;
+    int streamIndex = recCtx->nbVideoStreamIndex;
+
+    if (recCtx->nbFramesTotal == 0) {
+        LOGD("first frame (key=%d, len=%u, pts=%llu)", bKey, pkt->len, pts);
+
+        if (!bKey) {
+            vi2venc_requestIFrame(recCtx->vv);
+            return;
+        }
+        recCtx->ptsBase = pts;
+    }
+
+    if (recCtx->nbAudioFrames == 0) {
+        recCtx->ptsBaseDeltaA = pts - recCtx->ptsBase;
+    }
+
+    pts2 = (pts - recCtx->ptsBase + recCtx->ptsBaseDeltaV) / 10; // unit us to 10us
+    // LOGD("%llu, %llu", pts2, recCtx->ptsBase);
+
+    struct iovec frameSegs[PKT_refSEGMAX];
+    int nbSegs = pktring_segs(pkt, frameSegs);
+    ret = ffpack_inputv(ff, streamIndex, frameSegs, nbSegs, bKey, pts2);
+    if (ret == -5) {
+        /* I/O error, need to check disk immediately */
+        // record_checkDiskImmediately(recCtx);
+    }
+    recCtx->nbFramesTotal++;
+}
+
+static void record_writeAudio(RecordContext_t *recCtx, PktHead_t *pkt) {
+    int ret = 0;
+    uint64_t pts = pkt->pts;
+    uint64_t pts2 = 0; // nbFrames * 90000;
+
+    FFPack_t *ff = (FFPack_t *)recCtx->ff;
+    int streamIndex = recCtx->nbAudioStreamIndex;
+
+    if (recCtx->nbAudioFrames == 0) {
+        recCtx->ptsBaseAudio = pts;
+        LOGD("first frame (len=%u, pts=%llu)", pkt->len, pts);
+
+#if (0)
+        /* no need */
+        if (recCtx->aa->aeAttr.Type == PT_AAC) {
+            ffpack_setExtradata(ff, streamIndex, pktring_data(pkt), ADTS_HEADER__LEN);
+        }
+#endif
+    }
+
+    if (recCtx->nbFramesTotal == 0) {
+        recCtx->ptsBaseDeltaV = pts - recCtx->ptsBaseAudio;
+    }
+
+    pts2 = (pts - recCtx->ptsBaseAudio + recCtx->ptsBaseDeltaA) / 10; // unit us to 10us
+    // LOGD("len=%d, %llu, %llu", pkt->len, pts2, recCtx->ptsBaseAudio);
+
+    ret = ffpack_input(ff, streamIndex, pktring_data(pkt), pkt->len, true, pts2);
+    if (ret == -5) {
+        /* I/O error, need to check disk immediately */
+        // record_checkDiskImmediately(recCtx);
+    }
+
+    recCtx->nbAudioFrames++;
+}
+
+static void record_writerDrain(RecordContext_t *recCtx) {
+    RecordWriter_t *wr = &recCtx->writer;
+    PktHead_t *pktVideo;
+    PktHead_t *pktAudio;
+
+    for (;;) {
+        pktVideo = pktring_peek(&wr->ringVideo);
+        pktAudio = pktring_peek(&wr->ringAudio);
+
+        // oldest first, the muxer interleaves the rest
+        if (pktVideo != NULL && (pktAudio == NULL || pktVideo->pts <= pktAudio->pts)) {
+            record_writeVideo(recCtx, pktVideo);
+            atomic_fetch_add_explicit(&wr->nbBytes, pktVideo->len, memory_order_relaxed);
+            if (pktVideo->flags & PKT_flagREF) {
+                vi2venc_releaseFrame(recCtx->vv);
+            }
+            pktring_pop(&wr->ringVideo);
+        } else if (pktAudio != NULL) {
+            record_writeAudio(recCtx, pktAudio);
+            atomic_fetch_add_explicit(&wr->nbBytes, pktAudio->len, memory_order_relaxed);
+            pktring_pop(&wr->ringAudio);
+        } else {
+            break;
+        }
+    }
+}
+
+static inline bool record_writerIdle(RecordWriter_t *wr) {
+    return !wr->bBusy && !wr->bOpen && (wr->ffRetired == NULL) &&
+           pktring_empty(&wr->ringVideo) && pktring_empty(&wr->ringAudio);
+}
+
+static void *record_writerProc(void *arg) {
+    RecordContext_t *recCtx = (RecordContext_t *)arg;
+    RecordWriter_t *wr = &recCtx->writer;
+
+    for (;;) {
+        sem_wait(&wr->sem);
+
+        pthread_mutex_lock(&wr->mutex);
+        if (wr->bExit) {
+            pthread_mutex_unlock(&wr->mutex);
+            break;
+        }
+        wr->bBusy = true;
+        pthread_mutex_unlock(&wr->mutex);
+
+        record_writerDrain(recCtx);
+
+        pthread_mutex_lock(&wr->mutex);
+        FFPack_t *ffRetired = wr->ffRetired;
+        bool bOpen = wr->bOpen;
+        pthread_mutex_unlock(&wr->mutex);
+
+        if (ffRetired != NULL) {
+            uint64_t tick = get_tickUs();
+            ffpack_close(ffRetired);
+            uint32_t closeUs = get_tickUs() - tick;
+            LOGD("segment closed in %u us", closeUs);
+
+            // swapPack won't touch these before ffRetired is cleared below
+            record_indexClip(recCtx, wr->fileRetired.sFile, wr->durationRetired, 0);
+
+            pthread_mutex_lock(&recCtx->mutex);
+            recCtx->stats.closeUs = closeUs;
+            if (closeUs > recCtx->stats.closeMaxUs) {
+                recCtx->stats.closeMaxUs = closeUs;
+            }
+            pthread_mutex_unlock(&recCtx->mutex);
+        }
+
+        if (bOpen) {
+            int videoIndex = 0;
+            int audioIndex = 0;
+            FFPack_t *ff = record_openPack(recCtx, wr->fileNext.sFile, &videoIndex, &audioIndex);
+
+            if (ff == NULL) {
+                LOGE("create %s failed", wr->fileNext.sFile);
+            } else {
+                record_indexClip(recCtx, wr->fileNext.sFile, 0, DVRIDX_flagPARTIAL);
+
+                pthread_mutex_lock(&recCtx->mutex);
+                if (recCtx->stateGoing == REC_statRun) {
+                    recCtx->ffNext = ff;
+                    recCtx->nbVideoStreamIndexNext = videoIndex;
+                    recCtx->nbAudioStreamIndexNext = audioIndex;
+                    ff = NULL;
+                }
+                pthread_mutex_unlock(&recCtx->mutex);
+
+                if (ff != NULL) {
+                    // stopped meanwhile, drop the empty file
+                    ffpack_close(ff);
+                    remove(wr->fileNext.sFile);
+                    record_unindexClip(recCtx, wr->fileNext.sFile);
+                }
+            }
+        }
+
+        pthread_mutex_lock(&wr->mutex);
+        if (ffRetired != NULL) {
+            wr->ffRetired = NULL;
+        }
+        if (bOpen) {
+            wr->bOpen = false;
+        }
+        wr->bBusy = false;
+        pthread_cond_broadcast(&wr->cond);
+        pthread_mutex_unlock(&wr->mutex);
+    }
+
+    return NULL;
+}
+
+static int record_writerStart(RecordContext_t *recCtx) {
+    RecordWriter_t *wr = &recCtx->writer;
+
+    pthread_mutex_init(&wr->mutex, NULL);
+    pthread_cond_init(&wr->cond, NULL);
+    sem_init(&wr->sem, 0, 0);
+    wr->bExit = false;
+    wr->bBusy = false;
+    wr->bOpen = false;
+    wr->ffRetired = NULL;
+
+    if (pktring_init(&wr->ringVideo, REC_ringVideoSIZE, true) != 0 ||
+        pktring_init(&wr->ringAudio, REC_ringAudioSIZE, false) != 0) {
+        return -1;
+    }
+
+    return pthread_create(&wr->threadId, NULL, record_writerProc, recCtx);
+}
+
+static void record_writerStop(RecordContext_t *recCtx) {
+    RecordWriter_t *wr = &recCtx->writer;
+
+    if (wr->threadId != 0) {
+        pthread_mutex_lock(&wr->mutex);
+        wr->bExit = true;
+        pthread_mutex_unlock(&wr->mutex);
+        sem_post(&wr->sem);
+
+        pthread_join(wr->threadId, NULL);
+        wr->threadId = 0;
+    }
+
+    pktring_deinit(&wr->ringVideo);
+    pktring_deinit(&wr->ringAudio);
+    sem_destroy(&wr->sem);
+    pthread_cond_destroy(&wr->cond);
+    pthread_mutex_destroy(&wr->mutex);
+}
+
+/* wait until all queued jobs and packets are done */
+static void record_writerSync(RecordContext_t *recCtx) {
+    RecordWriter_t *wr = &recCtx->writer;
+
+    if (wr->threadId == 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&wr->mutex);
+    while (!record_writerIdle(wr)) {
+        pthread_cond_wait(&wr->cond, &wr->mutex);
+    }
+    pthread_mutex_unlock(&wr->mutex);
+}
+
+void record_stop(RecordContext_t *recCtx) {
+    // no more rollovers, let the writer finish its jobs before the encoders go,
+    // then the packets still queued
+    pthread_mutex_lock(&recCtx->mutex);
+    recCtx->stateGoing = REC_statStop;
+    recCtx->bPackDue = false;
+    pthread_mutex_unlock(&recCtx->mutex);
+    record_writerSync(recCtx);
+
+    // the audio encoder keeps running for live clients
+    if (recCtx->params.enableAudio && !recCtx->bLiveAudio) {
         bool aoplay = ai2ao_playing(recCtx->ao);
         ai2aenc_stop(recCtx->aa, !aoplay);
     }
 
+    // its VI tap has to go before the VI may be stopped
+    record_snapClose(recCtx);
+
+    // live_run() brings the live encoder back for the stream
+    atomic_store(&recCtx->bFanout, false);
     vi2venc_stop(recCtx->vv, !record_isGoing(recCtx->vvLive));
+    record_writerSync(recCtx);
 
     pthread_mutex_lock(&recCtx->mutex);
+    bool bClosed = (recCtx->ff != NULL);
     if (recCtx->ff != NULL) {
         ffpack_close(recCtx->ff);
         recCtx->ff = NULL;
     }
+    if (recCtx->ffNext != NULL) {
+        // opened ahead but never used
+        ffpack_close(recCtx->ffNext);
+        recCtx->ffNext = NULL;
+        remove(recCtx->writer.fileNext.sFile);
+        record_unindexClip(recCtx, recCtx->writer.fileNext.sFile);
+    }
     recCtx->stateGoing = REC_statStop;
     pthread_mutex_unlock(&recCtx->mutex);
 
+    // after the removal above, the index has to be newer than the directory
+    if (bClosed && recCtx->sFileNow[0] != 0) {
+        record_indexClip(recCtx, recCtx->sFileNow, get_tickCount() - recCtx->tickBegin, 0);
+    }
+
+    recCtx->sFileNow[0] = 0;
+    recCtx->fpsStatus.fps = 0;
     record_saveStatus(recCtx, record_stopStatus(recCtx));
     remove(NOW_RECORDING_FILE);
 }
 
+// one encoder can serve both when it makes the codec and picture size the
+// RTSP server announced. Frame rate doesn't matter, the RTP timestamps follow
+// the capture time; a watcher then gets the record rate and bitrate, the live
+// bitrate is what a separate encoder needs, not a limit of the stream.
+static bool live_canFanout(RecordContext_t *recCtx, VencParams_t *veParams) {
+    VencParams_t liveParams;
+
+    if (!recCtx->params.enableFanout) {
+        return false;
+    }
+
+    ZeroMemory(&liveParams, sizeof(liveParams));
+    conf_loadVencParamsForLive(recCtx->confFile, &liveParams);
+
+    return (liveParams.codecType == veParams->codecType) &&
+           (liveParams.width == veParams->width) &&
+           (liveParams.height == veParams->height);
+}
+
 int record_start(RecordContext_t *recCtx) {
     if (recCtx->ff != NULL) {
         LOGD("recording ...");
@@ -278,8 +917,7 @@ int record_start(RecordContext_t *recCtx) {
     }
 
     int ret;
-    VencSpspps_t veHeader = {NULL, 0};
-    int nbFileIndex = recCtx->nbFileIndex;
+    RecordFile_t file;
 
     ViParams_t viParams;
     VencParams_t veParams;
@@ -300,87 +938,44 @@ int record_start(RecordContext_t *recCtx) {
     }
 
     if (veParams.maxKeyItl == 0) {
-        veParams.maxKeyItl = veParams.fps;
-    }
-    veParams.picFormat = MM_PIXEL_FORMAT_YVU_SEMIPLANAR_420;
-
-    ret = vi2venc_prepare(recCtx->vv, &viParams, &veParams, NULL);
-    if (ret != 0) {
-        goto failed;
-    }
-
-    if (recCtx->params.enableAudio) {
-        ret = ai2aenc_prepare(recCtx->aa, &aiParams, &aeParams);
-        if (ret != 0) {
-            goto failed;
-        }
-    }
-
-    ret = vi2venc_getSpsPpsInfo(recCtx->vv, &veHeader, true);
-    if (ret == SUCCESS) {
-        // LOGD("dump spspps");
-        // dump_bytes(veHeader.pBuffer, veHeader.nLength);
-    } else {
-        LOGE("get sps failed: %x", ret);
-    }
-
-    char dateString[16];
-    char sFile[256];
-    switch (recCtx->params.fileNaming) {
-    case NAMING_CONTIGUOUS:
-        REC_filePathGet(sFile, sizeof(sFile), recCtx->params.packPath, REC_packPREFIX, nbFileIndex, recCtx->params.packType);
-        break;
-    case NAMING_DATE: {
-        const time_t t = time(0);
-        const struct tm *date = localtime(&t);
-        snprintf(dateString, sizeof(dateString), "%04d%02d%02d-%02d%02d%02d", date->tm_year + 1900, date->tm_mon + 1, date->tm_mday, date->tm_hour, date->tm_min, date->tm_sec);
-        snprintf(sFile, sizeof(sFile), "%s%s.%s", recCtx->params.packPath, dateString, recCtx->params.packType);
-        break;
-    }
-    }
-
-    FFPack_t *ff = ffpack_openFile(sFile, NULL);
-    if (ff == NULL) {
-        LOGE("open failed");
-        ret = -1;
-        record_saveStatus(recCtx, REC_statusFileError);
-        goto failed;
+        veParams.maxKeyItl = veParams.fps;
     }
-    recCtx->ff = ff;
+    veParams.picFormat = MM_PIXEL_FORMAT_YVU_SEMIPLANAR_420;
+    // also the writer's backlog, frames wait in it until they are muxed
+    veParams.veAttr.mBufSize = REC_vencBufSIZE;
 
-    FFStreamParameters_t streamParam;
-    ZeroMemory(&streamParam, sizeof(streamParam));
-    streamParam.mediaType = AVMEDIA_TYPE_VIDEO;
-    streamParam.codecId = (PT_H265 == veParams.codecType) ? AV_CODEC_ID_HEVC : AV_CODEC_ID_H264;
-    streamParam.video.width = veParams.width;   // VE_WIDTH;
-    streamParam.video.height = veParams.height; // VE_HEIGHT;
-    streamParam.video.fps = veParams.fps;       // VE_FPS;
-    streamParam.spsData = veHeader.pBuffer;
-    streamParam.spsLen = veHeader.nLength;
-    int streamIndex = ffpack_newVideoStream(ff, -1, &streamParam);
-    if (streamIndex < 0) {
-        LOGE("create video stream failed");
-        ret = -2;
+    ret = vi2venc_prepare(recCtx->vv, &viParams, &veParams, NULL);
+    if (ret != 0) {
         goto failed;
     }
-    recCtx->nbVideoStreamIndex = streamIndex;
+    recCtx->bFanoutOk = live_canFanout(recCtx, &veParams);
 
-    if (recCtx->params.enableAudio) {
-        ZeroMemory(&streamParam, sizeof(streamParam));
-        streamParam.mediaType = AVMEDIA_TYPE_AUDIO;
-        streamParam.codecId = (PT_AAC == aeParams.codecType) ? AV_CODEC_ID_AAC : AV_CODEC_ID_MP3;
-        streamParam.audio.sample_rate = aiParams.sampleRate;
-        streamParam.audio.channels = aiParams.channels;
-        streamParam.audio.bits_per_sample = aiParams.bitsPerSample;
-        streamIndex = ffpack_newAudioStream(ff, -1, &streamParam);
-        if (streamIndex < 0) {
-            LOGE("create audio stream failed");
-            ret = -3;
+    // already running when a live client listens
+    if (recCtx->params.enableAudio && !aenc_isGoing(recCtx->aa)) {
+        ret = ai2aenc_prepare(recCtx->aa, &aiParams, &aeParams);
+        if (ret != 0) {
             goto failed;
         }
-        recCtx->nbAudioStreamIndex = streamIndex;
     }
 
+    record_makeFile(recCtx, &file);
+    recCtx->ff = record_openPack(recCtx, file.sFile, &recCtx->nbVideoStreamIndex, &recCtx->nbAudioStreamIndex);
+    if (recCtx->ff == NULL) {
+        LOGE("open failed");
+        ret = -1;
+        record_saveStatus(recCtx, REC_statusFileError);
+        goto failed;
+    }
+    record_indexClip(recCtx, file.sFile, 0, DVRIDX_flagPARTIAL);
+    recCtx->ffNext = NULL;
+    recCtx->bPackDue = false;
+    recCtx->bSnapPending = false;
+    ZeroMemory(&recCtx->stats, sizeof(recCtx->stats));
+    atomic_store(&recCtx->writer.nbBytes, 0);
+    snprintf(recCtx->sFileNow, sizeof(recCtx->sFileNow), "%s", file.sFile);
+    pktring_reset(&recCtx->writer.ringVideo);
+    pktring_reset(&recCtx->writer.ringAudio);
+
     recCtx->tickBegin = get_tickCount();
     recCtx->nbFramesTotal = 0;
     recCtx->nbAudioFrames = 0;
@@ -391,33 +986,13 @@ int record_start(RecordContext_t *recCtx) {
     recCtx->fpsStatus.tickFps = recCtx->tickBegin;
     recCtx->fpsStatus.nbFrames = 0;
 
-    // Add metadata to the program context
-    // Note: ts container does not support date so this will only be visible when
-    //       recording to mp4 container format
-    {
-        const time_t t = time(0);
-        const struct tm *date = localtime(&t);
-        char localDateString[20];
-        char fileName[64];
-
-        strcpy(fileName, strrchr(sFile, '/') + 1);
-        av_dict_set(&ff->ofmtContext->metadata, "title", fileName, 0);
-
-        snprintf(localDateString, sizeof(localDateString), "%04d-%02d-%02d %02d:%02d:%02d", date->tm_year + 1900, date->tm_mon + 1, date->tm_mday, date->tm_hour, date->tm_min, date->tm_sec);
-        av_dict_set(&ff->ofmtContext->metadata, "date", localDateString, 0);
-    }
-
-    ret = ffpack_start(ff);
-    if (ret != SUCCESS) {
-        goto failed;
-    }
-
     ret = vi2venc_start(recCtx->vv, NULL);
     if (ret != SUCCESS) {
         goto failed;
     }
+    record_snapOpen(recCtx);
 
-    if (recCtx->params.enableAudio) {
+    if (recCtx->params.enableAudio && !aenc_isGoing(recCtx->aa)) {
         ret = ai2aenc_start(recCtx->aa);
         if (ret != SUCCESS) {
             goto failed;
@@ -426,23 +1001,14 @@ int record_start(RecordContext_t *recCtx) {
 
     recCtx->stateGoing = REC_statRun;
     record_saveStatus(recCtx, REC_statusRun);
-    recCtx->nbFileIndex++;
 
     FILE *recording_file = fopen(NOW_RECORDING_FILE, "w");
     if (recording_file) {
-        fprintf(recording_file, "%s", sFile);
+        fprintf(recording_file, "%s", file.sFile);
         fclose(recording_file);
     }
 
-    switch (recCtx->params.fileNaming) {
-    case NAMING_CONTIGUOUS:
-        REC_filePathGet(sFile, sizeof(sFile), recCtx->params.packPath, REC_packPREFIX, nbFileIndex, REC_packSnapTYPE);
-        break;
-    case NAMING_DATE:
-        snprintf(sFile, sizeof(sFile), "%s%s.%s", recCtx->params.packPath, dateString, REC_packSnapTYPE);
-        break;
-    }
-    ret = record_takePicture(recCtx, sFile);
+    ret = record_takePicture(recCtx, file.sSnap);
 
     record_dumpViParams(&viParams);
     record_dumpVeParams(&veParams);
@@ -463,6 +1029,7 @@ failed:
 bool record_pack(RecordContext_t *recCtx) {
     uint32_t tickNow = get_tickCount();
     uint32_t tickDuration = tickNow - recCtx->tickBegin;
+    RecordWriter_t *wr = &recCtx->writer;
 
     if (recCtx->stateGo != REC_statRun) {
         return false;
@@ -471,185 +1038,173 @@ bool record_pack(RecordContext_t *recCtx) {
         return false;
     }
 
-    bool bPack = (tickDuration >= recCtx->params.packDuration);
-    bPack |= (recCtx->ff->nbTotalSize >= recCtx->params.packSize);
-    if (!bPack) {
-        return false;
-    }
-
     pthread_mutex_lock(&recCtx->mutex);
-    ffpack_close(recCtx->ff);
-    recCtx->ff = NULL;
-    recCtx->nbFramesTotal = 0;
-    recCtx->nbAudioFrames = 0;
-    recCtx->ptsBase = 0;
-    recCtx->ptsBaseAudio = 0;
-    recCtx->ptsBaseDeltaA = 0;
-    recCtx->ptsBaseDeltaV = 0;
-    recCtx->fpsStatus.tickFps = get_tickCount();
-    recCtx->fpsStatus.nbFrames = 0;
+    uint64_t nbTotalSize = recCtx->ff->nbTotalSize;
+    bool bSnap = recCtx->bSnapPending;
+    recCtx->bSnapPending = false;
+    pthread_mutex_unlock(&recCtx->mutex);
 
-    VencSpspps_t veHeader = {NULL, 0};
-    int nbFileIndex = recCtx->nbFileIndex;
-    char dateString[16];
-    char sFile[256];
-    switch (recCtx->params.fileNaming) {
-    case NAMING_CONTIGUOUS:
-        REC_filePathGet(sFile, sizeof(sFile), recCtx->params.packPath, REC_packPREFIX, nbFileIndex, recCtx->params.packType);
-        break;
-    case NAMING_DATE: {
-        const time_t t = time(0);
-        const struct tm *date = localtime(&t);
-        snprintf(dateString, sizeof(dateString), "%04d%02d%02d-%02d%02d%02d", date->tm_year + 1900, date->tm_mon + 1, date->tm_mday, date->tm_hour, date->tm_min, date->tm_sec);
-        snprintf(sFile, sizeof(sFile), "%s%s.%s", recCtx->params.packPath, dateString, recCtx->params.packType);
-        break;
+    if (bSnap) {
+        // fileNext is the segment just swapped in
+        record_takePicture(recCtx, wr->fileNext.sSnap);
     }
+
+    bool bPack = (tickDuration >= recCtx->params.packDuration);
+    bPack |= (nbTotalSize >= recCtx->params.packSize);
+    bool bPreopen = (tickDuration + REC_packPreopenMS >= recCtx->params.packDuration);
+    bPreopen |= (nbTotalSize >= recCtx->params.packSize - recCtx->params.packSize / 16);
+    if (!bPack && !bPreopen) {
+        return false;
     }
 
-    FFPack_t *ff = ffpack_openFile(sFile, NULL);
-    if (ff == NULL) {
-        LOGE("open failed");
-        goto failed;
+    pthread_mutex_lock(&recCtx->mutex);
+    if (recCtx->ffNext != NULL) {
+        if (bPack && !recCtx->bPackDue) {
+            // next file is ready, split on the next IDR
+            recCtx->bPackDue = true;
+            vi2venc_requestIFrame(recCtx->vv);
+        }
+    } else {
+        pthread_mutex_lock(&wr->mutex);
+        if (!wr->bBusy && !wr->bOpen && wr->ffRetired == NULL) {
+            record_makeFile(recCtx, &wr->fileNext);
+            wr->bOpen = true;
+            sem_post(&wr->sem);
+        }
+        pthread_mutex_unlock(&wr->mutex);
     }
-    recCtx->ff = ff;
+    pthread_mutex_unlock(&recCtx->mutex);
 
-    vi2venc_getSpsPpsInfo(recCtx->vv, &veHeader, true);
-    // LOGD("dump spspps");
-    // dump_bytes(veHeader.pBuffer, veHeader.nLength);
+    return bPack;
+}
 
-    VencParams_t *veParams = &recCtx->vv->veParams;
+static int live_feed(RecordContext_t *recCtx, Vi2Venc_t *vv, const struct iovec *frameSegs, int nbSegs, VencFrameType_e frameType, uint64_t pts);
 
-    FFStreamParameters_t streamParam;
-    ZeroMemory(&streamParam, sizeof(streamParam));
-    streamParam.mediaType = AVMEDIA_TYPE_VIDEO;
-    streamParam.codecId = (PT_H265 == veParams->codecType) ? AV_CODEC_ID_HEVC : AV_CODEC_ID_H264;
-    streamParam.video.width = veParams->width;   // VE_WIDTH;
-    streamParam.video.height = veParams->height; // VE_HEIGHT;
-    streamParam.video.fps = veParams->fps;       // VE_FPS;
-    streamParam.spsData = veHeader.pBuffer;
-    streamParam.spsLen = veHeader.nLength;
-    int streamIndex = ffpack_newVideoStream(ff, -1, &streamParam);
-    if (streamIndex < 0) {
-        LOGE("create video stream failed");
-        goto failed;
-    }
-    recCtx->nbVideoStreamIndex = streamIndex;
+/* MPI pts to CLOCK_MONOTONIC us. The VENC and AI timestamps have been on it so
+ * far, but nothing documents that: the first frame of each encoder is checked
+ * against its arrival and, if further off than REC_ptsClockTolUS, that encoder
+ * is converted from then on. Not re-checked per frame, a late frame must not
+ * move the clock and break the muxer's monotonic timestamps. */
+static uint64_t record_captureUs(PtsClock_t *clk, const char *sName, uint64_t pts, int32_t *lagUs) {
+    uint64_t nowUs = get_tickUs();
 
-    if (recCtx->params.enableAudio) {
-        AencAttr_t *aeParams = &recCtx->aa->aeAttr;
+    if (!clk->bChecked) {
+        int64_t offsetUs = (int64_t)(nowUs - pts);
 
-        ZeroMemory(&streamParam, sizeof(streamParam));
-        streamParam.mediaType = AVMEDIA_TYPE_AUDIO;
-        streamParam.codecId = (PT_AAC == aeParams->Type) ? AV_CODEC_ID_AAC : AV_CODEC_ID_MP3;
-        streamParam.audio.sample_rate = aeParams->sampleRate;
-        streamParam.audio.channels = aeParams->channels;
-        streamParam.audio.bits_per_sample = aeParams->bitsPerSample;
-        streamIndex = ffpack_newAudioStream(ff, -1, &streamParam);
-        if (streamIndex < 0) {
-            LOGE("create audio stream failed");
-            goto failed;
+        if ((offsetUs < -REC_ptsClockTolUS) || (offsetUs > REC_ptsClockTolUS)) {
+            LOGW("%s pts %llu is %lld us off CLOCK_MONOTONIC, converting", sName, pts, offsetUs);
+            clk->offsetUs = offsetUs;
+        } else {
+            LOGI("%s pts on CLOCK_MONOTONIC, first frame %lld us old", sName, offsetUs);
+            clk->offsetUs = 0;
         }
-        recCtx->nbAudioStreamIndex = streamIndex;
+        clk->bChecked = true;
     }
 
-    if (ffpack_start(ff) != 0) {
-        goto failed;
-    }
+    uint64_t captureUs = pts + clk->offsetUs;
+    *lagUs = (int32_t)(nowUs - captureUs);
 
-    recCtx->tickBegin = get_tickCount();
-    recCtx->nbFileIndex++;
-    vi2venc_requestIFrame(recCtx->vv);
+    return captureUs;
+}
 
-    pthread_mutex_unlock(&recCtx->mutex);
+static inline void record_lagVideo(AvSkew_t *skew, int32_t lagUs) {
+    atomic_store(&skew->lagVideoUs, lagUs);
+    atomic_store(&skew->tickVideo, get_tickCount());
+}
 
-    switch (recCtx->params.fileNaming) {
-    case NAMING_CONTIGUOUS:
-        REC_filePathGet(sFile, sizeof(sFile), recCtx->params.packPath, REC_packPREFIX, nbFileIndex, REC_packSnapTYPE);
-        break;
-    case NAMING_DATE:
-        snprintf(sFile, sizeof(sFile), "%s%s.%s", recCtx->params.packPath, dateString, REC_packSnapTYPE);
-        break;
+static void record_countSkew(AvSkew_t *skew, int32_t lagAudioUs, uint32_t tick) {
+    if (tick - atomic_load(&skew->tickVideo) >= REC_avSkewIdleMS) {
+        return;
     }
-    record_takePicture(recCtx, sFile);
 
-    return true;
+    int32_t skewUs = lagAudioUs - atomic_load(&skew->lagVideoUs);
+    if (abs(skewUs) > REC_avSkewMaxUS) {
+        skew->nbSkews++;
+        if (abs(skewUs) > abs(skew->skewMaxUs)) {
+            skew->skewMaxUs = skewUs;
+        }
+    }
+}
 
-failed:
-    LOGE("create %s failed", sFile);
-    remove(sFile);
-    if (recCtx->ff != NULL) {
-        ffpack_close(recCtx->ff);
-        recCtx->ff = NULL;
+static void record_reportSkew(AvSkew_t *skew, const char *sName) {
+    if (skew->nbSkews > 0) {
+        LOGW("A/V skew on %s: %u audio frames over %d us, max %d us", sName, skew->nbSkews, REC_avSkewMaxUS, skew->skewMaxUs);
     }
-    pthread_mutex_unlock(&recCtx->mutex);
-    return true;
+    skew->nbSkews = 0;
+    skew->skewMaxUs = 0;
 }
 
-int vv_onFrame(void *vvPtr, uint8_t *frameData, int frameLen, VencFrameType_e frameType, uint64_t pts, void *context) {
-    int ret = 0;
-    RecordContext_t *recCtx = (RecordContext_t *)context;
-    uint64_t pts2 = 0; // nbFrames * 90000;
+/* audio and video reach their callbacks a few tens of ms after capture; lags
+ * drifting apart mean the two timestamps don't follow the same clock. Each
+ * video encoder that is delivering is compared on its own. */
+static void record_checkSkew(RecordContext_t *recCtx, int32_t lagAudioUs) {
+    uint32_t tick = get_tickCount();
 
-    pthread_mutex_lock(&recCtx->mutex);
+    record_countSkew(&recCtx->skewVideo, lagAudioUs, tick);
+    record_countSkew(&recCtx->skewLive, lagAudioUs, tick);
 
-    FFPack_t *ff = (FFPack_t *)recCtx->ff;
-    int streamIndex = recCtx->nbVideoStreamIndex;
+    if (tick - recCtx->tickSkew >= REC_avSkewReportMS) {
+        record_reportSkew(&recCtx->skewVideo, "VENC");
+        record_reportSkew(&recCtx->skewLive, "live VENC");
+        recCtx->tickSkew = tick;
+    }
+}
 
-    if (recCtx->nbFramesTotal == 0) {
-        LOGD("first frame (type=%d, len=%d, pts=%llu)", frameType, frameLen, pts);
+int vv_onFrame(void *vvPtr, const struct iovec *frameSegs, int nbSegs, VencFrameType_e frameType, uint64_t pts, void *context) {
+    RecordContext_t *recCtx = (RecordContext_t *)context;
+    RecordWriter_t *wr = &recCtx->writer;
+    bool bSkipping = wr->ringVideo.bSkipToKey;
+    bool bQueued = false;
+    int32_t lagUs;
 
-        if (frameType != FRAME_typeI) {
-            pthread_mutex_unlock(&recCtx->mutex);
-            vi2venc_requestIFrame(recCtx->vv);
-            return 0;
-        }
-        recCtx->ptsBase = pts;
+    recCtx->fpsStatus.nbFrames++;
 
-#if (0)
-        VencSpspps_t veHeader = {NULL, 0, false};
-        ret = vi2venc_getSpsPpsInfo(recCtx->vv, &veHeader, true);
-        if (ret == SUCCESS) {
-            LOGD("dump spspps on first frame");
-            dump_bytes(veHeader.pBuffer, veHeader.nLength);
-            vi2venc_freeSpsPpsInfo(&veHeader);
-        }
-#endif
-    }
+    pts = record_captureUs(&recCtx->clockVideo, "VENC", pts, &lagUs);
+    record_lagVideo(&recCtx->skewVideo, lagUs);
 
-    if (recCtx->nbAudioFrames == 0) {
-        recCtx->ptsBaseDeltaA = pts - recCtx->ptsBase;
+    // the live leg copies into avshare before the callback returns
+    if (atomic_load(&recCtx->bFanout)) {
+        live_feed(recCtx, recCtx->vv, frameSegs, nbSegs, frameType, pts);
     }
 
-    pts2 = (pts - recCtx->ptsBase + recCtx->ptsBaseDeltaV) / 10; // unit us to 10us
-    // LOGD("%llu, %llu", pts2, recCtx->ptsBase);
-
-    ret = ffpack_input(ff, streamIndex, frameData, frameLen, frameType == FRAME_typeI, pts2);
-    if (ret == -5) {
-        /* I/O error, need to check disk immediately */
-        // record_checkDiskImmediately(recCtx);
+    // the record leg keeps the stream until the writer has muxed it
+    if (vi2venc_canHold(recCtx->vv)) {
+        bQueued = pktring_pushRef(&wr->ringVideo, (frameType == FRAME_typeI) ? PKT_flagKEY : 0, pts, frameSegs, nbSegs);
+    } else if (!bSkipping) {
+        pktring_drop(&wr->ringVideo);
     }
-    recCtx->nbFramesTotal++;
-    recCtx->fpsStatus.nbFrames++;
 
-    pthread_mutex_unlock(&recCtx->mutex);
+    if (!bQueued) {
+        if (!bSkipping) {
+            // writer fell behind, the rest of the GOP is dropped
+            LOGE("video backlog full");
+            vi2venc_requestIFrame(recCtx->vv);
+        }
+        return 0;
+    }
+    sem_post(&wr->sem);
 
-    return 0;
+    return VENC_frameHELD;
 }
 
-int vvLive_onFrame(void *vvPtr, uint8_t *frameData, int frameLen, VencFrameType_e frameType, uint64_t pts, void *context) {
-    RecordContext_t *recCtx = (RecordContext_t *)context;
+// feeds avshare from either the live encoder or, in fan-out, the record encoder
+static int live_feed(RecordContext_t *recCtx, Vi2Venc_t *vv, const struct iovec *frameSegs, int nbSegs, VencFrameType_e frameType, uint64_t pts) {
     uint64_t pts2 = 0; // nbFrames * 90000;
 
     if (recCtx->nbFramesLive == 0) {
-        LOGD("first frame (type=%d, len=%d, pts=%llu)", frameType, frameLen, pts);
+        LOGD("first frame (type=%d, segs=%d, pts=%llu)", frameType, nbSegs, pts);
 
         if (frameType != FRAME_typeI) {
-            vi2venc_requestIFrame(recCtx->vvLive);
+            vi2venc_requestIFrame(vv);
             return 0;
         }
-        recCtx->ptsBaseLive = pts;
 
-        int ret = vi2venc_getSpsPpsInfo(recCtx->vvLive, &recCtx->spspps, true);
+        // kept across encoder switches, both encoders share the VI clock
+        if (recCtx->ptsBaseLive == 0) {
+            recCtx->ptsBaseLive = pts;
+        }
+
+        int ret = vi2venc_getSpsPpsInfo(vv, &recCtx->spspps, true);
         if (ret == SUCCESS) {
             // LOGD("dump spspps on first frame");
             // dump_bytes(recCtx->spspps.pBuffer, recCtx->spspps.nLength);
@@ -662,56 +1217,81 @@ int vvLive_onFrame(void *vvPtr, uint8_t *frameData, int frameLen, VencFrameType_
     pts2 = (pts - recCtx->ptsBaseLive) / 1000; // unit us to ms
     // LOGD("%llu, %llu", pts2, recCtx->ptsBaseLive);
 
+    // pts is CLOCK_MONOTONIC in us by now, rtspLive measures glass to RTP latency against it
     if (frameType == FRAME_typeI) {
-        avshare_addvid(recCtx->spspps.pBuffer, recCtx->spspps.nLength, FRAME_SPS, pts2);
+        struct iovec seg = {recCtx->spspps.pBuffer, recCtx->spspps.nLength};
+        avshare_addvidv(&seg, 1, FRAME_SPS, pts2, pts);
     }
 
-    avshare_addvid(frameData, frameLen, frameType, pts2);
+    avshare_addvidv(frameSegs, nbSegs, frameType, pts2, pts);
     recCtx->nbFramesLive++;
 
     return 0;
 }
 
-int aa_onFrame(void *aaPtr, uint8_t *frameData, int frameLen, uint64_t pts, void *context) {
-    int ret = 0;
+int vvLive_onFrame(void *vvPtr, const struct iovec *frameSegs, int nbSegs, VencFrameType_e frameType, uint64_t pts, void *context) {
     RecordContext_t *recCtx = (RecordContext_t *)context;
-    uint64_t pts2 = 0; // nbFrames * 90000;
+    int32_t lagUs;
 
-    pthread_mutex_lock(&recCtx->mutex);
+    pts = record_captureUs(&recCtx->clockLive, "live VENC", pts, &lagUs);
+    record_lagVideo(&recCtx->skewLive, lagUs);
 
-    FFPack_t *ff = (FFPack_t *)recCtx->ff;
-    int streamIndex = recCtx->nbAudioStreamIndex;
+    return live_feed(recCtx, recCtx->vvLive, frameSegs, nbSegs, frameType, pts);
+}
 
-    if (recCtx->nbAudioFrames == 0) {
-        recCtx->ptsBaseAudio = pts;
-        LOGD("first frame (len=%d, pts=%llu)", frameLen, pts);
+int aa_onFrame(void *aaPtr, uint8_t *frameData, int frameLen, uint64_t pts, void *context) {
+    RecordContext_t *recCtx = (RecordContext_t *)context;
+    RecordWriter_t *wr = &recCtx->writer;
+    struct iovec frameSeg = {frameData, frameLen};
+    int32_t lagUs;
 
-#if (0)
-        /* no need */
-        if (recCtx->aa->aeAttr.Type == PT_AAC) {
-            ffpack_setExtradata(ff, streamIndex, frameData, ADTS_HEADER__LEN);
-        }
-#endif
-    }
+    // on CLOCK_MONOTONIC like the video, rtspLive and the muxer use both as they are
+    pts = record_captureUs(&recCtx->clockAudio, "AENC", pts, &lagUs);
+    record_checkSkew(recCtx, lagUs);
 
-    if (recCtx->nbFramesTotal == 0) {
-        recCtx->ptsBaseDeltaV = pts - recCtx->ptsBaseAudio;
+    if (avshare_connected(MEDIA_AUDIO)) {
+        avshare_addaud(frameData, frameLen, pts);
     }
 
-    pts2 = (pts - recCtx->ptsBaseAudio + recCtx->ptsBaseDeltaA) / 10; // unit us to 10us
-    // LOGD("len=%d, %llu, %llu", frameLen, pts2, recCtx->ptsBaseAudio);
+    if ((recCtx->stateGoing != REC_statRun) || !recCtx->params.enableAudio) {
+        return 0;
+    }
 
-    ret = ffpack_input(ff, streamIndex, frameData, frameLen, FRAME_typeI, pts2);
-    if (ret == -5) {
-        /* I/O error, need to check disk immediately */
-        // record_checkDiskImmediately(recCtx);
+    if (pktring_push(&wr->ringAudio, PKT_flagKEY, pts, &frameSeg, 1)) {
+        sem_post(&wr->sem);
     }
 
-    recCtx->nbAudioFrames++;
+    return 0;
+}
 
-    pthread_mutex_unlock(&recCtx->mutex);
+/* highest clip number on the card, the directory is only scanned when its
+ * index is missing or out of date. A valid index can still lack the segment
+ * opened right before a power cut, so the numbers above it are looked at
+ * too. */
+static int record_lastFileIndex(RecordContext_t *recCtx) {
+    char *sTypes[] = REC_packEXTS;
+    DvrIndex_t idx;
+    int nIndexMax = -1;
+
+    if (dvridx_load(recCtx->params.packPath, &idx) != 0) {
+        return disk_countMovies(recCtx->params.packPath, REC_packPREFIX,
+                                sTypes, REC_packTypesNUM, REC_packIndexLEN);
+    }
+
+    for (int i = 0; i < idx.nbEntries; i++) {
+        int nIndex = disk_movieIndex(idx.entries[i].sName, REC_packPREFIX,
+                                     sTypes, REC_packTypesNUM, REC_packIndexLEN);
+        if (nIndex > nIndexMax) {
+            nIndexMax = nIndex;
+        }
+    }
+    dvridx_free(&idx);
 
-    return 0;
+    while (record_packExists(recCtx, nIndexMax + 1)) {
+        nIndexMax++;
+    }
+
+    return nIndexMax;
 }
 
 int record_checkDisk(RecordContext_t *recCtx) {
@@ -731,9 +1311,7 @@ int record_checkDisk(RecordContext_t *recCtx) {
                 LOGE("sdcard full");
                 record_saveStatus(recCtx, REC_statusDiskFull);
             } else {
-                char *sTypes[] = REC_packEXTS;
-                int nIndex = disk_countMovies(recCtx->params.packPath, REC_packPREFIX,
-                                              sTypes, REC_packTypesNUM, REC_packIndexLEN);
+                int nIndex = record_lastFileIndex(recCtx);
                 recCtx->nbFileIndex = nIndex + 1;
                 LOGD("movies index: %d", recCtx->nbFileIndex);
             }
@@ -761,6 +1339,7 @@ void record_run(RecordContext_t *recCtx, RecordState_e stateGo) {
         } else {
             uint32_t tickNow = get_tickCount();
             if ((tickNow - recCtx->fpsStatus.tickFps) >= 1000) {
+                recCtx->fpsStatus.fps = recCtx->fpsStatus.nbFrames;
                 if (recCtx->fpsStatus.nbFrames < 10) {
                     record_saveStatus(recCtx, REC_statusFramesTimeout);
                 }
@@ -803,7 +1382,6 @@ int live_start(RecordContext_t *recCtx) {
     }
 
     recCtx->nbFramesLive = 0;
-    recCtx->ptsBaseLive = 0;
 
     record_dumpViParams(&viParams);
     record_dumpVeParams(&veParams);
@@ -817,19 +1395,71 @@ failed:
 }
 
 static inline void live_stop(RecordContext_t *recCtx) {
+    atomic_store(&recCtx->bFanout, false);
     if (vi2live_started(recCtx->vvLive)) {
         vi2venc_stop(recCtx->vvLive, !record_isGoing(recCtx->vv));
         avshare_reset();
     }
 }
 
+// the live encoder is released, its frames come from the record encoder
+static void live_fanoutStart(RecordContext_t *recCtx) {
+    if (vi2live_started(recCtx->vvLive)) {
+        vi2venc_stop(recCtx->vvLive, false);
+    }
+    recCtx->nbFramesLive = 0;
+    atomic_store(&recCtx->bFanout, true);
+    LOGD("live stream fed by the record encoder");
+}
+
+// one audio encoder serves the recording and the live AAC track
+static void live_runAudio(RecordContext_t *recCtx) {
+    bool bWanted = recCtx->enableLive && avshare_connected(MEDIA_AUDIO);
+
+    if (bWanted && !recCtx->bLiveAudio) {
+        recCtx->bLiveAudio = true;
+        if (!aenc_isGoing(recCtx->aa)) {
+            AiParams_t aiParams;
+            AencParams_t aeParams;
+
+            ZeroMemory(&aiParams, sizeof(aiParams));
+            ZeroMemory(&aeParams, sizeof(aeParams));
+            conf_loadAiParams(recCtx->confFile, &aiParams);
+            conf_loadAencParams(recCtx->confFile, &aeParams);
+
+            if (aeParams.codecType != PT_AAC) {
+                LOGE("live audio needs AAC");
+            } else if ((ai2aenc_prepare(recCtx->aa, &aiParams, &aeParams) != SUCCESS) ||
+                       (ai2aenc_start(recCtx->aa) != SUCCESS)) {
+                LOGE("live audio start failed");
+                ai2aenc_stop(recCtx->aa, !ai2ao_playing(recCtx->ao));
+            }
+        }
+    } else if (!bWanted && recCtx->bLiveAudio) {
+        recCtx->bLiveAudio = false;
+        if (!record_isArecording(recCtx)) {
+            ai2aenc_stop(recCtx->aa, !ai2ao_playing(recCtx->ao));
+        }
+    }
+}
+
 static inline void live_run(RecordContext_t *recCtx) {
+    live_runAudio(recCtx);
+
     if (avshare_connected(MEDIA_VIDEO)) {
-        if (recCtx->enableLive && !vi2live_started(recCtx->vvLive)) {
+        if (!recCtx->enableLive || atomic_load(&recCtx->bFanout)) {
+            return;
+        }
+
+        if (record_isGoing(recCtx->vv) && recCtx->bFanoutOk) {
+            live_fanoutStart(recCtx);
+        } else if (!vi2live_started(recCtx->vvLive)) {
+            // separate, lower bitrate layer only while somebody watches
             live_start(recCtx);
         }
     } else {
         live_stop(recCtx);
+        recCtx->ptsBaseLive = 0;
     }
 }
 
@@ -870,71 +1500,85 @@ void main_loop(RecordContext_t *recCtx) {
     bool isExit = false;
     uint32_t tkIdle = 0;
     uint32_t tkNow = 0;
+    RequestMsg_t msgs[REC_msgBATCH];
 
     gogglemsg_init(false, MTYPE_RECORD);
     gogglemsg_flush(MTYPE_RECORD);
+    gogglemsg_listen(MTYPE_RECORD);
 
     while (!isExit) {
-        int nMsg = gogglemsg_recv(MTYPE_RECORD);
+        // wakes up on a command right away, live clients are still looked for every 100 ms
+        int nbMsgs = gogglemsg_wait(msgs, REC_msgBATCH, REC_pollMS);
 
-        switch (nMsg) {
-        case MSG_cmdQUIT:
-            isExit = true;
-            break;
-        case MSG_cmdSTART:
-            if (!record_isGoing(recCtx->vv)) {
-                conf_loadRecordParams(recCtx->confFile, &recCtx->params);
-            }
-            record_run(recCtx, REC_statRun);
-            tkIdle = tkNow;
-            break;
-        case MSG_cmdSTOP:
-            record_run(recCtx, REC_statStop);
-            tkIdle = tkNow;
-            break;
-        case REC_cmdSAVE:
-            conf_saveRecordParams(recCtx->confFile, &recCtx->params);
-            if (recCtx->vv != NULL) {
-                conf_saveVencParams(recCtx->confFile, &recCtx->vv->veParams);
-                conf_saveViParams(recCtx->confFile, &recCtx->vv->viParams);
-            }
-            break;
-        case AIO_cmdSTART: {
-            AiParams_t aiParams;
-            ZeroMemory(&aiParams, sizeof(aiParams));
-            conf_loadAiParams(recCtx->confFile, &aiParams);
-            ai2ao_start(recCtx->ao, &aiParams);
-            break;
-        }
-        case AIO_cmdSTOP:
-            ai2ao_stop(recCtx->ao, !record_isArecording(recCtx));
-            break;
-        case LIVE_cmdSTART:
-            recCtx->enableLive = true;
-            // for debug only
-            if (!vi2live_started(recCtx->vvLive)) {
-                live_start(recCtx);
-            }
-            break;
-        case LIVE_cmdSTOP:
-            // recCtx->enableLive = false;
-
-            // must stop record & live stream both while video input switched,
-            // then restart them (vi & venc) if needed, to make sure the encoded video correct.
-            // stop live stream encoding here
-            // will restart automatically if any clients connected
-            record_run(recCtx, REC_statStop);
-            live_stop(recCtx);
-            break;
-        default:
+        if (nbMsgs == 0) {
             // start live stream encoding if any clients connected
             live_run(recCtx);
-            usleep(100 * 1000);
-            break;
+        }
+
+        for (int i = 0; (i < nbMsgs) && !isExit; i++) {
+            int result = 0;
+
+            switch (msgs[i].cmd) {
+            case MSG_cmdQUIT:
+                isExit = true;
+                break;
+            case MSG_cmdSTART:
+                if (!record_isGoing(recCtx->vv)) {
+                    conf_loadRecordParams(recCtx->confFile, &recCtx->params);
+                }
+                record_run(recCtx, REC_statRun);
+                result = recCtx->status;
+                tkIdle = tkNow;
+                break;
+            case MSG_cmdSTOP:
+                record_run(recCtx, REC_statStop);
+                result = recCtx->status;
+                tkIdle = tkNow;
+                break;
+            case REC_cmdSAVE:
+                conf_saveRecordParams(recCtx->confFile, &recCtx->params);
+                if (recCtx->vv != NULL) {
+                    conf_saveVencParams(recCtx->confFile, &recCtx->vv->veParams);
+                    conf_saveViParams(recCtx->confFile, &recCtx->vv->viParams);
+                }
+                break;
+            case AIO_cmdSTART: {
+                AiParams_t aiParams;
+                ZeroMemory(&aiParams, sizeof(aiParams));
+                conf_loadAiParams(recCtx->confFile, &aiParams);
+                ai2ao_start(recCtx->ao, &aiParams);
+                break;
+            }
+            case AIO_cmdSTOP:
+                ai2ao_stop(recCtx->ao, !record_isArecording(recCtx));
+                break;
+            case LIVE_cmdSTART:
+                recCtx->enableLive = true;
+                // for debug only
+                if (!vi2live_started(recCtx->vvLive) && !atomic_load(&recCtx->bFanout)) {
+                    live_start(recCtx);
+                }
+                break;
+            case LIVE_cmdSTOP:
+                // recCtx->enableLive = false;
+
+                // must stop record & live stream both while video input switched,
+                // then restart them (vi & venc) if needed, to make sure the encoded video correct.
+                // stop live stream encoding here
+                // will restart automatically if any clients connected
+                record_run(recCtx, REC_statStop);
+                live_stop(recCtx);
+                break;
+            default:
+                break;
+            }
+
+            // the sender learns when the command is done, e.g. whether recording really started
+            gogglemsg_ack(&msgs[i], result);
         }
 
         tkNow = get_tickCount();
-        if (tkNow - tkIdle >= 500) {
+        if (tkNow - tkIdle >= REC_idleMS) {
             record_checkDisk(recCtx);
             record_saveStatus(recCtx, REC_statusSave);
             record_run(recCtx, recCtx->stateGo);
@@ -978,7 +1622,12 @@ int main(int argc, char *argv[]) {
     recCtx.statusSaved = REC_statSave;
     recCtx.enableLive = true;
     pthread_mutex_init(&recCtx.mutex, NULL);
+    record_statusOpen(&recCtx);
     record_saveStatus(&recCtx, REC_statusIdle);
+    if (record_writerStart(&recCtx) != 0) {
+        LOGE("writer thread failed");
+        goto failed;
+    }
     conf_loadRecordParams(recCtx.confFile, &recCtx.params);
     record_dumpParams(&recCtx.params);
 
@@ -1008,6 +1657,7 @@ failed:
     LOGD("exit ...");
 
     record_stop(&recCtx);
+    record_writerStop(&recCtx);
     ai2ao_deinitSys(recCtx.ao);
     ai2aenc_deinitSys(recCtx.aa);
     vi2live_deinitSys(recCtx.vvLive);
@@ -1015,6 +1665,7 @@ failed:
     pthread_mutex_destroy(&recCtx.mutex);
     disk_sdstat_delete();
     avshare_uninit();
+    record_statusClose(&recCtx);
 
     LOGD("exit done");
     log_close();
@@ -0,0 +1,203 @@
+//#define LOG_NDEBUG 0
+#define LOG_TAG "pktring"
+#include <log/log.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pktring.h"
+
+#define PKT_lenWRAP     0xFFFFFFFF
+#define PKT_align(n)    (((n) + 7) & ~7)
+
+int pktring_init(PktRing_t* ring, uint32_t size, bool bKeyed)
+{
+    memset(ring, 0, sizeof(PktRing_t));
+
+    if( (size & (size - 1)) != 0 ) {
+        LOGE("size %u is not a power of 2", size);
+        return -1;
+    }
+
+    ring->buf = (uint8_t*)malloc(size);
+    if( ring->buf == NULL ) {
+        LOGE("out of memory");
+        return -1;
+    }
+
+    ring->size = size;
+    ring->bKeyed = bKeyed;
+
+    return 0;
+}
+
+void pktring_deinit(PktRing_t* ring)
+{
+    if( ring->buf != NULL ) {
+        free(ring->buf);
+        ring->buf = NULL;
+    }
+}
+
+/* only while neither side is running */
+void pktring_reset(PktRing_t* ring)
+{
+    atomic_store(&ring->head, 0);
+    atomic_store(&ring->tail, 0);
+    atomic_store(&ring->highWater, 0);
+    atomic_store(&ring->nbDrops, 0);
+    ring->bSkipToKey = false;
+}
+
+/* room for a packet with a payload of size bytes, NULL if it is dropped */
+static PktHead_t* pktring_reserve(PktRing_t* ring, uint32_t flags, uint32_t size, uint32_t* headNew)
+{
+    if( ring->buf == NULL ) {
+        return NULL;
+    }
+
+    if( ring->bSkipToKey ) {
+        if( !(flags & PKT_flagKEY) ) {
+            atomic_fetch_add_explicit(&ring->nbDrops, 1, memory_order_relaxed);
+            return NULL;
+        }
+        ring->bSkipToKey = false;
+    }
+
+    uint32_t need = sizeof(PktHead_t) + PKT_align(size);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    uint32_t offset = head & (ring->size - 1);
+    uint32_t room = ring->size - offset;
+    uint32_t pad = (room < need) ? room : 0;
+
+    if( need + pad > ring->size - (head - tail) ) {
+        pktring_drop(ring);
+        return NULL;
+    }
+
+    if( pad > 0 ) {
+        // no room left before the end, the consumer skips it
+        if( room >= sizeof(PktHead_t) ) {
+            ((PktHead_t*)(ring->buf + offset))->len = PKT_lenWRAP;
+        }
+        head += pad;
+        offset = 0;
+    }
+
+    *headNew = head + need;
+    return (PktHead_t*)(ring->buf + offset);
+}
+
+static void pktring_commit(PktRing_t* ring, uint32_t head)
+{
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    atomic_store_explicit(&ring->head, head, memory_order_release);
+
+    if( head - tail > atomic_load_explicit(&ring->highWater, memory_order_relaxed) ) {
+        atomic_store_explicit(&ring->highWater, head - tail, memory_order_relaxed);
+    }
+}
+
+/* counts a packet the producer couldn't queue, a keyed ring drops the rest
+ * up to the next key packet */
+void pktring_drop(PktRing_t* ring)
+{
+    atomic_fetch_add_explicit(&ring->nbDrops, 1, memory_order_relaxed);
+    ring->bSkipToKey = ring->bKeyed;
+}
+
+bool pktring_push(PktRing_t* ring, uint32_t flags, uint64_t pts, const struct iovec* segs, int nbSegs)
+{
+    uint32_t len = 0;
+    uint32_t head;
+    int i;
+
+    for( i=0; i<nbSegs; i++ ) {
+        len += segs[i].iov_len;
+    }
+
+    PktHead_t* pkt = pktring_reserve(ring, flags, len, &head);
+    if( pkt == NULL ) {
+        return false;
+    }
+
+    uint8_t* p = pktring_data(pkt);
+
+    pkt->len = len;
+    pkt->flags = flags;
+    pkt->pts = pts;
+    for( i=0; i<nbSegs; i++ ) {
+        memcpy(p, segs[i].iov_base, segs[i].iov_len);
+        p += segs[i].iov_len;
+    }
+
+    pktring_commit(ring, head);
+    return true;
+}
+
+bool pktring_pushRef(PktRing_t* ring, uint32_t flags, uint64_t pts, const struct iovec* segs, int nbSegs)
+{
+    uint32_t len = 0;
+    uint32_t head;
+    int i;
+
+    if( nbSegs > PKT_refSEGMAX ) {
+        pktring_drop(ring);
+        return false;
+    }
+
+    PktHead_t* pkt = pktring_reserve(ring, flags, sizeof(PktRef_t), &head);
+    if( pkt == NULL ) {
+        return false;
+    }
+
+    PktRef_t* ref = (PktRef_t*)pktring_data(pkt);
+
+    for( i=0; i<nbSegs; i++ ) {
+        ref->segs[i] = segs[i];
+        len += segs[i].iov_len;
+    }
+    ref->nbSegs = nbSegs;
+    pkt->len = len;
+    pkt->flags = flags | PKT_flagREF;
+    pkt->pts = pts;
+
+    pktring_commit(ring, head);
+    return true;
+}
+
+PktHead_t* pktring_peek(PktRing_t* ring)
+{
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    if( tail == head ) {
+        return NULL;
+    }
+
+    uint32_t offset = tail & (ring->size - 1);
+    uint32_t room = ring->size - offset;
+
+    if( room < sizeof(PktHead_t) || ((PktHead_t*)(ring->buf + offset))->len == PKT_lenWRAP ) {
+        tail += room;
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+        if( tail == head ) {
+            return NULL;
+        }
+        offset = 0;
+    }
+
+    return (PktHead_t*)(ring->buf + offset);
+}
+
+void pktring_pop(PktRing_t* ring)
+{
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    PktHead_t* pkt = (PktHead_t*)(ring->buf + (tail & (ring->size - 1)));
+
+    uint32_t size = (pkt->flags & PKT_flagREF) ? sizeof(PktRef_t) : pkt->len;
+
+    tail += sizeof(PktHead_t) + PKT_align(size);
+    atomic_store_explicit(&ring->tail, tail, memory_order_release);
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/uio.h>
+
+#define PKT_flagKEY     0x01
+#define PKT_flagREF     0x02    //payload is PktRef_t, the data stays in the producer's buffer
+#define PKT_refSEGMAX   2
+
+/* every packet is a head followed by its payload, padded to 8 bytes */
+typedef struct
+{
+    uint32_t len;       //packet bytes, wherever they are
+    uint32_t flags;
+    uint64_t pts;
+} PktHead_t;
+
+typedef struct
+{
+    uint32_t     nbSegs;
+    struct iovec segs[PKT_refSEGMAX];
+} PktRef_t;
+
+/* single producer, single consumer ring of variable length packets.
+ * head/tail are free running byte counters, only the producer moves head
+ * and only the consumer moves tail. */
+typedef struct
+{
+    uint8_t*          buf;
+    uint32_t          size;         // power of 2
+    _Atomic uint32_t  head;
+    _Atomic uint32_t  tail;
+
+    bool              bKeyed;       // after a drop, drop until the next key packet
+    bool              bSkipToKey;
+    _Atomic uint32_t  highWater;    // bytes
+    _Atomic uint32_t  nbDrops;
+} PktRing_t;
+
+int  pktring_init(PktRing_t* ring, uint32_t size, bool bKeyed);
+void pktring_deinit(PktRing_t* ring);
+void pktring_reset(PktRing_t* ring);
+
+/* producer, push copies the segments in, pushRef only queues where they are
+ * and the producer keeps them until the consumer is done with the packet */
+bool pktring_push(PktRing_t* ring, uint32_t flags, uint64_t pts, const struct iovec* segs, int nbSegs);
+bool pktring_pushRef(PktRing_t* ring, uint32_t flags, uint64_t pts, const struct iovec* segs, int nbSegs);
+void pktring_drop(PktRing_t* ring);
+
+/* consumer, the payload stays valid until pktring_pop */
+PktHead_t* pktring_peek(PktRing_t* ring);
+void pktring_pop(PktRing_t* ring);
+
+static inline bool pktring_empty(PktRing_t* ring)
+{
+    return atomic_load(&ring->head) == atomic_load(&ring->tail);
+}
+
+static inline uint8_t* pktring_data(PktHead_t* pkt)
+{
+    return (uint8_t*)(pkt + 1);
+}
+
+/* the packet as segments, PKT_refSEGMAX at most */
+static inline int pktring_segs(PktHead_t* pkt, struct iovec* segs)
+{
+    if( pkt->flags & PKT_flagREF ) {
+        PktRef_t* ref = (PktRef_t*)pktring_data(pkt);
+        for( uint32_t i=0; i<ref->nbSegs; i++ ) {
+            segs[i] = ref->segs[i];
+        }
+        return ref->nbSegs;
+    }
+
+    segs[0].iov_base = pktring_data(pkt);
+    segs[0].iov_len = pkt->len;
+    return 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
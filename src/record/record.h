@@ -4,12 +4,17 @@
 extern "C" {
 #endif
 
+#include <semaphore.h>
+
 #include "vi2venc.h"
 #include "ai2aenc.h"
 #include "ai2ao.h"
 #include "ffpack.h"
+#include "jpegenc.h"
 #include "disk.h"
+#include "pktring.h"
 #include "record_definitions.h"
+#include "record_status.h"
 
 typedef enum
 {
@@ -56,12 +61,17 @@ typedef struct
     uint64_t    packSize;
     bool        enableAudio;
     FileNaming_t fileNaming;
+    uint32_t    fragDuration;   //mp4 fragment length in ms, 0: plain mp4
+    uint32_t    syncInterval;   //ms between fdatasyncs of the fragments, 0: every key frame
+    bool        preallocate;
+    bool        enableFanout;   //live stream shares the record encoder when compatible
 } RecordParams_t;
 
 typedef struct
 {
     uint32_t tickFps;
     uint32_t nbFrames;
+    uint32_t fps;           //frames counted over the last second
 } RecordFps_t;
 
 typedef struct
@@ -70,6 +80,60 @@ typedef struct
     uint32_t num;
 } CountWithTick_t;
 
+typedef struct
+{
+    char sFile[MAX_pathLEN*2];
+    char sSnap[MAX_pathLEN*2];
+} RecordFile_t;
+
+typedef struct
+{
+    uint32_t nbRollovers;
+    uint32_t closeUs;       //time the writer spent in ffpack_close() of the last retired segment
+    uint32_t closeMaxUs;
+    uint32_t ringHighWater; //KB, video ring
+    uint32_t nbDropsVideo;
+    uint32_t nbDropsAudio;
+} RecordStats_t;
+
+/* MPI timestamps are in us, but no header says on which clock: each encoder
+ * is checked against CLOCK_MONOTONIC on its first frame and converted */
+typedef struct
+{
+    bool    bChecked;
+    int64_t offsetUs;               //CLOCK_MONOTONIC - pts, 0 when they match
+} PtsClock_t;
+
+/* audio against one video encoder, record and live run on their own */
+typedef struct
+{
+    atomic_int  lagVideoUs;         //arrival - capture of its last frame
+    atomic_uint tickVideo;          //get_tickCount() at that frame
+    uint32_t    nbSkews;            //audio frames over REC_avSkewMaxUS since tickSkew
+    int32_t     skewMaxUs;
+} AvSkew_t;
+
+/* the only thread touching the card while recording: encoder callbacks queue
+ * packets into the rings, the writer muxes them, opens the next segment ahead
+ * of time and finalizes the retired one */
+typedef struct
+{
+    pthread_t       threadId;
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;           //signaled when a pass is done
+    sem_t           sem;            //posted per packet and per job
+    bool            bExit;
+    bool            bBusy;
+    bool            bOpen;          //job: open fileNext
+    FFPack_t*       ffRetired;      //job: close it
+    RecordFile_t    fileRetired;    //and index it
+    uint32_t        durationRetired;//ms
+    RecordFile_t    fileNext;
+    PktRing_t       ringVideo;
+    PktRing_t       ringAudio;
+    _Atomic uint64_t nbBytes;       //muxed since recording started
+} RecordWriter_t;
+
 typedef struct
 {
     Vi2Venc_t* vv;
@@ -77,6 +141,12 @@ typedef struct
     Ai2Aenc_t* aa;
     Ai2Ao_t*   ao;
     FFPack_t*  ff;
+    FFPack_t*  ffNext;              //pre-opened, swapped in on the next IDR
+    int        nbVideoStreamIndexNext;
+    int        nbAudioStreamIndexNext;
+    bool       bPackDue;            //split on the next IDR
+    bool       bSnapPending;        //snapshot of the segment just swapped in
+    JpegSnap_t* snap;               //snapshot service while recording
     uint32_t   tickBegin;
     uint32_t   nbFramesTotal;
     uint32_t   nbAudioFrames;
@@ -96,12 +166,26 @@ typedef struct
     SdcardStatus_t sdstat;
     RecordParams_t params;
     RecordFps_t    fpsStatus;
+    RecordWriter_t writer;
+    RecordStats_t  stats;
+    RecordStatusShm_t* statusShm;   //read by the goggle UI
+    char sFileNow[MAX_pathLEN*2];
     char confFile[MAX_pathLEN];
 
     bool     enableLive;
+    bool     bFanoutOk;             //record encoder matches the live settings
+    atomic_bool bFanout;            //live stream is fed by vv, vvLive is idle; read by the encoder callback
+    bool     bLiveAudio;            //aa runs for a live AAC client
     uint32_t nbFramesLive;
     uint64_t ptsBaseLive;
     VencSpspps_t spspps;
+
+    PtsClock_t clockVideo;          //record encoder
+    PtsClock_t clockLive;           //live encoder
+    PtsClock_t clockAudio;
+    AvSkew_t   skewVideo;           //record encoder
+    AvSkew_t   skewLive;            //live encoder
+    uint32_t   tickSkew;            //A/V skew reported at
 } RecordContext_t;
 
 #ifdef __cplusplus
@@ -72,6 +72,18 @@ extern "C" {
 #define REC_packSIZE        1024                //MB
 #define REC_minSIZE         50                  //MB
 #define REC_maxSIZE         (2 * 1024)          //MB
+#define REC_packPreopenMS   2000                //open the next file this early
+#define REC_fragDURATION    1000                //ms
+#define REC_maxFragDURATION 10000               //ms
+#define REC_syncINTERVAL    5000                //ms, fragments go to the card at most this often
+#define REC_maxSyncINTERVAL 60000               //ms
+#define REC_vencBufSIZE     (4 * 1024 * 1024)   //record encoder stream buffer, 3/4 of it is the writer backlog
+#define REC_ringVideoSIZE   (8 * 1024)          //segment lists of the held frames, must be a power of 2
+#define REC_ringAudioSIZE   (256 * 1024)
+#define REC_ptsClockTolUS   1000000             //first frame's pts further than this from CLOCK_MONOTONIC: the encoder has its own clock
+#define REC_avSkewMaxUS     200000              //audio and video capture lags further apart than this are reported
+#define REC_avSkewReportMS  10000
+#define REC_avSkewIdleMS    1000                //video encoder silent this long: not compared against
 #define REC_packPATH        "/DCIM/100HDZRO/" //REC_diskPATH "/DCIM/100HDZRO/"
 #define REC_packPREFIX      "hdz_"
 #define REC_hotPREFIX       "hot_"
@@ -90,6 +102,9 @@ extern "C" {
 #define REC_packEXTS        {DOT REC_packMP4, DOT REC_packTS}
 #define REC_packTypesNUM    2
 #define REC_starFORMAT      "%u:%02u star\n"
+#define REC_idleMS          500                 //housekeeping: disk, status, rollover
+#define REC_pollMS          100                 //main loop wakes up at least this often
+#define REC_msgBATCH        8                   //commands handled per wake up
 
 #define REC_filePathGet(BUFF, MAXLEN, PATH, PREFIX, INDEX, FILEFMT) \
     snprintf((BUFF), (MAXLEN), "%s%s%04d.%s", (PATH), (PREFIX), (INDEX), (FILEFMT));
@@ -0,0 +1,110 @@
+/******************************************************************************
+  File Name     : record_status.h
+  Description   : DVR status the record app publishes in shared memory for
+                  the goggle UI, replaces polling /tmp/record.dat.
+
+  The record app is the only writer. It makes seq odd, fills the block and
+  makes seq even again; a reader copies the block and retries while seq was
+  odd or changed meanwhile, so neither side ever blocks the other. A record
+  app that died mid-update leaves seq odd, the reader gives up after a few
+  tries and the next instance evens it out once it has set the block up.
+
+  Statistics change all the time and are simply read when wanted. Changes
+  the UI acts on (status, current file) also bump the changes counter,
+  readers compare it against the value they saw last.
+******************************************************************************/
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#define RECSTAT_memKEY      0x568068
+#define RECSTAT_MAGIC       0x54535252          //"RRST"
+#define RECSTAT_VERSION     1
+#define RECSTAT_fileLEN     256
+#define RECSTAT_readTRIES   64                  //then the block counts as stale
+
+typedef struct
+{
+    int32_t  status;            //RecordStatus_e, same values /tmp/record.dat had
+    uint32_t fps;               //frames encoded in the last second
+    uint64_t bytesWritten;      //since recording started
+    uint32_t nbDropsVideo;
+    uint32_t nbDropsAudio;
+    uint32_t ringDepth;         //KB queued for the writer
+    uint32_t ringHighWater;     //KB
+    uint32_t ringSize;          //KB
+    uint32_t nbRollovers;
+    uint32_t closeUs;           //time the writer spent in ffpack_close() of the last retired segment
+    uint32_t closeMaxUs;
+    uint32_t diskFreeMB;
+    char     sFile[RECSTAT_fileLEN];
+} RecordStatusData_t;
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    _Atomic uint32_t seq;       //odd while the record app writes
+    _Atomic uint32_t changes;   //bumped when status or file changed
+    RecordStatusData_t data;
+} RecordStatusShm_t;
+
+/* record app, the only writer. seq is made odd rather than bumped, so an
+ * odd one left behind by a crash is evened out by the next writeEnd. */
+static inline void recstat_writeBegin(RecordStatusShm_t* shm)
+{
+    uint32_t seq = atomic_load_explicit(&shm->seq, memory_order_relaxed);
+
+    atomic_store_explicit(&shm->seq, seq | 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static inline void recstat_writeEnd(RecordStatusShm_t* shm, bool bChanged)
+{
+    uint32_t seq = atomic_load_explicit(&shm->seq, memory_order_relaxed);
+
+    atomic_store_explicit(&shm->seq, (seq | 1) + 1, memory_order_release);
+
+    if (bChanged) {
+        atomic_fetch_add(&shm->changes, 1);
+    }
+}
+
+/* readers, false if no consistent copy was had within RECSTAT_readTRIES */
+static inline bool recstat_read(RecordStatusShm_t* shm, RecordStatusData_t* data)
+{
+    uint32_t seq;
+
+    for (int i = 0; i < RECSTAT_readTRIES; i++) {
+        seq = atomic_load_explicit(&shm->seq, memory_order_acquire);
+        if (seq & 1) {
+            sched_yield();
+            continue;
+        }
+
+        memcpy(data, &shm->data, sizeof(RecordStatusData_t));
+
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&shm->seq, memory_order_relaxed) == seq) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static inline uint32_t recstat_changes(RecordStatusShm_t* shm)
+{
+    return atomic_load(&shm->changes);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -4,8 +4,8 @@
 extern "C" {
 #endif
 
-int H264_Modify_SPS(uint8_t* src, int srcSize, int fps);
-int H265_Modify_SPS(uint8_t* src, int srcSize, int fps);
+int H264_Modify_SPS(uint8_t* src, int srcSize, int bufSize, int fps);
+int H265_Modify_SPS(uint8_t* src, int srcSize, int bufSize, int fps);
 
 #ifdef __cplusplus
 }
@@ -24,6 +24,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "vi2venc.h"
 #include "spspps_patch.h"
@@ -66,6 +67,67 @@ static VencFrameType_e vi2venc_frameType(Vi2Venc_t* vv, VENC_PACK_S* vencPack)
     return frameType;
 }
 
+/* takes the next held slot for the frame about to go to the callback, NULL
+ * when the callback may not keep it: too many frames or bytes already held */
+static VencHeldFrame_t* vi2venc_reserveHeld(Vi2Venc_t* vv, VENC_STREAM_S* stream, const struct iovec* frameSegs, int nbSegs)
+{
+    uint32_t head = atomic_load_explicit(&vv->heldHead, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&vv->heldTail, memory_order_acquire);
+    uint32_t len = 0;
+    int i;
+
+    for( i=0; i<nbSegs; i++ ) {
+        len += frameSegs[i].iov_len;
+    }
+
+    if( (vv->heldBytesMax == 0) || (head - tail >= VENC_heldMAX) ||
+        (atomic_load(&vv->heldBytes) + len > vv->heldBytesMax) ) {
+        return NULL;
+    }
+
+    VencHeldFrame_t* held = &vv->heldFrames[head % VENC_heldMAX];
+    held->stream = *stream;
+    held->pack = *stream->mpPack;
+    held->stream.mpPack = &held->pack;
+    held->len = len;
+
+    uint32_t bytes = atomic_fetch_add(&vv->heldBytes, len) + len;
+    if( bytes > atomic_load_explicit(&vv->heldHighWater, memory_order_relaxed) ) {
+        atomic_store_explicit(&vv->heldHighWater, bytes, memory_order_relaxed);
+    }
+    atomic_store_explicit(&vv->heldHead, head + 1, memory_order_release);
+    vv->heldNext = held;
+
+    return held;
+}
+
+/* the callback didn't keep it, nobody else saw the slot */
+static void vi2venc_unreserveHeld(Vi2Venc_t* vv, VencHeldFrame_t* held)
+{
+    atomic_fetch_sub(&vv->heldBytes, held->len);
+    atomic_store_explicit(&vv->heldHead, atomic_load(&vv->heldHead) - 1, memory_order_release);
+}
+
+/* from the callback: true if it may return VENC_frameHELD for this frame */
+bool vi2venc_canHold(Vi2Venc_t* vv)
+{
+    return vv->heldNext != NULL;
+}
+
+/* hands the oldest held frame back to the encoder */
+void vi2venc_releaseFrame(Vi2Venc_t* vv)
+{
+    uint32_t tail = atomic_load_explicit(&vv->heldTail, memory_order_relaxed);
+    VencHeldFrame_t* held = &vv->heldFrames[tail % VENC_heldMAX];
+
+    if( AW_MPI_VENC_ReleaseStream(vv->veChn, &held->stream) < 0 ) {
+        LOGW("release failed!");
+    }
+
+    atomic_fetch_sub(&vv->heldBytes, held->len);
+    atomic_store_explicit(&vv->heldTail, tail + 1, memory_order_release);
+}
+
 static void* vi2venc_frameProc(void *arg)
 {
     Vi2Venc_t* vv = (Vi2Venc_t*)arg;
@@ -83,8 +145,9 @@ static void* vi2venc_frameProc(void *arg)
 
     LOGD("venc thread: dev[%d] chn[%d] ve[%d]", vipp_dev, virvi_chn, ve_chn);
 
-    uint8_t* frameData = malloc(2*1024*1024);
-    int frameLen = 0;
+    struct iovec frameSegs[VENC_frameSEGMAX];
+    int nbSegs = 0;
+    VencHeldFrame_t* held;
 
 #if(0)
     VencHeaderData vencheader;
@@ -107,32 +170,47 @@ static void* vi2venc_frameProc(void *arg)
             //continue;
             break;
         } else {
+            // pass the stream buffer straight through, mpAddr1 is only set
+            // when the frame wraps around the end of the ring
             if(VencFrame.mpPack != NULL && VencFrame.mpPack->mLen0) {
-                memcpy(frameData, VencFrame.mpPack->mpAddr0, VencFrame.mpPack->mLen0);
-                frameLen += VencFrame.mpPack->mLen0;
+                frameSegs[nbSegs].iov_base = VencFrame.mpPack->mpAddr0;
+                frameSegs[nbSegs].iov_len = VencFrame.mpPack->mLen0;
+                nbSegs++;
             }
             if(VencFrame.mpPack != NULL && VencFrame.mpPack->mLen1) {
-                memcpy(frameData+frameLen, VencFrame.mpPack->mpAddr1, VencFrame.mpPack->mLen1);
-                frameLen += VencFrame.mpPack->mLen1;
-            }
-            ret = AW_MPI_VENC_ReleaseStream(ve_chn,&VencFrame);
-            if(ret < 0) {
-                LOGW("release failed!");
+                frameSegs[nbSegs].iov_base = VencFrame.mpPack->mpAddr1;
+                frameSegs[nbSegs].iov_len = VencFrame.mpPack->mLen1;
+                nbSegs++;
             }
 
-            if( frameLen > 0 ) {
+            held = NULL;
+            if( nbSegs > 0 ) {
                 if( vv->cbOnFrame ) {
+                    held = vi2venc_reserveHeld(vv, &VencFrame, frameSegs, nbSegs);
                     frameType = vi2venc_frameType(vv, VencFrame.mpPack);
-                    //vv->cbOnFrame(vv, frameData, frameLen, frameType, count*30*90, vv->contextOfOnFrame);
-                    vv->cbOnFrame(vv, frameData, frameLen, frameType, venc_pack.mPTS, vv->contextOfOnFrame);
+                    //vv->cbOnFrame(vv, frameSegs, nbSegs, frameType, count*30*90, vv->contextOfOnFrame);
+                    ret = vv->cbOnFrame(vv, frameSegs, nbSegs, frameType, venc_pack.mPTS, vv->contextOfOnFrame);
                     //LOGD("%llu", venc_pack.mPTS);
+                    if( (held != NULL) && (ret != VENC_frameHELD) ) {
+                        vi2venc_unreserveHeld(vv, held);
+                        held = NULL;
+                    }
+                    vv->heldNext = NULL;
+                }
+                nbSegs = 0;
+            }
+
+            // segments are consumed, hand the buffer back to the encoder;
+            // a held frame goes back through vi2venc_releaseFrame instead
+            if( held == NULL ) {
+                ret = AW_MPI_VENC_ReleaseStream(ve_chn,&VencFrame);
+                if(ret < 0) {
+                    LOGW("release failed!");
                 }
-                frameLen = 0;
             }
         }
     }
 
-    free(frameData);
     LOGD("venc thread exit");
 
     return NULL;
@@ -231,6 +309,46 @@ void vi2venc_deinitSys(Vi2Venc_t* vv)
     LOGD("done");
 }
 
+#if(VENC_spsppsPATCH)
+/* the encoder returns the same header until it is reconfigured, so the
+ * patch runs once per configuration instead of on every IDR */
+static int vi2venc_patchSpsPps(Vi2Venc_t* vv, uint8_t* src, int len)
+{
+    VencSpsppsCache_t* cache = &vv->spsppsCache;
+    PAYLOAD_TYPE_E codecType = vv->veParams.codecType;
+    int fps = vv->veParams.fps;
+    int nLength;
+
+    if( (cache->len > 0) && (cache->codecType == codecType) && (cache->fps == fps) &&
+        (cache->srcLen == len) && (memcmp(cache->src, src, len) == 0) ) {
+        return cache->len;
+    }
+
+    cache->len = 0;
+    if( len > VENC_spsppsLEN ) {
+        return -1;
+    }
+
+    memcpy(vv->spsppsBuff, src, len);
+    if( PT_H264 == codecType ) {
+        nLength = H264_Modify_SPS(vv->spsppsBuff, len-1, VENC_spsppsLEN, fps);
+    } else {
+        nLength = H265_Modify_SPS(vv->spsppsBuff, len, VENC_spsppsLEN, fps);
+    }
+    if( nLength < 0 ) {
+        return -1;
+    }
+
+    cache->codecType = codecType;
+    cache->fps = fps;
+    cache->srcLen = len;
+    memcpy(cache->src, src, len);
+    cache->len = nLength;
+
+    return nLength;
+}
+#endif
+
 ERRORTYPE vi2venc_getSpsPpsInfo(Vi2Venc_t* vv, VencSpspps_t* spsppsInfo, bool patch)
 {
     int ret = -1;
@@ -238,51 +356,26 @@ ERRORTYPE vi2venc_getSpsPpsInfo(Vi2Venc_t* vv, VencSpspps_t* spsppsInfo, bool pa
     PAYLOAD_TYPE_E codecType = vv->veParams.codecType;
     VencHeaderData veHeader = { NULL, 0 };
     int nLength = 0;
-    uint8_t* spsppsData = vv->spsppsBuff;
+    uint8_t* spsppsData = NULL;
 
     if(PT_H264 == codecType) {
         ret = AW_MPI_VENC_GetH264SpsPpsInfo(mVeChn, &veHeader);
-        if( ret == SUCCESS ) {
-            //LOGD("h264sps: %d, %p", veHeader.nLength, veHeader.pBuffer);
-#if(VENC_spsppsPATCH)
-            if ( patch ) {
-                nLength = max(veHeader.nLength*2, VENC_spsppsLEN);
-
-                memset(spsppsData, 0, nLength);
-                memcpy(spsppsData, veHeader.pBuffer, veHeader.nLength);
-                nLength = H264_Modify_SPS(spsppsData, veHeader.nLength-1, vv->veParams.fps);
-                if( nLength < 0 ) {
-                    nLength = veHeader.nLength;
-                    spsppsData = veHeader.pBuffer;
-                }
-            } else
-#endif
-            {
-                nLength = veHeader.nLength;
-                spsppsData = veHeader.pBuffer;
-            }
-        }
     } else if(PT_H265 == codecType) {
         ret = AW_MPI_VENC_GetH265SpsPpsInfo(mVeChn, &veHeader);
-        if( ret == SUCCESS ) {
+    }
+
+    if( ret == SUCCESS ) {
+        nLength = veHeader.nLength;
+        spsppsData = veHeader.pBuffer;
 #if(VENC_spsppsPATCH)
-            if ( patch ) {
-                nLength = max(veHeader.nLength*2, VENC_spsppsLEN);
-
-                memset(spsppsData, 0, nLength);
-                memcpy(spsppsData, veHeader.pBuffer, veHeader.nLength);
-                nLength = H265_Modify_SPS(spsppsData, veHeader.nLength, vv->veParams.fps);
-                if( nLength < 0 ) {
-                    nLength = veHeader.nLength;
-                    spsppsData = veHeader.pBuffer;
-                }
-            } else
-#endif
-            {
-                nLength = veHeader.nLength;
-                spsppsData = veHeader.pBuffer;
+        if ( patch ) {
+            int len = vi2venc_patchSpsPps(vv, veHeader.pBuffer, veHeader.nLength);
+            if( len >= 0 ) {
+                nLength = len;
+                spsppsData = vv->spsppsBuff;
             }
         }
+#endif
     }
 
     spsppsInfo->nLength = nLength;
@@ -333,6 +426,7 @@ static ERRORTYPE vi2venc_configVencChnAttr(ViParams_t* viParams, VencParams_t* v
         veChnAttr->VeAttr.AttrH264e.Profile = veParams->veAttr.mAttrH264.mProfile;// 2;//0:base 1:main 2:high
         veChnAttr->VeAttr.AttrH264e.PicWidth  = veParams->width;
         veChnAttr->VeAttr.AttrH264e.PicHeight = veParams->height;
+        veChnAttr->VeAttr.AttrH264e.BufSize = veParams->veAttr.mBufSize;
         switch (veParams->rcMode)
         {
         case VENC_rcVBR:
@@ -368,6 +462,7 @@ static ERRORTYPE vi2venc_configVencChnAttr(ViParams_t* viParams, VencParams_t* v
         veChnAttr->VeAttr.AttrH265e.mProfile = veParams->veAttr.mAttrH265.mProfile;//0;//0:main 1:main10 2:sti11
         veChnAttr->VeAttr.AttrH265e.mPicWidth = veParams->width;
         veChnAttr->VeAttr.AttrH265e.mPicHeight = veParams->height;
+        veChnAttr->VeAttr.AttrH265e.mBufSize = veParams->veAttr.mBufSize;
         veChnAttr->RcAttr.mAttrH265Cbr.mBitRate = veParams->bps;
         switch (veParams->rcMode)
         {
@@ -803,6 +898,10 @@ ERRORTYPE vi2venc_prepare(Vi2Venc_t* vv, ViParams_t* viParams, VencParams_t* veP
         return ret;
     }
 
+    // a quarter of the stream buffer stays free for the frames being encoded
+    vv->heldBytesMax = veParams->veAttr.mBufSize - veParams->veAttr.mBufSize / 4;
+    atomic_store(&vv->heldHighWater, 0);
+
     //config roi
     vi2venc_configRoi(vv, veParams);
 
@@ -859,6 +958,14 @@ ERRORTYPE vi2venc_stop(Vi2Venc_t* vv, bool all)
         vv->threadId = 0;
     }
 
+    // held frames point into the stream buffer, it goes with the channel
+    for( int i=0; atomic_load(&vv->heldTail) != atomic_load(&vv->heldHead); i++ ) {
+        if( i % 200 == 0 ) {
+            LOGD("waiting for %u held frames", atomic_load(&vv->heldHead) - atomic_load(&vv->heldTail));
+        }
+        usleep(5000);
+    }
+
     if (vv->viChn >= 0)
     {
         AW_MPI_VI_DisableVirChn(vv->viDev, vv->viChn);
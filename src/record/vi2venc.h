@@ -6,6 +6,8 @@ extern "C" {
 
 #include <plat_type.h>
 #include <tsemaphore.h>
+#include <stdatomic.h>
+#include <sys/uio.h>
 
 #include "mm_comm_vi.h"
 #include "mpi_vi.h"
@@ -18,6 +20,9 @@ extern "C" {
 
 #define VENC_spsppsPATCH    1
 #define VENC_spsppsLEN      256
+#define VENC_frameSEGMAX    2               /* stream buffer is a ring, a frame wraps at most once */
+#define VENC_heldMAX        64              /* frames a callback may keep past its return */
+#define VENC_frameHELD      1               /* CB_onFrame kept the stream, see vi2venc_releaseFrame */
 
 typedef enum
 {
@@ -192,8 +197,29 @@ typedef enum {
     FRAME_typeO,    //others
 } VencFrameType_e;
 
+/* the patched sps/pps, kept while the encoder hands out the same header */
+typedef struct
+{
+    PAYLOAD_TYPE_E codecType;
+    int         fps;
+    int         srcLen;
+    int         len;                        /* 0 while nothing is cached */
+    uint8_t     src[VENC_spsppsLEN];        /* header the patch was made from */
+} VencSpsppsCache_t;
+
+/* a stream a callback kept, given back to the encoder in the order it was kept */
+typedef struct
+{
+    VENC_STREAM_S stream;
+    VENC_PACK_S   pack;
+    uint32_t      len;
+} VencHeldFrame_t;
+
 typedef void* (*vi2venc_threadProc)(void *arg);
-typedef int (*CB_onFrame)(void* vvCtxPtr, uint8_t* frameData, int frameLen, VencFrameType_e frameType, uint64_t pts, void* context);
+/* frame is handed over as segments pointing into the encoder's stream buffer,
+ * which stays valid until the callback returns, or until vi2venc_releaseFrame
+ * if it returned VENC_frameHELD (only when vi2venc_canHold allowed it) */
+typedef int (*CB_onFrame)(void* vvCtxPtr, const struct iovec* frameSegs, int nbSegs, VencFrameType_e frameType, uint64_t pts, void* context);
 
 typedef struct Vi2Venc
 {
@@ -207,6 +233,15 @@ typedef struct Vi2Venc
     bool        bExit;
     VencParams_t veParams;
     uint8_t*    spsppsBuff;
+    VencSpsppsCache_t spsppsCache;
+
+    VencHeldFrame_t  heldFrames[VENC_heldMAX];
+    _Atomic uint32_t heldHead;              /* moved by the frame thread */
+    _Atomic uint32_t heldTail;              /* moved by vi2venc_releaseFrame */
+    _Atomic uint32_t heldBytes;
+    _Atomic uint32_t heldHighWater;
+    uint32_t    heldBytesMax;               /* 0: frames are never held */
+    VencHeldFrame_t* heldNext;              /* slot of the frame in the callback */
 
     CB_onFrame  cbOnFrame;
     void*       contextOfOnFrame;
@@ -224,6 +259,8 @@ ERRORTYPE vi2venc_start(Vi2Venc_t* vv, vi2venc_threadProc proc);
 ERRORTYPE vi2venc_stop(Vi2Venc_t* vv, bool all);
 ERRORTYPE vi2venc_getSpsPpsInfo(Vi2Venc_t* vv, VencSpspps_t* spsppsInfo, bool patch);
 ERRORTYPE vi2venc_requestIFrame(Vi2Venc_t* vv);
+bool      vi2venc_canHold(Vi2Venc_t* vv);
+void      vi2venc_releaseFrame(Vi2Venc_t* vv);
 char*     vi2venc_getRcModeName(VencRateControlMode_e rcMode);
 char*     vi2venc_getProfileName(VencProfile_e profile, bool h265);
 
@@ -12,10 +12,12 @@
 #include "version.hh"
 #include <GroupsockHelper.hh> // for "weHaveAnIPv*Address()"
 #include "H264FramedLiveSource.hh"
+#include "AACFramedLiveSource.hh"
 
 #if(!USE_DynamicRTSPServer)
 #include "H264LiveVideoServerMediaSubssion.hh"
 #include "H265LiveVideoServerMediaSubssion.hh"
+#include "AACLiveAudioServerMediaSubssion.hh"
 #endif
 
 extern "C"
@@ -315,14 +317,40 @@ void* live_multicast_loop(void *context)
 
   if( liveCtx->h265 ) {
     // Create a framer for the Video Elementary Stream:
-    videoSource = H265VideoStreamFramer::createNew(*env, videoES);
+    videoSource = H265VideoStreamDiscreteFramer::createNew(*env, videoES);
   }
   else {
     // Create a framer for the Video Elementary Stream:
-    videoSource = H264VideoStreamFramer::createNew(*env, videoES);
+    videoSource = H264VideoStreamDiscreteFramer::createNew(*env, videoES);
   }
   videoSink->startPlaying(*videoSource, NULL, NULL);
 
+  // AAC track on its own port pair, both use the capture clock for presentation times
+  if( liveCtx->audio ) {
+    const Port rtpPortAudio(rtpPortNum+2);
+    const Port rtcpPortAudio(rtpPortNum+3);
+    Groupsock* rtpGroupsockAudio = new Groupsock(*env, destinationAddress, rtpPortAudio, ttl);
+    Groupsock* rtcpGroupsockAudio = new Groupsock(*env, destinationAddress, rtcpPortAudio, ttl);
+    rtpGroupsockAudio->multicastSendOnly();
+    rtcpGroupsockAudio->multicastSendOnly();
+
+    char configStr[AACFramedLiveSource_configLEN];
+    AACFramedLiveSource::makeConfig(configStr, liveCtx->audioSampleRate, liveCtx->audioChannels);
+
+    RTPSink* audioSink = MPEG4GenericRTPSink::createNew(*env, rtpGroupsockAudio, 97, liveCtx->audioSampleRate,
+                                                        "audio", "AAC-hbr", configStr, liveCtx->audioChannels);
+    RTCPInstance* rtcpAudio
+    = RTCPInstance::createNew(*env, rtcpGroupsockAudio,
+                              64 /* kbps */, CNAME,
+                              audioSink, NULL /* we're a server */,
+                              liveCtx->isSSM /* we're a SSM source */);
+    sms->addSubsession(PassiveServerMediaSubsession::createNew(*audioSink, rtcpAudio));
+
+    FramedSource* audioES = AACFramedLiveSource::createNew(*env, liveCtx->audioSampleRate);
+    FramedSource* audioSource = ADTSAudioStreamDiscreteFramer::createNew(*env, audioES, configStr);
+    audioSink->startPlaying(*audioSource, NULL, NULL);
+  }
+
   env->taskScheduler().doEventLoop((char*)&liveCtx->bExit); // does not return
 
   return 0; // only to prevent compiler warning
@@ -358,6 +386,10 @@ void* live_loop(void *context)
             else {
                 sms->addSubsession(H264LiveVideoServerMediaSubssion::createNew(*env, reuseFirstSource));
             }
+            if (liveCtx->audio) {
+                sms->addSubsession(AACLiveAudioServerMediaSubssion::createNew(*env, reuseFirstSource,
+                                                                              liveCtx->audioSampleRate, liveCtx->audioChannels));
+            }
             rtspServer->addServerMediaSession(sms);
         }
     }
@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include "AACFramedLiveSource.hh"
+#include "live_context.h"
+
+extern "C"
+{
+#include "avshare.h"
+}
+
+#define SKEW_reportMS   10000
+
+static unsigned get_tickMs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+AACFramedLiveSource* AACFramedLiveSource::createNew(UsageEnvironment& env, unsigned sampleRate)
+{
+	AACFramedLiveSource* newSource = new AACFramedLiveSource(env, sampleRate);
+	return newSource;
+}
+
+// AAC-LC AudioSpecificConfig: 5 bits object type, 4 bits frequency index, 4 bits channels
+void AACFramedLiveSource::makeConfig(char* configStr, unsigned sampleRate, unsigned channels)
+{
+    static const unsigned rates[] = {96000, 88200, 64000, 48000, 44100, 32000, 24000, 22050, 16000, 12000, 11025, 8000, 7350};
+    unsigned index = 3;
+
+    for (unsigned i = 0; i < sizeof(rates)/sizeof(rates[0]); i++) {
+        if (rates[i] == sampleRate) {
+            index = i;
+            break;
+        }
+    }
+
+    unsigned config = (2 << 11) | (index << 7) | ((channels & 0x0F) << 3);
+    snprintf(configStr, AACFramedLiveSource_configLEN, "%02X%02X", (config >> 8) & 0xFF, config & 0xFF);
+}
+
+AACFramedLiveSource::AACFramedLiveSource(UsageEnvironment& env, unsigned sampleRate)
+: FramedSource(env), fScheduler(env.taskScheduler()), fEventTriggerId(0),
+  fFrameDuration(1024 * 1000000 / sampleRate), fSkewTick(get_tickMs()), fNbSkew(0), fSkewSumUs(0), fSkewMaxUs(0), fReader(NULL)
+{
+	alogd("live audio source opened\n");
+
+    fReader = avshare_openReader(MEDIA_AUDIO);
+
+    fEventTriggerId = fScheduler.createEventTrigger(deliverFrame0);
+    if (fReader != NULL) {
+        avshare_readerNotify(fReader, onAvshare, this);
+    }
+}
+
+AACFramedLiveSource::~AACFramedLiveSource()
+{
+    alogd("live audio source closed\n");
+
+    if (fReader != NULL) {
+        avshare_readerNotifyStop(fReader);
+    }
+    fScheduler.deleteEventTrigger(fEventTriggerId);
+    avshare_closeReader(fReader);
+}
+
+// called from the avshare notify thread
+void AACFramedLiveSource::onAvshare(void* clientData)
+{
+    AACFramedLiveSource* source = (AACFramedLiveSource*)clientData;
+
+    source->fScheduler.triggerEvent(source->fEventTriggerId, source);
+}
+
+void AACFramedLiveSource::deliverFrame0(void* clientData)
+{
+    ((AACFramedLiveSource*)clientData)->deliverFrame();
+}
+
+void AACFramedLiveSource::doGetNextFrame()
+{
+    deliverFrame();
+}
+
+// ADTS frames, ADTSAudioStreamDiscreteFramer strips the headers
+void AACFramedLiveSource::deliverFrame()
+{
+    if (!isCurrentlyAwaitingData() || (fReader == NULL)) {
+        return;
+    }
+
+    int nLen = avshare_readerAudio(fReader, fTo, fMaxSize, &fPresentationTime, &fDurationInMicroseconds);
+    if (nLen <= 0) {
+        return;
+    }
+
+    fFrameSize = nLen;
+    fNumTruncatedBytes = 0;
+    fDurationInMicroseconds = fFrameDuration;
+
+    countSkew();
+
+    FramedSource::afterGetting(this);
+}
+
+// glass to RTP latency of this client's audio against the video last sent
+void AACFramedLiveSource::countSkew()
+{
+    AvshareLatency_t latencyVideo;
+    struct timeval now;
+
+    avshare_getLatency(MEDIA_VIDEO, &latencyVideo, false);
+    if (latencyVideo.nbFrames > 0) {
+        gettimeofday(&now, NULL);
+
+        int64_t latencyAudio = (int64_t)(now.tv_sec - fPresentationTime.tv_sec) * 1000000 + (now.tv_usec - fPresentationTime.tv_usec);
+        int skewUs = (int)(latencyAudio - latencyVideo.lastUs);
+
+        fNbSkew++;
+        fSkewSumUs += skewUs;
+        if (abs(skewUs) > abs(fSkewMaxUs)) {
+            fSkewMaxUs = skewUs;
+        }
+    }
+
+    unsigned tick = get_tickMs();
+    if (tick - fSkewTick >= SKEW_reportMS) {
+        if (fNbSkew > 0) {
+            alogd("client %p A/V skew: avg %dus, max %dus, %u frames\n",
+                  this, (int)(fSkewSumUs / fNbSkew), fSkewMaxUs, fNbSkew);
+        }
+        fNbSkew = 0;
+        fSkewSumUs = 0;
+        fSkewMaxUs = 0;
+        fSkewTick = tick;
+    }
+}
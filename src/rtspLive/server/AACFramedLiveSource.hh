@@ -0,0 +1,39 @@
+#pragma once
+
+#include <FramedSource.hh>
+
+struct AvshareReader_s;
+
+#define AACFramedLiveSource_configLEN   5   //2 bytes AudioSpecificConfig in hex
+
+class AACFramedLiveSource : public FramedSource
+{
+public:
+	static AACFramedLiveSource* createNew(UsageEnvironment& env, unsigned sampleRate);
+	static void makeConfig(char* configStr, unsigned sampleRate, unsigned channels);
+
+protected:
+	AACFramedLiveSource(UsageEnvironment& env, unsigned sampleRate);
+	~AACFramedLiveSource();
+
+protected:
+	virtual void doGetNextFrame();
+
+private:
+	static void onAvshare(void* clientData);
+	static void deliverFrame0(void* clientData);
+	void deliverFrame();
+	void countSkew();
+
+	TaskScheduler& fScheduler;
+	EventTriggerId fEventTriggerId;
+	unsigned       fFrameDuration;  //us per AAC frame
+
+	//A/V skew of this client: audio minus video glass to RTP latency
+	unsigned       fSkewTick;
+	unsigned       fNbSkew;
+	int64_t        fSkewSumUs;
+	int            fSkewMaxUs;
+
+	struct AvshareReader_s* fReader;  //own cursor in the avshare ring
+};
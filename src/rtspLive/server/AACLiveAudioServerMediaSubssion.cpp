@@ -0,0 +1,40 @@
+#include "AACLiveAudioServerMediaSubssion.hh"
+#include "ADTSAudioStreamDiscreteFramer.hh"
+#include "MPEG4GenericRTPSink.hh"
+#include "live_context.h"
+
+AACLiveAudioServerMediaSubssion* AACLiveAudioServerMediaSubssion::createNew(UsageEnvironment& env, Boolean reuseFirstSource, unsigned sampleRate, unsigned channels)
+{
+    return new AACLiveAudioServerMediaSubssion(env, reuseFirstSource, sampleRate, channels);
+}
+
+AACLiveAudioServerMediaSubssion::AACLiveAudioServerMediaSubssion(UsageEnvironment& env, Boolean reuseFirstSource, unsigned sampleRate, unsigned channels)
+: OnDemandServerMediaSubsession(env, reuseFirstSource), fSampleRate(sampleRate), fChannels(channels)
+{
+    AACFramedLiveSource::makeConfig(fConfigStr, fSampleRate, fChannels);
+    alogd("AAC server media subssion construct (%uHz, %u ch, config %s)\n", fSampleRate, fChannels, fConfigStr);
+}
+
+AACLiveAudioServerMediaSubssion::~AACLiveAudioServerMediaSubssion()
+{
+    alogd("AAC server media subssion destruct\n");
+}
+
+FramedSource* AACLiveAudioServerMediaSubssion::createNewStreamSource(unsigned clientSessionId, unsigned& estBitrate)
+{
+	estBitrate = 64; //kbps, estimate
+
+	AACFramedLiveSource* liveSource = AACFramedLiveSource::createNew(envir(), fSampleRate);
+	if (liveSource == NULL)
+	{
+		return NULL;
+	}
+
+	return ADTSAudioStreamDiscreteFramer::createNew(envir(), liveSource, fConfigStr);
+}
+
+RTPSink* AACLiveAudioServerMediaSubssion::createNewRTPSink(Groupsock* rtpGroupsock, unsigned char rtpPayloadTypeIfDynamic, FramedSource* inputSource)
+{
+    return MPEG4GenericRTPSink::createNew(envir(), rtpGroupsock, rtpPayloadTypeIfDynamic, fSampleRate,
+                                          "audio", "AAC-hbr", fConfigStr, fChannels);
+}
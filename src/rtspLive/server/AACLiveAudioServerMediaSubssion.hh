@@ -0,0 +1,23 @@
+#pragma once
+
+#include "OnDemandServerMediaSubsession.hh"
+#include "AACFramedLiveSource.hh"
+
+class AACLiveAudioServerMediaSubssion : public OnDemandServerMediaSubsession {
+
+public:
+	static AACLiveAudioServerMediaSubssion* createNew(UsageEnvironment& env, Boolean reuseFirstSource, unsigned sampleRate, unsigned channels);
+
+protected:
+	AACLiveAudioServerMediaSubssion(UsageEnvironment& env, Boolean reuseFirstSource, unsigned sampleRate, unsigned channels);
+	~AACLiveAudioServerMediaSubssion();
+
+protected:
+	FramedSource* createNewStreamSource(unsigned clientSessionId, unsigned& estBitrate);
+	RTPSink* createNewRTPSink(Groupsock* rtpGroupsock, unsigned char rtpPayloadTypeIfDynamic, FramedSource* inputSource);
+
+private:
+	unsigned fSampleRate;
+	unsigned fChannels;
+	char     fConfigStr[AACFramedLiveSource_configLEN];
+};
@@ -1,10 +1,27 @@
+#include <time.h>
+#include <string.h>
+
 #include "H264FramedLiveSource.hh"
+#include "live_context.h"
 
 extern "C"
 {
 #include "avshare.h"
 }
 
+#if(H264FramedLiveSource_REPORT)
+#define LATENCY_reportMS    10000
+
+static unsigned get_tickMs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+#endif
+
 H264FramedLiveSource* H264FramedLiveSource::createNew(UsageEnvironment& env)
 {
 	H264FramedLiveSource* newSource = new H264FramedLiveSource(env);
@@ -12,22 +29,37 @@ H264FramedLiveSource* H264FramedLiveSource::createNew(UsageEnvironment& env)
 }
 
 H264FramedLiveSource::H264FramedLiveSource(UsageEnvironment& env)
-: FramedSource(env)
+: FramedSource(env), fScheduler(env.taskScheduler()), fEventTriggerId(0), fReader(NULL),
+  fHasFrame(false), fNalPos(0)
 {
+#if(H264FramedLiveSource_REPORT)
+    fLatencyTick = get_tickMs();
+#endif
 	printf("[MEDIA SERVER]live source opened\n");
 
 #if(H264FramedLiveSource_SAVE_FILE)
 	_fileTest = fopen("/mnt/extsd/test_live.264", "wb");
 #endif
 
-    avshare_start();
+    // every client reads at its own pace, a slow one never holds back the others
+    fReader = avshare_openReader(MEDIA_VIDEO);
+
+    // frames are delivered when the record app publishes them, no polling
+    fEventTriggerId = fScheduler.createEventTrigger(deliverFrame0);
+    if (fReader != NULL) {
+        avshare_readerNotify(fReader, onAvshare, this);
+    }
 }
 
 H264FramedLiveSource::~H264FramedLiveSource()
 {
     printf("[MEDIA SERVER]live source closed\n");
 
-    avshare_stop();
+    if (fReader != NULL) {
+        avshare_readerNotifyStop(fReader);
+    }
+    fScheduler.deleteEventTrigger(fEventTriggerId);
+    avshare_closeReader(fReader);
 
 #if(H264FramedLiveSource_SAVE_FILE)
     if( _fileTest != NULL ) {
@@ -36,33 +68,121 @@ H264FramedLiveSource::~H264FramedLiveSource()
 #endif
 }
 
+// called from the avshare notify thread, triggerEvent() is the only thread safe scheduler call
+void H264FramedLiveSource::onAvshare(void* clientData)
+{
+    H264FramedLiveSource* source = (H264FramedLiveSource*)clientData;
+
+    source->fScheduler.triggerEvent(source->fEventTriggerId, source);
+}
+
+void H264FramedLiveSource::deliverFrame0(void* clientData)
+{
+    ((H264FramedLiveSource*)clientData)->deliverFrame();
+}
+
 void H264FramedLiveSource::doGetNextFrame()
 {
-    int nLen = avshare_readFrame(fTo, fMaxSize, &fPresentationTime, &fDurationInMicroseconds);
+    deliverFrame();
+}
 
-    //printf("[MEDIA SERVER]GetFrameData len = [%d],fMaxSize = [%d]\n",fFrameSize,fMaxSize);
-    fFrameSize = (nLen>0) ? nLen : 0;
+// copies the NAL unit at fNalPos into fTo without its start code, false when the frame is done
+bool H264FramedLiveSource::nextNalUnit()
+{
+    const uint8_t* data = (const uint8_t*)fFrame.iov.iov_base;
+    unsigned len = fFrame.iov.iov_len;
+    unsigned start, end, i;
 
-    if (fFrameSize > fMaxSize) {
-        //fNumTruncatedBytes = fFrameSize - fMaxSize;
-        fFrameSize = fMaxSize;
-        printf("[MEDIA SERVER]Live source frame is overfload [%d/%d]\n",nLen,fMaxSize);
+    // skip the start code
+    for (start = fNalPos; (start < len) && (data[start] == 0); start++) {
     }
-    else {
-        //fNumTruncatedBytes = 0;
-        fDurationInMicroseconds = 0;
+    if ((start >= len) || (data[start] != 1)) {
+        fNalPos = len;
+        return false;
+    }
+    start++;
+
+    // up to the next start code, the zeros in front of it belong to that one
+    for (i = start; (i + 2 < len) && !((data[i] == 0) && (data[i+1] == 0) && (data[i+2] == 1)); i++) {
+    }
+    end = (i + 2 < len) ? i : len;
+    fNalPos = end;
+    while ((end > start) && (data[end-1] == 0)) {
+        end--;
+    }
+
+    unsigned nalSize = end - start;
+    fFrameSize = (nalSize > fMaxSize) ? fMaxSize : nalSize;
+    fNumTruncatedBytes = nalSize - fFrameSize;
+    memcpy(fTo, data + start, fFrameSize);
+
+    return true;
+}
+
+// the discrete framer takes NAL units, so they go from the shared ring right into the
+// fragmenter's buffer instead of through the stream parser
+void H264FramedLiveSource::deliverFrame()
+{
+    if (!isCurrentlyAwaitingData() || (fReader == NULL)) {
+        return;
+    }
+
+    for (;;) {
+        if (!fHasFrame) {
+            if (avshare_readerPeekFrame(fReader, &fFrame) != 0) {
+                // nothing published yet, the event trigger calls us again
+                return;
+            }
+            fHasFrame = true;
+            fNalPos = 0;
+        }
+
+        bool bNal = nextNalUnit();
+
+        if (!avshare_readerCheck(fReader)) {
+            // overwritten while copying, the reader restarts at a key frame
+            fHasFrame = false;
+            continue;
+        }
+
+        if (fNalPos >= fFrame.iov.iov_len) {
+            avshare_readerRelease(fReader);
+            fHasFrame = false;
+        }
+
+        if (bNal) {
+            break;
+        }
+    }
+
+    fPresentationTime = fFrame.timestamp;
+    fDurationInMicroseconds = 0;
+    if (fNumTruncatedBytes > 0) {
+        printf("[MEDIA SERVER]Live source frame is overfload [%u/%u]\n", fFrameSize + fNumTruncatedBytes, fMaxSize);
     }
 
 #if(H264FramedLiveSource_SAVE_FILE)
     if( (fFrameSize > 0) && (_fileTest != NULL) ) {
+        static const uint8_t startCode[4] = { 0, 0, 0, 1 };
+
+        fwrite(startCode, sizeof(startCode), 1, _fileTest);
         fwrite(fTo, fFrameSize, 1, _fileTest);
     }
 #endif
 
-    if(!fFrameSize){
-		nextTask() = envir().taskScheduler().scheduleDelayedTask(1000,(TaskFunc*)FramedSource::afterGetting, this);
-    }
-    else{
-		nextTask() = envir().taskScheduler().scheduleDelayedTask(0,(TaskFunc*)FramedSource::afterGetting, this);//ʾӳ0ִ afterGetting 
+#if(H264FramedLiveSource_REPORT)
+    unsigned tick = get_tickMs();
+    if (tick - fLatencyTick >= LATENCY_reportMS) {
+        AvshareLatency_t latency;
+        AvshareReaderStats_t stats;
+
+        avshare_readerLatency(fReader, &latency, true);
+        avshare_readerStats(fReader, &stats);
+        alogd("client %p glass to RTP latency: avg %uus, max %uus, %u frames, %u dropped, %u resyncs\n",
+              this, latency.avgUs, latency.maxUs, latency.nbFrames, stats.nbDropped, stats.nbResyncs);
+        fLatencyTick = tick;
     }
+#endif
+
+    FramedSource::afterGetting(this);
 }
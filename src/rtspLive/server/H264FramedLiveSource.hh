@@ -1,8 +1,10 @@
 #pragma once
 
 #include <FramedSource.hh>
+#include "avshare.h"
 
 #define H264FramedLiveSource_SAVE_FILE  0
+#define H264FramedLiveSource_REPORT     0   //log each client's glass to RTP latency every 10 s
 
 class H264FramedLiveSource : public FramedSource
 {
@@ -16,6 +18,24 @@ protected:
 protected:
 	virtual void doGetNextFrame();
 
+private:
+	static void onAvshare(void* clientData);
+	static void deliverFrame0(void* clientData);
+	void deliverFrame();
+	bool nextNalUnit();
+
+	TaskScheduler& fScheduler;
+	EventTriggerId fEventTriggerId;
+#if(H264FramedLiveSource_REPORT)
+	unsigned       fLatencyTick;
+#endif
+	AvshareReader_t* fReader;  //own cursor in the avshare ring
+
+	// frame being handed out one NAL unit at a time, straight from the ring
+	AvshareFrame_t fFrame;
+	bool           fHasFrame;
+	unsigned       fNalPos;
+
 #if(H264FramedLiveSource_SAVE_FILE)
 	FILE *_fileTest;
 #endif
@@ -1,6 +1,6 @@
 #include "H264LiveVideoServerMediaSubssion.hh"
 #include "H264FramedLiveSource.hh"
-#include "H264VideoStreamFramer.hh"
+#include "H264VideoStreamDiscreteFramer.hh"
 
 H264LiveVideoServerMediaSubssion* H264LiveVideoServerMediaSubssion::createNew(UsageEnvironment& env, Boolean reuseFirstSource)
 {
@@ -29,5 +29,5 @@ FramedSource* H264LiveVideoServerMediaSubssion::createNewStreamSource(unsigned c
 	}
 
 	// Create a framer for the Video Elementary Stream:
-	return H264VideoStreamFramer::createNew(envir(), liveSource);
+	return H264VideoStreamDiscreteFramer::createNew(envir(), liveSource);
 }
@@ -1,6 +1,6 @@
 #include "H265LiveVideoServerMediaSubssion.hh"
 #include "H264FramedLiveSource.hh"
-#include "H265VideoStreamFramer.hh"
+#include "H265VideoStreamDiscreteFramer.hh"
 
 H265LiveVideoServerMediaSubssion* H265LiveVideoServerMediaSubssion::createNew(UsageEnvironment& env, Boolean reuseFirstSource)
 {
@@ -29,5 +29,5 @@ FramedSource* H265LiveVideoServerMediaSubssion::createNewStreamSource(unsigned c
 	}
 
 	// Create a framer for the Video Elementary Stream:
-	return H265VideoStreamFramer::createNew(envir(), liveSource);
+	return H265VideoStreamDiscreteFramer::createNew(envir(), liveSource);
 }
@@ -20,73 +20,67 @@
 #include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
 #include <sys/shm.h>
 #include <sys/ipc.h>
 #include <sys/time.h>
+#include <sys/uio.h>
 #include <pthread.h>
 
 #include "avshare.h"
+#include "avshare_shm.h"
 #include "live_context.h"
 
-#define MEM_KEY 0x568066
-#define largeStreamSize		10*1024	//0x100000
-#define littleStreamSize	5*1024	//0x80000
-#define audioStreamSize		1*1024	//0x40000
-#define SHAREBUF_COUNT		56		//8*7
-
-#define RESET_IsConnect(p, num)	    {gAvshare.ptrConnect=p; memset(gAvshare.ptrConnect, 0, num);}
-#define CHECK_IsConnect(no)	        (gAvshare.ptrConnect[MEDIA_type2index(no)])
-#define SET_IsConnect(no, x)	    {gAvshare.ptrConnect[MEDIA_type2index(no)] = x; }
 #define MEDIA_type2index(t)         ((t)-MEDIA_VIDEO)
-#define CHECK_IsInitialized(ret)    {if(gAvshare.bufShare == NULL) return (ret);}
+#define CHECK_IsInitialized(ret)    {if(gAvshare.shm == NULL) return (ret);}
 
 #define FIFO_NAME    "rtspStream.fifo"//"/tmp/H264_fifo"
-#define MEDIA_NUM     2
 #define FIFO_EN       1
 
 #define SAVE_FILE_TEST  0
 #define SAVE_FILE_PATH  "/mnt/extsd/test_share_rx.264"
 
-#pragma pack(push)
-#pragma pack(1)
-
-typedef struct {
-	char wflag;     //ÊÇ·ñ¿ÉÐ´£¬µ±Îª0Ê±¿É¶Á²»¿ÉÐ´£¬¶ÁÈ¡½ø³Ì¶ÁÍêÖ®ºóÖÃ1£»µ±Îª1Ê±¿ÉÐ´²»¿É¶Á£¬Ð´Èë½ø³ÌÐ´ÍêºóÖÃ0¡£
-	char frameType; //ÊÓÆµÖ¡ÀàÐÍ£º IÖ¡:1 PÖ¡:0
-	char mediaType; //Ö¡ÀàÐÍ£ºvedio:0 audio:1
-	char buff_type;
-	uint64_t  timestamp;
-	int  length;
-} ShareStream_t;
-
-#pragma pack(pop)
-
-enum _BUFF_TYPE
+struct AvshareReader_s
 {
-	BUF_BEGIN,
-	BUF_MIDDLE,
-	BUF_END,
-	BUF_BEG_END,
+	int      index;         //ring
+	int      slot;
+	uint32_t cursor;
+	int      posNext;       //bytes of the current record already read
+	uint32_t seqNext;
+	bool     bSkipToKey;    //after a (re)connect, a lap or lost records
+	AvshareRecord_t hdrPeeked;
+
+	pthread_t     notifyThread;
+	volatile bool bNotifyExit;
+	CB_onAvshare  cbOnData;
+	void*         contextOnData;
+
+	AvshareLatency_t latency;
+	uint64_t         latencySumUs;
 };
 
 typedef struct
 {
 	int	id;
-	uint8_t* bufShare;
-	uint8_t* ptrConnect;
+	AvshareShm_t* shm;
+	int nbReaders;
+	pthread_mutex_t mutex;
 
-	ShareStream_t* bufStreamHead[MEDIA_NUM];
-    char * streamBuf[MEDIA_NUM][SHAREBUF_COUNT];
-	int idxNext[MEDIA_NUM];
-	int posNext[MEDIA_NUM];
+	//readers behind the media type based calls
+	AvshareReader_t* reader[AVSHARE_mediaNUM];
 #if(!FIFO_EN)
 	int fdPipe;
 #endif
-	//int readOffset;
 	int nFrames;
 	int nFrameI;
 	int nSPS;
 
+	//all readers of a media together, the A/V skew compares against it
+	AvshareLatency_t latency[AVSHARE_mediaNUM];
+	uint64_t         latencySumUs[AVSHARE_mediaNUM];
+	int64_t          wallOffsetUs;  //gettimeofday() - CLOCK_MONOTONIC
+
 #if(SAVE_FILE_TEST)
 	FILE*     fileTest;
     pthread_t threadId;
@@ -98,75 +92,56 @@ typedef struct
 //----------------------------------------------------------------------------------------------
 // global variables
 //----------------------------------------------------------------------------------------------
-AvshareInfo_t gAvshare = { -1, NULL, NULL };
+AvshareInfo_t gAvshare = { -1, NULL, 0, PTHREAD_MUTEX_INITIALIZER };
 
 //----------------------------------------------------------------------------------------------
 // avshare initialize
 //----------------------------------------------------------------------------------------------
-int avshare_init(void)
+static uint64_t avshare_tickUs(void)
 {
-    int j = 0;
-    int i = 0;
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ((uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
 
-	int SHARE_CAPACITY = (largeStreamSize + audioStreamSize + sizeof(ShareStream_t)*MEDIA_NUM)*SHAREBUF_COUNT + MEDIA_NUM;
+int avshare_init(void)
+{
+	struct timeval tv;
 
 	if(gAvshare.id != -1)
     {
-        //avshare_uninit();
-        //avshare_flush();
         return 0;
     }
 
-	memset(&gAvshare, 0, sizeof(gAvshare));
-    memset(gAvshare.streamBuf, 0, sizeof(gAvshare.streamBuf));
-
-	gAvshare.id = shmget( MEM_KEY, SHARE_CAPACITY, IPC_CREAT|0644 );
+	gAvshare.id = shmget( AVSHARE_memKEY, AVSHARE_shmSIZE, IPC_CREAT|0644 );
 	if( gAvshare.id < 0)
 	{
 		alogd("failed to create share memory\n");
+		gAvshare.id = -1;
 		return -1;
 	}
 
-	gAvshare.bufShare = (uint8_t*)shmat(gAvshare.id, NULL, 0);
-	if (gAvshare.bufShare == (void*)-1)
+	gAvshare.shm = (AvshareShm_t*)shmat(gAvshare.id, NULL, 0);
+	if (gAvshare.shm == (void*)-1)
 	{
 		alogd("get share mem address failed\n");
-		gAvshare.bufShare = NULL;
+		gAvshare.shm = NULL;
+		gAvshare.id = -1;
 		return -2;
 	}
 
-	RESET_IsConnect(gAvshare.bufShare, MEDIA_NUM);
- /*        ____________________________________________________________________________________________________
-  format:|connect |        (video + audio) header           |          (video + audio) stream                  |
-  bytes: |-2(v,a)-|-(sizeof(ShareStream_t)*2*SHAREBUF_COUNT-|-(largeStreamSize+audioStreamSize)*SHAREBUF_COUNT-|
- */
-
-	for(i=0; i<MEDIA_NUM; i++)
+	//the writer may not be running yet, magic is set once it is
+	if( gAvshare.shm->magic == AVSHARE_MAGIC && gAvshare.shm->version != AVSHARE_VERSION )
 	{
-		gAvshare.bufStreamHead[i] = (ShareStream_t*)(gAvshare.bufShare + MEDIA_NUM + i*sizeof(ShareStream_t)*SHAREBUF_COUNT);
-		for(j=0; j<SHAREBUF_COUNT; j++)
-		{
-			gAvshare.bufStreamHead[i][j].wflag = 1;
-		}
+		aloge("share memory version %d, expected %d\n", gAvshare.shm->version, AVSHARE_VERSION);
 	}
 
-	for(j=0; j<SHAREBUF_COUNT; j++)  //video
-	{
-		gAvshare.streamBuf[0][j] = (char*)(gAvshare.bufShare + MEDIA_NUM + sizeof(ShareStream_t)*SHAREBUF_COUNT*MEDIA_NUM + j*largeStreamSize);
-	}
+	//capture times are CLOCK_MONOTONIC, RTCP wants presentation times on the wall clock
+	gettimeofday(&tv, NULL);
+	gAvshare.wallOffsetUs = ((int64_t)tv.tv_sec * 1000000 + tv.tv_usec) - (int64_t)avshare_tickUs();
 
-	for(j=0; j<SHAREBUF_COUNT; j++)  //audio
-	{
-		gAvshare.streamBuf[1][j] = gAvshare.streamBuf[0][SHAREBUF_COUNT-1] + largeStreamSize + j*audioStreamSize;
-	}
-
-    for(i=0; i<MEDIA_NUM; i++)
-    {
-	    gAvshare.idxNext[i] = 0;
-	    gAvshare.posNext[i] = 0;
-    }
-
-	//alogd("bufShare=%x, countOfBuffer=%d\n", gAvshare.bufShare, SHAREBUF_COUNT);
 #if(!FIFO_EN)
     gAvshare.fdPipe = open(FIFO_NAME, O_RDONLY|O_NONBLOCK);
 #endif
@@ -178,15 +153,15 @@ int avshare_uninit(void)
 {
 	CHECK_IsInitialized(0);
 
-	if(shmdt(gAvshare.bufShare)==-1)
+	if( gAvshare.nbReaders > 0 )
 	{
-		aloge("remove share mem failed\n");
+		return 0;
 	}
 
-	if(0)//shmctl(gAvshare.id,IPC_RMID,NULL) == -1)//remove id
-  	{
-    	aloge("remove share mem ID failed\n");
- 	}
+	if(shmdt(gAvshare.shm)==-1)
+	{
+		aloge("remove share mem failed\n");
+	}
 
 #if(!FIFO_EN)
  	if(gAvshare.fdPipe >= 0)
@@ -197,7 +172,7 @@ int avshare_uninit(void)
 #endif
 
     gAvshare.id = -1;
-    gAvshare.bufShare = NULL;
+    gAvshare.shm = NULL;
 
    	alogd("uninit share memory\n");
 
@@ -205,414 +180,579 @@ int avshare_uninit(void)
 }
 
 //----------------------------------------------------------------------------------------------
-// avshare server
+// avshare reader
 //----------------------------------------------------------------------------------------------
-/*
-pstStream:流数据
-len:流数据长度
-frame_type: 1:I帧; 0:P帧，音频帧不生效，可默认赋值为0
-millis: 时间戳
-streamType: 0:大码流; 1:小码流; 2:音频流
-*/
+//restart at the newest key record still in the ring, else at the next one published
+static void avshare_resync(AvshareReader_t* reader)
+{
+	AvshareRing_t* ring = &gAvshare.shm->ring[reader->index];
+	uint32_t size = avshare_ringSize(reader->index);
+	uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+	uint32_t key = atomic_load_explicit(&ring->keyPos, memory_order_acquire);
+
+	reader->cursor = (head - key < size) ? key : head;
+	reader->posNext = 0;
+	reader->bSkipToKey = true;
+	gAvshare.shm->slot[reader->slot].nbResyncs++;
+}
 
-int avshare_add(uint8_t* pstStream, int len, FrameType_e frame_type, uint32_t millis, MediaType_e streamType)
+//the writer announces what it overwrites in reserve, copied bytes are good while it stays in reach
+static inline bool avshare_intact(AvshareReader_t* reader)
 {
-    int buff_size[MEDIA_NUM];
-	ShareStream_t* pStreamHead = NULL;
-	int data_send = 0;
-	int data_len = len;
-    int connect_flag = 0;
+	AvshareRing_t* ring = &gAvshare.shm->ring[reader->index];
 
-	buff_size[0] = largeStreamSize;
-	buff_size[1] = audioStreamSize;
+	atomic_thread_fence(memory_order_acquire);
+	return (atomic_load_explicit(&ring->reserve, memory_order_relaxed) - reader->cursor) <= avshare_ringSize(reader->index);
+}
 
-	CHECK_IsInitialized(-2);
+//claims a slot, a slot left behind by a dead process is taken over
+static int avshare_claimSlot(int index)
+{
+	uint32_t pid = (uint32_t)getpid();
+	int i;
 
-	while( data_len > 0)
+	for(i=0; i<AVSHARE_readerNUM; i++)
 	{
-        connect_flag = MEDIA_type2index(streamType);
-		pStreamHead = (ShareStream_t*)&gAvshare.bufStreamHead[connect_flag][gAvshare.idxNext[connect_flag]];
+		AvshareSlot_t* slot = &gAvshare.shm->slot[i];
+		uint32_t owner = atomic_load(&slot->owner);
 
-		if(!CHECK_IsConnect(streamType))
-		{
-			gAvshare.idxNext[connect_flag]= 0;
-			return -3;
+		if( (owner != 0) && ((kill(owner, 0) == 0) || (errno != ESRCH)) ) {
+			continue;
+		}
+		if( !atomic_compare_exchange_strong(&slot->owner, &owner, pid) ) {
+			continue;
 		}
 
-		int buffer_len = data_len;
-		if( buffer_len > buff_size[connect_flag] )
+		if( owner != 0 )
 		{
-			buffer_len = buff_size[connect_flag];
+			alogd("slot %d taken over from pid %u\n", i, owner);
+			atomic_fetch_and(&gAvshare.shm->ring[slot->media].readers, ~(1u << i));
 		}
+		slot->media = index;
+		slot->nbFrames = 0;
+		slot->nbDropped = 0;
+		slot->nbResyncs = 0;
+		slot->lagMax = 0;
 
-		//alogd("debug --share_stream_header[%d][%d]---AddToShareStream-1--%d,%d,%d,%d\n",streamType,indexOfBuf[streamType],pShareStreamHeader->wflag,streamType,pShareStreamHeader->frameType,frame_type);
-		//alogd("debug -----AddToShareStream-1--%d,%d,%d,%d\n",pShareStreamHeader->wflag,streamType,pShareStreamHeader->frameType,frame_type);
-		if(pStreamHead->wflag == 1)
-		{
-			pStreamHead->frameType = frame_type;
-			pStreamHead->timestamp = millis;
-			pStreamHead->mediaType = streamType;
+		return i;
+	}
 
-			memcpy((uint8_t*)gAvshare.streamBuf[connect_flag][gAvshare.idxNext[connect_flag]], pstStream+data_send, buffer_len);
+	return -1;
+}
 
-			pStreamHead->length    = buffer_len;
-			if( data_send == 0 )//begin
-			{
-				if( data_len > buff_size[connect_flag] )
-				{
-					pStreamHead->buff_type   = BUF_BEGIN;
-                    //alogd("frame begin %d\n", gAvshare.idxNext);
-				}
-				else
-				{
-					pStreamHead->buff_type   = BUF_BEG_END;
-                    //alogd("frame begin end %d\n", gAvshare.idxNext);
-				}
-			}
-			else
-			{
-				if( data_len > buff_size[connect_flag] )
-				{
-					pStreamHead->buff_type   = BUF_MIDDLE;
-				}
-				else
-				{
-					pStreamHead->buff_type   = BUF_END;
-                    //alogd("frame end %d\n", gAvshare.idxNext);
-				}
-			}
+AvshareReader_t* avshare_openReader(int media_type)
+{
+	int index = MEDIA_type2index(media_type);
+	AvshareReader_t* reader = NULL;
+	int slot;
 
-			pStreamHead->wflag = 0;
-			gAvshare.idxNext[connect_flag] = (gAvshare.idxNext[connect_flag]+1) % SHAREBUF_COUNT;
+	pthread_mutex_lock(&gAvshare.mutex);
+	if( avshare_init() != 0 ) {
+		goto done;
+	}
 
-			data_len -= buffer_len;
-			data_send += buffer_len;
-		}
-		else  //对有连接却没读取数据的情况做处理
-		{
-			return 1;
-		}
+	slot = avshare_claimSlot(index);
+	if( slot < 0 )
+	{
+		aloge("no free reader slot\n");
+		avshare_uninit();
+		goto done;
 	}
 
-	return 0;
+	reader = (AvshareReader_t*)calloc(1, sizeof(AvshareReader_t));
+	reader->index = index;
+	reader->slot = slot;
+	avshare_resync(reader);
+	gAvshare.shm->slot[slot].nbResyncs = 0;
+	gAvshare.nbReaders++;
+
+	//the writer publishes while any reader is connected
+	atomic_fetch_or(&gAvshare.shm->ring[index].readers, 1u << slot);
+
+	alogd("connect stream %d successfully, slot %d\n", media_type, slot);
+
+done:
+	pthread_mutex_unlock(&gAvshare.mutex);
+	return reader;
+}
+
+void avshare_closeReader(AvshareReader_t* reader)
+{
+	AvshareSlot_t* slot;
+
+	if( reader == NULL ) {
+		return;
+	}
+
+	avshare_readerNotifyStop(reader);
+
+	pthread_mutex_lock(&gAvshare.mutex);
+	slot = &gAvshare.shm->slot[reader->slot];
+	atomic_fetch_and(&gAvshare.shm->ring[reader->index].readers, ~(1u << reader->slot));
+	alogd("disconnect stream %d successfully, %u frames, %u dropped, %u resyncs, lag max %uKB\n",
+	      reader->index + MEDIA_VIDEO, slot->nbFrames, slot->nbDropped, slot->nbResyncs, slot->lagMax / 1024);
+	atomic_store(&slot->owner, 0);
+
+	free(reader);
+	gAvshare.nbReaders--;
+	avshare_uninit();
+	pthread_mutex_unlock(&gAvshare.mutex);
 }
 
-//-----------------------------------------------------------------------------------------------------------
-void avshare_addaud( unsigned char * buf, int len, uint32_t millis )
+void avshare_readerStats(AvshareReader_t* reader, AvshareReaderStats_t* stats)
 {
-#if(0)
-	//alogd("debug --------------1\n");
-	int ret=avshare_add(buf, len, 1, millis, 2); //  add to share memory, Audio stream
-	if(ret==1)
+	AvshareSlot_t* slot = &gAvshare.shm->slot[reader->slot];
+
+	stats->nbFrames = slot->nbFrames;
+	stats->nbDropped = slot->nbDropped;
+	stats->nbResyncs = slot->nbResyncs;
+	stats->lagMax = slot->lagMax;
+}
+
+//copies the header of the next record, NULL if there is none
+static AvshareRecord_t* avshare_peek(AvshareReader_t* reader, AvshareRecord_t* hdr)
+{
+	AvshareRing_t* ring = &gAvshare.shm->ring[reader->index];
+	AvshareSlot_t* slot = &gAvshare.shm->slot[reader->slot];
+	uint8_t* data = avshare_ringData(gAvshare.shm, reader->index);
+	uint32_t size = avshare_ringSize(reader->index);
+	uint32_t head, pos;
+	AvshareRecord_t* rec;
+
+	for(;;)
 	{
-		//buffer fuul, dropped
-		static int iDropped = 0;
+		head = atomic_load_explicit(&ring->head, memory_order_acquire);
+		if( reader->cursor == head ) {
+			return NULL;
+		}
+
+		//lapped, this reader is too slow for the others
+		if( head - reader->cursor > size )
+		{
+			avshare_resync(reader);
+			continue;
+		}
+
+		if( head - reader->cursor > slot->lagMax ) {
+			slot->lagMax = head - reader->cursor;
+		}
+
+		pos = reader->cursor & (size-1);
+		rec = (AvshareRecord_t*)(data + pos);
+		*hdr = *rec;
+		if( !avshare_intact(reader) )
+		{
+			avshare_resync(reader);
+			continue;
+		}
 
-		iDropped++;
-		if(iDropped >= 100)
+		if( hdr->len == AVSHARE_lenWRAP )
 		{
-			alogd("share buffer overflowed, dropped %d audio packets\n", iDropped);
+			reader->cursor += size - pos;
+			continue;
 		}
+
+		return rec;
 	}
-#endif
 }
 
-void avshare_addvid(uint8_t* pstStream, int len, FrameType_e frameType, uint32_t millis )
+static void avshare_pop(AvshareReader_t* reader, AvshareRecord_t* hdr)
 {
-	static int iDropped = 0;
-	int ret = 0;
+	reader->posNext = 0;
+	reader->seqNext = hdr->seq + 1;
+	reader->cursor += sizeof(AvshareRecord_t) + AVSHARE_align(hdr->len);
+	gAvshare.shm->slot[reader->slot].cursor = reader->cursor;
+}
 
-#if(SAVE_FILE_TEST)
-	if( gAvshare.fileTest == NULL ) {
-        gAvshare.fileTest = fopen(SAVE_FILE_PATH, "wb");
+//glass to RTP: from VI capture to the frame being handed to the RTP framer
+static void avshare_countLatency(AvshareLatency_t* latency, uint64_t* sumUs, uint32_t latencyUs)
+{
+	latency->nbFrames++;
+	latency->lastUs = latencyUs;
+	*sumUs += latencyUs;
+	latency->avgUs = *sumUs / latency->nbFrames;
+	if( latencyUs > latency->maxUs ) {
+		latency->maxUs = latencyUs;
+	}
+}
+
+static void avshare_frameDone(AvshareReader_t* reader, AvshareRecord_t* hdr)
+{
+	uint64_t now;
+
+	gAvshare.shm->slot[reader->slot].nbFrames++;
+
+	if( (hdr->captureUs == 0) || (hdr->frameType == FRAME_SPS) ) {
+		return;
 	}
-	if( gAvshare.fileTest != NULL ) {
-        fwrite(pstStream, len, 1, gAvshare.fileTest);
+
+	now = avshare_tickUs();
+	if( hdr->captureUs > now ) {
+		return;
+	}
+
+	avshare_countLatency(&reader->latency, &reader->latencySumUs, now - hdr->captureUs);
+	avshare_countLatency(&gAvshare.latency[reader->index], &gAvshare.latencySumUs[reader->index], now - hdr->captureUs);
+}
+
+static void avshare_resetLatency(AvshareLatency_t* latency, uint64_t* sumUs)
+{
+	memset(latency, 0, sizeof(AvshareLatency_t));
+	*sumUs = 0;
+}
+
+void avshare_readerLatency(AvshareReader_t* reader, AvshareLatency_t* latency, bool bReset)
+{
+	*latency = reader->latency;
+
+	if( bReset ) {
+		avshare_resetLatency(&reader->latency, &reader->latencySumUs);
+	}
+}
+
+void avshare_getLatency(int media_type, AvshareLatency_t* latency, bool bReset)
+{
+	int index = MEDIA_type2index(media_type);
+
+	*latency = gAvshare.latency[index];
+
+	if( bReset ) {
+		avshare_resetLatency(&gAvshare.latency[index], &gAvshare.latencySumUs[index]);
+	}
+}
+
+//one clock for audio and video: the capture time, moved onto the wall clock
+static bool avshare_captureTime(AvshareRecord_t* rec, struct timeval* timestamp)
+{
+	uint64_t us;
+
+	if( rec->captureUs == 0 ) {
+		return false;
 	}
-#endif
 
-	if(iDropped > 0)
+	us = rec->captureUs + gAvshare.wallOffsetUs;
+	timestamp->tv_sec = us / 1000000;
+	timestamp->tv_usec = us % 1000000;
+
+	return true;
+}
+
+//next record to hand out, skipping up to a key frame after a gap
+static AvshareRecord_t* avshare_nextFrame(AvshareReader_t* reader, AvshareRecord_t* hdr)
+{
+	AvshareSlot_t* slot = &gAvshare.shm->slot[reader->slot];
+	AvshareRecord_t* rec;
+
+	for(;;)
 	{
-		if(frameType != FRAME_I)
+		rec = avshare_peek(reader, hdr);
+		if( rec == NULL ) {
+			return NULL;
+		}
+
+		//the writer counts dropped frames as well, a gap breaks the reference chain
+		if( !reader->bSkipToKey && (hdr->seq != reader->seqNext) )
 		{
-			iDropped++;
-			return;
+			slot->nbDropped += hdr->seq - reader->seqNext;
+			reader->posNext = 0;
+			reader->bSkipToKey = true;
 		}
-		else
+
+		if( reader->bSkipToKey )
 		{
-			alogd("share buffer overflowed, dropped %d video packets\n", iDropped);
-			iDropped = 0;
+			if( (hdr->frameType != FRAME_SPS) && (hdr->frameType != FRAME_I) )
+			{
+				slot->nbDropped++;
+				avshare_pop(reader, hdr);
+				continue;
+			}
+			reader->bSkipToKey = false;
 		}
-	}
 
-	ret = avshare_add(pstStream, len, frameType, millis, MEDIA_VIDEO);// add to share memory
-	if( ret == 1 )
-	{
-		//buffer full, dropped a frame
-		iDropped++;
-	}
-	else if (0 == ret )
-	{
-		//added a frame
+		return rec;
 	}
 }
 
-void avshare_flush(void)
+static void avshare_frameTime(AvshareRecord_t* hdr, struct timeval* timestamp)
 {
-	int j;
-    int i;
+    if( !avshare_captureTime(hdr, timestamp) )
+    {
+        timestamp->tv_sec = (hdr->timestamp/1000);          //s
+        timestamp->tv_usec= ((hdr->timestamp%1000)*1000);   //us
+    }
+}
 
-	if(gAvshare.bufShare != NULL)
+static void avshare_frameRelease(AvshareReader_t* reader, AvshareRecord_t* hdr)
+{
+	gAvshare.nFrames++;
+	if( hdr->frameType == FRAME_I )   gAvshare.nFrameI++;
+	if( hdr->frameType == FRAME_SPS ) gAvshare.nSPS++;
+	avshare_frameDone(reader, hdr);
+	avshare_pop(reader, hdr);
+}
+
+int avshare_readerFrame(AvshareReader_t* reader, uint8_t*sFrameBuf, int nBufLen, struct timeval* timestamp, unsigned* uDurationInMicroseconds)
+{
+	AvshareRecord_t hdr;
+	AvshareRecord_t* rec;
+	int offset, copyLen;
+
+	for(;;)
 	{
-        for(i=0; i<MEDIA_NUM; i++)
-        {
-		    for(j=0; j<SHAREBUF_COUNT; j++)
-		    {
-		    	gAvshare.bufStreamHead[i][j].wflag = 1;
-		    }
-		    gAvshare.idxNext[i] = 0;
-            gAvshare.posNext[i] = 0;
-        }
+		rec = avshare_nextFrame(reader, &hdr);
+		if( rec == NULL ) {
+			return -1;
+		}
+
+		//a record larger than the caller's buffer is handed out over several calls
+		offset = reader->posNext;
+		copyLen = hdr.len - offset;
+		if( copyLen > nBufLen ) {
+			copyLen = nBufLen;
+		}
+		memcpy(sFrameBuf, (uint8_t*)(rec + 1) + offset, copyLen);
+
+		if( avshare_intact(reader) ) {
+			break;
+		}
+
+		//overwritten while copying
+		avshare_resync(reader);
 	}
+
+	avshare_frameTime(&hdr, timestamp);
+    *uDurationInMicroseconds = 0;
+
+	if( offset + copyLen >= (int)hdr.len ) {
+		avshare_frameRelease(reader, &hdr);
+	}
+	else {
+		reader->posNext = offset + copyLen;
+	}
+
+	return copyLen;
 }
 
 //----------------------------------------------------------------------------------------------
-// avshare client
+// zero copy: the frame is left in the ring, the caller takes what it needs from the iovec
 //----------------------------------------------------------------------------------------------
-int avshare_connect(int media_type)
+int avshare_readerPeekFrame(AvshareReader_t* reader, AvshareFrame_t* frame)
 {
-	if(!CHECK_IsConnect(media_type))
-	{
-		SET_IsConnect(media_type, 1);
-		gAvshare.idxNext[media_type] = 0;
+	AvshareRecord_t* rec = avshare_nextFrame(reader, &reader->hdrPeeked);
+
+	if( rec == NULL ) {
+		return -1;
 	}
 
-	alogd("connect stream %d successfully: %d\n", media_type, CHECK_IsConnect(media_type));
+	//records never wrap, a frame is always one contiguous piece of the ring
+	frame->iov.iov_base = rec + 1;
+	frame->iov.iov_len = reader->hdrPeeked.len;
+	frame->frameType = reader->hdrPeeked.frameType;
+	avshare_frameTime(&reader->hdrPeeked, &frame->timestamp);
 
 	return 0;
 }
 
-int avshare_disconnect(int media_type)
+//whatever was taken from the peeked frame is only good if the writer did not reach it meanwhile
+bool avshare_readerCheck(AvshareReader_t* reader)
 {
-	int i=0;
+	if( avshare_intact(reader) ) {
+		return true;
+	}
 
-	CHECK_IsInitialized(0);
-	SET_IsConnect(media_type, 0);
+	avshare_resync(reader);
+	return false;
+}
 
-	//sleep(1);
-	usleep(100);//ä¿è¯writeä¸åç»§ç»­ï¼åå° wflagé½ç½®ä¸º1ï¼writeçindexOfBufå°è¢«ç½®ä¸º0;
+void avshare_readerRelease(AvshareReader_t* reader)
+{
+	avshare_frameRelease(reader, &reader->hdrPeeked);
+}
+
+int avshare_readerAudio(AvshareReader_t* reader, uint8_t*sFrameBuf, int nBufLen, struct timeval* timestamp, unsigned* uDurationInMicroseconds)
+{
+	AvshareRecord_t hdr;
+	AvshareRecord_t* rec;
+	int audioLen;
 
-	for(i=0; i<SHAREBUF_COUNT; i++)
+	for(;;)
 	{
-		gAvshare.bufStreamHead[media_type][i].wflag = 1;
+		rec = avshare_peek(reader, &hdr);
+		if( rec == NULL ) {
+			return -1;
+		}
+
+		audioLen = 0;
+		if( (int)hdr.len <= nBufLen )
+		{
+			memcpy(sFrameBuf, rec + 1, hdr.len);
+			audioLen = hdr.len;
+		}
+		else
+		{
+			alogd("polldata audio err, out of buf size size=%d", hdr.len);
+		}
+
+		if( avshare_intact(reader) ) {
+			break;
+		}
+		avshare_resync(reader);
 	}
 
-	alogd("disconnect stream %d successfully\n", media_type);
+    if( !avshare_captureTime(&hdr, timestamp) )
+    {
+        timestamp->tv_sec = (hdr.timestamp/90000);     //s
+        timestamp->tv_usec = (hdr.timestamp*100/9);    //us
+    }
+    *uDurationInMicroseconds = 0;
 
-	return 0;
+	avshare_frameDone(reader, &hdr);
+	avshare_pop(reader, &hdr);
+
+	return audioLen;
 }
 
-int avshare_readFrame(uint8_t*sFrameBuf, int nBufLen, struct timeval* timestamp, unsigned* uDurationInMicroseconds)
+//----------------------------------------------------------------------------------------------
+// avshare notify, sleeps on the futex word the writer bumps after every record
+//----------------------------------------------------------------------------------------------
+static void* avshare_notifyProc(void* param)
 {
-	ShareStream_t* pStreamHead = NULL;
-	uint8_t* pStreamData = NULL;
-	uint8_t  mediaIndex = MEDIA_type2index(MEDIA_VIDEO);
-	FrameType_e frameType = FRAME_NUM;
-	int frameLen = 0;
-	int copyLen = 0;
-	int idxBuf = gAvshare.idxNext[mediaIndex];
-	uint32_t offset = gAvshare.posNext[mediaIndex];
-    int i = 0;
+	AvshareReader_t* reader = (AvshareReader_t*)param;
+	AvshareRing_t* ring = &gAvshare.shm->ring[reader->index];
+	uint32_t seen = atomic_load(&ring->futex);
+	uint32_t now;
 
-	CHECK_IsInitialized(0);
-    pStreamHead = (ShareStream_t*)&gAvshare.bufStreamHead[mediaIndex][idxBuf];
-
-	if( pStreamHead->wflag==1 )
+	while(!reader->bNotifyExit)
 	{
-		for(i=0; i<SHAREBUF_COUNT; i++)
-        {
-            idxBuf = (idxBuf+1) % SHAREBUF_COUNT;
-            pStreamHead = (ShareStream_t*)&gAvshare.bufStreamHead[mediaIndex][idxBuf];
-            if(pStreamHead->wflag != 1)
-            {
-                offset = 0;
-                break;
-            }
-        }
+		//pairs with the writer bumping futex before it checks sleepers
+		atomic_fetch_add(&ring->sleepers, 1);
+		if( atomic_load(&ring->futex) == seen ) {
+			avshare_futexWait(&ring->futex, seen, 100);
+		}
+		atomic_fetch_sub(&ring->sleepers, 1);
 
-		if( i>=SHAREBUF_COUNT )
-        {
-            gAvshare.idxNext[mediaIndex] = idxBuf;
-            gAvshare.posNext[mediaIndex] = 0;
-            return -1;
-        }
+		now = atomic_load(&ring->futex);
+		if( now != seen )
+		{
+			seen = now;
+			reader->cbOnData(reader->contextOnData);
+		}
 	}
 
-    timestamp->tv_sec = (pStreamHead->timestamp/1000);          //s
-    timestamp->tv_usec= ((pStreamHead->timestamp%1000)*1000);   //us
-    *uDurationInMicroseconds = 0;
+	return (void*)0;
+}
 
-    frameType = (FrameType_e)pStreamHead->frameType;
-    pStreamData = (uint8_t*)gAvshare.streamBuf[mediaIndex][idxBuf];
+int avshare_readerNotify(AvshareReader_t* reader, CB_onAvshare cbOnData, void* context)
+{
+	if( reader->notifyThread != 0 ) {
+		return 0;
+	}
 
-	do
-    {
-        copyLen = pStreamHead->length - offset;
-        if( frameLen + copyLen <= nBufLen )//MAXSTREAMBUF )
-        {
-            memcpy( sFrameBuf + frameLen, pStreamData + offset, copyLen );
-            frameLen += copyLen;
-        }
-        else
-        {
-            copyLen = nBufLen - frameLen;
-            memcpy( sFrameBuf + frameLen, pStreamData + offset, copyLen );
-            frameLen += copyLen;
-            offset += copyLen;
-            break;
-        }
+	reader->cbOnData = cbOnData;
+	reader->contextOnData = context;
+	reader->bNotifyExit = false;
+	if( pthread_create(&reader->notifyThread, NULL, avshare_notifyProc, reader) != 0 )
+	{
+		aloge("create notify thread failed\n");
+		reader->notifyThread = 0;
+		return -1;
+	}
 
-        pStreamHead->wflag = 1;
-        idxBuf = (idxBuf+1) % SHAREBUF_COUNT;
-        pStreamHead = (ShareStream_t*)&gAvshare.bufStreamHead[mediaIndex][idxBuf];;
-        pStreamData = (uint8_t*)gAvshare.streamBuf[mediaIndex][idxBuf];
-        offset = 0;
-    } while(pStreamHead->wflag != 1);
+	return 0;
+}
 
-    gAvshare.idxNext[mediaIndex] = idxBuf;
-    gAvshare.posNext[mediaIndex] = offset;
+void avshare_readerNotifyStop(AvshareReader_t* reader)
+{
+	if( reader->notifyThread == 0 ) {
+		return;
+	}
 
-	return frameLen;
+	reader->bNotifyExit = true;
+	pthread_join(reader->notifyThread, NULL);
+	reader->notifyThread = 0;
 }
 
-int avshare_readAudio(uint8_t*sFrameBuf, int nBufLen, struct timeval* timestamp, unsigned* uDurationInMicroseconds)
+//----------------------------------------------------------------------------------------------
+// avshare client, one reader per media behind the media type based calls
+//----------------------------------------------------------------------------------------------
+int avshare_connect(int media_type)
 {
-	ShareStream_t* pStreamHead = NULL;
-	uint8_t* pStreamData = NULL;
-	uint8_t  mediaIndex = MEDIA_type2index(MEDIA_AUDIO);
-	int audioLen = 0;
-	int idxBuf = gAvshare.idxNext[mediaIndex];
-    int bFrameEnd = 0;
-    int i = 0;
+	int index = MEDIA_type2index(media_type);
 
-	CHECK_IsInitialized(0);
-    pStreamHead = (ShareStream_t*)&gAvshare.bufStreamHead[mediaIndex][idxBuf];
+	if( gAvshare.reader[index] == NULL ) {
+		gAvshare.reader[index] = avshare_openReader(media_type);
+	}
 
-	if( pStreamHead->wflag==1 )
-	{
-		for(i=0; i<SHAREBUF_COUNT; i++)
-        {
-            idxBuf = (idxBuf+1) % SHAREBUF_COUNT;
-            pStreamHead = (ShareStream_t*)&gAvshare.bufStreamHead[mediaIndex][idxBuf];
-            if(pStreamHead->wflag != 1)
-            {
-                break;
-            }
-        }
+	return (gAvshare.reader[index] != NULL) ? 0 : -1;
+}
 
-		if( i>=SHAREBUF_COUNT )
-        {
-            //alogd("No frame to be sent...\n");
-            if(audioLen <= 0)
-            {
-                gAvshare.idxNext[mediaIndex] = idxBuf;
-            }
+int avshare_disconnect(int media_type)
+{
+	int index = MEDIA_type2index(media_type);
 
-            return -1;
-        }
-	}
-	if( (pStreamHead->buff_type != BUF_BEGIN)  && (pStreamHead->buff_type != BUF_BEG_END) )
-	{
-		alogd("No audio frame start found... %d-%d\n", idxBuf, pStreamHead->buff_type);
-        pStreamHead->wflag = 1;
-        idxBuf = (idxBuf+1) % SHAREBUF_COUNT;
-        if(audioLen <= 0)
-        {
-            gAvshare.idxNext[mediaIndex] = idxBuf;
-        }
+	avshare_closeReader(gAvshare.reader[index]);
+	gAvshare.reader[index] = NULL;
 
-		return -2;
-	}
+	return 0;
+}
 
-    timestamp->tv_sec = (pStreamHead->timestamp/90000);     //s
-    timestamp->tv_usec = (pStreamHead->timestamp*100/9);    //us
-    *uDurationInMicroseconds = 0;
+//drop everything queued and wait for the next key frame
+void avshare_flush(void)
+{
+    int i;
 
-	while(bFrameEnd == 0)
+    for(i=0; i<AVSHARE_mediaNUM; i++)
     {
+        AvshareReader_t* reader = gAvshare.reader[i];
 
-        pStreamData = (uint8_t*)gAvshare.streamBuf[mediaIndex][idxBuf];
-        //sendBuf = streamBuf[stream][indexOfBuf[stream]];
-        if( audioLen + pStreamHead->length <= nBufLen )//MAXSTREAMBUF )
-        {
-            memcpy( sFrameBuf + audioLen, pStreamData, pStreamHead->length );
-            audioLen += pStreamHead->length;
-        }
-        else
-        {
-            alogd("polldata audio err, out of buf size size=%d", audioLen + pStreamHead->length );
+        if( reader != NULL ) {
+            reader->cursor = atomic_load_explicit(&gAvshare.shm->ring[i].head, memory_order_acquire);
+            reader->posNext = 0;
+            reader->bSkipToKey = true;
         }
+    }
+}
 
-        if( (pStreamHead->buff_type == BUF_END) || (pStreamHead->buff_type == BUF_BEG_END) )
-        {
-            //a whole frame found
-            //alogd("frame buffer %d - %d\n", gAvshare.idxNext, idxBuf);
-            bFrameEnd = 1;
-        }
+int avshare_readFrame(uint8_t*sFrameBuf, int nBufLen, struct timeval* timestamp, unsigned* uDurationInMicroseconds)
+{
+	AvshareReader_t* reader = gAvshare.reader[MEDIA_type2index(MEDIA_VIDEO)];
 
-        idxBuf = (idxBuf+1) % SHAREBUF_COUNT;
-        if(!bFrameEnd)
-        {
-            pStreamHead = (ShareStream_t*)&gAvshare.bufStreamHead[mediaIndex][idxBuf];;
-            if( pStreamHead->wflag==1 )
-            {
-                //not a complete frame
-                bFrameEnd = 2;
-            }
-            else if(idxBuf == gAvshare.idxNext[mediaIndex])
-            {
-                //buffer empty
-                bFrameEnd = 3;
-            }
-        }
-    }
+	if( reader == NULL ) {
+		return 0;
+	}
 
-    if(bFrameEnd == 1)
-    {
-        //alogd("audioLen - %d, timestamp - %d / %d\n", audioLen, (timestamp->tv_usec-timestampLast.tv_usec), \
-        //          (fTimeNow.tv_usec-fTimeLast.tv_usec));
+	return avshare_readerFrame(reader, sFrameBuf, nBufLen, timestamp, uDurationInMicroseconds);
+}
 
-        //release frame buffers
-        if(idxBuf < gAvshare.idxNext[mediaIndex])
-        {
-            for(i=gAvshare.idxNext[mediaIndex]; i<SHAREBUF_COUNT; i++)
-            {
-                pStreamHead = (ShareStream_t*)&gAvshare.bufStreamHead[mediaIndex][i];
-                pStreamHead->wflag = 1;
-            }
-            for(i=0; i<idxBuf; i++)
-            {
-                pStreamHead = (ShareStream_t*)&gAvshare.bufStreamHead[mediaIndex][i];
-                pStreamHead->wflag = 1;
-            }
-        }
-        else
-        {
-            for(i=gAvshare.idxNext[mediaIndex]; i<idxBuf; i++)
-            {
-                pStreamHead = (ShareStream_t*)&gAvshare.bufStreamHead[mediaIndex][i];
-                pStreamHead->wflag = 1;
-            }
-        }
+int avshare_readAudio(uint8_t*sFrameBuf, int nBufLen, struct timeval* timestamp, unsigned* uDurationInMicroseconds)
+{
+	AvshareReader_t* reader = gAvshare.reader[MEDIA_type2index(MEDIA_AUDIO)];
 
-        gAvshare.idxNext[mediaIndex] = idxBuf;
-    }
-    else
-    {
-        audioLen = 0;
-    }
+	if( reader == NULL ) {
+		return 0;
+	}
 
-	return audioLen;
+	return avshare_readerAudio(reader, sFrameBuf, nBufLen, timestamp, uDurationInMicroseconds);
+}
+
+int avshare_notifyStart(int media_type, CB_onAvshare cbOnData, void* context)
+{
+	AvshareReader_t* reader = gAvshare.reader[MEDIA_type2index(media_type)];
+
+	if( reader == NULL ) {
+		return -1;
+	}
+
+	return avshare_readerNotify(reader, cbOnData, context);
+}
+
+void avshare_notifyStop(int media_type)
+{
+	AvshareReader_t* reader = gAvshare.reader[MEDIA_type2index(media_type)];
+
+	if( reader != NULL ) {
+		avshare_readerNotifyStop(reader);
+	}
 }
 
 #if(SAVE_FILE_TEST)
@@ -653,8 +793,9 @@ void* avshare_task(void * param)
 
 bool avshare_start(void)
 {
-    avshare_init();
-    avshare_connect(MEDIA_VIDEO);
+    if( avshare_connect(MEDIA_VIDEO) != 0 ) {
+        return false;
+    }
 
 #if(SAVE_FILE_TEST)
     gAvshare.bExit = false;
@@ -666,11 +807,6 @@ bool avshare_start(void)
 
 void avshare_stop(void)
 {
-    if( gAvshare.bufShare == NULL ) {
-        return;
-    }
-
-    avshare_disconnect(MEDIA_VIDEO);
 #if(SAVE_FILE_TEST)
     if( gAvshare.threadId != 0 ) {
         gAvshare.bExit = true;
@@ -678,5 +814,6 @@ void avshare_stop(void)
         gAvshare.threadId = 0;
     }
 #endif
-    avshare_uninit();
+    avshare_disconnect(MEDIA_VIDEO);
+    avshare_disconnect(MEDIA_AUDIO);
 }
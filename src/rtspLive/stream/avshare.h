@@ -22,6 +22,8 @@ extern "C" {
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <sys/time.h>
+#include <sys/uio.h>
 
 #define  MAXSTREAMBUF 1024*1024   //65535 * 12
 
@@ -41,9 +43,6 @@ typedef enum
 	FRAME_NUM,
 } FrameType_e;
 
-int  avshare_add(uint8_t* pstStream, int len, FrameType_e frame_type, uint32_t millis, MediaType_e streamType);
-void avshare_addaud(uint8_t * buf, int len, uint32_t millis );
-void avshare_addvid(uint8_t* pstStream, int len, FrameType_e frameType, uint32_t millis);
 void avshare_flush(void);
 
 int  avshare_init(void);
@@ -58,9 +57,56 @@ int  avshare_readAudio(uint8_t* sFrameBuf, int nLen, struct timeval* timestamp,
 int  avshare_readFrame2(uint8_t*sFrameBuf, int nBufLen, uint32_t* timestamp);
 int  avshare_readPipe(uint8_t* sFrameBuf, int nLen);
 
+typedef void (*CB_onAvshare)(void* context);
+
+typedef struct
+{
+	uint32_t nbFrames;
+	uint32_t avgUs;
+	uint32_t maxUs;
+	uint32_t lastUs;
+} AvshareLatency_t;
+
+typedef struct
+{
+	uint32_t nbFrames;
+	uint32_t nbDropped;
+	uint32_t nbResyncs;
+	uint32_t lagMax;    //bytes
+} AvshareReaderStats_t;
+
+int  avshare_notifyStart(int media_type, CB_onAvshare cbOnData, void* context);
+void avshare_notifyStop(int media_type);
+void avshare_getLatency(int media_type, AvshareLatency_t* latency, bool bReset);
+
 bool avshare_start(void);
 void avshare_stop(void);
 
+/* independent readers: RTSP clients, local taps, test tools, each with its own cursor */
+typedef struct AvshareReader_s AvshareReader_t;
+
+AvshareReader_t* avshare_openReader(int media_type);
+void avshare_closeReader(AvshareReader_t* reader);
+int  avshare_readerFrame(AvshareReader_t* reader, uint8_t* sFrameBuf, int nLen, struct timeval* timestamp, unsigned* fDurationInMicroseconds);
+int  avshare_readerAudio(AvshareReader_t* reader, uint8_t* sFrameBuf, int nLen, struct timeval* timestamp, unsigned* fDurationInMicroseconds);
+int  avshare_readerNotify(AvshareReader_t* reader, CB_onAvshare cbOnData, void* context);
+void avshare_readerNotifyStop(AvshareReader_t* reader);
+void avshare_readerLatency(AvshareReader_t* reader, AvshareLatency_t* latency, bool bReset);
+void avshare_readerStats(AvshareReader_t* reader, AvshareReaderStats_t* stats);
+
+/* zero copy read: iov points into the shared ring until avshare_readerRelease(),
+   avshare_readerCheck() tells whether what was taken from it is still valid */
+typedef struct
+{
+	struct iovec   iov;
+	int            frameType;
+	struct timeval timestamp;
+} AvshareFrame_t;
+
+int  avshare_readerPeekFrame(AvshareReader_t* reader, AvshareFrame_t* frame);
+bool avshare_readerCheck(AvshareReader_t* reader);
+void avshare_readerRelease(AvshareReader_t* reader);
+
 #ifdef __cplusplus
 }
 #endif
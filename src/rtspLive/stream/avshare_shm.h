@@ -0,0 +1,112 @@
+/******************************************************************************
+  File Name     : avshare_shm.h
+  Description   : layout of the shared memory between record (writer) and
+                  its readers (rtspLive, local taps). src/record and
+                  src/rtspLive/stream keep identical copies of this file.
+
+  Every media has a single writer, multi reader ring of variable length
+  records. head is a free running byte counter; the writer never waits for
+  readers, it announces the bytes it is about to overwrite in reserve first,
+  then fills them and publishes head with a release store. Every reader owns
+  a slot with its own cursor: it copies a record out, then checks reserve to
+  make sure the bytes were not overwritten meanwhile. A reader lapped by the
+  writer resyncs to keyPos, the newest SPS/IDR still in the ring.
+
+  The writer bumps the futex word after every record and wakes the readers
+  only when one of them announced that it is about to sleep on it.
+******************************************************************************/
+#pragma once
+
+#include <linux/futex.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define AVSHARE_memKEY      0x568067
+#define AVSHARE_MAGIC       0x48535641          //"AVSH"
+#define AVSHARE_VERSION     3
+
+#define AVSHARE_mediaNUM    2                   //video, audio
+#define AVSHARE_readerNUM   8
+#define AVSHARE_videoSIZE   (1024 * 1024)       //power of 2
+#define AVSHARE_audioSIZE   (64 * 1024)         //power of 2
+#define AVSHARE_dataOFFSET  4096
+#define AVSHARE_shmSIZE     (AVSHARE_dataOFFSET + AVSHARE_videoSIZE + AVSHARE_audioSIZE)
+
+#define AVSHARE_lenWRAP     0xFFFFFFFF          //rest of the ring is unused, go on at its start
+#define AVSHARE_align(n)    (((n) + 7) & ~7)
+
+/* every record is followed by its payload, padded to 8 bytes */
+typedef struct
+{
+    uint32_t len;
+    uint32_t seq;               //per media, gaps mean dropped frames
+    uint8_t  frameType;
+    uint8_t  mediaType;
+    uint16_t reserved0;
+    uint32_t reserved1;
+    uint64_t timestamp;
+    uint64_t captureUs;         //CLOCK_MONOTONIC at capture, 0 if unknown
+} AvshareRecord_t;
+
+typedef struct
+{
+    _Atomic uint32_t head;      //writer, end of the published records
+    _Atomic uint32_t reserve;   //writer, end of the record being written
+    _Atomic uint32_t keyPos;    //writer, start of the newest key record
+    uint32_t         seq;       //writer, sequence of the next record
+    uint32_t         dropped;   //writer, frames too large for the ring
+    _Atomic uint32_t futex;     //writer, incremented after every record
+    uint8_t          pad0[40];
+
+    _Atomic uint32_t readers;   //readers, bit per connected slot, writer only writes while set
+    _Atomic uint32_t sleepers;  //readers, waiting on futex
+    uint8_t          pad1[56];
+} AvshareRing_t;
+
+/* owned by one reader, the writer does not look at it */
+typedef struct
+{
+    _Atomic uint32_t owner;     //pid, 0 when free
+    uint32_t         media;     //ring index
+    uint32_t         cursor;
+    uint32_t         nbFrames;
+    uint32_t         nbDropped; //frames skipped after being lapped or on gaps
+    uint32_t         nbResyncs;
+    uint32_t         lagMax;    //bytes behind head
+    uint8_t          pad[36];
+} AvshareSlot_t;
+
+typedef struct
+{
+    uint32_t      magic;
+    uint32_t      version;
+    uint8_t       pad[56];
+    AvshareRing_t ring[AVSHARE_mediaNUM];
+    AvshareSlot_t slot[AVSHARE_readerNUM];
+} AvshareShm_t;
+
+static inline uint32_t avshare_ringSize(int index)
+{
+    return (index == 0) ? AVSHARE_videoSIZE : AVSHARE_audioSIZE;
+}
+
+static inline uint8_t* avshare_ringData(AvshareShm_t* shm, int index)
+{
+    return (uint8_t*)shm + AVSHARE_dataOFFSET + ((index == 0) ? 0 : AVSHARE_videoSIZE);
+}
+
+/* process shared futex, the word lives in the shm segment */
+static inline int avshare_futexWait(_Atomic uint32_t* word, uint32_t val, int timeoutMs)
+{
+    struct timespec ts = {timeoutMs / 1000, (timeoutMs % 1000) * 1000000};
+
+    return syscall(SYS_futex, word, FUTEX_WAIT, val, &ts, NULL, 0);
+}
+
+static inline int avshare_futexWake(_Atomic uint32_t* word)
+{
+    return syscall(SYS_futex, word, FUTEX_WAKE, 0x7FFFFFFF, NULL, NULL, 0);
+}
@@ -10,11 +10,17 @@
 #define SEC_H264_LIVE   "h264_live"
 #define SEC_H265_LIVE   "h265_live"
 #define SEC_VENC_LIVE   "venc_live"
+#define SEC_AI          "ai"
+#define SEC_AENC        "aenc"
 
 #define KEY_H265        "h265"
 #define KEY_NAME        "name"
 #define KEY_PORT        "port"
 #define KEY_MULITCAST   "multicast"
+#define KEY_AUDIO       "audio"
+#define KEY_sampleRATE  "sample_rate"
+#define KEY_CHANNELS    "channels"
+#define KEY_AAC         "aac"
 
 #define sizearray(a)  (sizeof(a) / sizeof((a)[0]))
 #define check_set(v, min, max)  ( ((v)<(min)) ? (min) : (((v)>(max)) ? (max) : (v)) )
@@ -41,4 +47,17 @@ void conf_loadLiveParams(LiveContext_t* liveCtx)
 
     lValue = ini_getbool(sSection, KEY_MULITCAST, LIVE_rtspMULTICAST, confFile);
     liveCtx->IsMulticast = (lValue > 0);
+
+    lValue = ini_getbool(sSection, KEY_AUDIO, LIVE_audioENABLE, confFile);
+    liveCtx->audio = (lValue > 0);
+
+    //only AAC is streamed
+    lValue = ini_getbool(SEC_AENC, KEY_AAC, true, confFile);
+    liveCtx->audio = liveCtx->audio && (lValue > 0);
+
+    lValue = ini_getl(SEC_AI, KEY_sampleRATE, LIVE_audioRATE, confFile);
+    liveCtx->audioSampleRate = check_set(lValue, 8000, 96000);
+
+    lValue = ini_getl(SEC_AI, KEY_CHANNELS, LIVE_audioCHANNELS, confFile);
+    liveCtx->audioChannels = check_set(lValue, 1, 2);
 }
@@ -23,6 +23,9 @@
 #define LIVE_streamNAME     "hdzero"
 #define LIVE_rtspPORT       8554
 #define LIVE_rtspMULTICAST  true
+#define LIVE_audioENABLE    true
+#define LIVE_audioRATE      48000
+#define LIVE_audioCHANNELS  2
 
 #define ZeroMemory(p, size) memset(p, 0, size)
 
@@ -39,6 +42,11 @@ typedef struct
     bool       runThread;
     uint16_t   port;
 
+    //AAC track, same settings as the record app's [ai]
+    bool       audio;
+    int        audioSampleRate;
+    int        audioChannels;
+
     //live thread
     pthread_mutex_t mutex;
     pthread_t   threadId;
@@ -10,6 +10,7 @@
 
 #include "core/app_state.h"
 #include "core/battery.h"
+#include "core/channel_monitor.h"
 #include "core/common.hh"
 #include "driver/dm5680.h"
 #include "driver/hardware.h"
@@ -91,6 +92,7 @@ static lv_obj_t *page_analog_rssi_create(lv_obj_t *parent, panel_arr_t *arr) {
 }
 
 static void on_enter() {
+    channel_monitor_join();
     rtc6715.init(1, 0);
     rtc6715.set_ch(33); // R1
 }
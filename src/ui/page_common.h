@@ -8,7 +8,6 @@ extern "C" {
 #include "ui/ui_style.h"
 
 #define TMP_DIR             "/tmp"
-#define AUDIO_SEL_SH        "/mnt/app/script/audio_sel.sh"
 #define SETTING_INI_VERSION 1
 #ifndef EMULATOR_BUILD
 #define SETTING_INI "/mnt/app/setting.ini"
@@ -6,6 +6,7 @@
 #include "../conf/ui.h"
 
 #include "core/app_state.h"
+#include "core/channel_monitor.h"
 #include "core/common.hh"
 #include "driver/hardware.h"
 #include "driver/screen.h"
@@ -114,6 +115,7 @@ static void page_imagesettings_enter() {
     app_state_push(APP_STATE_IMS);
     if (SOURCE_HDZERO == g_source_info.source) {
         progress_bar.start = 1;
+        channel_monitor_join();
         HDZero_open(g_setting.source.hdzero_bw);
         app_switch_to_hdzero(true);
         g_bShowIMS = true;
@@ -8,6 +8,7 @@
 #include "../conf/ui.h"
 
 #include "core/app_state.h"
+#include "core/channel_monitor.h"
 #include "core/common.hh"
 #include "core/osd.h"
 #include "driver/hardware.h"
@@ -108,6 +109,7 @@ void page_osd_update_ui_elements() {
 static void open_element_pos_preview() {
     if (SOURCE_HDZERO == g_source_info.source) {
         progress_bar.start = 1;
+        channel_monitor_join();
         HDZero_open(g_setting.source.hdzero_bw);
         app_switch_to_hdzero(true);
     } else if (SOURCE_HDMI_IN == g_source_info.source) {
@@ -17,6 +17,7 @@
 #include "core/app_state.h"
 #include "core/osd.h"
 #include "lang/language.h"
+#include "record/dvr_index.h"
 #include "record/record_definitions.h"
 #include "ui/page_common.h"
 #include "ui/ui_player.h"
@@ -135,7 +136,7 @@ static lv_obj_t *page_playback_create(lv_obj_t *parent, panel_arr_t *arr) {
     return page;
 }
 
-static void show_pb_item(uint8_t pos, char *label, bool star) {
+static void show_pb_item(uint8_t pos, char *label, bool star, bool thumb) {
     char fname[256];
     if (pb_ui[pos].state == ITEM_STATE_INVISIBLE) {
         lv_obj_add_flag(pb_ui[pos]._img, LV_OBJ_FLAG_HIDDEN);
@@ -153,9 +154,8 @@ static void show_pb_item(uint8_t pos, char *label, bool star) {
     lv_obj_set_pos(pb_ui[pos]._label, labelPosX, labelPosY);
     lv_obj_set_pos(pb_ui[pos]._arrow, labelPosX - lv_obj_get_width(pb_ui[pos]._arrow) - 5, labelPosY);
 
-    snprintf(fname, sizeof(fname), "%s/%s." REC_packJPG, TMP_DIR, label);
-    if (fs_file_exists(fname))
-        snprintf(fname, sizeof(fname), "A:%s/%s." REC_packJPG, TMP_DIR, label);
+    if (thumb)
+        snprintf(fname, sizeof(fname), "A:%s%s." REC_packJPG, MEDIA_FILES_DIR, label);
     else
         osd_resource_path(fname, "%s", OSD_RESOURCE_720, DEF_VIDEOICON);
     lv_img_set_src(pb_ui[pos]._img, fname);
@@ -201,16 +201,24 @@ static bool get_seleteced(int seq, char *fname) {
     return true;
 }
 
-int hot_alphasort(const struct dirent **a, const struct dirent **b) {
-    const bool a_hot = strncmp((*a)->d_name, REC_hotPREFIX, 4) == 0;
-    const bool b_hot = strncmp((*b)->d_name, REC_hotPREFIX, 4) == 0;
+static int hot_namecmp(const char *a, const char *b) {
+    const bool a_hot = strncmp(a, REC_hotPREFIX, 4) == 0;
+    const bool b_hot = strncmp(b, REC_hotPREFIX, 4) == 0;
     if (a_hot && !b_hot) {
         return -1;
     }
     if (!a_hot && b_hot) {
         return 1;
     }
-    return strcoll((*a)->d_name, (*b)->d_name);
+    return strcoll(a, b);
+}
+
+int hot_alphasort(const struct dirent **a, const struct dirent **b) {
+    return hot_namecmp((*a)->d_name, (*b)->d_name);
+}
+
+static int hot_entrycmp(const void *a, const void *b) {
+    return hot_namecmp(((const DvrIndexEntry_t *)a)->sName, ((const DvrIndexEntry_t *)b)->sName);
 }
 
 static bool dvr_has_stars(const char *filename) {
@@ -220,62 +228,119 @@ static bool dvr_has_stars(const char *filename) {
     return fs_file_exists(star_file);
 }
 
+static bool is_video_file(const char *filename) {
+    const char *dot = strrchr(filename, '.');
+    if (filename[0] == '.' || dot == NULL) {
+        return false;
+    }
+
+    return strcasecmp(dot, "." REC_packTS) == 0 || strcasecmp(dot, "." REC_packMP4) == 0;
+}
+
+static void add_media_file(const DvrIndexEntry_t *entry) {
+    const char *dot = strrchr(entry->sName, '.');
+    const int size = entry->size >> 20; // in MB
+
+    if (size < 5) {
+        // skip small files
+        return;
+    }
+
+    if (media_db.count >= MAX_VIDEO_FILES) {
+        LOGI("max video file cnt reached %d,skipped", MAX_VIDEO_FILES);
+        return;
+    }
+
+    media_file_node_t *pnode = &media_db.list[media_db.count];
+    ZeroMemory(pnode->filename, sizeof(pnode->filename));
+    ZeroMemory(pnode->label, sizeof(pnode->label));
+    ZeroMemory(pnode->ext, sizeof(pnode->ext));
+    strncpy(pnode->filename, entry->sName, sizeof(pnode->filename) - 1);
+    strncpy(pnode->label, entry->sName, dot - entry->sName);
+    strncpy(pnode->ext, dot + 1, sizeof(pnode->ext) - 1);
+    pnode->star = (entry->flags & DVRIDX_flagSTAR) != 0;
+    pnode->thumb = entry->thumbSize > 0;
+    pnode->size = size;
+
+    LOGI("%d: %s-%dMB", media_db.count, pnode->filename, size);
+
+    media_db.count++;
+}
+
+// the index the recorder keeps, fails when it is missing or out of date
+static bool walk_index() {
+    DvrIndex_t idx;
+    if (dvridx_load(MEDIA_FILES_DIR, &idx) != 0) {
+        return false;
+    }
+
+    qsort(idx.entries, idx.nbEntries, sizeof(DvrIndexEntry_t), hot_entrycmp);
+    for (int i = 0; i < idx.nbEntries; i++) {
+        DvrIndexEntry_t *entry = &idx.entries[i];
+        if (!is_video_file(entry->sName)) {
+            continue;
+        }
+        if (entry->flags & DVRIDX_flagPARTIAL) {
+            // never closed, what made it to the card
+            char fname[512];
+            snprintf(fname, sizeof(fname), "%s%s", MEDIA_FILES_DIR, entry->sName);
+            entry->size = fs_filesize(fname);
+        }
+        add_media_file(entry);
+    }
+
+    if (dvridx_sparse(&idx)) {
+        dvridx_rebuild(MEDIA_FILES_DIR, idx.entries, idx.nbEntries);
+    }
+    dvridx_free(&idx);
+
+    return true;
+}
+
 static int walk_sdcard() {
     char fname[512];
 
     media_db.count = 0;
     media_db.cur_sel = 0;
 
+    if (walk_index()) {
+        return media_db.count;
+    }
+
     struct dirent **namelist;
     int count = scandir(MEDIA_FILES_DIR, &namelist, NULL, hot_alphasort);
     if (count == -1) {
         return 0;
     }
 
+    // everything found goes into a fresh index, so the next visit is quick
+    DvrIndexEntry_t *entries = (DvrIndexEntry_t *)calloc(count > 0 ? count : 1, sizeof(DvrIndexEntry_t));
+    int nbEntries = 0;
+
     for (size_t i = 0; i < count; i++) {
         struct dirent *in_file = namelist[i];
-        if (in_file->d_name[0] == '.') {
+        if (!is_video_file(in_file->d_name) || strlen(in_file->d_name) >= DVRIDX_nameLEN) {
             continue;
         }
 
-        const char *dot = strrchr(in_file->d_name, '.');
-        if (dot == NULL) {
-            // '.' not found
-            continue;
-        }
-
-        if (strcasecmp(dot, "." REC_packTS) != 0 && strcasecmp(dot, "." REC_packMP4) != 0) {
-            continue;
-        }
+        DvrIndexEntry_t entry;
+        ZeroMemory(&entry, sizeof(entry));
+        strcpy(entry.sName, in_file->d_name);
 
         snprintf(fname, sizeof(fname), "%s%s", MEDIA_FILES_DIR, in_file->d_name);
-
-        long size = fs_filesize(fname);
-        size >>= 20; // in MB
-        if (size < 5) {
-            // skip small files
-            continue;
-        }
-
-        if (media_db.count >= MAX_VIDEO_FILES) {
-            LOGI("max video file cnt reached %d,skipped", MAX_VIDEO_FILES);
-            continue;
+        entry.size = fs_filesize(fname);
+        if (dvr_has_stars(fname)) {
+            entry.flags |= DVRIDX_flagSTAR;
         }
 
-        media_file_node_t *pnode = &media_db.list[media_db.count];
-        ZeroMemory(pnode->filename, sizeof(pnode->filename));
-        ZeroMemory(pnode->label, sizeof(pnode->label));
-        ZeroMemory(pnode->ext, sizeof(pnode->ext));
-        strcpy(pnode->filename, in_file->d_name);
-        strncpy(pnode->label, in_file->d_name, dot - in_file->d_name);
-        strcpy(pnode->ext, dot + 1);
-        pnode->star = dvr_has_stars(fname);
-
-        pnode->size = size;
-
-        LOGI("%d: %s-%dMB", media_db.count, pnode->filename, size);
+        const char *dot = strrchr(in_file->d_name, '.');
+        snprintf(fname, sizeof(fname), "%s%.*s." REC_packJPG, MEDIA_FILES_DIR, (int)(dot - in_file->d_name), in_file->d_name);
+        entry.thumbSize = fs_filesize(fname);
 
-        media_db.count++;
+        add_media_file(&entry);
+        if (entries) {
+            entries[nbEntries++] = entry;
+        }
     }
 
     for (size_t i = 0; i < count; i++) {
@@ -283,9 +348,10 @@ static int walk_sdcard() {
     }
     free(namelist);
 
-    // copy all thumbnail files to /tmp
-    snprintf(fname, sizeof(fname), "cp %s*." REC_packJPG " %s", MEDIA_FILES_DIR, TMP_DIR);
-    system_exec(fname);
+    if (entries) {
+        dvridx_rebuild(MEDIA_FILES_DIR, entries, nbEntries);
+        free(entries);
+    }
 
     return media_db.count;
 }
@@ -350,10 +416,10 @@ static void update_page() {
             else
                 pb_ui[i].state = ITEM_STATE_INVISIBLE;
 
-            show_pb_item(i, pnode->label, pnode->star);
+            show_pb_item(i, pnode->label, pnode->star, pnode->thumb);
         } else {
             pb_ui[i].state = ITEM_STATE_INVISIBLE;
-            show_pb_item(i, NULL, false);
+            show_pb_item(i, NULL, false, false);
         }
     }
 }
@@ -395,6 +461,9 @@ static void mark_video_file(int const seq) {
     snprintf(cmd, sizeof(cmd), "mv %s%s" REC_starSUFFIX " %s%s.%s" REC_starSUFFIX, MEDIA_FILES_DIR, pnode->filename, MEDIA_FILES_DIR, newLabel, pnode->ext);
     system_exec(cmd);
 
+    snprintf(cmd, sizeof(cmd), "%s.%s", newLabel, pnode->ext);
+    dvridx_rename(MEDIA_FILES_DIR, pnode->filename, cmd);
+
     walk_sdcard();
     media_db.cur_sel = constrain(seq, 0, (media_db.count - 1));
     update_page();
@@ -411,6 +480,7 @@ static void delete_video_file(int seq) {
     snprintf(cmd, sizeof(cmd), "rm %s%s.*", MEDIA_FILES_DIR, pnode->label);
 
     if (system_exec(cmd) != -1) {
+        dvridx_remove(MEDIA_FILES_DIR, pnode->filename);
         walk_sdcard();
         media_db.cur_sel = constrain(seq, 0, (media_db.count - 1));
         update_page();
@@ -29,6 +29,7 @@ typedef struct {
     char ext[16];
     int size;
     bool star;
+    bool thumb;
 } media_file_node_t;
 
 typedef struct {
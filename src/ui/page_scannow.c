@@ -13,6 +13,8 @@
 #include "../conf/ui.h"
 
 #include "core/app_state.h"
+#include "core/channel_monitor.h"
+#include "core/channel_scan.h"
 #include "core/common.hh"
 #include "core/defines.h"
 #include "core/msp_displayport.h"
@@ -29,6 +31,7 @@
 #include "ui/page_common.h"
 #include "ui/ui_main_menu.h"
 #include "ui/ui_style.h"
+#include "util/time.h"
 
 LV_IMG_DECLARE(img_signal_status);
 LV_IMG_DECLARE(img_signal_status2);
@@ -70,6 +73,7 @@ int user_select_index = 0;
 
 // local
 static int auto_scaned_cnt = 0;
+static bool scan_shown[BASE_CH_NUM];
 static lv_obj_t *progressbar;
 static lv_obj_t *label;
 static lv_coord_t col_dsc1[] = {UI_SCANNOW_SCANNER_COLS};
@@ -279,11 +283,19 @@ static lv_obj_t *page_scannow_create(lv_obj_t *parent, panel_arr_t *arr) {
 }
 
 static void user_select_signal(void) {
+    int best;
+
     if (valid_channel_tb[0] == -1)
         return;
 
+    // the one that looked best lately, else the first
+    best = channel_monitor_hdzero_best(g_setting.source.hdzero_band, HDZERO_CHANNEL_NUM, CHANNEL_MONITOR_FRESH_MS);
     user_select_index = 0;
-    select_signal(&channel_tb[valid_channel_tb[0] & 0x7F]);
+    for (int i = 0; i < BASE_CH_NUM && valid_channel_tb[i] != -1; i++) {
+        if (valid_channel_tb[i] == best)
+            user_select_index = i;
+    }
+    select_signal(&channel_tb[valid_channel_tb[user_select_index] & 0x7F]);
 }
 
 static void user_clear_signal(void) {
@@ -294,74 +306,80 @@ static void user_clear_signal(void) {
     }
 }
 
-uint8_t max4(uint8_t a1, uint8_t a2, uint8_t a3, uint8_t a4) {
-    uint8_t b1 = (a1 > a2) ? a1 : a2;
-    uint8_t b2 = (a3 > a4) ? a3 : a4;
-    return (b1 > b2) ? b1 : b2;
+static void scan_show_channel(int ch, bool valid, int gain) {
+    channel_status_tb[ch].is_valid = valid;
+    channel_status_tb[ch].gain = gain;
+    if (valid) {
+        set_signal_bar(&channel_tb[ch], channel_status_tb[ch].is_valid, channel_status_tb[ch].gain);
+    } else {
+        lv_img_set_src(channel_tb[ch].img0, &img_signal_status);
+        lv_img_set_src(channel_tb[ch].img1, &img_ant1);
+    }
 }
 
-void scan_channel(band_t band, uint8_t channel, uint8_t *gain_ret, bool *valid) {
-    uint8_t vld0, vld1;
-    uint8_t gain[4];
+// what the channel monitor saw lately, until the sweep gets there
+static void scan_show_monitored(void) {
+    uint32_t now_ms = time_ms();
+    channel_sample_t sample;
 
-    DM6302_SetChannel(band, channel);
-
-    usleep(100000);
-    DM5680_clear_vldflg();
-    DM5680_req_vldflg();
-
-    DM6302_get_gain(gain);
-    *gain_ret = max4(gain[0], gain[1], gain[2], gain[3]);
+    for (int ch = 0; ch < HDZERO_CHANNEL_NUM; ch++) {
+        if (channel_monitor_hdzero(g_setting.source.hdzero_band, ch, &sample, 1) &&
+            now_ms - sample.ms <= CHANNEL_MONITOR_FRESH_MS) {
+            scan_show_channel(ch, sample.valid, sample.level);
+        } else {
+            scan_show_channel(ch, false, 0);
+        }
+    }
+}
 
-    vld0 = rx_status[0].rx_valid;
-    vld1 = rx_status[1].rx_valid;
-    *valid = vld0 | vld1;
+static void scan_show_results(void) {
+    channel_scan_result_t result;
 
-    LOGI("Scan band:%d, channel%d: valid:%d, gain:%d", band, channel, *valid, *gain_ret);
+    for (int ch = 0; ch < HDZERO_CHANNEL_NUM; ch++) {
+        if (scan_shown[ch] || !channel_scan_result(ch, &result)) {
+            continue;
+        }
+        scan_shown[ch] = true;
+        scan_show_channel(ch, result.valid, result.gain);
+    }
+    lv_bar_set_value(progressbar, 2 + channel_scan_progress() * 12 / HDZERO_CHANNEL_NUM, LV_ANIM_OFF);
 }
 
-int8_t scan_now(void) {
-    uint8_t ch, gain;
-    bool valid;
-    uint8_t valid_index;
+static int scan_now(void) {
     char buf[128];
 
-    snprintf(buf, sizeof(buf), "%s...", _lang("Scanning"));
-    lv_label_set_text(label, buf);
-    lv_bar_set_value(progressbar, 0, LV_ANIM_OFF);
-    lv_timer_handler();
-    lv_bar_set_value(progressbar, 2, LV_ANIM_OFF);
-    lv_timer_handler();
-
     // clear
-    for (ch = 0; ch < BASE_CH_NUM; ch++) {
+    for (uint8_t ch = 0; ch < BASE_CH_NUM; ch++) {
         valid_channel_tb[ch] = -1;
         channel_status_tb[ch].is_valid = 0;
+        scan_shown[ch] = false;
     }
 
-    HDZero_open(g_setting.source.hdzero_bw);
-    lv_bar_set_value(progressbar, 4, LV_ANIM_OFF);
-    lv_timer_handler();
+    // the band is always swept, the monitor's samples only fill the wait
+    scan_show_monitored();
 
-    for (ch = 0; ch < HDZERO_CHANNEL_NUM; ch++) {
-        scan_channel(g_setting.source.hdzero_band, ch, &gain, &valid);
-        if (valid) {
-            channel_status_tb[ch].is_valid = 1;
-            channel_status_tb[ch].gain = gain;
-            set_signal_bar(&channel_tb[ch], channel_status_tb[ch].is_valid, channel_status_tb[ch].gain);
-        }
-        lv_bar_set_value(progressbar, ch + 5, LV_ANIM_OFF);
-        lv_timer_handler();
+    if (channel_scan_start(g_setting.source.hdzero_band, g_setting.source.hdzero_bw, HDZERO_CHANNEL_NUM) < 0) {
+        return -1;
     }
+
+    snprintf(buf, sizeof(buf), "%s...", _lang("Scanning"));
+    lv_label_set_text(label, buf);
+    lv_bar_set_value(progressbar, 2, LV_ANIM_OFF);
+    return 0;
+}
+
+// the result of a scan, once it is done
+static int scan_done(void) {
+    uint8_t valid_index = 0;
+
+    scan_show_results();
+    channel_scan_finish();
     lv_bar_set_value(progressbar, 14, LV_ANIM_OFF);
 
-    valid_index = 0;
-    for (ch = 0; ch < HDZERO_CHANNEL_NUM; ch++) {
+    for (uint8_t ch = 0; ch < HDZERO_CHANNEL_NUM; ch++) {
         if (channel_status_tb[ch].is_valid) {
             valid_channel_tb[valid_index++] = ch;
         }
-
-        lv_timer_handler();
     }
 
     user_select_signal();
@@ -381,11 +399,16 @@ int scan_reinit(void) {
 }
 
 int scan(void) {
-    g_scanning = true;
+    if (g_scanning) {
+        return -1;
+    }
+
     g_source_info.source = SOURCE_HDZERO;
-    int8_t ret = scan_now();
-    g_scanning = false;
-    return ret;
+    if (scan_now() < 0) {
+        return -1;
+    }
+    g_scanning = true;
+    return 0;
 }
 
 void autoscan_exit(void) {
@@ -400,7 +423,22 @@ void autoscan_exit(void) {
 }
 
 static void page_scannow_enter() {
-    auto_scaned_cnt = scan();
+    scan();
+}
+
+// the scan runs on its own thread, its results are shown from here
+static void page_scannow_on_update(uint32_t delta_ms) {
+    if (!g_scanning) {
+        return;
+    }
+
+    if (channel_scan_state() == CHANNEL_SCAN_RUNNING) {
+        scan_show_results();
+        return;
+    }
+
+    auto_scaned_cnt = scan_done();
+    g_scanning = false;
     LOGI("scan return :%d", auto_scaned_cnt);
 
     if (auto_scaned_cnt == 1) {
@@ -444,7 +482,7 @@ page_pack_t pp_scannow = {
     .enter = page_scannow_enter,
     .exit = page_scannow_exit,
     .on_created = NULL,
-    .on_update = NULL,
+    .on_update = page_scannow_on_update,
     .on_roller = page_scannow_on_roller,
     .on_click = page_scannow_on_click,
     .on_right_button = NULL,
@@ -9,6 +9,7 @@
 
 #include "common.hh"
 #include "core/app_state.h"
+#include "core/channel_monitor.h"
 #include "driver/hardware.h"
 #include "driver/mcp3021.h"
 #include "driver/screen.h"
@@ -88,6 +89,8 @@ void submenu_enter(void) {
         return;
     }
 
+    // a page using the receivers joins the monitor before it does
+    channel_monitor_stop();
     select_menu_tab(pp);
 
     if (pp->p_arr.max) {
@@ -396,6 +399,7 @@ void main_menu_update() {
             page_packs[i]->on_update(delta_ms);
         }
     }
+    channel_monitor_idle(g_app_state == APP_STATE_MAINMENU);
 
     if (!bootup_actions_fired) {
         bootup_actions_fired = true;
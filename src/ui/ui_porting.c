@@ -1,6 +1,8 @@
 #include "ui/ui_porting.h"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <log/log.h>
 
@@ -26,94 +28,247 @@ typedef enum {
     ORBIT_R = 0x02,
     ORBIT_U = 0x04,
     ORBIT_L = 0x08,
-    ORBIT_FLUSH = 0x10,
 } orbit_state_t;
 
+#define ORBIT_STEP_MS 10000 // the screen moves by a pixel this often, redrawn or not
+
 FBDEV fbdev;
 static lv_disp_draw_buf_t draw_buf;
-static lv_color_t disp_buf[DRAW_HOR_RES_FHD * DRAW_VER_RES_FHD * 4];
+static lv_color_t *disp_buf;     // private draw buffer, only allocated when page flipping is unavailable
+static lv_color_t *disp_page[2]; // framebuffer pages lvgl renders into directly
+static int disp_page_shown;
+static lv_area_t disp_page_copied; // areas copied into the shown page after it was rendered
+static bool disp_page_copied_valid = false;
+static bool disp_page_flip = false;
 static lv_disp_drv_t disp_drv;
 static orbit_state_t disp_orbit_state = ORBIT_NONE;
 static int disp_orbit_x, disp_orbit_y;
 static lv_disp_t *disp;
 
-static void hdz_disp_flush(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color_p) {
-    static int orbit_flush = 0;
+static lv_area_t disp_dirty; // framebuffer area written since the last sync
+static bool disp_dirty_valid = false;
+
+static void disp_dirty_add(const lv_area_t *area) {
+    if (disp_dirty_valid) {
+        _lv_area_join(&disp_dirty, &disp_dirty, area);
+    } else {
+        lv_area_copy(&disp_dirty, area);
+        disp_dirty_valid = true;
+    }
+}
+
+#ifndef EMULATOR_BUILD
+// Direct mode: lvgl has just finished rendering a frame into one of the
+// framebuffer pages. Show that page, then bring the other page up to date
+// with this frame's dirty areas so lvgl can render the next frame into it.
+static void hdz_disp_flip(lv_disp_drv_t *drv, lv_color_t *color_p) {
+    lv_disp_t *d = _lv_refr_get_disp_refreshing();
+    const int page = (color_p == disp_page[0]) ? 0 : 1;
+    lv_color_t *other = disp_page[!page];
+    lv_area_t sync;
+    bool sync_valid = disp_page_copied_valid;
+
+    // the page about to be shown holds this frame plus last frame's copied areas
+    lv_area_copy(&sync, &disp_page_copied);
+    for (int i = 0; i < d->inv_p; i++) {
+        if (d->inv_area_joined[i])
+            continue;
+        if (sync_valid) {
+            _lv_area_join(&sync, &sync, &d->inv_areas[i]);
+        } else {
+            lv_area_copy(&sync, &d->inv_areas[i]);
+            sync_valid = true;
+        }
+    }
+
+    if (sync_valid) {
+        fb_flip(&fbdev, disp_orbit_x, page * drv->ver_res + disp_orbit_y,
+                sync.x1, page * drv->ver_res + sync.y1,
+                lv_area_get_width(&sync), lv_area_get_height(&sync));
+    } else {
+        fb_flip(&fbdev, disp_orbit_x, page * drv->ver_res + disp_orbit_y, 0, 0, 0, 0);
+    }
+    disp_page_shown = page;
+
+    disp_page_copied_valid = false;
+    for (int i = 0; i < d->inv_p; i++) {
+        const lv_area_t *area = &d->inv_areas[i];
+        if (d->inv_area_joined[i])
+            continue;
 
-    // Manipulates the orbiting speed
-    if (++orbit_flush % 500 == 0) {
-        disp_orbit_state |= ORBIT_FLUSH;
+        const size_t len = lv_area_get_width(area) * sizeof(lv_color_t);
+        for (lv_coord_t y = area->y1; y <= area->y2; y++) {
+            const uint32_t offset = y * drv->hor_res + area->x1;
+            memcpy(other + offset, color_p + offset, len);
+        }
+
+        if (disp_page_copied_valid) {
+            _lv_area_join(&disp_page_copied, &disp_page_copied, area);
+        } else {
+            lv_area_copy(&disp_page_copied, area);
+            disp_page_copied_valid = true;
+        }
     }
+}
+#endif
 
+static void hdz_disp_flush(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color_p) {
 #ifndef EMULATOR_BUILD
-    for (lv_coord_t y = area->y1 + disp_orbit_y; y <= area->y2; y++) {
-        fbdev.fb_mem_offset = (y * (disp_drv.hor_res - DISP_OVERSCAN) + disp_orbit_x) * 4;
-        fbdev.fb_fix.smem_len = 4 * (area->x2 - area->x1 + 1 - DISP_OVERSCAN);
-        memcpy(fbdev.fb_mem + fbdev.fb_mem_offset, ((char *)color_p), fbdev.fb_fix.smem_len);
-        color_p += (area->x2 - area->x1 + 1);
+    if (disp_page_flip) {
+        if (lv_disp_flush_is_last(disp)) {
+            hdz_disp_flip(disp, color_p);
+        }
+        lv_disp_flush_ready(disp);
+        return;
     }
+#endif
+
+    const lv_coord_t src_w = lv_area_get_width(area);
+    const lv_coord_t fb_w = disp_drv.hor_res - DISP_OVERSCAN;
+    const lv_coord_t fb_h = disp_drv.ver_res - DISP_OVERSCAN;
+    lv_area_t dst;
+
+    // framebuffer area of this flush, shifted by the orbit offset and clipped to the visible screen
+    dst.x1 = area->x1 + disp_orbit_x;
+    dst.y1 = area->y1 + disp_orbit_y;
+    dst.x2 = LV_MIN(area->x2 + disp_orbit_x, fb_w - 1);
+    dst.y2 = LV_MIN(area->y2 + disp_orbit_y, fb_h - 1);
 
-    fb_sync(&fbdev);
+    if (dst.x1 <= dst.x2 && dst.y1 <= dst.y2) {
+#ifndef EMULATOR_BUILD
+        char *fb_mem = (char *)fbdev.fb_mem + fbdev.fb_mem_offset;
+        const size_t len = lv_area_get_width(&dst) * sizeof(lv_color_t);
+
+        for (lv_coord_t y = dst.y1; y <= dst.y2; y++) {
+            memcpy(fb_mem + (y * fb_w + dst.x1) * sizeof(lv_color_t), color_p, len);
+            color_p += src_w;
+        }
 #else
-    SDL_LockMutex(global_sdl_mutex);
-    SDL_Rect
-        src = {
-            .x = 0,
-            .y = 0,
-            .w = disp_drv.hor_res,
-            .h = disp_drv.ver_res,
-        },
-        dst = {
-            .x = 0,
-            .y = 0,
-            .w = disp_drv.hor_res - DISP_OVERSCAN,
-            .h = disp_drv.ver_res - DISP_OVERSCAN,
+        SDL_LockMutex(global_sdl_mutex);
+        SDL_Rect rect = {
+            .x = area->x1,
+            .y = area->y1,
+            .w = src_w,
+            .h = lv_area_get_height(area),
         };
+        SDL_UpdateTexture(texture, &rect, color_p, src_w * ((LV_COLOR_DEPTH + 7) / 8));
+        SDL_UnlockMutex(global_sdl_mutex);
+#endif
+        disp_dirty_add(&dst);
+    }
 
-    SDL_UpdateTexture(texture, &src, color_p, disp_drv.hor_res * ((LV_COLOR_DEPTH + 7) / 8));
-    src.x = disp_orbit_x;
-    src.w = dst.w;
-    src.y = disp_orbit_y;
-    src.h = dst.h;
-    SDL_RenderCopy(renderer, texture, &src, &dst);
-    SDL_RenderPresent(renderer);
-    SDL_UnlockMutex(global_sdl_mutex);
+    if (lv_disp_flush_is_last(disp) && disp_dirty_valid) {
+#ifndef EMULATOR_BUILD
+        fb_sync_area(&fbdev, fb_w * sizeof(lv_color_t),
+                     disp_dirty.x1, disp_dirty.y1,
+                     lv_area_get_width(&disp_dirty), lv_area_get_height(&disp_dirty));
+#else
+        SDL_LockMutex(global_sdl_mutex);
+        SDL_Rect
+            tex_rect = {
+                .x = 0,
+                .y = 0,
+                .w = fb_w,
+                .h = fb_h,
+            },
+            win_rect = {
+                .x = disp_orbit_x,
+                .y = disp_orbit_y,
+                .w = fb_w,
+                .h = fb_h,
+            };
+        SDL_RenderCopy(renderer, texture, &tex_rect, &win_rect);
+        SDL_RenderPresent(renderer);
+        SDL_UnlockMutex(global_sdl_mutex);
 #endif
+        disp_dirty_valid = false;
+    }
 
-    if (disp_orbit_state & ORBIT_FLUSH) {
-        disp_orbit_state &= ~ORBIT_FLUSH;
+    lv_disp_flush_ready(disp);
+}
 
-        int pixels = 1 << g_setting.osd.orbit;
+// Moves the screen a pixel along its orbit, on a timer so a static screen
+// keeps moving too
+static void hdz_disp_orbit(lv_timer_t *timer) {
+    int pixels = 1 << g_setting.osd.orbit;
+    int orbit_x = disp_orbit_x;
+    int orbit_y = disp_orbit_y;
 
-        if (disp_orbit_state & ORBIT_D && disp_orbit_y < pixels) {
-            disp_orbit_y += 1;
-            if (disp_orbit_y == pixels) {
-                disp_orbit_state &= ~ORBIT_D;
-                disp_orbit_state |= ORBIT_R;
-            }
-        } else if (disp_orbit_state & ORBIT_R && disp_orbit_x < pixels) {
-            disp_orbit_x += 1;
-            if (disp_orbit_x == pixels) {
-                disp_orbit_state &= ~ORBIT_R;
-                disp_orbit_state |= ORBIT_U;
-            }
-        } else if (disp_orbit_state & ORBIT_U && disp_orbit_y > 0) {
-            disp_orbit_y -= 1;
-            if (disp_orbit_y == 0) {
-                disp_orbit_state &= !ORBIT_U;
-                disp_orbit_state |= ORBIT_L;
-            }
-        } else if (disp_orbit_state & ORBIT_L && disp_orbit_x > 0) {
-            disp_orbit_x -= 1;
-            if (disp_orbit_x == 0) {
-                disp_orbit_state &= ~ORBIT_L;
-                disp_orbit_state |= ORBIT_D;
+    if (disp_orbit_state & ORBIT_D && disp_orbit_y < pixels) {
+        disp_orbit_y += 1;
+        if (disp_orbit_y == pixels) {
+            disp_orbit_state &= ~ORBIT_D;
+            disp_orbit_state |= ORBIT_R;
+        }
+    } else if (disp_orbit_state & ORBIT_R && disp_orbit_x < pixels) {
+        disp_orbit_x += 1;
+        if (disp_orbit_x == pixels) {
+            disp_orbit_state &= ~ORBIT_R;
+            disp_orbit_state |= ORBIT_U;
+        }
+    } else if (disp_orbit_state & ORBIT_U && disp_orbit_y > 0) {
+        disp_orbit_y -= 1;
+        if (disp_orbit_y == 0) {
+            disp_orbit_state &= !ORBIT_U;
+            disp_orbit_state |= ORBIT_L;
+        }
+    } else if (disp_orbit_state & ORBIT_L && disp_orbit_x > 0) {
+        disp_orbit_x -= 1;
+        if (disp_orbit_x == 0) {
+            disp_orbit_state &= ~ORBIT_L;
+            disp_orbit_state |= ORBIT_D;
+        }
+    }
+
+    if (orbit_x != disp_orbit_x || orbit_y != disp_orbit_y) {
+#ifndef EMULATOR_BUILD
+        if (disp_page_flip) {
+            // just move the visible window over the shown page
+            fb_flip(&fbdev, disp_orbit_x, disp_page_shown * disp_drv.ver_res + disp_orbit_y, 0, 0, 0, 0);
+            return;
+        }
+#endif
+        // the whole picture moved, so every pixel on the framebuffer is stale
+        lv_obj_invalidate(lv_disp_get_scr_act(disp));
+    }
+}
+
+#ifndef EMULATOR_BUILD
+// Prefer rendering straight into two framebuffer pages and flipping between
+// them, fall back to a private draw buffer that is copied on flush. -1 and
+// the driver left as it was if neither is available.
+static int disp_set_draw_buf(lv_coord_t hor_res, lv_coord_t ver_res) {
+    const uint32_t page_size = hor_res * ver_res;
+
+    if (fb_set_pages(&fbdev, hor_res, ver_res, 2) == 0) {
+        lv_color_t *fb_mem = (lv_color_t *)((char *)fbdev.fb_mem + fbdev.fb_mem_offset);
+
+        disp_page[0] = fb_mem;
+        disp_page[1] = fb_mem + page_size;
+        disp_page_shown = 0;
+        disp_page_copied_valid = false;
+        disp_page_flip = true;
+        lv_disp_draw_buf_init(&draw_buf, disp_page[0], disp_page[1], page_size);
+    } else {
+        LOGI("page flipping unavailable, using copy flush");
+        if (!disp_buf) {
+            disp_buf = malloc(DRAW_HOR_RES_FHD * DRAW_VER_RES_FHD * sizeof(lv_color_t));
+            if (!disp_buf) {
+                LOGE("no memory for the draw buffer");
+                return -1;
             }
         }
+        disp_page_flip = false;
+        lv_disp_draw_buf_init(&draw_buf, disp_buf, NULL, page_size);
     }
 
-    lv_disp_flush_ready(disp);
+    disp_drv.direct_mode = disp_page_flip;
+    disp_drv.draw_buf = &draw_buf;
+    disp_drv.hor_res = hor_res;
+    disp_drv.ver_res = ver_res;
+    return 0;
 }
+#endif
 
 int lvgl_init_porting() {
 #ifndef EMULATOR_BUILD
@@ -125,9 +280,11 @@ int lvgl_init_porting() {
     }
     LOGI("register disp drv");
 
-    lv_disp_draw_buf_init(&draw_buf, disp_buf, NULL, DRAW_HOR_RES_FHD * DRAW_VER_RES_FHD * 4);
-
     lv_disp_drv_init(&disp_drv);
+    if (disp_set_draw_buf(DRAW_HOR_RES_FHD, DRAW_VER_RES_FHD) != 0) {
+        fb_close(&fbdev);
+        return -1;
+    }
 #else
     if (SDL_WasInit(SDL_INIT_VIDEO) == 0) {
         SDL_InitSubSystem(SDL_INIT_VIDEO);
@@ -154,24 +311,31 @@ int lvgl_init_porting() {
 
     lv_disp_draw_buf_init(&draw_buf, fb1, fb2, DRAW_HOR_RES_FHD * DRAW_VER_RES_FHD);
     lv_disp_drv_init(&disp_drv);
-#endif
-
-    disp_drv.full_refresh = 1;
-    disp_drv.flush_cb = hdz_disp_flush;
     disp_drv.draw_buf = &draw_buf;
     disp_drv.hor_res = DRAW_HOR_RES_FHD;
     disp_drv.ver_res = DRAW_VER_RES_FHD;
+#endif
+
+    disp_drv.full_refresh = 0;
+    disp_drv.flush_cb = hdz_disp_flush;
     disp = lv_disp_drv_register(&disp_drv);
+    lv_timer_create(hdz_disp_orbit, ORBIT_STEP_MS, NULL);
 
     return 0;
 }
 
 int lvgl_switch_to_720p() {
     lvgl_screen_orbit(false);
-    lv_disp_draw_buf_init(&draw_buf, disp_buf, NULL, DRAW_HOR_RES_HD * DRAW_VER_RES_HD * 4);
+#ifndef EMULATOR_BUILD
+    if (disp_set_draw_buf(DRAW_HOR_RES_HD, DRAW_VER_RES_HD) != 0) {
+        return -1;
+    }
+#else
+    lv_disp_draw_buf_init(&draw_buf, fb1, fb2, DRAW_HOR_RES_HD * DRAW_VER_RES_HD);
     disp_drv.draw_buf = &draw_buf;
     disp_drv.hor_res = DRAW_HOR_RES_HD;
     disp_drv.ver_res = DRAW_VER_RES_HD;
+#endif
     lv_disp_drv_update(disp, &disp_drv);
     lvgl_screen_orbit(g_setting.osd.orbit > 0);
     return 0;
@@ -179,10 +343,16 @@ int lvgl_switch_to_720p() {
 
 int lvgl_switch_to_1080p() {
     lvgl_screen_orbit(false);
-    lv_disp_draw_buf_init(&draw_buf, disp_buf, NULL, DRAW_HOR_RES_FHD * DRAW_VER_RES_FHD * 4);
+#ifndef EMULATOR_BUILD
+    if (disp_set_draw_buf(DRAW_HOR_RES_FHD, DRAW_VER_RES_FHD) != 0) {
+        return -1;
+    }
+#else
+    lv_disp_draw_buf_init(&draw_buf, fb1, fb2, DRAW_HOR_RES_FHD * DRAW_VER_RES_FHD);
     disp_drv.draw_buf = &draw_buf;
     disp_drv.hor_res = DRAW_HOR_RES_FHD;
     disp_drv.ver_res = DRAW_VER_RES_FHD;
+#endif
     lv_disp_drv_update(disp, &disp_drv);
     lvgl_screen_orbit(g_setting.osd.orbit > 0);
     return 0;
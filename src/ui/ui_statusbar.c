@@ -16,6 +16,7 @@
 #include "ui/ui_porting.h"
 #include "ui/ui_style.h"
 #include "util/sdcard.h"
+#include "util/time.h"
 
 ///////////////////////////////////////////////////////////////////////////////
 // local
@@ -174,8 +175,8 @@ void statubar_update(void) {
     lv_label_set_text(label[STS_BATT], buf);
 
     {
-#define BEEP_INTERVAL 20
-        static uint8_t beep_gap = 0;
+#define BEEP_INTERVAL 100 // ms
+        static uint32_t beep_ms = 0;
 
         const bool low = battery_is_low();
         if (low)
@@ -186,9 +187,9 @@ void statubar_update(void) {
         switch (g_setting.power.warning_type) {
         case SETTING_POWER_WARNING_TYPE_BEEP:
             if (low) {
-                if (beep_gap++ == BEEP_INTERVAL) {
+                if (time_ms() - beep_ms >= BEEP_INTERVAL) {
                     beep();
-                    beep_gap = 0;
+                    beep_ms = time_ms();
                 }
                 lv_obj_set_style_text_color(label[STS_BATT], lv_color_hex(TEXT_COLOR_DEFAULT), 0);
             }
@@ -203,9 +204,9 @@ void statubar_update(void) {
 
         case SETTING_POWER_WARNING_TYPE_BOTH:
             if (low) {
-                if (beep_gap++ == BEEP_INTERVAL) {
+                if (time_ms() - beep_ms >= BEEP_INTERVAL) {
                     beep();
-                    beep_gap = 0;
+                    beep_ms = time_ms();
                 }
                 lv_obj_set_style_text_color(label[STS_BATT], lv_color_make(255, 0, 0), 0);
             } else
@@ -29,4 +29,11 @@ uint32_t time_s() {
     }
 
     return now_s - start_s;
-}
\ No newline at end of file
+}
+
+uint64_t time_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
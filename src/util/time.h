@@ -8,6 +8,7 @@ extern "C" {
 
 uint32_t time_ms();
 uint32_t time_s();
+uint64_t time_us();
 
 #ifdef __cplusplus
 }
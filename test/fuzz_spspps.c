@@ -0,0 +1,184 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "bitstream.h"
+#include "spspps_patch.h"
+
+/* fuzz entry for the sps patcher: the first byte picks the codec (bit 0) and
+ * the frame rate, the rest is the extradata. Built for libFuzzer with
+ * -DHDZ_FUZZ=ON under clang; otherwise main() below runs it over the samples
+ * and deterministic mutations of them, or over the files given. */
+
+#define FUZZ_maxLEN     1024
+#define FUZZ_GROW       64      // room left for the patched sps
+
+#define FUZZ_ASSERT(cond)                                                       \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            fprintf(stderr, "%s:%d: fuzz check failed: %s\n", __FILE__, __LINE__, #cond); \
+            fuzz_dump(data, size);                                              \
+            abort();                                                            \
+        }                                                                       \
+    } while (0)
+
+static void fuzz_dump(const uint8_t* data, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        fprintf(stderr, "%02x%s", data[i], ((i & 15) == 15) ? "\n" : " ");
+    }
+    fprintf(stderr, "\n");
+}
+
+static int fuzz_patch(int bHevc, uint8_t* buf, int len, int bufSize, int fps)
+{
+    return bHevc ? H265_Modify_SPS(buf, len, bufSize, fps) : H264_Modify_SPS(buf, len, bufSize, fps);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    static uint8_t buf[FUZZ_maxLEN + FUZZ_GROW], again[FUZZ_maxLEN + FUZZ_GROW];
+    static uint8_t rbsp[FUZZ_maxLEN], esc[FUZZ_maxLEN * 3 / 2];
+    int bHevc, fps, len, ret, ret2, escLen;
+
+    if (size < 2 || size - 1 > FUZZ_maxLEN) {
+        return 0;
+    }
+    bHevc = data[0] & 1;
+    fps = (data[0] >> 1) + 1;
+    len = (int)size - 1;
+
+    // the buffer is exactly as big as the patcher is told, so asan sees a
+    // write past bufSize
+    uint8_t* heap = malloc(len + FUZZ_GROW);
+    FUZZ_ASSERT(heap);
+    memcpy(heap, data + 1, len);
+    ret = fuzz_patch(bHevc, heap, len, len + FUZZ_GROW, fps);
+    FUZZ_ASSERT(ret == -1 || (ret > 0 && ret <= len + FUZZ_GROW));
+
+    if (ret > 0) {
+        // what the patcher wrote is a sps it takes again, and patching that
+        // one changes nothing
+        memcpy(buf, heap, ret);
+        memcpy(again, heap, ret);
+        ret2 = fuzz_patch(bHevc, again, ret, sizeof(again), fps);
+        FUZZ_ASSERT(ret2 == ret);
+        FUZZ_ASSERT(memcmp(again, buf, ret) == 0);
+    } else {
+        // nothing written on an error
+        FUZZ_ASSERT(memcmp(heap, data + 1, len) == 0);
+    }
+    free(heap);
+
+    // escaping round trip on the raw input
+    escLen = bitstream_escape(data + 1, len, esc, sizeof(esc));
+    FUZZ_ASSERT(escLen >= len);
+    FUZZ_ASSERT(bitstream_unescape(esc, escLen, rbsp, sizeof(rbsp)) == len);
+    FUZZ_ASSERT(memcmp(rbsp, data + 1, len) == 0);
+
+    return 0;
+}
+
+#ifndef HDZ_LIBFUZZER
+#include "spspps_samples.h"
+
+static uint32_t rnd_state = 0x2545f491;
+
+static uint32_t rnd(void)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    return rnd_state;
+}
+
+static void fuzz_file(const char* path)
+{
+    static uint8_t data[FUZZ_maxLEN + 1];
+    FILE* fp = fopen(path, "rb");
+    size_t size;
+
+    if (!fp) {
+        perror(path);
+        exit(1);
+    }
+    size = fread(data, 1, sizeof(data), fp);
+    fclose(fp);
+
+    LLVMFuzzerTestOneInput(data, size);
+}
+
+// bit flips, byte sets, cuts and inserts on each sample, with every codec
+// and a few frame rates
+static int fuzz_samples(int rounds)
+{
+    static uint8_t data[FUZZ_maxLEN + 1];
+    int runs = 0;
+
+    for (int i = 0; i < SPS_SAMPLES; i++) {
+        const SpsSample_t* s = &sps_samples[i];
+
+        for (int r = 0; r < rounds; r++) {
+            int len = s->len;
+            int edits = (r == 0) ? 0 : (1 + rnd() % 4);
+
+            data[0] = (uint8_t)(((rnd() % 127) << 1) | s->bHevc);
+            if ((r & 15) == 15) {
+                data[0] ^= 1;
+            }
+            memcpy(data + 1, s->data, len);
+
+            for (int e = 0; e < edits; e++) {
+                int at = 1 + rnd() % len;
+
+                switch (rnd() % 5) {
+                case 0:
+                    data[at] ^= (uint8_t)(1 << (rnd() % 8));
+                    break;
+                case 1:
+                    data[at] = (rnd() & 1) ? 0x00 : (uint8_t)rnd();
+                    break;
+                case 2:
+                    len = at;
+                    break;
+                case 3:
+                    if (len < FUZZ_maxLEN) {
+                        memmove(data + at + 1, data + at, len + 1 - at);
+                        data[at] = (uint8_t)(rnd() % 4);
+                        len++;
+                    }
+                    break;
+                default:
+                    if (len > 1) {
+                        memmove(data + at, data + at + 1, len - at);
+                        len--;
+                    }
+                    break;
+                }
+                if (len < 1) {
+                    len = 1;
+                }
+            }
+
+            LLVMFuzzerTestOneInput(data, len + 1);
+            runs++;
+        }
+    }
+    return runs;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++) {
+            fuzz_file(argv[i]);
+        }
+        printf("%d inputs\n", argc - 1);
+        return 0;
+    }
+
+    printf("%d inputs\n", fuzz_samples(20000));
+    return 0;
+}
+#endif
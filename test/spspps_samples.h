@@ -0,0 +1,114 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* sps/pps extradata the encoders were seen to produce, taken from the test
+ * vectors at the end of src/record/spspps_patch.c */
+
+typedef struct
+{
+    const char*    name;
+    bool           bHevc;
+    bool           bBroken;     // must be refused and left as it is
+    const uint8_t* data;
+    int            len;
+} SpsSample_t;
+
+static const uint8_t h264_extradata720p30[] = {
+    0x00, 0x00, 0x00, 0x01, 0x67, 0x64, 0x00, 0x1f,
+    0xac, 0xd9, 0x40, 0x50, 0x05, 0xba, 0x10, 0x00,
+    0x00, 0x03, 0x00, 0x10, 0x00, 0x00, 0x03, 0x03,
+    0xc0, 0xf1, 0x83, 0x19, 0x60, 0x00, 0x00, 0x00,
+    0x01, 0x68, 0xeb, 0xe3, 0xcb, 0x22, 0xc0,
+};
+
+static const uint8_t h264_extradata720p30_aw[] = {
+    0x00, 0x00, 0x00, 0x01, 0x67, 0x4d, 0x00, 0x33,
+    0x96, 0x54, 0x02, 0x80, 0x2d, 0x93, 0x70, 0x50,
+    0x60, 0x50, 0x20, 0x00, 0x00, 0x00, 0x01, 0x68,
+    0xee, 0x3c, 0x80, 0x00,
+};
+
+static const uint8_t h265_extradata1080p30[] = {
+    0x00, 0x00, 0x00, 0x01, 0x42, 0x01, 0x01, 0x01,
+    0x60, 0x00, 0x00, 0x03, 0x00, 0x90, 0x00, 0x00,
+    0x03, 0x00, 0x00, 0x03, 0x00, 0x78, 0xa0, 0x03,
+    0xc0, 0x80, 0x10, 0xe5, 0x96, 0x4a, 0x92, 0x49,
+    0x02, 0x60, 0x10, 0x00, 0x00, 0x3e, 0x80, 0x00,
+    0x07, 0x53, 0x00, 0x80
+};
+
+static const uint8_t h265_extradata720p30_aw[] = {
+    0x00, 0x00, 0x00, 0x01, 0x40, 0x01, 0x0c, 0x01,
+    0xff, 0xff, 0x01, 0x60, 0x00, 0x00, 0x03, 0x00,
+    0x00, 0x03, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03,
+    0x00, 0xba, 0xac, 0x09, 0x00, 0x00, 0x00, 0x01,
+    0x42, 0x01, 0x01, 0x01, 0x60, 0x00, 0x00, 0x03,
+    0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00, 0x00,
+    0x03, 0x00, 0xba, 0xa0, 0x02, 0x80, 0x80, 0x2d,
+    0x1f, 0xe5, 0xae, 0xe4, 0x48, 0x81, 0x02, 0xfc,
+    0xf3, 0xcf, 0x3c, 0xf3, 0xcf, 0x3c, 0xf3, 0xcf,
+    0x3c, 0xf3, 0xcf, 0x3c, 0xf3, 0xcf, 0x3c, 0xf3,
+    0xcf, 0x3c, 0xf3, 0xcf, 0x3c, 0xb5, 0x37, 0x05,
+    0x06, 0x05, 0x00, 0x80, 0x00, 0x00, 0x00, 0x01,
+    0x44, 0x01, 0xc0, 0xf6, 0x88, 0x40, 0x33, 0x24
+};
+
+// the short term ref pic sets run past the end of this sps, the vector has a
+// byte too many or too few somewhere
+static const uint8_t h265_extradata1080p30_aw[] = {
+    0x00, 0x00, 0x00, 0x01, 0x40, 0x01, 0x0c, 0x01,
+    0xff, 0xff, 0x01, 0x60, 0x00, 0x00, 0x03, 0x00,
+    0x00, 0x03, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03,
+    0x00, 0xba, 0xac, 0x09, 0x00, 0x00, 0x00, 0x01,
+    0x42, 0x01, 0x01, 0x01, 0x60, 0x00, 0x00, 0x03,
+    0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00, 0x00,
+    0x03, 0x00, 0xba, 0xa0, 0x03, 0xc0, 0x80, 0x10,
+    0xe7, 0xf9, 0x6b, 0xb9, 0x12, 0x20, 0x40, 0xbf,
+    0xf3, 0xcf, 0x3c, 0xf3, 0xcf, 0x3c, 0xf3, 0xcf,
+    0x3c, 0x3c, 0xf3, 0xcf, 0x3c, 0xf3, 0xcf, 0x3c,
+    0xf3, 0xcf, 0x3c, 0xf3, 0xcf, 0x2d, 0x4d, 0xc1,
+    0x41, 0x81, 0x40, 0x20, 0x00, 0x00, 0x00, 0x01,
+    0x44, 0x01, 0xc0, 0xf6, 0x88, 0x40, 0x33, 0x24,
+};
+
+static const uint8_t h265_spsdata_ts4[] = {
+    0x00, 0x00, 0x00, 0x01, 0x42, 0x01, 0x01, 0x01,
+    0x60, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00,
+    0x00, 0x03, 0x00, 0x00, 0x03, 0x00, 0xba, 0xa0,
+    0x02, 0x80, 0x80, 0x2d, 0x1f, 0xe5, 0xae, 0xe4,
+    0x48, 0x81, 0xf2, 0xfc, 0xf3, 0xcf, 0x3c, 0xf3,
+    0xcf, 0x3c, 0xf3, 0xcf, 0x3c, 0xf3, 0xcf, 0x3c,
+    0xf3, 0xcf, 0x3c, 0xf3, 0xcf, 0x3c, 0xf3, 0xcf,
+    0x3c, 0xf3, 0xcf, 0x3c, 0xf3, 0xcf, 0x3c, 0xf3,
+    0xcf, 0x3c, 0xf3, 0xcf, 0x3c, 0xf3, 0xcf, 0x3c,
+    0xf3, 0xcf, 0x3c, 0xf3, 0xcf, 0x3c, 0xf3, 0xcb,
+    0x53, 0x70, 0x50, 0x60, 0x50, 0x08
+};
+
+static const uint8_t h265_extradata720p60_ts4[] = {
+    0x00, 0x00, 0x00, 0x01, 0x40, 0x01, 0x0c, 0x01, 0xff, 0xff, 0x01, 0x60, 0x00, 0x00, 0x03, 0x00,
+    0x00, 0x03, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00, 0xba, 0xac, 0x09, 0x00, 0x00, 0x00, 0x01,
+    0x42, 0x01, 0x01, 0x01, 0x60, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00, 0x00,
+    0x03, 0x00, 0xba, 0xa0, 0x02, 0x80, 0x80, 0x2d, 0x1f, 0xe5, 0xae, 0xe4, 0x48, 0x81, 0xf2, 0xfc,
+    0xf3, 0xcf, 0x3c, 0xf3, 0xcf, 0x3c, 0xf3, 0xcf, 0x3c, 0xf3, 0xcf, 0x3c, 0xf3, 0xcf, 0x3c, 0xf3,
+    0xcf, 0x3c, 0xf3, 0xcf, 0x3c, 0xf3, 0xcf, 0x3c, 0xf3, 0xcf, 0x3c, 0xf3, 0xcf, 0x3c, 0xf3, 0xcf,
+    0x3c, 0xf3, 0xcf, 0x3c, 0xf3, 0xcf, 0x3c, 0xf3, 0xcf, 0x3c, 0xf3, 0xcb, 0x53, 0x70, 0x50, 0x60,
+    0x50, 0x08, 0x00, 0x00, 0x00, 0x01, 0x44, 0x01, 0xc0, 0xf6, 0x88, 0x40, 0x33, 0x24
+};
+
+#define SPS_SAMPLE(codec, arr)  { #arr, (codec), false, arr, (int)sizeof(arr) }
+#define SPS_BROKEN(codec, arr)  { #arr, (codec), true, arr, (int)sizeof(arr) }
+
+static const SpsSample_t sps_samples[] = {
+    SPS_SAMPLE(false, h264_extradata720p30),
+    SPS_SAMPLE(false, h264_extradata720p30_aw),
+    SPS_SAMPLE(true,  h265_extradata1080p30),
+    SPS_SAMPLE(true,  h265_extradata720p30_aw),
+    SPS_BROKEN(true,  h265_extradata1080p30_aw),
+    SPS_SAMPLE(true,  h265_spsdata_ts4),
+    SPS_SAMPLE(true,  h265_extradata720p60_ts4),
+};
+
+#define SPS_SAMPLES     (int)(sizeof(sps_samples) / sizeof(sps_samples[0]))
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdio.h>
+
+/* a failed check is reported and counted, the test goes on with the next one */
+
+static int test_failures = 0;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            test_failures++;                                                \
+        }                                                                   \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                      \
+    do {                                                                    \
+        long long _a = (long long)(a), _b = (long long)(b);                 \
+        if (_a != _b) {                                                     \
+            printf("%s:%d: check failed: %s == %s (%lld != %lld)\n",        \
+                   __FILE__, __LINE__, #a, #b, _a, _b);                     \
+            test_failures++;                                                \
+        }                                                                   \
+    } while (0)
+
+#define TEST_RUN(fn)                                                        \
+    do {                                                                    \
+        int _before = test_failures;                                        \
+        fn();                                                               \
+        printf("%s %s\n", (test_failures == _before) ? "ok  " : "FAIL", #fn); \
+    } while (0)
+
+#define TEST_RESULT()   (test_failures ? 1 : 0)
@@ -0,0 +1,394 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "i2c.h"
+#include "i2c_mock.h"
+
+#include "test.h"
+
+/* i2c transactions and the port locks, run on the mock register files */
+
+#define TEST_PORT   2
+#define THREADS     8
+#define ROUNDS      5000
+
+static i2c_mock_stats_t stats_since(void)
+{
+    i2c_mock_stats_t stats;
+
+    i2c_mock_stats(&stats);
+    i2c_mock_reset_stats();
+    return stats;
+}
+
+static void test_txn_batched(void)
+{
+    uint8_t back[16] = { 0 }, one = 0;
+    i2c_txn_t txn;
+    i2c_mock_stats_t stats;
+
+    i2c_mock_reset_stats();
+    i2c_txn_begin(&txn, TEST_PORT);
+    for (int i = 0; i < 16; i++) {
+        i2c_txn_write(&txn, ADDR_FPGA, 0x10 + i, 0xa0 + i);
+    }
+    i2c_txn_read(&txn, ADDR_FPGA, 0x10, back, sizeof(back));
+    // a read sees the writes queued before it in the same transaction
+    i2c_txn_write(&txn, ADDR_FPGA, 0x13, 0x55);
+    i2c_txn_read(&txn, ADDR_FPGA, 0x13, &one, 1);
+
+    // nothing is sent until the submit
+    CHECK_EQ(stats_since().xfers, 0);
+    CHECK_EQ(i2c_txn_submit(&txn), 0);
+
+    stats = stats_since();
+    CHECK_EQ(stats.xfers, 1);
+    CHECK_EQ(stats.msgs, 16 + 2 + 1 + 2);
+    CHECK_EQ(stats.bytes, 16 * 2 + (1 + 16) + 2 + (1 + 1));
+
+    for (int i = 0; i < 16; i++) {
+        CHECK_EQ(back[i], 0xa0 + i);
+    }
+    CHECK_EQ(one, 0x55);
+    CHECK_EQ(i2c_read(TEST_PORT, ADDR_FPGA, 0x13), 0x55);
+    CHECK_EQ(i2c_read(TEST_PORT, ADDR_FPGA, 0x1f), 0xaf);
+
+    // an empty submit sends nothing
+    i2c_mock_reset_stats();
+    i2c_txn_begin(&txn, TEST_PORT);
+    CHECK_EQ(i2c_txn_submit(&txn), 0);
+    CHECK_EQ(stats_since().xfers, 0);
+}
+
+static void test_txn_stop(void)
+{
+    uint8_t back[4] = { 0 };
+    i2c_txn_t txn;
+    i2c_mock_stats_t stats;
+
+    // the spi bridge way: a STOP after every write, a read still sent with
+    // its pointer write
+    i2c_mock_reset_stats();
+    i2c_txn_begin_stop(&txn, TEST_PORT);
+    i2c_txn_write(&txn, ADDR_FPGA, 0x91, 0x34);
+    i2c_txn_write(&txn, ADDR_FPGA, 0x92, 0x12);
+    i2c_txn_write(&txn, ADDR_FPGA, 0x90, 0x10);
+    i2c_txn_read(&txn, ADDR_FPGA, 0x91, back, 2);
+    i2c_txn_write(&txn, ADDR_FPGA, 0x98, 0x77);
+    CHECK_EQ(stats_since().xfers, 0);
+    CHECK_EQ(i2c_txn_submit(&txn), 0);
+
+    stats = stats_since();
+    CHECK_EQ(stats.xfers, 5);
+    CHECK_EQ(stats.msgs, 6);
+    CHECK_EQ(back[0], 0x34);
+    CHECK_EQ(back[1], 0x12);
+    CHECK_EQ(i2c_read(TEST_PORT, ADDR_FPGA, 0x98), 0x77);
+
+    // a full queue goes out the same way
+    i2c_mock_reset_stats();
+    i2c_txn_begin_stop(&txn, TEST_PORT);
+    for (int i = 0; i < I2C_txnMSGS + 2; i++) {
+        i2c_txn_write(&txn, ADDR_FPGA, 0x93 + (i & 3), i);
+    }
+    CHECK_EQ(i2c_txn_submit(&txn), 0);
+    stats = stats_since();
+    CHECK_EQ(stats.xfers, I2C_txnMSGS + 2);
+    CHECK_EQ(stats.msgs, I2C_txnMSGS + 2);
+
+    // begin resets the mode
+    i2c_txn_begin(&txn, TEST_PORT);
+    i2c_txn_write(&txn, ADDR_FPGA, 0x93, 0);
+    i2c_txn_write(&txn, ADDR_FPGA, 0x94, 0);
+    CHECK_EQ(i2c_txn_submit(&txn), 0);
+    CHECK_EQ(stats_since().xfers, 1);
+}
+
+static void test_txn_full(void)
+{
+    uint8_t back[I2C_txnMSGS + 8] = { 0 };
+    uint8_t block[50];
+    i2c_txn_t txn;
+    i2c_mock_stats_t stats;
+
+    // more messages than one I2C_RDWR takes: sent when full, in order
+    i2c_mock_reset_stats();
+    i2c_txn_begin(&txn, TEST_PORT);
+    for (int i = 0; i < I2C_txnMSGS + 8; i++) {
+        i2c_txn_write(&txn, ADDR_AL, i, i ^ 0x5a);
+    }
+    CHECK_EQ(stats_since().xfers, 1);
+    CHECK_EQ(i2c_txn_submit(&txn), 0);
+    stats = stats_since();
+    CHECK_EQ(stats.xfers, 1);
+    CHECK_EQ(stats.msgs, 8);
+
+    CHECK_EQ(i2c_read_n(TEST_PORT, ADDR_AL, 0, back, sizeof(back)), 0);
+    for (int i = 0; i < I2C_txnMSGS + 8; i++) {
+        CHECK_EQ(back[i], i ^ 0x5a);
+    }
+
+    // more bytes than the transaction buffer: 3 x 51 bytes, the third one
+    // goes out with the read after it
+    memset(back, 0, sizeof(back));
+    i2c_mock_reset_stats();
+    i2c_txn_begin(&txn, TEST_PORT);
+    for (int n = 0; n < 3; n++) {
+        for (int i = 0; i < (int)sizeof(block); i++) {
+            block[i] = n * 50 + i;
+        }
+        i2c_txn_write_n(&txn, ADDR_AL, 0x40 + n * 50, block, sizeof(block));
+    }
+    i2c_txn_read(&txn, ADDR_AL, 0x40, back, 50);
+    CHECK_EQ(stats_since().xfers, 1);
+    CHECK_EQ(i2c_txn_submit(&txn), 0);
+    CHECK_EQ(stats_since().xfers, 1);
+
+    // a read queued before a flush lands as well
+    for (int i = 0; i < 50; i++) {
+        CHECK_EQ(back[i], i);
+    }
+    CHECK_EQ(i2c_read(TEST_PORT, ADDR_AL, 0x40 + 149), 149);
+}
+
+static void test_txn_oversize(void)
+{
+    uint8_t big[I2C_txnBYTES + 64];
+    uint8_t back[I2C_txnBYTES + 64];
+    i2c_txn_t txn;
+
+    for (int i = 0; i < (int)sizeof(big); i++) {
+        big[i] = 0xff - i;
+    }
+
+    // too big for the transaction buffer: what is queued goes first, the
+    // block on its own, then the rest
+    i2c_mock_reset_stats();
+    i2c_txn_begin(&txn, TEST_PORT);
+    i2c_txn_write(&txn, ADDR_IT66121, 0x00, 0x11);
+    i2c_txn_write_n(&txn, ADDR_IT66121, 0x00, big, sizeof(big));
+    i2c_txn_write(&txn, ADDR_IT66121, 0x01, 0x22);
+    CHECK_EQ(i2c_txn_submit(&txn), 0);
+    CHECK_EQ(stats_since().xfers, 3);
+
+    CHECK_EQ(i2c_read_n(TEST_PORT, ADDR_IT66121, 0x00, back, sizeof(back)), 0);
+    CHECK_EQ(back[0], 0xff);
+    CHECK_EQ(back[1], 0x22);
+    CHECK(memcmp(back + 2, big + 2, sizeof(big) - 2) == 0);
+
+    // longer than one i2c_write_n takes
+    {
+        static uint8_t huge[I2C_xferMAX + 1];
+
+        CHECK_EQ(i2c_write_n(TEST_PORT, ADDR_IT66121, 0, huge, sizeof(huge)), -1);
+        i2c_txn_begin(&txn, TEST_PORT);
+        i2c_txn_write_n(&txn, ADDR_IT66121, 0, huge, sizeof(huge));
+        CHECK_EQ(i2c_txn_submit(&txn), -EINVAL);
+    }
+}
+
+static void test_txn_errors(void)
+{
+    uint8_t val = 0xee;
+    i2c_txn_t txn;
+
+    // no such port
+    i2c_txn_begin(&txn, IIC_PORTS);
+    i2c_txn_write(&txn, ADDR_FPGA, 0x00, 0x01);
+    CHECK_EQ(i2c_txn_submit(&txn), -ENODEV);
+    CHECK_EQ(i2c_write(-1, ADDR_FPGA, 0x00, 0x01), -1);
+    CHECK_EQ(i2c_read(IIC_PORTS, ADDR_FPGA, 0x00), 0);
+
+    // a slave the mock doesn't have: the first error is kept until the
+    // submit, the messages after it are still sent
+    i2c_txn_begin(&txn, TEST_PORT);
+    for (int i = 0; i < I2C_txnMSGS; i++) {
+        i2c_txn_write(&txn, 0x80, 0x00, 0x01);
+    }
+    i2c_txn_write(&txn, ADDR_FPGA, 0x40, 0x77);
+    i2c_txn_read(&txn, ADDR_FPGA, 0x40, &val, 1);
+    CHECK_EQ(i2c_txn_submit(&txn), -ENXIO);
+    CHECK_EQ(val, 0x77);
+
+    // and cleared by it, the transaction is reused
+    i2c_txn_write(&txn, ADDR_FPGA, 0x40, 0x78);
+    CHECK_EQ(i2c_txn_submit(&txn), 0);
+    CHECK_EQ(i2c_read(TEST_PORT, ADDR_FPGA, 0x40), 0x78);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// locks
+
+typedef struct {
+    pthread_t tid;
+    int id;
+    int port;
+    uint8_t slave;
+} worker_t;
+
+static atomic_int g_mismatches;
+
+// i2c_write_n shares one buffer per port, a slave of its own per thread
+// shows whether another thread wrote into it before it was sent
+static void *worker_write_n(void *arg)
+{
+    worker_t *w = arg;
+    uint8_t out[128], back[128];
+
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < (int)sizeof(out); i++) {
+            out[i] = w->id * 31 + r + i;
+        }
+        i2c_write_n(w->port, w->slave, 0x40, out, sizeof(out));
+        i2c_read_n(w->port, w->slave, 0x40, back, sizeof(back));
+        if (memcmp(out, back, sizeof(out))) {
+            atomic_fetch_add(&g_mismatches, 1);
+        }
+    }
+    return NULL;
+}
+
+// one slave for all: a transaction is not split by the others
+static void *worker_txn(void *arg)
+{
+    worker_t *w = arg;
+    uint8_t back[16];
+    i2c_txn_t txn;
+
+    for (int r = 0; r < ROUNDS; r++) {
+        i2c_txn_begin(&txn, w->port);
+        for (int i = 0; i < (int)sizeof(back); i++) {
+            i2c_txn_write(&txn, w->slave, 0x20 + i, w->id);
+        }
+        i2c_txn_read(&txn, w->slave, 0x20, back, sizeof(back));
+        if (i2c_txn_submit(&txn) < 0) {
+            atomic_fetch_add(&g_mismatches, 1);
+            continue;
+        }
+        for (int i = 0; i < (int)sizeof(back); i++) {
+            if (back[i] != w->id) {
+                atomic_fetch_add(&g_mismatches, 1);
+                break;
+            }
+        }
+    }
+    return NULL;
+}
+
+static void run_workers(void *(*fn)(void *), worker_t *workers, int n)
+{
+    atomic_store(&g_mismatches, 0);
+    for (int i = 0; i < n; i++) {
+        CHECK_EQ(pthread_create(&workers[i].tid, NULL, fn, &workers[i]), 0);
+    }
+    for (int i = 0; i < n; i++) {
+        pthread_join(workers[i].tid, NULL);
+    }
+}
+
+static void test_lock_same_port(void)
+{
+    worker_t workers[THREADS];
+
+    for (int i = 0; i < THREADS; i++) {
+        workers[i].id = i + 1;
+        workers[i].port = TEST_PORT;
+        workers[i].slave = 0x10 + i;
+    }
+    run_workers(worker_write_n, workers, THREADS);
+    CHECK_EQ(atomic_load(&g_mismatches), 0);
+
+    for (int i = 0; i < THREADS; i++) {
+        workers[i].slave = ADDR_NCT75;
+    }
+    run_workers(worker_txn, workers, THREADS);
+    CHECK_EQ(atomic_load(&g_mismatches), 0);
+}
+
+static void test_lock_ports(void)
+{
+    worker_t workers[THREADS];
+    uint8_t back[16];
+
+    // the same slave address on each bus is another device
+    for (int i = 0; i < THREADS; i++) {
+        workers[i].id = 0x80 + i;
+        workers[i].port = 1 + i % 3;
+        workers[i].slave = ADDR_NCT75;
+    }
+    run_workers(worker_txn, workers, THREADS);
+    CHECK_EQ(atomic_load(&g_mismatches), 0);
+
+    for (int port = 1; port <= 3; port++) {
+        CHECK_EQ(i2c_read_n(port, ADDR_NCT75, 0x20, back, sizeof(back)), 0);
+        for (int i = 1; i < (int)sizeof(back); i++) {
+            CHECK_EQ(back[i], back[0]);
+        }
+        CHECK((back[0] & 0x7f) % 3 == port - 1);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// trace replay
+
+static void test_trace_replay(void)
+{
+    static const char trace[] =
+        "2 64 W 60 01 02 03\n"
+        "2 64 W 60\n"
+        "2 64 R 3\n"
+        "3 49 W 10 aa\n"
+        "3 49 R 1\n"          // no register write before it, left out
+        "not a trace line\n"
+        "2 65 W 70\n";        // register write at the end, sent on its own
+    char path[] = "/tmp/test_i2c_XXXXXX";
+    i2c_mock_stats_t stats;
+    int fd;
+
+    fd = mkstemp(path);
+    CHECK(fd >= 0);
+    if (fd < 0) {
+        return;
+    }
+    CHECK_EQ(write(fd, trace, sizeof(trace) - 1), sizeof(trace) - 1);
+    close(fd);
+
+    i2c_mock_reset_stats();
+    // every line but the two left out
+    CHECK_EQ(i2c_trace_replay(path), 5);
+    stats = stats_since();
+    // port 2, port 3, then port 2 again
+    CHECK_EQ(stats.xfers, 3);
+    CHECK_EQ(stats.msgs, 1 + 2 + 1 + 1);
+
+    CHECK_EQ(i2c_read(2, ADDR_FPGA, 0x62), 0x03);
+    CHECK_EQ(i2c_read(3, ADDR_IT66021, 0x10), 0xaa);
+
+    CHECK_EQ(i2c_trace_replay("/nonexistent/trace"), -1);
+    unlink(path);
+}
+
+int main(int argc, char *argv[])
+{
+    setvbuf(stdout, NULL, _IONBF, 0);
+
+    setenv("HDZ_I2C_MOCK", "1", 1);
+    iic_init();
+
+    TEST_RUN(test_txn_batched);
+    TEST_RUN(test_txn_stop);
+    TEST_RUN(test_txn_full);
+    TEST_RUN(test_txn_oversize);
+    TEST_RUN(test_txn_errors);
+    TEST_RUN(test_lock_same_port);
+    TEST_RUN(test_lock_ports);
+    TEST_RUN(test_trace_replay);
+
+    return TEST_RESULT();
+}
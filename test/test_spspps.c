@@ -0,0 +1,382 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "bitstream.h"
+#include "spspps_patch.h"
+
+#include "spspps_samples.h"
+#include "test.h"
+
+#define PATCH_bufSIZE   512
+
+typedef struct
+{
+    uint8_t buf[PATCH_bufSIZE];
+    int     len;
+    int     spsStart;           // sps header byte
+    int     spsEnd;             // next start code or the end
+} Patched_t;
+
+static uint32_t rnd_state = 0x12345678;
+
+static uint32_t rnd(void)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    return rnd_state;
+}
+
+static uint8_t sps_type(const SpsSample_t* s)
+{
+    return s->bHevc ? 0x42 : 0x67;
+}
+
+// the same search the patcher does, kept apart so a bug there shows here
+static int find_nal(const uint8_t* dat, int len, uint8_t type, int* start, int* end)
+{
+    int i;
+
+    for (i = 3; i < len; i++) {
+        if (dat[i - 3] == 0x00 && dat[i - 2] == 0x00 && dat[i - 1] == 0x01 && dat[i] == type) {
+            break;
+        }
+    }
+    if (i >= len) {
+        return -1;
+    }
+
+    *start = i;
+    *end = len;
+    for (; i < len - 2; i++) {
+        if (dat[i] == 0x00 && dat[i + 1] == 0x00 && dat[i + 2] <= 0x01) {
+            *end = i;
+            break;
+        }
+    }
+    return 0;
+}
+
+static int patch(const SpsSample_t* s, const uint8_t* src, int len, int fps, Patched_t* p)
+{
+    memset(p, 0, sizeof(*p));
+    memcpy(p->buf, src, len);
+
+    p->len = s->bHevc ? H265_Modify_SPS(p->buf, len, sizeof(p->buf), fps)
+                      : H264_Modify_SPS(p->buf, len, sizeof(p->buf), fps);
+    if (p->len < 0) {
+        return -1;
+    }
+    return find_nal(p->buf, p->len, sps_type(s), &p->spsStart, &p->spsEnd);
+}
+
+// bit offset of the 32 bit time_scale in the rbsp of the patched sps, the
+// only field two patches with a different fps may differ in
+static int find_time_scale(const Patched_t* a, uint32_t scaleA, const Patched_t* b, uint32_t scaleB)
+{
+    uint8_t rbspA[PATCH_bufSIZE], rbspB[PATCH_bufSIZE];
+    int lenA, lenB, pos, i;
+
+    lenA = bitstream_unescape(a->buf + a->spsStart, a->spsEnd - a->spsStart, rbspA, sizeof(rbspA));
+    lenB = bitstream_unescape(b->buf + b->spsStart, b->spsEnd - b->spsStart, rbspB, sizeof(rbspB));
+    if (lenA < 0 || lenA != lenB) {
+        return -1;
+    }
+
+    for (pos = 32; pos + 32 <= lenA * 8; pos++) {
+        BitReader_t rdA, rdB;
+
+        bitreader_init(&rdA, rbspA, lenA);
+        bitreader_init(&rdB, rbspB, lenB);
+        for (i = 0; i < pos - 32; i++) {
+            if (bitreader_readU(&rdA, 1) != bitreader_readU(&rdB, 1)) {
+                break;
+            }
+        }
+        if (i < pos - 32) {
+            continue;
+        }
+
+        // num_units_in_tick, then time_scale
+        if (bitreader_readU(&rdA, 32) != 1 || bitreader_readU(&rdB, 32) != 1 ||
+            bitreader_readU(&rdA, 32) != scaleA || bitreader_readU(&rdB, 32) != scaleB) {
+            continue;
+        }
+
+        while (!bitreader_eof(&rdA)) {
+            if (bitreader_readU(&rdA, 1) != bitreader_readU(&rdB, 1)) {
+                break;
+            }
+        }
+        if (bitreader_eof(&rdA)) {
+            return pos;
+        }
+    }
+    return -1;
+}
+
+static int rbsp_len(const uint8_t* nal, int len)
+{
+    uint8_t rbsp[PATCH_bufSIZE];
+
+    return bitstream_unescape(nal, len, rbsp, sizeof(rbsp));
+}
+
+static bool has_start_code(const uint8_t* dat, int len)
+{
+    for (int i = 0; i + 2 < len; i++) {
+        if (dat[i] == 0x00 && dat[i + 1] == 0x00 && dat[i + 2] <= 0x02) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int ue_bits(uint32_t val)
+{
+    return 2 * (32 - __builtin_clz(val + 1)) - 1;
+}
+
+static void test_bitstream_fields(void)
+{
+    enum { FIELDS = 4096, FIELD_UE = 33, FIELD_SE = 34 };
+    static uint8_t buf[FIELDS * 9];
+    static uint32_t val[FIELDS];
+    static uint8_t kind[FIELDS];        // 0..32: u(n), or ue(v), se(v)
+    BitWriter_t bw;
+    BitReader_t br;
+    int i, bits = 0, len;
+
+    bitwriter_init(&bw, buf, sizeof(buf));
+    for (i = 0; i < FIELDS; i++) {
+        switch (rnd() % 3) {
+        case 0:
+            kind[i] = rnd() % 33;
+            val[i] = kind[i] ? (rnd() >> (32 - kind[i])) : 0;
+            bitwriter_putU(&bw, val[i], kind[i]);
+            bits += kind[i];
+            break;
+        case 1:
+            // small values are the common ones, 2^32 - 1 has no 32 bit code
+            kind[i] = FIELD_UE;
+            val[i] = (rnd() & 1) ? (rnd() % 300) : (rnd() >> (rnd() % 32));
+            if (val[i] == 0xffffffff) {
+                val[i]--;
+            }
+            bitwriter_putUE(&bw, val[i]);
+            bits += ue_bits(val[i]);
+            break;
+        default: {
+            int32_t se = (int32_t)(rnd() % 2001) - 1000;
+            uint32_t ue = (se > 0) ? (uint32_t)(2 * se - 1) : (uint32_t)(-2 * se);
+
+            kind[i] = FIELD_SE;
+            val[i] = (uint32_t)se;
+            bitwriter_putUE(&bw, ue);
+            bits += ue_bits(ue);
+            break;
+        }
+        }
+        CHECK_EQ(bitwriter_pos(&bw), bits);
+    }
+    bitwriter_putU(&bw, 1, 1);
+    len = bitwriter_flush(&bw);
+    CHECK_EQ(len, (bits + 1 + 7) / 8);
+
+    bitreader_init(&br, buf, len);
+    for (i = 0; i < FIELDS; i++) {
+        if (kind[i] == FIELD_UE) {
+            CHECK_EQ(bitreader_readUE(&br), val[i]);
+        } else if (kind[i] == FIELD_SE) {
+            CHECK_EQ(bitreader_readSE(&br), (int32_t)val[i]);
+        } else {
+            CHECK_EQ(bitreader_readU(&br, kind[i]), val[i]);
+        }
+    }
+    CHECK_EQ(bitreader_readU(&br, 1), 1);
+    CHECK_EQ(bitreader_left(&br), len * 8 - bits - 1);
+
+    // past the end reads are zeros and end the stream
+    bitreader_skip(&br, bitreader_left(&br));
+    CHECK(bitreader_eof(&br));
+    CHECK_EQ(bitreader_readU(&br, 32), 0);
+    CHECK_EQ(bitreader_readUE(&br), 0);
+    CHECK_EQ(bitreader_left(&br), 0);
+}
+
+static void test_bitstream_overflow(void)
+{
+    uint8_t buf[8];
+    BitWriter_t bw;
+
+    bitwriter_init(&bw, buf, 5);
+    bitwriter_putU(&bw, 0xffffffff, 32);
+    bitwriter_putU(&bw, 0xff, 8);
+    CHECK_EQ(bitwriter_flush(&bw), 5);
+
+    bitwriter_init(&bw, buf, 5);
+    bitwriter_putU(&bw, 0xffffffff, 32);
+    bitwriter_putU(&bw, 0x1ff, 9);
+    CHECK_EQ(bitwriter_flush(&bw), -1);
+
+    bitwriter_init(&bw, buf, 3);
+    bitwriter_putU(&bw, 0xffffffff, 32);
+    CHECK_EQ(bitwriter_flush(&bw), -1);
+}
+
+static void test_bitstream_escape(void)
+{
+    static uint8_t raw[1024], esc[1536], back[1536];
+    static const uint8_t tricky[] = { 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x02, 0x00, 0x00, 0x03, 0x03, 0x00, 0x00 };
+    static const uint8_t trickyEsc[] = { 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x01, 0x00, 0x00, 0x03, 0x02,
+                                         0x00, 0x00, 0x03, 0x03, 0x03, 0x00, 0x00 };
+    int round, len, escLen, backLen;
+
+    escLen = bitstream_escape(tricky, sizeof(tricky), esc, sizeof(esc));
+    CHECK_EQ(escLen, sizeof(trickyEsc));
+    CHECK(memcmp(esc, trickyEsc, sizeof(trickyEsc)) == 0);
+    backLen = bitstream_unescape(esc, escLen, back, sizeof(back));
+    CHECK_EQ(backLen, sizeof(tricky));
+    CHECK(memcmp(back, tricky, sizeof(tricky)) == 0);
+
+    for (round = 0; round < 2000; round++) {
+        len = rnd() % sizeof(raw);
+        for (int i = 0; i < len; i++) {
+            // mostly zeros and small values, the ones that get escaped
+            raw[i] = (rnd() % 4) ? (rnd() % 4) : rnd();
+        }
+
+        escLen = bitstream_escape(raw, len, esc, sizeof(esc));
+        CHECK(escLen >= len);
+        // only the end may be left as zeros, the next start code follows there
+        CHECK(!has_start_code(esc, escLen));
+
+        backLen = bitstream_unescape(esc, escLen, back, sizeof(back));
+        CHECK_EQ(backLen, len);
+        CHECK(memcmp(back, raw, len) == 0);
+
+        // too small a buffer on either side is an error, never a write past it
+        if (escLen > 0) {
+            CHECK_EQ(bitstream_escape(raw, len, esc, escLen - 1), -1);
+            CHECK_EQ(bitstream_unescape(esc, escLen, back, escLen - 1), -1);
+        }
+    }
+}
+
+static void test_patch_samples(void)
+{
+    for (int i = 0; i < SPS_SAMPLES; i++) {
+        const SpsSample_t* s = &sps_samples[i];
+        static const int fpsList[] = { 30, 60, 90, 120 };
+        int srcStart, srcEnd;
+
+        printf("  %s\n", s->name);
+        CHECK(find_nal(s->data, s->len, sps_type(s), &srcStart, &srcEnd) == 0);
+        if (s->bBroken) {
+            continue;
+        }
+
+        for (int f = 0; f < (int)(sizeof(fpsList) / sizeof(fpsList[0])); f++) {
+            int fps = fpsList[f];
+            Patched_t p, again, other;
+            int tail = s->len - srcEnd;
+            int pos;
+
+            if (patch(s, s->data, s->len, fps, &p) < 0) {
+                CHECK(!"sps not patched");
+                continue;
+            }
+
+            // the nals before and after the sps are moved over unchanged
+            CHECK_EQ(p.spsStart, srcStart);
+            CHECK(memcmp(p.buf, s->data, srcStart) == 0);
+            CHECK_EQ(p.len - p.spsEnd, tail);
+            CHECK(memcmp(p.buf + p.spsEnd, s->data + srcEnd, tail) == 0);
+
+            // the timing info is added or rewritten in place
+            CHECK(rbsp_len(p.buf + p.spsStart, p.spsEnd - p.spsStart) >=
+                  rbsp_len(s->data + srcStart, srcEnd - srcStart));
+            CHECK(!has_start_code(p.buf + p.spsStart, p.spsEnd - p.spsStart));
+            CHECK(p.buf[p.spsEnd - 1] != 0x00);
+
+            // patching it again only rewrites the timing info already there
+            CHECK(patch(s, p.buf, p.len, fps, &again) == 0);
+            CHECK_EQ(again.len, p.len);
+            CHECK(memcmp(again.buf, p.buf, p.len) == 0);
+
+            // the frame rate lands in time_scale, H.264 counts fields; the
+            // nal may differ in length by the emulation bytes only
+            CHECK(patch(s, p.buf, p.len, fps + 7, &other) == 0);
+            pos = find_time_scale(&p, s->bHevc ? fps : fps * 2, &other, s->bHevc ? fps + 7 : (fps + 7) * 2);
+            CHECK(pos > 0);
+        }
+    }
+}
+
+static void test_patch_errors(void)
+{
+    for (int i = 0; i < SPS_SAMPLES; i++) {
+        const SpsSample_t* s = &sps_samples[i];
+        uint8_t buf[PATCH_bufSIZE];
+        Patched_t p;
+        int ret;
+
+        if (s->bBroken) {
+            // refused, and the pps after it is not touched
+            memcpy(buf, s->data, s->len);
+            ret = s->bHevc ? H265_Modify_SPS(buf, s->len, sizeof(buf), 60)
+                           : H264_Modify_SPS(buf, s->len, sizeof(buf), 60);
+            CHECK_EQ(ret, -1);
+            CHECK(memcmp(buf, s->data, s->len) == 0);
+            continue;
+        }
+
+        CHECK(patch(s, s->data, s->len, 60, &p) == 0);
+
+        // one byte short of the patched length: an error and src untouched
+        memset(buf, 0xa5, sizeof(buf));
+        memcpy(buf, s->data, s->len);
+        ret = s->bHevc ? H265_Modify_SPS(buf, s->len, p.len - 1, 60)
+                       : H264_Modify_SPS(buf, s->len, p.len - 1, 60);
+        CHECK_EQ(ret, -1);
+        CHECK(memcmp(buf, s->data, s->len) == 0);
+        CHECK_EQ(buf[s->len], 0xa5);
+
+        // exactly the patched length is enough
+        memcpy(buf, s->data, s->len);
+        ret = s->bHevc ? H265_Modify_SPS(buf, s->len, p.len, 60)
+                       : H264_Modify_SPS(buf, s->len, p.len, 60);
+        CHECK_EQ(ret, p.len);
+        CHECK(memcmp(buf, p.buf, p.len) == 0);
+
+        // the other codec's sps is not there
+        memcpy(buf, s->data, s->len);
+        ret = s->bHevc ? H264_Modify_SPS(buf, s->len, sizeof(buf), 60)
+                       : H265_Modify_SPS(buf, s->len, sizeof(buf), 60);
+        CHECK_EQ(ret, -1);
+
+        // cut in the middle of the sps
+        memcpy(buf, s->data, s->len);
+        ret = s->bHevc ? H265_Modify_SPS(buf, p.spsStart + 6, sizeof(buf), 60)
+                       : H264_Modify_SPS(buf, p.spsStart + 6, sizeof(buf), 60);
+        CHECK_EQ(ret, -1);
+    }
+
+    CHECK_EQ(H264_Modify_SPS(NULL, 10, 10, 60), -1);
+    CHECK_EQ(H265_Modify_SPS((uint8_t*)h265_spsdata_ts4, 0, 10, 60), -1);
+}
+
+int main(int argc, char* argv[])
+{
+    setvbuf(stdout, NULL, _IONBF, 0);
+
+    TEST_RUN(test_bitstream_fields);
+    TEST_RUN(test_bitstream_overflow);
+    TEST_RUN(test_bitstream_escape);
+    TEST_RUN(test_patch_samples);
+    TEST_RUN(test_patch_errors);
+
+    return TEST_RESULT();
+}
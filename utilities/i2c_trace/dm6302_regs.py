@@ -0,0 +1,56 @@
+import sys
+
+# Turns an i2c trace (HDZ_I2C_TRACE, see src/driver/i2c_mock.h) into the
+# DM6302 register writes and reads it carries over the FPGA spi bridge,
+# one per line, so two captures can be compared with diff.
+#
+#   python3 dm6302_regs.py before.trace > before.regs
+#   python3 dm6302_regs.py after.trace > after.regs
+#   diff before.regs after.regs
+
+PORT_MAIN = 2
+ADDR_FPGA = 0x64
+
+
+def decode(lines):
+    bridge = {}
+
+    for line in lines:
+        fields = line.split()
+        if len(fields) < 4 or int(fields[0]) != PORT_MAIN or int(fields[1], 16) != ADDR_FPGA:
+            continue
+        if fields[2] != "W" or len(fields) != 5:
+            continue
+
+        reg = int(fields[3], 16)
+        val = int(fields[4], 16)
+        bridge[reg] = val
+
+        if reg != 0x90:
+            continue
+
+        addr = bridge.get(0x91, 0) | ((bridge.get(0x92, 0) & 0x0F) << 8)
+        page = bridge.get(0x92, 0) >> 4
+        if val == 0x10:
+            yield "R page %x addr %03x" % (page, addr)
+        else:
+            dat = 0
+            for i in range(4):
+                dat |= bridge.get(0x93 + i, 0) << (8 * i)
+            sel = 0 if val == 0x03 else val
+            yield "W sel %d page %x addr %03x dat %08x" % (sel, page, addr, dat)
+
+
+def main():
+    if len(sys.argv) != 2:
+        print("usage: %s <trace>" % sys.argv[0])
+        return 1
+
+    with open(sys.argv[1]) as f:
+        for reg in decode(f):
+            print(reg)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())